@@ -24,9 +24,10 @@ RC_ICONS = cascade.ico
 
 DEFINES += QT_DEPRECATED_WARNINGS
 
+include(cascade-core-link.pri)
+
 SOURCES += \
     src/aboutdialog.cpp \
-    src/benchmark.cpp \
     src/codeeditor/QCXXHighlighter.cpp \
     src/codeeditor/QCodeEditor.cpp \
     src/codeeditor/QFramedTextAttribute.cpp \
@@ -61,9 +62,9 @@ SOURCES += \
     src/docking/IconProvider.cpp \
     src/docking/ads_globals.cpp \
     src/docking/linux/FloatingWidgetTitleBar.cpp \
+    src/gpuprofilerview.cpp \
     src/inputhandler.cpp \
     src/isfmanager.cpp \
-    src/log.cpp \
     src/main.cpp \
     src/mainmenu.cpp \
     src/mainwindow.cpp \
@@ -98,17 +99,14 @@ SOURCES += \
     src/properties/propertieswindow.cpp \
     src/properties/propertyview.cpp \
     src/properties/propertywidget.cpp \
+    src/properties/textpropertyview.cpp \
     src/properties/titlepropertyview.cpp \
     src/propertiesheading.cpp \
     src/propertiesview.cpp \
-    src/renderer/cscommandbuffer.cpp \
-    src/renderer/csimage.cpp \
     src/renderer/cssettingsbuffer.cpp \
-    src/renderer/rendertask.cpp \
-    src/renderer/rendertaskread.cpp \
+    src/renderer/renderthread.cpp \
     src/renderer/vulkanrenderer.cpp \
     src/rendermanager.cpp \
-    src/shadercompiler/SpvShaderCompiler.cpp \
     src/slidernoclick.cpp \
     src/ui/slider.cpp \
     src/uientities/channelselectentity.cpp \
@@ -136,7 +134,6 @@ SOURCES += \
 
 HEADERS += \
     src/aboutdialog.h \
-    src/benchmark.h \
     src/codeeditor/QCXXHighlighter.hpp \
     src/codeeditor/QCodeEditor.hpp \
     src/codeeditor/QFramedTextAttribute.hpp \
@@ -176,12 +173,11 @@ HEADERS += \
     src/docking/ads_globals.h \
     src/docking/linux/FloatingWidgetTitleBar.h \
     src/global.h \
+    src/gpuprofilerview.h \
     src/inputhandler.h \
     src/isfmanager.h \
-    src/log.h \
     src/mainmenu.h \
     src/mainwindow.h \
-    src/multithreading.h \
     src/nodegraph/connection.h \
     src/nodegraph/connectiongeometry.h \
     src/nodegraph/connectiongraphicsobject.h \
@@ -192,7 +188,6 @@ HEADERS += \
     src/nodegraph/datamodelregistry.h \
     src/nodegraph/node.h \
     src/nodegraph/nodeconnectioninteraction.h \
-    src/nodegraph/nodedata.h \
     src/nodegraph/nodedatamodel.h \
     src/nodegraph/nodegeometry.h \
     src/nodegraph/nodegraphdata.h \
@@ -203,14 +198,15 @@ HEADERS += \
     src/nodegraph/nodegraphviewstyle.h \
     src/nodegraph/nodepainter.h \
     src/nodegraph/nodepainterdelegate.h \
+    src/nodegraph/nodes/exposurenodedatamodel.h \
     src/nodegraph/nodes/readnodedatamodel.h \
     src/nodegraph/nodes/testnodedatamodel.h \
+    src/nodegraph/nodes/writenodedatamodel.h \
     src/nodegraph/nodestate.h \
     src/nodegraph/nodestyle.h \
     src/nodegraph/porttype.h \
     src/nodegraph/properties.h \
     src/nodegraph/qstringstdhash.h \
-    src/nodegraph/quuidstdhash.h \
     src/nodegraph/serializable.h \
     src/nodegraph/style.h \
     src/nodegraph/stylecollection.h \
@@ -218,31 +214,19 @@ HEADERS += \
     src/preferencesdialog.h \
     src/preferencesmanager.h \
     src/projectmanager.h \
-    src/properties/filespropertymodel.h \
     src/properties/filespropertyview.h \
-    src/properties/intpropertymodel.h \
     src/properties/intpropertyview.h \
     src/properties/propertieswindow.h \
-    src/properties/propertydata.h \
-    src/properties/propertymodel.h \
     src/properties/propertyview.h \
     src/properties/propertywidget.h \
-    src/properties/titlepropertymodel.h \
+    src/properties/textpropertyview.h \
     src/properties/titlepropertyview.h \
     src/propertiesheading.h \
     src/propertiesview.h \
-    src/renderer/cscommandbuffer.h \
-    src/renderer/csimage.h \
     src/renderer/cssettingsbuffer.h \
-    src/renderer/renderconfig.h \
-    src/renderer/rendertask.h \
-    src/renderer/rendertaskread.h \
-    src/renderer/renderutility.h \
-    src/renderer/vulkanhppinclude.h \
+    src/renderer/renderthread.h \
     src/renderer/vulkanrenderer.h \
     src/rendermanager.h \
-    src/shadercompiler/DirStackFileIncluder.h \
-    src/shadercompiler/SpvShaderCompiler.h \
     src/slidernoclick.h \
     src/ui/slider.h \
     src/uientities/channelselectentity.h \
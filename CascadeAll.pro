@@ -0,0 +1,25 @@
+# Builds libcascade-core first, then the editor, cascade-cli and the
+# tests, which all link it instead of compiling the core sources again.
+# The projects share a directory, so each gets its own Makefile.
+
+TEMPLATE = subdirs
+
+core.file = CascadeCore.pro
+core.makefile = Makefile.core
+
+app.file = Cascade.pro
+app.makefile = Makefile.app
+app.depends = core
+
+cli.file = CascadeCli.pro
+cli.makefile = Makefile.cli
+cli.depends = core
+
+tests.file = test/CascadeTests/CascadeTests.pro
+tests.depends = core
+
+SUBDIRS += \
+    core \
+    app \
+    cli \
+    tests
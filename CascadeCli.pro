@@ -0,0 +1,115 @@
+# Headless batch renderer, renders all Write nodes of a project
+# without a window. Only links the GUI-free core, see cascade-core-link.pri.
+
+QT        = core
+
+TEMPLATE = app
+TARGET = cascade-cli
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+#------------------------------- Versioning
+
+VERSION_MAJOR = 0
+VERSION_MINOR = 2
+VERSION_BUILD = 1
+
+DEFINES += "VERSION_MAJOR=$$VERSION_MAJOR"\
+           "VERSION_MINOR=$$VERSION_MINOR"\
+           "VERSION_BUILD=$$VERSION_BUILD"
+
+VERSION = $${VERSION_MAJOR}.$${VERSION_MINOR}.$${VERSION_BUILD}
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x050F00
+
+#-------------------------------
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(cascade-core-link.pri)
+
+SOURCES += \
+    src/cli/batchrenderer.cpp \
+    src/cli/main.cpp
+
+HEADERS += \
+    src/cli/batchrenderer.h
+
+linux-g++ {
+
+    OS = $$system(uname -a)
+    isArch = $$find(OS,arch)
+    isUbuntu1804LTS = $$find(OS, 18.04.1-Ubuntu)
+
+    !isEmpty( isUbuntu1804LTS ){
+        INCLUDEPATH += $$(VULKAN_SDK)/include
+    }
+    isEmpty(isArch){
+        INCLUDEPATH += $$PWD/external/OpenColorIO/install/include
+        INCLUDEPATH += $$PWD/external/glslang/include
+    }
+
+    LIBS += -L/usr/local/lib -lOpenImageIO -lOpenImageIO_Util
+    LIBS += -L$$PWD/external/OpenColorIO/install/lib -lOpenColorIO
+    LIBS += -L$$PWD/external/glslang/lib
+    # The link order of the following libs is important
+    LIBS += -lSPIRV \
+    -lSPIRV-Tools-opt \
+    -lSPIRV-Tools \
+    -lMachineIndependent \
+    -lglslang \
+    -lglslang-default-resource-limits \
+    -lOSDependent \
+    -lOGLCompiler \
+    -lGenericCodeGen
+
+    LIBS += -L/usr/lib/x86_64-linux-gnu -ldl -ltbb
+
+    CONFIG(debug, debug|release): DESTDIR = $$OUT_PWD/debug
+    CONFIG(release, debug|release): DESTDIR = $$OUT_PWD/release
+}
+
+# The DLLs are copied next to the executables by Cascade.pro
+win32-msvc* {
+    DEPENDENCY_ROOT = vcpkg_installed/x64-windows
+    LIB_ROOT = ../vcpkg_installed/x64-windows
+
+    INCLUDEPATH += $$DEPENDENCY_ROOT/include
+    INCLUDEPATH += $$(VULKAN_SDK)/include
+
+    CONFIG(debug, debug|release) {
+        DESTDIR = $$OUT_PWD/debug
+
+        LIBS += -L$$LIB_ROOT/debug/lib -lOpenImageIO_d
+        LIBS += -L$$LIB_ROOT/debug/lib -lOpenImageIO_Util_d
+        LIBS += -L$$LIB_ROOT/debug/lib -lOpenColorIO
+        LIBS += -L$$LIB_ROOT/debug/lib -ltbb_debug
+        LIBS += -L$$LIB_ROOT/debug/lib -lglslangd
+        LIBS += -L$$LIB_ROOT/debug/lib -lglslang-default-resource-limitsd
+        LIBS += -L$$LIB_ROOT/debug/lib -lGenericCodeGend
+        LIBS += -L$$LIB_ROOT/debug/lib -lMachineIndependentd
+        LIBS += -L$$LIB_ROOT/debug/lib -lOGLCompilerd
+        LIBS += -L$$LIB_ROOT/debug/lib -lOSDependentd
+        LIBS += -L$$LIB_ROOT/debug/lib -lSPIRVd
+        LIBS += -L$$LIB_ROOT/debug/lib -lSPVRemapperd
+    }
+    CONFIG(release, debug|release) {
+        DESTDIR = $$OUT_PWD/release
+
+        LIBS += -L$$LIB_ROOT/lib -lOpenImageIO
+        LIBS += -L$$LIB_ROOT/lib -lOpenImageIO_Util
+        LIBS += -L$$LIB_ROOT/lib -lOpenColorIO
+        LIBS += -L$$LIB_ROOT/lib -ltbb
+        LIBS += -L$$LIB_ROOT/lib -lglslang
+        LIBS += -L$$LIB_ROOT/lib -lglslang-default-resource-limits
+        LIBS += -L$$LIB_ROOT/lib -lGenericCodeGen
+        LIBS += -L$$LIB_ROOT/lib -lMachineIndependent
+        LIBS += -L$$LIB_ROOT/lib -lOGLCompiler
+        LIBS += -L$$LIB_ROOT/lib -lOSDependent
+        LIBS += -L$$LIB_ROOT/lib -lSPIRV
+        LIBS += -L$$LIB_ROOT/lib -lSPVRemapper
+    }
+}
+
+RESOURCES += \
+    resources.qrc
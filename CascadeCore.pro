@@ -0,0 +1,42 @@
+# libcascade-core, the GUI-free part of Cascade as a static library
+# for batch workers and benchmarks that don't need the editor.
+# The editor, cascade-cli and the tests link it through
+# cascade-core-link.pri, see CascadeAll.pro.
+
+QT        = core
+
+TEMPLATE = lib
+TARGET = cascade-core
+CONFIG += staticlib c++17
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x050F00
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(cascade-core.pri)
+
+# cascade-core-link.pri expects the library here on every platform
+CONFIG(debug, debug|release): DESTDIR = $$OUT_PWD/debug
+CONFIG(release, debug|release): DESTDIR = $$OUT_PWD/release
+
+linux-g++ {
+
+    OS = $$system(uname -a)
+    isArch = $$find(OS,arch)
+    isUbuntu1804LTS = $$find(OS, 18.04.1-Ubuntu)
+
+    !isEmpty( isUbuntu1804LTS ){
+        INCLUDEPATH += $$(VULKAN_SDK)/include
+    }
+    isEmpty(isArch){
+        INCLUDEPATH += $$PWD/external/OpenColorIO/install/include
+        INCLUDEPATH += $$PWD/external/glslang/include
+    }
+}
+
+# Consumers link OpenImageIO, OpenColorIO, tbb and glslang themselves
+win32-msvc* {
+    DEPENDENCY_ROOT = vcpkg_installed/x64-windows
+
+    INCLUDEPATH += $$DEPENDENCY_ROOT/include
+    INCLUDEPATH += $$(VULKAN_SDK)/include
+}
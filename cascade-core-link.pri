@@ -0,0 +1,18 @@
+# Links libcascade-core, built by CascadeCore.pro into the build
+# directory of this folder. Build through CascadeAll.pro so the library
+# is up to date before anything links it.
+
+QT *= core
+
+CONFIG *= c++17
+
+CASCADE_CORE_DIR = $$shadowed($$PWD)
+CONFIG(debug, debug|release): CASCADE_CORE_DIR = $$CASCADE_CORE_DIR/debug
+CONFIG(release, debug|release): CASCADE_CORE_DIR = $$CASCADE_CORE_DIR/release
+
+DEPENDPATH += $$PWD/src
+
+LIBS += -L$$CASCADE_CORE_DIR -lcascade-core
+
+win32-msvc*: PRE_TARGETDEPS += $$CASCADE_CORE_DIR/cascade-core.lib
+else: PRE_TARGETDEPS += $$CASCADE_CORE_DIR/libcascade-core.a
@@ -0,0 +1,105 @@
+# GUI-free core of Cascade: node definitions, properties, render tasks,
+# the renderer, image IO and color management. Depends on QtCore only,
+# must not include anything from QtWidgets.
+#
+# Only included by CascadeCore.pro, which builds it as the static
+# library libcascade-core. Everything else links that library through
+# cascade-core-link.pri.
+
+QT *= core
+
+CONFIG *= c++17
+
+SOURCES += \
+    $$PWD/src/benchmark.cpp \
+    $$PWD/src/log.cpp \
+    $$PWD/src/nodegraph/projectgraph.cpp \
+    $$PWD/src/renderer/barrierplanner.cpp \
+    $$PWD/src/renderer/cscommandbuffer.cpp \
+    $$PWD/src/renderer/csdeletionqueue.cpp \
+    $$PWD/src/renderer/csdescriptorallocator.cpp \
+    $$PWD/src/renderer/csgpuprofiler.cpp \
+    $$PWD/src/renderer/csimage.cpp \
+    $$PWD/src/renderer/csimagehasher.cpp \
+    $$PWD/src/renderer/csimagetransfer.cpp \
+    $$PWD/src/renderer/cskernelfuser.cpp \
+    $$PWD/src/renderer/csmemoryallocator.cpp \
+    $$PWD/src/renderer/csstagingbuffer.cpp \
+    $$PWD/src/renderer/cstransientimagepool.cpp \
+    $$PWD/src/renderer/fileoutput.cpp \
+    $$PWD/src/renderer/graphexecutor.cpp \
+    $$PWD/src/renderer/imagealiasing.cpp \
+    $$PWD/src/renderer/imageprecision.cpp \
+    $$PWD/src/renderer/kernelfusion.cpp \
+    $$PWD/src/renderer/offscreenrenderer.cpp \
+    $$PWD/src/renderer/pipelinecachefile.cpp \
+    $$PWD/src/renderer/pipelinecacheheader.cpp \
+    $$PWD/src/renderer/rangeallocator.cpp \
+    $$PWD/src/renderer/rendercache.cpp \
+    $$PWD/src/renderer/rendergraph.cpp \
+    $$PWD/src/renderer/rendertask.cpp \
+    $$PWD/src/renderer/rendertaskexposure.cpp \
+    $$PWD/src/renderer/rendertaskread.cpp \
+    $$PWD/src/renderer/rendertaskwrite.cpp \
+    $$PWD/src/renderer/sequenceoutput.cpp \
+    $$PWD/src/renderer/tiledimagewriter.cpp \
+    $$PWD/src/renderer/tiling.cpp \
+    $$PWD/src/resourcefiles.cpp \
+    $$PWD/src/shadercompiler/SpvShaderCompiler.cpp
+
+HEADERS += \
+    $$PWD/src/benchmark.h \
+    $$PWD/src/log.h \
+    $$PWD/src/multithreading.h \
+    $$PWD/src/nodegraph/nodedata.h \
+    $$PWD/src/nodegraph/nodes/exposurenodedata.h \
+    $$PWD/src/nodegraph/nodes/readnodedata.h \
+    $$PWD/src/nodegraph/nodes/testnodedata.h \
+    $$PWD/src/nodegraph/nodes/writenodedata.h \
+    $$PWD/src/nodegraph/projectgraph.h \
+    $$PWD/src/nodegraph/quuidstdhash.h \
+    $$PWD/src/properties/filespropertymodel.h \
+    $$PWD/src/properties/intpropertymodel.h \
+    $$PWD/src/properties/propertydata.h \
+    $$PWD/src/properties/propertymodel.h \
+    $$PWD/src/properties/textpropertymodel.h \
+    $$PWD/src/properties/titlepropertymodel.h \
+    $$PWD/src/renderer/barrierplanner.h \
+    $$PWD/src/renderer/cscommandbuffer.h \
+    $$PWD/src/renderer/csdeletionqueue.h \
+    $$PWD/src/renderer/csdescriptorallocator.h \
+    $$PWD/src/renderer/csgpuprofiler.h \
+    $$PWD/src/renderer/csimage.h \
+    $$PWD/src/renderer/csimagehasher.h \
+    $$PWD/src/renderer/csimagetransfer.h \
+    $$PWD/src/renderer/cskernelfuser.h \
+    $$PWD/src/renderer/csmemoryallocator.h \
+    $$PWD/src/renderer/csstagingbuffer.h \
+    $$PWD/src/renderer/cstransientimagepool.h \
+    $$PWD/src/renderer/fileoutput.h \
+    $$PWD/src/renderer/graphexecutor.h \
+    $$PWD/src/renderer/imagealiasing.h \
+    $$PWD/src/renderer/imageprecision.h \
+    $$PWD/src/renderer/kernelfusion.h \
+    $$PWD/src/renderer/latestvaluemailbox.h \
+    $$PWD/src/renderer/offscreenrenderer.h \
+    $$PWD/src/renderer/pipelinecachefile.h \
+    $$PWD/src/renderer/pipelinecacheheader.h \
+    $$PWD/src/renderer/rangeallocator.h \
+    $$PWD/src/renderer/rendercache.h \
+    $$PWD/src/renderer/renderconfig.h \
+    $$PWD/src/renderer/renderdevice.h \
+    $$PWD/src/renderer/rendergraph.h \
+    $$PWD/src/renderer/renderhash.h \
+    $$PWD/src/renderer/rendertask.h \
+    $$PWD/src/renderer/rendertaskexposure.h \
+    $$PWD/src/renderer/rendertaskread.h \
+    $$PWD/src/renderer/rendertaskwrite.h \
+    $$PWD/src/renderer/renderutility.h \
+    $$PWD/src/renderer/sequenceoutput.h \
+    $$PWD/src/renderer/tiledimagewriter.h \
+    $$PWD/src/renderer/tiling.h \
+    $$PWD/src/renderer/vulkanhppinclude.h \
+    $$PWD/src/resourcefiles.h \
+    $$PWD/src/shadercompiler/DirStackFileIncluder.h \
+    $$PWD/src/shadercompiler/SpvShaderCompiler.h
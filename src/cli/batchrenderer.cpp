@@ -0,0 +1,255 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "batchrenderer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../log.h"
+#include "../nodegraph/nodes/readnodedata.h"
+#include "../nodegraph/nodes/writenodedata.h"
+#include "../nodegraph/projectgraph.h"
+#include "../renderer/csimagehasher.h"
+#include "../renderer/cskernelfuser.h"
+#include "../renderer/fileoutput.h"
+#include "../renderer/renderconfig.h"
+#include "../renderer/renderdevice.h"
+#include "../renderer/rendertaskread.h"
+#include "../renderer/sequenceoutput.h"
+
+namespace Cascade {
+
+BatchRenderer::BatchRenderer(
+    Renderer::RenderDevice* device,
+    NodeGraph::ProjectGraph* project)
+    : mDevice(device)
+    , mProject(project)
+{
+    mExecutor = std::make_unique<Renderer::GraphExecutor>(
+        [this]() { return mDevice->createComputeCommandBuffer(); },
+        Renderer::maxParallelBranches);
+
+    if (auto hasher = mDevice->getImageHasher(); hasher && hasher->isValid())
+    {
+        mExecutor->setContentHasher(
+            [hasher](Renderer::CsImage* image, Renderer::CsCommandBuffer* commandBuffer)
+            {
+                return hasher->hash(image, commandBuffer);
+            });
+    }
+
+    if (auto fuser = mDevice->getKernelFuser())
+    {
+        mExecutor->setKernelFuser(
+            [fuser](const std::vector<Renderer::PointwiseKernel>& kernels,
+                    const std::shared_ptr<Renderer::CsImage>& input,
+                    Renderer::CsCommandBuffer* commandBuffer,
+                    const Renderer::FusedRegion& region,
+                    const bool isParameterUpdate,
+                    const Renderer::OutputFactory& createOutput)
+            {
+                return fuser->execute(
+                    kernels, input, commandBuffer, region, isParameterUpdate, createOutput);
+            });
+    }
+
+    mExecutor->setTransientImagePool(mDevice->getTransientImagePool());
+}
+
+bool BatchRenderer::renderAll()
+{
+    const auto writeNodes = mProject->getNodesOfType("Write");
+
+    if (writeNodes.empty())
+    {
+        CS_LOG_WARNING("The project does not contain any Write nodes.");
+        return false;
+    }
+
+    bool success = true;
+
+    for (const auto& id : writeNodes)
+    {
+        success &= renderWriteNode(id);
+    }
+
+    return success;
+}
+
+bool BatchRenderer::renderWriteNode(const QUuid& id)
+{
+    const auto& write = mProject->getNodeData(id);
+
+    const QString path = NodeGraph::WriteNodeData::getPath(write);
+    if (path.isEmpty())
+    {
+        CS_LOG_WARNING("Skipping Write node without a path.");
+        return false;
+    }
+
+    auto graph = mProject->createRenderGraph();
+    const int target = graph.indexOf(id);
+
+    mExecutor->setNodeTimer(
+        [this, &graph](const int index, const double milliseconds)
+        {
+            const QUuid nodeId = graph.getNode(index).id;
+
+            std::lock_guard<std::mutex> lock(mTimingsMutex);
+
+            auto& timing = mTimings[nodeId];
+            ++timing.executions;
+            timing.milliseconds += milliseconds;
+        });
+
+    // A Read node with several files turns the output into a sequence,
+    // the ones with a single file are read when they are executed, in
+    // tiles if they are too large for the GPU
+    int sequenceRead = -1;
+    QStringList files;
+    std::vector<Renderer::RenderTaskRead*> loadedReads;
+    bool isLoaded = true;
+
+    for (const auto index : graph.upstreamOf(target))
+    {
+        const auto& data = mProject->getNodeData(graph.getNode(index).id);
+
+        if (data.mName != "Read")
+            continue;
+
+        const QStringList readFiles = NodeGraph::ReadNodeData::getFiles(data);
+
+        if (readFiles.size() == 1)
+        {
+            auto readTask = dynamic_cast<Renderer::RenderTaskRead*>(graph.getNode(index).task);
+
+            QSize size;
+            auto loader = readTask ?
+                Renderer::createRegionLoader(*mDevice, readFiles.front(), size) :
+                nullptr;
+
+            if (!loader)
+            {
+                CS_LOG_WARNING("Failed to read " + readFiles.front());
+                isLoaded = false;
+                break;
+            }
+
+            readTask->setRegionLoader(size, std::move(loader));
+            loadedReads.push_back(readTask);
+
+            continue;
+        }
+
+        if (readFiles.size() < 2)
+            continue;
+
+        if (sequenceRead >= 0)
+        {
+            CS_LOG_WARNING("Only the first Read node with several files is rendered as a sequence.");
+            continue;
+        }
+
+        sequenceRead = index;
+        files = readFiles;
+    }
+
+    const int colorSpace = NodeGraph::WriteNodeData::getColorSpace(write);
+    bool success = isLoaded;
+
+    if (success && sequenceRead >= 0)
+    {
+        CS_LOG_INFO("Writing " + QString::number(files.size()) + " frames to " + path);
+
+        success = Renderer::renderSequenceToFiles(
+            *mExecutor, *mDevice, graph, target, sequenceRead, files, path, {}, colorSpace);
+    }
+    else if (success)
+    {
+        CS_LOG_INFO("Writing " + path);
+
+        success = Renderer::renderToFile(
+            *mExecutor, *mDevice, graph, target, path, {}, colorSpace);
+    }
+
+    // The files are read again for the next Write node
+    for (auto readTask : loadedReads)
+    {
+        readTask->setImage(nullptr);
+        readTask->setRegionLoader(QSize(), nullptr);
+    }
+
+    mExecutor->setNodeTimer(nullptr);
+
+    if (!success)
+    {
+        CS_LOG_WARNING("Failed to write " + path);
+        return false;
+    }
+
+    // Branches shared with the next Write node are not rendered again
+    for (const auto index : graph.upstreamOf(target))
+    {
+        mProject->setIsDirty(graph.getNode(index).id, false);
+    }
+
+    return true;
+}
+
+void BatchRenderer::printTimings(QTextStream& out) const
+{
+    std::vector<NodeTiming> timings;
+    double total = 0.0;
+
+    {
+        std::lock_guard<std::mutex> lock(mTimingsMutex);
+
+        for (const auto& timing : mTimings)
+        {
+            timings.push_back(timing.second);
+            total += timing.second.milliseconds;
+
+            // Caption and the start of the id, several nodes can share a caption
+            timings.back().name =
+                mProject->getNodeData(timing.first).mCaption + " " + timing.first.toString().mid(1, 8);
+        }
+    }
+
+    std::sort(timings.begin(), timings.end(),
+              [](const NodeTiming& a, const NodeTiming& b)
+              {
+                  return a.milliseconds > b.milliseconds;
+              });
+
+    out << QString("%1 %2 %3").arg("Node", -32).arg("Runs", 6).arg("Time (ms)", 12) << Qt::endl;
+
+    for (const auto& timing : timings)
+    {
+        out << QString("%1 %2 %3")
+                   .arg(timing.name, -32)
+                   .arg(timing.executions, 6)
+                   .arg(timing.milliseconds, 12, 'f', 2)
+            << Qt::endl;
+    }
+
+    out << QString("%1 %2 %3").arg("Total", -32).arg("", 6).arg(total, 12, 'f', 2) << Qt::endl;
+}
+
+} // namespace Cascade
@@ -0,0 +1,81 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <mutex>
+#include <unordered_map>
+
+#include <QString>
+#include <QTextStream>
+#include <QUuid>
+
+#include "../nodegraph/quuidstdhash.h"
+#include "../renderer/graphexecutor.h"
+
+namespace Cascade::Renderer
+{
+    class RenderDevice;
+}
+
+namespace Cascade::NodeGraph
+{
+    class ProjectGraph;
+}
+
+namespace Cascade {
+
+// Renders all Write nodes of a node graph to disk without any UI
+// and keeps track of how long every node took to execute
+class BatchRenderer
+{
+public:
+    BatchRenderer(
+        Renderer::RenderDevice* device,
+        NodeGraph::ProjectGraph* project);
+
+    // False if any of the Write nodes could not be written
+    bool renderAll();
+
+    // Accumulated over all Write nodes, slowest first
+    void printTimings(QTextStream& out) const;
+
+private:
+    bool renderWriteNode(const QUuid& id);
+
+    struct NodeTiming
+    {
+        QString name;
+        int executions = 0;
+        double milliseconds = 0.0;
+    };
+
+    Renderer::RenderDevice* mDevice;
+    NodeGraph::ProjectGraph* mProject;
+
+    std::unique_ptr<Renderer::GraphExecutor> mExecutor;
+
+    std::unordered_map<QUuid, NodeTiming> mTimings;
+    mutable std::mutex mTimingsMutex;
+};
+
+} // namespace Cascade
+
+#endif // BATCHRENDERER_H
@@ -0,0 +1,104 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include "../renderer/vulkanhppinclude.h"
+
+#include "../log.h"
+#include "../nodegraph/projectgraph.h"
+#include "../renderer/imageprecision.h"
+#include "../renderer/offscreenrenderer.h"
+#include "../resourcefiles.h"
+#include "batchrenderer.h"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("cascade-cli");
+    QCoreApplication::setApplicationVersion(
+        QString("%1.%2.%3").arg(VERSION_MAJOR).arg(VERSION_MINOR).arg(VERSION_BUILD));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders all Write nodes of a Cascade project.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("project", "The .csc project to render.");
+
+    QCommandLineOption deviceOption(
+        "device",
+        "Render on the first GPU whose name contains <name>, e.g. llvmpipe.",
+        "name");
+    parser.addOption(deviceOption);
+
+    parser.process(a);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1)
+        parser.showHelp(1);
+
+    Cascade::Log::Init();
+
+    Cascade::copyOcioConfigToDisk();
+
+    QFile projectFile(arguments.first());
+    if (!projectFile.open(QIODevice::ReadOnly))
+    {
+        CS_LOG_WARNING("Couldn't open project file.");
+        return 1;
+    }
+
+    const QJsonObject jsonProject = QJsonDocument::fromJson(projectFile.readAll()).object();
+
+    // Before any shader or image is created
+    auto precision = Cascade::Renderer::imagePrecisionFromName(
+        jsonProject.value("precision").toString());
+    Cascade::Renderer::setImagePrecision(
+        precision.value_or(Cascade::Renderer::ImagePrecision::Float32));
+
+    Cascade::Renderer::OffscreenRenderer renderer;
+    if (!renderer.initialize(parser.value(deviceOption)))
+        return 1;
+
+    Cascade::NodeGraph::ProjectGraph project;
+    project.load(jsonProject.value("nodegraph").toObject());
+
+    bool success = false;
+    {
+        Cascade::BatchRenderer batchRenderer(&renderer, &project);
+
+        success = batchRenderer.renderAll();
+
+        QTextStream out(stdout);
+        batchRenderer.printTimings(out);
+    }
+
+    // The results of the nodes live on the device
+    project.clear();
+    renderer.shutdown();
+
+    return success ? 0 : 1;
+}
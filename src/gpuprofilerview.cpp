@@ -0,0 +1,73 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "gpuprofilerview.h"
+
+#include <algorithm>
+
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+namespace Cascade {
+
+GpuProfilerView::GpuProfilerView(QWidget *parent) :
+    QWidget(parent)
+{
+    mTable = new QTableWidget(0, 2, this);
+    mTable->setHorizontalHeaderLabels({ "Node", "GPU ms" });
+    mTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    mTable->verticalHeader()->hide();
+    mTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    mTable->setSelectionMode(QAbstractItemView::NoSelection);
+
+    mTotalLabel = new QLabel(this);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(mTable);
+    mainLayout->addWidget(mTotalLabel);
+    setLayout(mainLayout);
+
+    handleGpuTimingsChanged({});
+}
+
+void GpuProfilerView::handleGpuTimingsChanged(const QVector<QPair<QString, double>>& timings)
+{
+    auto sorted = timings;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    mTable->setRowCount(sorted.size());
+
+    double total = 0.0;
+
+    for (int i = 0; i < sorted.size(); ++i)
+    {
+        auto* timeItem = new QTableWidgetItem(QString::number(sorted[i].second, 'f', 2));
+        timeItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+        mTable->setItem(i, 0, new QTableWidgetItem(sorted[i].first));
+        mTable->setItem(i, 1, timeItem);
+
+        total += sorted[i].second;
+    }
+
+    mTotalLabel->setText("Total: " + QString::number(total, 'f', 2) + " ms");
+}
+
+} // namespace Cascade
@@ -0,0 +1,51 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef GPUPROFILERVIEW_H
+#define GPUPROFILERVIEW_H
+
+#include <QLabel>
+#include <QPair>
+#include <QTableWidget>
+#include <QVector>
+#include <QWidget>
+
+namespace Cascade {
+
+// Lists the GPU time of every node of the last renders,
+// the most expensive ones first
+class GpuProfilerView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GpuProfilerView(QWidget *parent = nullptr);
+
+private:
+    QTableWidget* mTable;
+    QLabel* mTotalLabel;
+
+public slots:
+    // Pairs of node caption and milliseconds
+    void handleGpuTimingsChanged(const QVector<QPair<QString, double>>& timings);
+};
+
+} // namespace Cascade
+
+#endif // GPUPROFILERVIEW_H
@@ -29,6 +29,7 @@
 #include "renderer/vulkanhppinclude.h"
 
 #include "log.h"
+#include "resourcefiles.h"
 
 #include <OpenImageIO/imagebuf.h>
 
@@ -68,27 +69,10 @@ int main(int argc, char *argv[])
 
     CS_LOG_INFO(title);
 
-    // Copy the OCIO config from the resources to disk.
-    // We do this so that they end up in the right place when
-    // running from an AppImage.
-    if (!QDir("ocio").exists())
-    {
-        QDir().mkdir("ocio");
-        QDir().mkdir("ocio/luts");
-
-        QFile::copy(":/ocio/config.ocio", "ocio/config.ocio");
-        QFile::copy(":/ocio/luts/alexalogc.spi1d", "ocio/luts/alexalogc.spi1d");
-        QFile::copy(":/ocio/luts/cineon.spi1d", "ocio/luts/cineon.spi1d");
-        QFile::copy(":/ocio/luts/panalog.spi1d", "ocio/luts/panalog.spi1d");
-        QFile::copy(":/ocio/luts/ploglin.spi1d", "ocio/luts/ploglin.spi1d");
-        QFile::copy(":/ocio/luts/rec709.spi1d", "ocio/luts/rec709.spi1d");
-        QFile::copy(":/ocio/luts/redlog.spi1d", "ocio/luts/redlog.spi1d");
-        QFile::copy(":/ocio/luts/slog.spi1d", "ocio/luts/slog.spi1d");
-        QFile::copy(":/ocio/luts/srgb.spi1d", "ocio/luts/srgb.spi1d");
-        QFile::copy(":/ocio/luts/srgbf.spi1d", "ocio/luts/srgbf.spi1d");
-        QFile::copy(":/ocio/luts/viperlog.spi1d", "ocio/luts/viperlog.spi1d");
-    }
-    // Same for the ISF shaders
+    Cascade::copyOcioConfigToDisk();
+
+    // Copy the ISF shaders from the resources to disk,
+    // same as the OCIO config
     QDir dstDir("isf");
     if (!dstDir.exists())
     {
@@ -19,6 +19,8 @@
 
 #include "mainmenu.h"
 
+#include <QActionGroup>
+
 #include "mainwindow.h"
 //#include "nodegraph/nodedefinitions.h"
 
@@ -63,6 +65,30 @@ MainMenu::MainMenu(MainWindow* mainWindow)
 
     mFileMenu->addSeparator();
 
+    auto precisionMenu = mFileMenu->addMenu("Processing Precision");
+    auto precisionGroup = new QActionGroup(precisionMenu);
+
+    mFullPrecisionAction = new QAction("Full (RGBA32F)", precisionGroup);
+    mFullPrecisionAction->setCheckable(true);
+    mFullPrecisionAction->setChecked(true);
+    precisionMenu->addAction(mFullPrecisionAction);
+    connect(mFullPrecisionAction, &QAction::triggered,
+            mainWindow, [mainWindow]()
+            {
+                mainWindow->handleImagePrecisionAction(Renderer::ImagePrecision::Float32);
+            });
+
+    mHalfPrecisionAction = new QAction("Half (RGBA16F)", precisionGroup);
+    mHalfPrecisionAction->setCheckable(true);
+    precisionMenu->addAction(mHalfPrecisionAction);
+    connect(mHalfPrecisionAction, &QAction::triggered,
+            mainWindow, [mainWindow]()
+            {
+                mainWindow->handleImagePrecisionAction(Renderer::ImagePrecision::Float16);
+            });
+
+    mFileMenu->addSeparator();
+
     mExitAction = new QAction("Exit" , mFileMenu);
     mFileMenu->addAction(mExitAction);
     connect(mExitAction, &QAction::triggered,
@@ -161,6 +187,7 @@ MainMenu::MainMenu(MainWindow* mainWindow)
 
     mViewMenu->addAction(mainWindow->mNodeGraphDockWidget->toggleViewAction());
     mViewMenu->addAction(mainWindow->mPropertiesWindowDockWidget->toggleViewAction());
+    mViewMenu->addAction(mainWindow->mGpuProfilerDockWidget->toggleViewAction());
 
     mViewMenu->addSeparator();
 
@@ -174,6 +201,14 @@ MainMenu::MainMenu(MainWindow* mainWindow)
             mainWindow, &MainWindow::handleAboutAction);
 }
 
+void MainMenu::handleImagePrecisionChanged(const Renderer::ImagePrecision precision)
+{
+    if (precision == Renderer::ImagePrecision::Float16)
+        mHalfPrecisionAction->setChecked(true);
+    else
+        mFullPrecisionAction->setChecked(true);
+}
+
 MainMenu::~MainMenu()
 {
     foreach (auto& action, mCreateNodeActions)
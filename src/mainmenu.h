@@ -22,6 +22,8 @@
 
 #include <QMenuBar>
 
+#include "renderer/imageprecision.h"
+
 //#include "nodegraph/nodegraphutility.h"
 
 namespace Cascade {
@@ -37,6 +39,9 @@ public:
 
     ~MainMenu();
 
+public slots:
+    void handleImagePrecisionChanged(const Cascade::Renderer::ImagePrecision precision);
+
 private:
     QMenu* mFileMenu;
     QMenu* mEditMenu;
@@ -47,6 +52,8 @@ private:
     QAction* mOpenProjectAction;
     QAction* mSaveProjectAction;
     QAction* mSaveProjectAsAction;
+    QAction* mFullPrecisionAction;
+    QAction* mHalfPrecisionAction;
     QAction* mExitAction;
     QAction* mPreferencesAction;
     QAction* mToggleNodeGraphAction;
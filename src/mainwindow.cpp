@@ -79,6 +79,14 @@ MainWindow::MainWindow(QWidget* parent)
     mDockManager->addDockWidget(
         DockWidgetArea::RightDockWidgetArea, mPropertiesWindowDockWidget, centralDockArea);
 
+    // Profiling only runs while this is open
+    mGpuProfilerView       = new GpuProfilerView();
+    mGpuProfilerDockWidget = new CDockWidget("GPU Profiler");
+    mGpuProfilerDockWidget->setWidget(mGpuProfilerView);
+    mDockManager->addDockWidgetTabToArea(
+        mGpuProfilerDockWidget, mPropertiesWindowDockWidget->dockAreaWidget());
+    mGpuProfilerDockWidget->toggleView(false);
+
     // TODO: Move into dispatch
     connect(
         mNodeGraph,
@@ -97,12 +105,17 @@ MainWindow::MainWindow(QWidget* parent)
     //                mViewerStatusBar);
 
     mProjectManager = &ProjectManager::getInstance();
-    //mProjectManager->setUp(mNodeGraph);
+    mProjectManager->setUp(mNodeGraph->getModel());
     connect(
         mProjectManager,
         &ProjectManager::projectTitleChanged,
         this,
         &MainWindow::handleProjectTitleChanged);
+    connect(
+        mProjectManager,
+        &ProjectManager::imagePrecisionChanged,
+        mMainMenu,
+        &MainMenu::handleImagePrecisionChanged);
 
     mPreferencesManager = &PreferencesManager::getInstance();
     mPreferencesManager->setUp();
@@ -158,7 +171,47 @@ void MainWindow::handleRendererHasBeenCreated()
     // We are waiting for the renderer to be fully
     // initialized here before using it
     mRenderManager = &RenderManager::getInstance();
-    //mRenderManager->setUp(mVulkanView->getVulkanWindow()->getRenderer(), mNodeGraph);
+    mRenderManager->setUp(mVulkanView->getVulkanWindow()->getRenderer(), mNodeGraph->getModel());
+
+    connect(
+        mVulkanView->getVulkanWindow(),
+        &VulkanWindow::viewChanged,
+        mRenderManager,
+        &RenderManager::handleViewChanged);
+
+    mRenderManager->setProxyScale(mViewerStatusBar->getProxyScale());
+    connect(
+        mViewerStatusBar,
+        &ViewerStatusBar::proxyScaleChanged,
+        mRenderManager,
+        &RenderManager::setProxyScale);
+
+    // The project may have been loaded before the renderer existed
+    mRenderManager->setImagePrecision(mProjectManager->getImagePrecision());
+    connect(
+        mProjectManager,
+        &ProjectManager::imagePrecisionChanged,
+        mRenderManager,
+        &RenderManager::setImagePrecision);
+
+    connect(
+        mGpuProfilerDockWidget,
+        &CDockWidget::viewToggled,
+        mRenderManager,
+        &RenderManager::setGpuProfiling);
+    connect(
+        mRenderManager,
+        &RenderManager::gpuTimingsChanged,
+        mGpuProfilerView,
+        &GpuProfilerView::handleGpuTimingsChanged);
+    mRenderManager->setGpuProfiling(!mGpuProfilerDockWidget->isClosed());
+
+    connect(
+        mNodeGraph,
+        &NodeGraphView::costHeatmapToggled,
+        mRenderManager,
+        &RenderManager::setCostHeatmap);
+    mRenderManager->setCostHeatmap(mNodeGraph->costHeatmapAction()->isChecked());
 
     this->statusBar()->showMessage(
         "GPU: " + mVulkanView->getVulkanWindow()->getRenderer()->getGpuName());
@@ -206,6 +259,11 @@ void MainWindow::handleSaveProjectAsAction()
     mProjectManager->saveProjectAs();
 }
 
+void MainWindow::handleImagePrecisionAction(const Renderer::ImagePrecision precision)
+{
+    mProjectManager->setImagePrecision(precision);
+}
+
 void MainWindow::handleExitAction()
 {
     // Using this instead of QApplication::quit(),
@@ -229,6 +287,9 @@ void MainWindow::closeEvent(QCloseEvent* event)
 {
     emit requestShutdown();
 
+    if (mRenderManager)
+        mRenderManager->shutdown();
+
     mVulkanView->getVulkanWindow()->getRenderer()->shutdown();
 
     QMainWindow::closeEvent(event);
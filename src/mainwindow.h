@@ -39,6 +39,7 @@
 #include "isfmanager.h"
 #include "inputhandler.h"
 #include "dispatch.h"
+#include "gpuprofilerview.h"
 #include "properties/propertieswindow.h"
 
 #include "nodegraph/nodegraphview.h"
@@ -66,6 +67,7 @@ public:
 
     ads::CDockWidget* mNodeGraphDockWidget;
     ads::CDockWidget* mPropertiesWindowDockWidget;
+    ads::CDockWidget* mGpuProfilerDockWidget;
 
     //NodeGraph* getNodeGraph() const;
 
@@ -77,9 +79,10 @@ private:
     NodeGraphView* mNodeGraph;
     PropertiesWindow* mPropertiesWindow;
     ViewerStatusBar* mViewerStatusBar;
+    GpuProfilerView* mGpuProfilerView;
 
     WindowManager* mWindowManager;
-    RenderManager* mRenderManager;
+    RenderManager* mRenderManager = nullptr;
     ProjectManager* mProjectManager;
     PreferencesManager* mPreferencesManager;
     ISFManager* mIsfManager;
@@ -104,6 +107,7 @@ public slots:
     void handleOpenProjectAction();
     void handleSaveProjectAction();
     void handleSaveProjectAsAction();
+    void handleImagePrecisionAction(const Cascade::Renderer::ImagePrecision precision);
     void handleExitAction();
     void handlePreferencesAction();
     void handleAboutAction();
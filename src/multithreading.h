@@ -6,6 +6,8 @@
 #include <OpenColorIO/OpenColorIO.h>
 #include <OpenImageIO/imagebuf.h>
 
+#include "renderer/imageprecision.h"
+
 // Prevent tbb emit() from clashing with Qt. Wtf.
 #ifndef Q_MOC_RUN
 #if defined(emit)
@@ -23,12 +25,12 @@ using tbb::blocked_range;
 
 namespace Cascade {
 
-void copyRow(const float* source, float* dst, size_t width, size_t i)
+inline void copyRow(const float* source, float* dst, size_t width, size_t i)
 {
     memcpy(dst + i * width, source + i * width, width * 4);
 }
 
-void parallelArrayCopy(const float* src, float* dst, size_t width, size_t height)
+inline void parallelArrayCopy(const float* src, float* dst, size_t width, size_t height)
 {
 
     parallel_for(blocked_range<size_t>(0, height * 4),
@@ -42,7 +44,45 @@ void parallelArrayCopy(const float* src, float* dst, size_t width, size_t height
 
 }
 
-void applyColorToScanline(
+inline void parallelHalfToFloat(const uint16_t* src, float* dst, size_t numValues)
+{
+    parallel_for(blocked_range<size_t>(0, numValues),
+        [=](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i = r.begin(); i!=r.end(); ++i)
+        {
+            dst[i] = Renderer::halfToFloat(src[i]);
+        }
+    });
+}
+
+inline void parallelFloatToHalf(const float* src, uint16_t* dst, size_t numValues)
+{
+    parallel_for(blocked_range<size_t>(0, numValues),
+        [=](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i = r.begin(); i!=r.end(); ++i)
+        {
+            dst[i] = Renderer::floatToHalf(src[i]);
+        }
+    });
+}
+
+// Sets the fourth value of every RGBA pixel, e.g. after decoding RGB
+template <typename T>
+inline void parallelFillAlpha(T* pixels, size_t numPixels, const T alpha)
+{
+    parallel_for(blocked_range<size_t>(0, numPixels),
+        [=](const tbb::blocked_range<size_t>& r)
+    {
+        for(size_t i = r.begin(); i!=r.end(); ++i)
+        {
+            pixels[i * 4 + 3] = alpha;
+        }
+    });
+}
+
+inline void applyColorToScanline(
         OCIO::ConstCPUProcessorRcPtr processor,
         float* pStart,
         int idx,
@@ -56,7 +96,7 @@ void applyColorToScanline(
     processor->apply(desc);
 }
 
-void parallelApplyColorSpace(
+inline void parallelApplyColorSpace(
         OCIO::ConstConfigRcPtr ocioConfig,
         const QString& sourceColor,
         const QString& dstColor,
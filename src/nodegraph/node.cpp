@@ -56,6 +56,15 @@ Node::Node(std::unique_ptr<NodeDataModel>&& dataModel)
 {
     mNodeGeometry.recalculateSize();
 
+    mNodeDataModel->connectProperties();
+
+    connect(mNodeDataModel.get(), &NodeDataModel::propertyChanged,
+            this, &Node::onPropertyChanged);
+    connect(mNodeDataModel.get(), &NodeDataModel::interactionStarted,
+            this, &Node::interactionStarted);
+    connect(mNodeDataModel.get(), &NodeDataModel::interactionFinished,
+            this, &Node::interactionFinished);
+
     // propagate data: model => node
     //    connect(mNodeDataModel.get(), &NodeDataModel::dataUpdated,
     //            this, &Node::onDataUpdated);
@@ -167,7 +176,7 @@ PropertyWidget* Node::propertyWidget()
     if (!mPropertyWidget)
     {
         mPropertyWidget = new PropertyWidget();
-        mPropertyWidget->addPropertyViews(mNodeDataModel->getPropertyViews());
+        mPropertyWidget->addProperties(mNodeDataModel->getPropertyModels());
     }
     return mPropertyWidget;
 }
@@ -202,6 +211,26 @@ std::set<Node*> Node::getNodesBelow()
     return nodes;
 }
 
+std::set<Node*> Node::getAllNodesBelow()
+{
+    std::set<Node*> nodes;
+
+    std::vector<Node*> stack = { this };
+
+    while (!stack.empty())
+    {
+        Node* current = stack.back();
+        stack.pop_back();
+
+        for (auto& node : current->getNodesBelow())
+        {
+            if (nodes.insert(node).second)
+                stack.push_back(node);
+        }
+    }
+    return nodes;
+}
+
 bool Node::isRoot() const
 {
     for (unsigned int i = 0; i < mNodeDataModel->nPorts(PortType::In); ++i)
@@ -236,7 +265,7 @@ void Node::view(const ViewerMode viewerMode)
 
     if (viewerMode == ViewerMode::Result)
     {
-        //render();
+        render();
     }
 }
 
@@ -252,9 +281,72 @@ void Node::setIsViewed(const bool viewed)
     mNodeGraphicsObject->update();
 }
 
+bool Node::getIsDirty() const
+{
+    return mIsDirty;
+}
+
+void Node::setIsDirty(const bool dirty)
+{
+    mIsDirty = dirty;
+}
+
+double Node::getGpuTime() const
+{
+    return mGpuTime;
+}
+
+void Node::setGpuTime(const double milliseconds)
+{
+    mGpuTime = milliseconds;
+
+    mNodeGraphicsObject->update();
+}
+
+double Node::getCpuTime() const
+{
+    return mCpuTime;
+}
+
+void Node::setCpuTime(const double milliseconds)
+{
+    mCpuTime = milliseconds;
+}
+
+double Node::getHeat() const
+{
+    return mHeat;
+}
+
+bool Node::getIsOnCriticalPath() const
+{
+    return mIsOnCriticalPath;
+}
+
+void Node::setHeat(const double heat, const bool isOnCriticalPath)
+{
+    if (heat == mHeat && isOnCriticalPath == mIsOnCriticalPath)
+        return;
+
+    mHeat = heat;
+    mIsOnCriticalPath = isOnCriticalPath;
+
+    mNodeGraphicsObject->update();
+}
+
+void Node::invalidate()
+{
+    setIsDirty(true);
+
+    for (auto& node : getAllNodesBelow())
+    {
+        node->setIsDirty(true);
+    }
+}
+
 void Node::render()
 {
-    mNodeDataModel->getRenderTask()->execute();
+    emit renderRequested(this);
 }
 
 void Node::propagateData(
@@ -281,6 +373,27 @@ void Node::onDataUpdated(PortIndex index)
         c.second->propagateData(nodeData);
 }
 
+void Node::onPropertyChanged()
+{
+    invalidate();
+
+    // Only re-render if the change is visible in the viewer
+    if (mIsViewed)
+    {
+        render();
+        return;
+    }
+
+    for (auto& node : getAllNodesBelow())
+    {
+        if (node->getIsViewed())
+        {
+            node->render();
+            return;
+        }
+    }
+}
+
 void Node::onNodeSizeUpdated()
 {
     nodeGeometry().recalculateSize();
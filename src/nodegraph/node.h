@@ -98,6 +98,9 @@ public:
     // Get the nodes connected directly below this one
     std::set<Node*> getNodesBelow();
 
+    // Get all nodes that depend on this one
+    std::set<Node*> getAllNodesBelow();
+
     bool isRoot() const;
 
     bool isLeaf() const;
@@ -108,8 +111,44 @@ public:
 
     void setIsViewed(const bool viewed);
 
+    // A dirty node needs to be executed before its result can be used
+    bool getIsDirty() const;
+
+    void setIsDirty(const bool dirty);
+
+    // Marks this node and everything below it as dirty
+    void invalidate();
+
+    // How long the last execution took on the GPU,
+    // negative if it wasn't profiled
+    double getGpuTime() const;
+
+    void setGpuTime(const double milliseconds);
+
+    // How long recording and submitting the last execution took,
+    // negative if it wasn't measured
+    double getCpuTime() const;
+
+    void setCpuTime(const double milliseconds);
+
+    // Cost relative to the most expensive node, from 0 to 1,
+    // negative if there is nothing to compare yet
+    double getHeat() const;
+
+    bool getIsOnCriticalPath() const;
+
+    void setHeat(const double heat, const bool isOnCriticalPath);
+
+    // Asks the renderer to bring this node and everything above it up to date
     void render();
 
+Q_SIGNALS:
+    void renderRequested(Cascade::NodeGraph::Node* node);
+
+    // A property of this node is being dragged
+    void interactionStarted();
+    void interactionFinished();
+
 public Q_SLOTS: // data propagation
     /// Propagates incoming data to the underlying model.
     void propagateData(
@@ -124,6 +163,9 @@ public Q_SLOTS: // data propagation
     /// update the graphic part if the size of the embeddedwidget changes
     void onNodeSizeUpdated();
 
+private Q_SLOTS:
+    void onPropertyChanged();
+
 private:
     // addressing
     QUuid mUid;
@@ -135,6 +177,14 @@ private:
 
     bool mIsViewed = false;
 
+    bool mIsDirty = true;
+
+    double mGpuTime = -1.0;
+    double mCpuTime = -1.0;
+
+    double mHeat = -1.0;
+    bool mIsOnCriticalPath = false;
+
     // painting
     NodeGeometry mNodeGeometry;
 
@@ -22,12 +22,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
+#include <QtCore/QJsonArray>
 #include <QtCore/QString>
+#include <QtCore/QVariant>
 
 #include "../properties/propertymodel.h"
+#include "../renderer/renderhash.h"
 #include "../renderer/rendertask.h"
 
 using Cascade::Properties::PropertyModel;
@@ -69,5 +73,51 @@ public:
     std::vector<QString> mOutPorts;
 
     std::vector<std::unique_ptr<PropertyModel>> mProperties;
+
+    /// Identifies the node type together with its current settings
+    uint64_t settingsHash() const
+    {
+        uint64_t hash = Cascade::Renderer::hashString(mName);
+        for (auto& prop : mProperties)
+        {
+            hash = prop->getData()->hash(hash);
+        }
+        return hash;
+    }
+
+    /// Copies of the property values for the render thread,
+    /// in the order the node declares them
+    std::vector<QVariant> settings() const
+    {
+        std::vector<QVariant> values;
+        for (auto& prop : mProperties)
+        {
+            values.push_back(prop->getData()->getRenderValue());
+        }
+        return values;
+    }
+
+    /// In the order the node declares them, properties
+    /// without user editable state are stored as null
+    QJsonArray saveProperties() const
+    {
+        QJsonArray json;
+        for (auto& prop : mProperties)
+        {
+            json.append(prop->getData()->save());
+        }
+        return json;
+    }
+
+    void restoreProperties(const QJsonArray& json)
+    {
+        const auto count = std::min(
+            static_cast<size_t>(json.size()), mProperties.size());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            mProperties[i]->restore(json[static_cast<int>(i)]);
+        }
+    }
 };
 } // namespace Cascade::NodeGraph
@@ -39,12 +39,20 @@ QJsonObject NodeDataModel::save() const
 {
     QJsonObject modelJson;
 
-    //modelJson["name"] = name();
+    modelJson["name"] = name();
+
+    modelJson["properties"] = mData.saveProperties();
 
     return modelJson;
 }
 
 
+void NodeDataModel::restore(QJsonObject const& json)
+{
+    mData.restoreProperties(json["properties"].toArray());
+}
+
+
 NodeStyle const& NodeDataModel::nodeStyle() const
 {
     return mNodeStyle;
@@ -24,7 +24,6 @@
 
 #include <QtWidgets/QWidget>
 
-#include "../properties/propertyview.h"
 #include "memory.h"
 #include "nodedata.h"
 #include "nodegeometry.h"
@@ -34,7 +33,6 @@
 #include "serializable.h"
 
 using Cascade::Properties::PropertyData;
-using Cascade::Properties::PropertyView;
 
 namespace Cascade::NodeGraph
 {
@@ -91,14 +89,14 @@ public:
         return data;
     };
 
-    std::vector<PropertyView*> getPropertyViews()
+    std::vector<PropertyModel*> getPropertyModels()
     {
-        std::vector<PropertyView*> views;
+        std::vector<PropertyModel*> models;
         for (auto& prop : mData.mProperties)
         {
-            views.push_back(prop->getView());
+            models.push_back(prop.get());
         }
-        return views;
+        return models;
     }
 
     RenderTask* getRenderTask()
@@ -106,9 +104,45 @@ public:
         return mRenderTask.get();
     };
 
+    /// Hands the task over to the caller, so that it can outlive the
+    /// node until nothing is rendering with it anymore
+    std::unique_ptr<RenderTask> takeRenderTask()
+    {
+        return std::move(mRenderTask);
+    }
+
+    /// Forwards changes of all properties to propertyChanged(),
+    /// has to be called once the node data is complete
+    void connectProperties()
+    {
+        for (auto& prop : mData.mProperties)
+        {
+            connect(prop.get(), &PropertyModel::valueChanged,
+                    this, &NodeDataModel::propertyChanged);
+            connect(prop.get(), &PropertyModel::interactionStarted,
+                    this, &NodeDataModel::interactionStarted);
+            connect(prop.get(), &PropertyModel::interactionFinished,
+                    this, &NodeDataModel::interactionFinished);
+        }
+    }
+
+    /// Identifies the node type together with its current settings
+    uint64_t settingsHash()
+    {
+        return mData.settingsHash();
+    }
+
+    /// Copies of the property values for the render thread
+    std::vector<QVariant> settings() const
+    {
+        return mData.settings();
+    }
+
 public:
     QJsonObject save() const override;
 
+    void restore(QJsonObject const& json) override;
+
 public:
     unsigned int nPorts(PortType portType) const
     {
@@ -213,6 +247,12 @@ Q_SIGNALS:
 
     void computingFinished();
 
+    void propertyChanged();
+
+    void interactionStarted();
+
+    void interactionFinished();
+
 protected:
     NodeData mData;
 
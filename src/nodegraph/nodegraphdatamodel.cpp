@@ -19,6 +19,10 @@
 
 #include "nodegraphdatamodel.h"
 
+#include <algorithm>
+
+#include <QJsonArray>
+
 namespace Cascade::NodeGraph
 {
 
@@ -43,6 +47,11 @@ NodeGraphDataModel::NodeGraphDataModel(
 }
 
 NodeGraphDataModel::~NodeGraphDataModel()
+{
+    clear();
+}
+
+void NodeGraphDataModel::clear()
 {
     // Manual node cleanup. Simply clearing the holding datastructures doesn't work, the code crashes when
     // there are both nodes and connections in the scene. (The data propagation internal logic tries to propagate
@@ -130,6 +139,12 @@ std::shared_ptr<Connection> NodeGraphDataModel::restoreConnection(
     PortIndex portIndexIn  = connectionJson["in_index"].toInt();
     PortIndex portIndexOut = connectionJson["out_index"].toInt();
 
+    if (!mData->getNodes().count(nodeInId) || !mData->getNodes().count(nodeOutId))
+    {
+        CS_LOG_WARNING("Skipping connection to a node that does not exist.");
+        return nullptr;
+    }
+
     auto nodeIn  = mData->getNode(nodeInId);
     auto nodeOut = mData->getNode(nodeOutId);
 
@@ -157,6 +172,13 @@ Node& NodeGraphDataModel::createNode(std::unique_ptr<NodeDataModel>&& dataModel)
 
     node->setGraphicsObject(std::move(ngo));
 
+    connect(node.get(), &Node::renderRequested,
+            this, &NodeGraphDataModel::renderRequested);
+    connect(node.get(), &Node::interactionStarted,
+            this, &NodeGraphDataModel::interactionStarted);
+    connect(node.get(), &Node::interactionFinished,
+            this, &NodeGraphDataModel::interactionFinished);
+
     auto nodePtr = node.get();
     mData->addNode(std::move(node));
 
@@ -181,6 +203,13 @@ Node& NodeGraphDataModel::restoreNode(QJsonObject const& nodeJson)
 
     node->restore(nodeJson);
 
+    connect(node.get(), &Node::renderRequested,
+            this, &NodeGraphDataModel::renderRequested);
+    connect(node.get(), &Node::interactionStarted,
+            this, &NodeGraphDataModel::interactionStarted);
+    connect(node.get(), &Node::interactionFinished,
+            this, &NodeGraphDataModel::interactionFinished);
+
     auto nodePtr = node.get();
     mData->addNode(std::move(node));
 
@@ -229,105 +258,163 @@ std::vector<Node*> NodeGraphDataModel::allNodes() const
 {
     std::vector<Node*> nodes;
 
-//    auto nodesMap = mData->getNodes();
+    auto& nodesMap = mData->getNodes();
 
-//    std::transform(nodesMap.begin(),
-//                   nodesMap.end(),
-//                   std::back_inserter(nodes),
-//                   [](std::pair<QUuid const, std::unique_ptr<Node>> const & p) { return p.second.get(); });
+    std::transform(nodesMap.begin(),
+                   nodesMap.end(),
+                   std::back_inserter(nodes),
+                   [](std::pair<QUuid const, std::unique_ptr<Node>> const & p) { return p.second.get(); });
 
     return nodes;
 }
 
 
-void NodeGraphDataModel::iterateOverNodes( [[maybe_unused]] std::function<void(Node*)> const& visitor)
+QJsonObject NodeGraphDataModel::save() const
+{
+    QJsonObject json;
+
+    QJsonArray nodesJson;
+    for (auto const& node : mData->getNodes())
+    {
+        nodesJson.append(node.second->save());
+    }
+    json["nodes"] = nodesJson;
+
+    QJsonArray connectionsJson;
+    for (auto const& connection : mData->getConnections())
+    {
+        QJsonObject connectionJson = connection.second->save();
+
+        // Connections that are still being dragged are not stored
+        if (!connectionJson.isEmpty())
+            connectionsJson.append(connectionJson);
+    }
+    json["connections"] = connectionsJson;
+
+    return json;
+}
+
+
+void NodeGraphDataModel::load(const QJsonObject& json)
+{
+    clear();
+
+    for (const auto& nodeJson : json["nodes"].toArray())
+    {
+        const QString modelName = nodeJson.toObject()["model"].toObject()["name"].toString();
+
+        if (!registry().registeredModelCreators().count(modelName))
+        {
+            CS_LOG_WARNING("Skipping node of unknown type " + modelName + ".");
+            continue;
+        }
+        restoreNode(nodeJson.toObject());
+    }
+
+    for (const auto& connectionJson : json["connections"].toArray())
+    {
+        restoreConnection(connectionJson.toObject());
+    }
+}
+
+
+Cascade::Renderer::RenderGraph NodeGraphDataModel::createRenderGraph() const
+{
+    Cascade::Renderer::RenderGraph graph;
+
+    for (auto const& node : mData->getNodes())
+    {
+        auto model = node.second->nodeDataModel();
+
+        graph.addNode(
+            node.first,
+            model->getRenderTask(),
+            model->nPorts(PortType::In),
+            model->settingsHash(),
+            node.second->getIsDirty(),
+            model->settings());
+    }
+
+    for (auto const& connection : mData->getConnections())
+    {
+        Node* from = connection.second->getNode(PortType::Out);
+        Node* to   = connection.second->getNode(PortType::In);
+
+        // Skip connections that are still being dragged
+        if (!from || !to)
+            continue;
+
+        graph.connect(
+            graph.indexOf(from->id()),
+            graph.indexOf(to->id()),
+            connection.second->getPortIndex(PortType::In));
+    }
+
+    graph.computeHashes();
+
+    return graph;
+}
+
+void NodeGraphDataModel::updateCostHeatmap()
+{
+    auto graph = createRenderGraph();
+
+    std::vector<double> costs(graph.size(), 0.0);
+    std::vector<bool> isMeasured(graph.size(), false);
+    double maxCost = 0.0;
+
+    for (size_t i = 0; i < graph.size(); ++i)
+    {
+        const Node* node = mData->getNode(graph.getNode(i).id);
+
+        isMeasured[i] = node->getCpuTime() >= 0.0 || node->getGpuTime() >= 0.0;
+
+        costs[i] = std::max(node->getCpuTime(), 0.0) + std::max(node->getGpuTime(), 0.0);
+        maxCost = std::max(maxCost, costs[i]);
+    }
+
+    std::vector<bool> isOnCriticalPath(graph.size(), false);
+
+    if (maxCost > 0.0)
+    {
+        for (const auto index : graph.criticalPath(costs))
+            isOnCriticalPath[index] = true;
+    }
+
+    for (size_t i = 0; i < graph.size(); ++i)
+    {
+        const double heat = isMeasured[i] && maxCost > 0.0 ? costs[i] / maxCost : -1.0;
+
+        mData->getNode(graph.getNode(i).id)->setHeat(heat, isOnCriticalPath[i]);
+    }
+}
+
+void NodeGraphDataModel::iterateOverNodes(std::function<void(Node*)> const& visitor)
 {
-//    for (const auto& _node : mNodes)
-//    {
-//        visitor(_node.second.get());
-//    }
+    for (const auto& node : mData->getNodes())
+    {
+        visitor(node.second.get());
+    }
 }
 
 
-void NodeGraphDataModel::iterateOverNodeData( [[maybe_unused]] std::function<void(NodeDataModel*)> const& visitor)
+void NodeGraphDataModel::iterateOverNodeData(std::function<void(NodeDataModel*)> const& visitor)
 {
-//    for (const auto& _node : mNodes)
-//    {
-//        visitor(_node.second->nodeDataModel());
-//    }
+    for (const auto& node : mData->getNodes())
+    {
+        visitor(node.second->nodeDataModel());
+    }
 }
 
 
-void NodeGraphDataModel::iterateOverNodeDataDependentOrder( [[maybe_unused]] std::function<void(NodeDataModel*)> const& visitor)
+void NodeGraphDataModel::iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel*)> const& visitor)
 {
-//    std::set<QUuid> visitedNodesSet;
-
-//    //A leaf node is a node with no input ports, or all possible input ports empty
-//    auto isNodeLeaf =
-//        [](Node const &node, NodeDataModel const &model)
-//    {
-//        for (unsigned int i = 0; i < model.nPorts(PortType::In); ++i)
-//        {
-//            auto connections = node.nodeState().connections(PortType::In, i);
-//            if (!connections.empty())
-//            {
-//                return false;
-//            }
-//        }
-
-//        return true;
-//    };
-
-//    //Iterate over "leaf" nodes
-//    for (auto const &_node : mNodes)
-//    {
-//        auto const &node = _node.second;
-//        auto model       = node->nodeDataModel();
-
-//        if (isNodeLeaf(*node, *model))
-//        {
-//            visitor(model);
-//            visitedNodesSet.insert(node->id());
-//        }
-//    }
-
-//    auto areNodeInputsVisitedBefore =
-//        [&](Node const &node, NodeDataModel const &model)
-//    {
-//        for (size_t i = 0; i < model.nPorts(PortType::In); ++i)
-//        {
-//            auto connections = node.nodeState().connections(PortType::In, static_cast<PortIndex>(i));
-
-//            for (auto& conn : connections)
-//            {
-//                if (visitedNodesSet.find(conn.second->getNode(PortType::Out)->id()) == visitedNodesSet.end())
-//                {
-//                    return false;
-//                }
-//            }
-//        }
-
-//        return true;
-//    };
-
-//    //Iterate over dependent nodes
-//    while (mNodes.size() != visitedNodesSet.size())
-//    {
-//        for (auto const &_node : mNodes)
-//        {
-//            auto const &node = _node.second;
-//            if (visitedNodesSet.find(node->id()) != visitedNodesSet.end())
-//                continue;
-
-//            auto model = node->nodeDataModel();
-
-//            if (areNodeInputsVisitedBefore(*node, *model))
-//            {
-//                visitor(model);
-//                visitedNodesSet.insert(node->id());
-//            }
-//        }
-//    }
+    auto graph = createRenderGraph();
+
+    for (const auto index : graph.topologicalOrder())
+    {
+        visitor(mData->getNode(graph.getNode(index).id)->nodeDataModel());
+    }
 }
 
 
@@ -359,6 +446,8 @@ void NodeGraphDataModel::sendConnectionCreatedToNodes(Connection const& c)
 
     from->nodeDataModel()->outputConnectionCreated(c);
     to->nodeDataModel()->inputConnectionCreated(c);
+
+    to->invalidate();
 }
 
 void NodeGraphDataModel::sendConnectionDeletedToNodes(Connection const& c)
@@ -371,6 +460,8 @@ void NodeGraphDataModel::sendConnectionDeletedToNodes(Connection const& c)
 
     from->nodeDataModel()->outputConnectionDeleted(c);
     to->nodeDataModel()->inputConnectionDeleted(c);
+
+    to->invalidate();
 }
 
 } //namespace Cascade::NodeGraph
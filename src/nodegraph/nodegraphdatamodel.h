@@ -25,8 +25,12 @@
 #include "nodegraphdata.h"
 #include "datamodelregistry.h"
 
+#include "../renderer/rendergraph.h"
+
 #include "nodes/testnodedatamodel.h"
 #include "nodes/readnodedatamodel.h"
+#include "nodes/writenodedatamodel.h"
+#include "nodes/exposurenodedatamodel.h"
 
 #include "../log.h"
 
@@ -83,12 +87,29 @@ public:
 
     std::vector<Node*> allNodes() const;
 
+    // Nodes and connections as stored in a project file
+    QJsonObject save() const;
+
+    // Replaces the current graph with the one from a project file
+    void load(const QJsonObject& json);
+
+    void clear();
+
+    // Snapshot of the current graph for the renderer
+    Cascade::Renderer::RenderGraph createRenderGraph() const;
+
+    // Rates every node by its measured CPU and GPU time
+    // and marks the most expensive chain through the graph
+    void updateCostHeatmap();
+
 private:
     std::unique_ptr<DataModelRegistry> registerDataModels()
     {
         auto ret = std::make_unique<DataModelRegistry>();
         ret->registerModel<TestNodeDataModel>("Test");
         ret->registerModel<ReadNodeDataModel>("Read");
+        ret->registerModel<WriteNodeDataModel>("Write");
+        ret->registerModel<ExposureNodeDataModel>("Exposure");
 
         return ret;
     }
@@ -109,6 +130,12 @@ signals:
 
     void nodeDeleted(Cascade::NodeGraph::Node &n);
 
+    void renderRequested(Cascade::NodeGraph::Node* n);
+
+    void interactionStarted();
+
+    void interactionFinished();
+
 private slots:
     void setupConnectionSignals(Cascade::NodeGraph::Connection const& c);
 
@@ -77,6 +77,18 @@ QSizeF NodeGraphScene::getNodeSize(const Node& node) const
     return QSizeF(node.nodeGeometry().width(), node.nodeGeometry().height());
 }
 
+bool NodeGraphScene::isCostHeatmapShown() const
+{
+    return mIsCostHeatmapShown;
+}
+
+void NodeGraphScene::setCostHeatmapShown(const bool shown)
+{
+    mIsCostHeatmapShown = shown;
+
+    update();
+}
+
 std::vector<Node*> NodeGraphScene::selectedNodes() const
 {
     QList<QGraphicsItem*> graphicsItems = selectedItems();
@@ -60,6 +60,11 @@ public:
 
     QSizeF getNodeSize(Node const& node) const;
 
+    // Nodes are tinted by how expensive they are to render
+    bool isCostHeatmapShown() const;
+
+    void setCostHeatmapShown(const bool shown);
+
 public:
     void clearScene();
 
@@ -119,6 +124,8 @@ private:
     std::unordered_map<QUuid, SharedConnection> mConnections;
     std::unordered_map<QUuid, UniqueNode> mNodes;
 
+    bool mIsCostHeatmapShown = false;
+
 private Q_SLOTS:
     //void setupConnectionSignals(Cascade::NodeGraph::Connection const& c);
 
@@ -54,6 +54,7 @@ NodeGraphView::NodeGraphView(QWidget* parent)
     : QGraphicsView(parent)
     , mClearSelectionAction(Q_NULLPTR)
     , mDeleteSelectionAction(Q_NULLPTR)
+    , mCostHeatmapAction(Q_NULLPTR)
     , mScene(Q_NULLPTR)
 {
     setDragMode(QGraphicsView::RubberBandDrag);
@@ -78,6 +79,8 @@ NodeGraphView::NodeGraphView(QWidget* parent)
     setModel(std::make_unique<NodeGraphDataModel>(mScene));
 
     mContextMenu = new ContextMenu(mModel.get(), scene, this);
+    mContextMenu->addSeparator();
+    mContextMenu->addAction(mCostHeatmapAction);
 
     scale(0.75, 0.75);
 
@@ -94,6 +97,11 @@ QAction* NodeGraphView::deleteSelectionAction() const
     return mDeleteSelectionAction;
 }
 
+QAction* NodeGraphView::costHeatmapAction() const
+{
+    return mCostHeatmapAction;
+}
+
 void NodeGraphView::setScene(NodeGraphScene* scene)
 {
     mScene = scene;
@@ -111,6 +119,16 @@ void NodeGraphView::setScene(NodeGraphScene* scene)
     mDeleteSelectionAction->setShortcut(Qt::Key_Delete);
     connect(mDeleteSelectionAction, &QAction::triggered, this, &NodeGraphView::deleteSelectedNodes);
     addAction(mDeleteSelectionAction);
+
+    delete mCostHeatmapAction;
+    mCostHeatmapAction = new QAction(QStringLiteral("Cost Heatmap"), this);
+    mCostHeatmapAction->setCheckable(true);
+    connect(mCostHeatmapAction, &QAction::toggled, this, [this](const bool checked)
+    {
+        mScene->setCostHeatmapShown(checked);
+        emit costHeatmapToggled(checked);
+    });
+    addAction(mCostHeatmapAction);
 }
 
 NodeGraphDataModel* NodeGraphView::getModel() const
@@ -50,6 +50,9 @@ public:
 
     QAction* deleteSelectionAction() const;
 
+    // Checkable, tints the nodes by their render cost
+    QAction* costHeatmapAction() const;
+
     void setScene(NodeGraphScene* scene);
 
     NodeGraphDataModel* getModel() const;
@@ -58,6 +61,8 @@ public:
 signals:
     void activeNodeChanged(Cascade::NodeGraph::Node* node);
 
+    void costHeatmapToggled(const bool shown);
+
 public slots:
     void scaleUp();
 
@@ -104,6 +109,7 @@ private:
 
     QAction* mClearSelectionAction;
     QAction* mDeleteSelectionAction;
+    QAction* mCostHeatmapAction;
 
     QPointF mMiddleClickPos;
 
@@ -22,6 +22,7 @@
 
 #include "nodepainter.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <QtCore/QMargins>
@@ -56,7 +57,7 @@ void NodePainter::paint(QPainter* painter, Node& node, NodeGraphScene const& sce
     //--------------------------------------------
     NodeDataModel const* model = node.nodeDataModel();
 
-    drawNodeRect(painter, node, geom, model, graphicsObject);
+    drawNodeRect(painter, node, geom, model, graphicsObject, scene);
 
     drawConnectionPoints(painter, geom, state, model, scene);
 
@@ -70,6 +71,8 @@ void NodePainter::paint(QPainter* painter, Node& node, NodeGraphScene const& sce
 
     drawValidationRect(painter, geom, model, graphicsObject);
 
+    drawGpuTime(painter, node, geom, model);
+
     /// call custom painter
     if (auto painterDelegate = model->painterDelegate())
     {
@@ -77,37 +80,69 @@ void NodePainter::paint(QPainter* painter, Node& node, NodeGraphScene const& sce
     }
 }
 
+// Blue for the cheapest nodes over green and yellow to red
+static QColor heatColor(const double heat)
+{
+    return QColor::fromHsvF((1.0 - std::clamp(heat, 0.0, 1.0)) * 240.0 / 360.0, 0.85, 0.9);
+}
+
+static QColor mixColors(const QColor& a, const QColor& b, const double t)
+{
+    return QColor::fromRgbF(
+        a.redF() + (b.redF() - a.redF()) * t,
+        a.greenF() + (b.greenF() - a.greenF()) * t,
+        a.blueF() + (b.blueF() - a.blueF()) * t,
+        a.alphaF() + (b.alphaF() - a.alphaF()) * t);
+}
+
 void NodePainter::drawNodeRect(
     QPainter* painter,
     Node& node,
     NodeGeometry const& geom,
     NodeDataModel const* model,
-    NodeGraphicsObject const& graphicsObject)
+    NodeGraphicsObject const& graphicsObject,
+    NodeGraphScene const& scene)
 {
     NodeStyle const& nodeStyle = model->nodeStyle();
 
+    const bool isHeatShown = scene.isCostHeatmapShown() && node.getHeat() >= 0.0;
+
     auto color = graphicsObject.isSelected() ? nodeStyle.SelectedBoundaryColor
                                              : nodeStyle.NormalBoundaryColor;
 
     color = node.getIsViewed() ? nodeStyle.ViewedBoundaryColor : color;
 
-    if (geom.hovered())
-    {
-        QPen p(color, nodeStyle.HoveredPenWidth);
-        painter->setPen(p);
-    }
-    else
+    double penWidth = geom.hovered() ? nodeStyle.HoveredPenWidth : nodeStyle.PenWidth;
+
+    // Selection and the viewed node still win over the critical path
+    if (isHeatShown && node.getIsOnCriticalPath())
     {
-        QPen p(color, nodeStyle.PenWidth);
-        painter->setPen(p);
+        if (!graphicsObject.isSelected() && !node.getIsViewed())
+            color = heatColor(1.0);
+
+        penWidth = nodeStyle.HoveredPenWidth * 2.0;
     }
 
+    painter->setPen(QPen(color, penWidth));
+
     QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, geom.height()));
 
-    gradient.setColorAt(0.0, nodeStyle.GradientColor0);
-    gradient.setColorAt(0.03, nodeStyle.GradientColor1);
-    gradient.setColorAt(0.97, nodeStyle.GradientColor2);
-    gradient.setColorAt(1.0, nodeStyle.GradientColor3);
+    if (isHeatShown)
+    {
+        const QColor heat = heatColor(node.getHeat());
+
+        gradient.setColorAt(0.0, mixColors(nodeStyle.GradientColor0, heat, 0.6));
+        gradient.setColorAt(0.03, mixColors(nodeStyle.GradientColor1, heat, 0.6));
+        gradient.setColorAt(0.97, mixColors(nodeStyle.GradientColor2, heat, 0.6));
+        gradient.setColorAt(1.0, mixColors(nodeStyle.GradientColor3, heat, 0.6));
+    }
+    else
+    {
+        gradient.setColorAt(0.0, nodeStyle.GradientColor0);
+        gradient.setColorAt(0.03, nodeStyle.GradientColor1);
+        gradient.setColorAt(0.97, nodeStyle.GradientColor2);
+        gradient.setColorAt(1.0, nodeStyle.GradientColor3);
+    }
 
     painter->setBrush(gradient);
 
@@ -357,3 +392,29 @@ void NodePainter::drawValidationRect(
         painter->drawText(position, errorMsg);
     }
 }
+
+void NodePainter::drawGpuTime(
+    QPainter* painter,
+    Node& node,
+    NodeGeometry const& geom,
+    NodeDataModel const* model)
+{
+    if (node.getGpuTime() < 0.0)
+        return;
+
+    NodeStyle const& nodeStyle = model->nodeStyle();
+
+    QString const text = QString::number(node.getGpuTime(), 'f', 2) + " ms";
+
+    QFontMetrics metrics(painter->font());
+
+    auto rect = metrics.boundingRect(text);
+
+    // Below the node, still inside of its bounding rect
+    QPointF position(
+        (geom.width() - rect.width()) / 2.0,
+        geom.height() + nodeStyle.ConnectionPointDiameter + metrics.ascent());
+
+    painter->setPen(nodeStyle.FontColorFaded);
+    painter->drawText(position, text);
+}
@@ -48,7 +48,8 @@ public:
         Node& node,
         NodeGeometry const& geom,
         NodeDataModel const* model,
-        NodeGraphicsObject const& graphicsObject);
+        NodeGraphicsObject const& graphicsObject,
+        NodeGraphScene const& scene);
 
     static void drawModelName(
         QPainter* painter,
@@ -85,5 +86,11 @@ public:
         NodeGeometry const& geom,
         NodeDataModel const* model,
         NodeGraphicsObject const& graphicsObject);
+
+    static void drawGpuTime(
+        QPainter* painter,
+        Node& node,
+        NodeGeometry const& geom,
+        NodeDataModel const* model);
 };
 } // namespace Cascade::NodeGraph
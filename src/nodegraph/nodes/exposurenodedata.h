@@ -0,0 +1,60 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXPOSURENODEDATA_H
+#define EXPOSURENODEDATA_H
+
+#include "../../properties/intpropertymodel.h"
+#include "../../properties/propertydata.h"
+#include "../../properties/titlepropertymodel.h"
+#include "../nodedata.h"
+
+using Cascade::Properties::IntPropertyData;
+using Cascade::Properties::IntPropertyModel;
+using Cascade::Properties::TitlePropertyData;
+using Cascade::Properties::TitlePropertyModel;
+
+namespace Cascade::NodeGraph
+{
+
+class ExposureNodeData : public NodeData
+{
+public:
+    ExposureNodeData()
+    {
+        mCaption = "Exposure Node";
+
+        mName = "Exposure";
+
+        mInPorts = {"Source"};
+
+        mOutPorts = {"Result"};
+
+        mProperties.push_back(
+            std::make_unique<TitlePropertyModel>(TitlePropertyData(mCaption.toUpper())));
+
+        // In hundredths of a stop, read by RenderTaskExposure
+        mProperties.push_back(
+            std::make_unique<IntPropertyModel>(IntPropertyData("Exposure", -1000, 1000, 1, 0)));
+    }
+};
+
+} // namespace Cascade::NodeGraph
+
+#endif // EXPOSURENODEDATA_H
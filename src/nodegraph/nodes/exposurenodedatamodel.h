@@ -0,0 +1,51 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXPOSURENODEDATAMODEL_H
+#define EXPOSURENODEDATAMODEL_H
+
+#include <QObject>
+
+#include "../../renderer/rendertaskexposure.h"
+#include "../nodedatamodel.h"
+#include "exposurenodedata.h"
+
+using Cascade::Renderer::RenderTaskExposure;
+
+namespace Cascade::NodeGraph
+{
+
+class ExposureNodeDataModel : public NodeDataModel
+{
+    Q_OBJECT
+
+public:
+    ExposureNodeDataModel()
+    {
+        mData = ExposureNodeData();
+
+        mRenderTask = std::make_unique<RenderTaskExposure>();
+    }
+
+    virtual ~ExposureNodeDataModel() {}
+};
+
+} // namespace Cascade::NodeGraph
+
+#endif // EXPOSURENODEDATAMODEL_H
@@ -0,0 +1,64 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef READNODEDATA_H
+#define READNODEDATA_H
+
+#include "../../properties/filespropertymodel.h"
+#include "../../properties/propertydata.h"
+#include "../../properties/titlepropertymodel.h"
+#include "../nodedata.h"
+
+using Cascade::Properties::FilesPropertyData;
+using Cascade::Properties::FilesPropertyModel;
+using Cascade::Properties::TitlePropertyData;
+using Cascade::Properties::TitlePropertyModel;
+
+namespace Cascade::NodeGraph
+{
+
+class ReadNodeData : public NodeData
+{
+public:
+    ReadNodeData()
+    {
+        mCaption = "Read Node";
+
+        mName = "Read";
+
+        mInPorts = {};
+
+        mOutPorts = {"Result"};
+
+        mProperties.push_back(
+            std::make_unique<TitlePropertyModel>(TitlePropertyData(mCaption.toUpper())));
+
+        mProperties.push_back(std::make_unique<FilesPropertyModel>(FilesPropertyData()));
+    }
+
+    // Node data is stored as the base class, this reads it back
+    static QStringList getFiles(const NodeData& data)
+    {
+        return static_cast<FilesPropertyData*>(data.mProperties.at(1)->getData())->getFiles()->stringList();
+    }
+};
+
+} // namespace Cascade::NodeGraph
+
+#endif // READNODEDATA_H
@@ -22,47 +22,15 @@
 
 #include <QObject>
 
-#include <QLabel>
-
-#include "../../properties/filespropertymodel.h"
-#include "../../properties/propertydata.h"
-#include "../../properties/titlepropertymodel.h"
 #include "../../renderer/rendertaskread.h"
-#include "../nodedata.h"
 #include "../nodedatamodel.h"
-
-using Cascade::Properties::FilesPropertyData;
-using Cascade::Properties::FilesPropertyModel;
-using Cascade::Properties::PropertyData;
-using Cascade::Properties::TitlePropertyData;
+#include "readnodedata.h"
 
 using Cascade::Renderer::RenderTaskRead;
 
 namespace Cascade::NodeGraph
 {
 
-class ReadNodeData : public NodeData
-{
-public:
-    ReadNodeData()
-    {
-        mCaption = "Read Node";
-
-        mName = "Read";
-
-        mInPorts = {};
-
-        mOutPorts = {"Result"};
-
-        mProperties.push_back(
-            std::make_unique<TitlePropertyModel>(TitlePropertyData(mCaption.toUpper())));
-
-        mProperties.push_back(std::make_unique<FilesPropertyModel>(FilesPropertyData()));
-    }
-};
-
-//------------------------------------------------------------------------------
-
 class ReadNodeDataModel : public NodeDataModel
 {
     Q_OBJECT
@@ -24,49 +24,12 @@
 
 #include <QObject>
 
-#include <QLabel>
-
-#include "../../properties/intpropertymodel.h"
-#include "../../properties/propertydata.h"
-#include "../../properties/titlepropertymodel.h"
-#include "../nodedata.h"
 #include "../nodedatamodel.h"
-
-using Cascade::Properties::IntPropertyData;
-using Cascade::Properties::IntPropertyModel;
-using Cascade::Properties::PropertyData;
-using Cascade::Properties::TitlePropertyData;
-using Cascade::Properties::TitlePropertyModel;
+#include "testnodedata.h"
 
 namespace Cascade::NodeGraph
 {
 
-class TestNodeData : public NodeData
-{
-public:
-    TestNodeData()
-    {
-        mCaption = "Test Node";
-
-        mName = "TestNode";
-
-        mInPorts = {"RGBA Back", "RGBA Front"};
-
-        mOutPorts = {"Result"};
-
-        mProperties.push_back(
-            std::make_unique<TitlePropertyModel>(TitlePropertyData(mCaption.toUpper())));
-
-        mProperties.push_back(
-            std::make_unique<IntPropertyModel>(IntPropertyData("Test int", 0, 100, 1, 40)));
-
-        mProperties.push_back(
-            std::make_unique<IntPropertyModel>(IntPropertyData("Test int", 0, 100, 1, 40)));
-    }
-};
-
-//------------------------------------------------------------------------------
-
 class TestNodeDataModel : public NodeDataModel
 {
     Q_OBJECT
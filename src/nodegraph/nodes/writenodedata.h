@@ -0,0 +1,77 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef WRITENODEDATA_H
+#define WRITENODEDATA_H
+
+#include "../../properties/intpropertymodel.h"
+#include "../../properties/propertydata.h"
+#include "../../properties/textpropertymodel.h"
+#include "../../properties/titlepropertymodel.h"
+#include "../nodedata.h"
+
+using Cascade::Properties::IntPropertyData;
+using Cascade::Properties::IntPropertyModel;
+using Cascade::Properties::TextPropertyData;
+using Cascade::Properties::TextPropertyModel;
+using Cascade::Properties::TitlePropertyData;
+using Cascade::Properties::TitlePropertyModel;
+
+namespace Cascade::NodeGraph
+{
+
+class WriteNodeData : public NodeData
+{
+public:
+    WriteNodeData()
+    {
+        mCaption = "Write Node";
+
+        mName = "Write";
+
+        mInPorts = {"Source"};
+
+        mOutPorts = {};
+
+        mProperties.push_back(
+            std::make_unique<TitlePropertyModel>(TitlePropertyData(mCaption.toUpper())));
+
+        mProperties.push_back(
+            std::make_unique<TextPropertyModel>(TextPropertyData("Path")));
+
+        // Index into Renderer::colorSpaces
+        mProperties.push_back(
+            std::make_unique<IntPropertyModel>(IntPropertyData("Color Space", 0, 11, 1, 0)));
+    }
+
+    // Node data is stored as the base class, these read it back
+    static QString getPath(const NodeData& data)
+    {
+        return static_cast<TextPropertyData*>(data.mProperties.at(1)->getData())->getValue();
+    }
+
+    static int getColorSpace(const NodeData& data)
+    {
+        return static_cast<IntPropertyData*>(data.mProperties.at(2)->getData())->getValue();
+    }
+};
+
+} // namespace Cascade::NodeGraph
+
+#endif // WRITENODEDATA_H
@@ -0,0 +1,175 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "projectgraph.h"
+
+#include <functional>
+#include <map>
+
+#include <QJsonArray>
+
+#include "../log.h"
+#include "../renderer/rendertaskexposure.h"
+#include "../renderer/rendertaskread.h"
+#include "../renderer/rendertaskwrite.h"
+#include "nodes/exposurenodedata.h"
+#include "nodes/readnodedata.h"
+#include "nodes/testnodedata.h"
+#include "nodes/writenodedata.h"
+
+using Cascade::Renderer::RenderTaskExposure;
+using Cascade::Renderer::RenderTaskRead;
+using Cascade::Renderer::RenderTaskWrite;
+
+namespace Cascade::NodeGraph
+{
+
+namespace
+{
+
+struct NodeType
+{
+    std::function<NodeData()> createData;
+    std::function<std::unique_ptr<RenderTask>()> createRenderTask;
+};
+
+// By the name a node is saved with, has to list the
+// same types as NodeGraphDataModel::registerDataModels()
+const std::map<QString, NodeType>& nodeTypes()
+{
+    static const std::map<QString, NodeType> types =
+    {
+        { "TestNode",
+          { []() -> NodeData { return TestNodeData(); },
+            []() -> std::unique_ptr<RenderTask> { return nullptr; } } },
+        { "Read",
+          { []() -> NodeData { return ReadNodeData(); },
+            []() -> std::unique_ptr<RenderTask> { return std::make_unique<RenderTaskRead>(); } } },
+        { "Write",
+          { []() -> NodeData { return WriteNodeData(); },
+            []() -> std::unique_ptr<RenderTask> { return std::make_unique<RenderTaskWrite>(); } } },
+        { "Exposure",
+          { []() -> NodeData { return ExposureNodeData(); },
+            []() -> std::unique_ptr<RenderTask> { return std::make_unique<RenderTaskExposure>(); } } },
+    };
+
+    return types;
+}
+
+} // namespace
+
+void ProjectGraph::load(const QJsonObject& json)
+{
+    clear();
+
+    for (const auto& nodeJson : json["nodes"].toArray())
+    {
+        const QJsonObject modelJson = nodeJson.toObject()["model"].toObject();
+        const QString modelName = modelJson["name"].toString();
+
+        const auto type = nodeTypes().find(modelName);
+        if (type == nodeTypes().end())
+        {
+            CS_LOG_WARNING("Skipping node of unknown type " + modelName + ".");
+            continue;
+        }
+
+        ProjectNode node;
+        node.data = type->second.createData();
+        node.data.restoreProperties(modelJson["properties"].toArray());
+        node.renderTask = type->second.createRenderTask();
+
+        mNodes.emplace(QUuid(nodeJson.toObject()["id"].toString()), std::move(node));
+    }
+
+    for (const auto& connectionJson : json["connections"].toArray())
+    {
+        const QJsonObject connection = connectionJson.toObject();
+
+        const QUuid from(connection["out_id"].toString());
+        const QUuid to(connection["in_id"].toString());
+
+        if (!mNodes.count(from) || !mNodes.count(to))
+        {
+            CS_LOG_WARNING("Skipping connection to a missing node.");
+            continue;
+        }
+
+        mConnections.push_back({ from, to, connection["in_index"].toInt() });
+    }
+}
+
+void ProjectGraph::clear()
+{
+    mConnections.clear();
+    mNodes.clear();
+}
+
+Cascade::Renderer::RenderGraph ProjectGraph::createRenderGraph() const
+{
+    Cascade::Renderer::RenderGraph graph;
+
+    for (const auto& node : mNodes)
+    {
+        graph.addNode(
+            node.first,
+            node.second.renderTask.get(),
+            node.second.data.mInPorts.size(),
+            node.second.data.settingsHash(),
+            node.second.isDirty,
+            node.second.data.settings());
+    }
+
+    for (const auto& connection : mConnections)
+    {
+        graph.connect(
+            graph.indexOf(connection.from),
+            graph.indexOf(connection.to),
+            connection.inputPort);
+    }
+
+    graph.computeHashes();
+
+    return graph;
+}
+
+std::vector<QUuid> ProjectGraph::getNodesOfType(const QString& name) const
+{
+    std::vector<QUuid> ids;
+
+    for (const auto& node : mNodes)
+    {
+        if (node.second.data.mName == name)
+            ids.push_back(node.first);
+    }
+
+    return ids;
+}
+
+const NodeData& ProjectGraph::getNodeData(const QUuid& id) const
+{
+    return mNodes.at(id).data;
+}
+
+void ProjectGraph::setIsDirty(const QUuid& id, const bool dirty)
+{
+    mNodes.at(id).isDirty = dirty;
+}
+
+} // namespace Cascade::NodeGraph
@@ -0,0 +1,78 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROJECTGRAPH_H
+#define PROJECTGRAPH_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QJsonObject>
+#include <QUuid>
+
+#include "../renderer/rendergraph.h"
+#include "nodedata.h"
+#include "quuidstdhash.h"
+
+namespace Cascade::NodeGraph
+{
+
+// The node graph of a project without any of the editor's
+// widgets, for rendering in processes that have no window
+class ProjectGraph
+{
+public:
+    // Reads the format written by NodeGraphDataModel::save()
+    void load(const QJsonObject& json);
+
+    void clear();
+
+    // Snapshot of the current graph for the renderer
+    Cascade::Renderer::RenderGraph createRenderGraph() const;
+
+    // Ids of all nodes of the given type, e.g. "Write"
+    std::vector<QUuid> getNodesOfType(const QString& name) const;
+
+    const NodeData& getNodeData(const QUuid& id) const;
+
+    void setIsDirty(const QUuid& id, const bool dirty);
+
+private:
+    struct ProjectNode
+    {
+        NodeData data;
+        std::unique_ptr<RenderTask> renderTask;
+        bool isDirty = true;
+    };
+
+    struct ProjectConnection
+    {
+        QUuid from;
+        QUuid to;
+        int inputPort;
+    };
+
+    std::unordered_map<QUuid, ProjectNode> mNodes;
+    std::vector<ProjectConnection> mConnections;
+};
+
+} // namespace Cascade::NodeGraph
+
+#endif // PROJECTGRAPH_H
@@ -75,6 +75,14 @@ void PreferencesManager::loadPreferences()
     QJsonObject jsonProject = prefsDocument.object();
     QJsonArray jsonPrefs = jsonProject.value("prefs").toArray();
     QJsonObject jsonGeneralHeading = jsonPrefs.at(0).toObject();
+    QJsonArray generalSettings = jsonGeneralHeading.value("general").toArray();
+
+    foreach (auto value, generalSettings)
+    {
+        auto obj = value.toObject();
+        if (obj["setting"].toString() == "Render Cache Budget (MB)")
+            mRenderCacheBudget = obj["value"].toInt(mRenderCacheBudget);
+    }
 
     QJsonObject jsonKeysHeading = jsonPrefs.at(1).toObject();
     QJsonArray jsonKeysArray = jsonKeysHeading.value("keys").toArray();
@@ -112,4 +120,9 @@ const std::vector<KeysCategory>& PreferencesManager::getKeys()
     return mKeyCategories;
 }
 
+int PreferencesManager::getRenderCacheBudget() const
+{
+    return mRenderCacheBudget;
+}
+
 } // namespace Cascade
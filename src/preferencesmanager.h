@@ -45,6 +45,9 @@ public:
 
     const std::vector<KeysCategory>& getKeys();
 
+    // How much GPU memory node outputs may take up in the render cache
+    int getRenderCacheBudget() const;
+
 private:
     PreferencesManager() {}
 
@@ -54,6 +57,8 @@ private:
             const QJsonArray& arr);
 
     std::vector<KeysCategory> mKeyCategories;
+
+    int mRenderCacheBudget = 2048;
 };
 
 } // namespace Cascade
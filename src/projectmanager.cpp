@@ -26,6 +26,7 @@
 #include <QMessageBox>
 
 #include "log.h"
+#include "nodegraph/nodegraphdatamodel.h"
 //#include "nodegraph/nodedefinitions.h"
 
 namespace Cascade {
@@ -37,6 +38,16 @@ ProjectManager& ProjectManager::getInstance()
     return instance;
 }
 
+void ProjectManager::setUp(NodeGraph::NodeGraphDataModel* model)
+{
+    mModel = model;
+
+    connect(this, &ProjectManager::requestCreateNewProject,
+            mModel, &NodeGraph::NodeGraphDataModel::clear);
+    connect(this, &ProjectManager::requestLoadProject,
+            mModel, &NodeGraph::NodeGraphDataModel::load);
+}
+
 //void ProjectManager::setUp(NodeGraph* ng)
 //{
 //    mNodeGraph = ng;
@@ -63,6 +74,8 @@ void ProjectManager::createNewProject()
 {
     if (checkIfDiscardChanges())
     {
+        setImagePrecision(Renderer::ImagePrecision::Float32);
+
         emit requestCreateNewProject();
     }
 }
@@ -110,7 +123,12 @@ void ProjectManager::loadProject()
             QJsonDocument projectDocument(QJsonDocument::fromJson(projectData));
 
             QJsonObject jsonProject = projectDocument.object();
-            QJsonArray jsonNodeGraph = jsonProject.value("nodegraph").toArray();
+            QJsonObject jsonNodeGraph = jsonProject.value("nodegraph").toObject();
+
+            // Projects saved before it was configurable are Float32
+            auto precision = Renderer::imagePrecisionFromName(
+                jsonProject.value("precision").toString());
+            setImagePrecision(precision.value_or(Renderer::ImagePrecision::Float32));
 
             emit requestLoadProject(jsonNodeGraph);
 
@@ -170,6 +188,23 @@ void ProjectManager::saveProjectAs()
     }
 }
 
+void ProjectManager::setImagePrecision(const Renderer::ImagePrecision precision)
+{
+    if (precision == mImagePrecision)
+        return;
+
+    mImagePrecision = precision;
+
+    emit imagePrecisionChanged(precision);
+
+    handleProjectIsDirty();
+}
+
+Renderer::ImagePrecision ProjectManager::getImagePrecision() const
+{
+    return mImagePrecision;
+}
+
 void ProjectManager::handleProjectIsDirty()
 {
     mProjectIsDirty = true;
@@ -205,11 +240,13 @@ void ProjectManager::writeJsonToDisk(const QJsonDocument& project,
 
 QJsonObject ProjectManager::getJsonFromNodeGraph()
 {
-    QJsonArray jsonNodeGraph;
-   // mNodeGraph->getNodeGraphAsJson(jsonNodeGraph);
+    QJsonObject jsonNodeGraph;
+    if (mModel)
+        jsonNodeGraph = mModel->save();
 
     QJsonObject jsonProject {
         { "nodegraph", jsonNodeGraph },
+        { "precision", Renderer::getImageFormatName(mImagePrecision) },
         { "cascade-version", QString("%1.%2.%3")
                     .arg(VERSION_MAJOR).arg(VERSION_MINOR).arg(VERSION_BUILD) }
 
@@ -23,8 +23,15 @@
 #include <QWidget>
 #include <QJsonDocument>
 
+#include "renderer/imageprecision.h"
+
 //#include "nodegraph/nodegraph.h"
 
+namespace Cascade::NodeGraph
+{
+    class NodeGraphDataModel;
+}
+
 namespace Cascade {
 
 class ProjectManager : public QObject
@@ -36,7 +43,7 @@ public:
     ProjectManager(ProjectManager const&) = delete;
     void operator=(ProjectManager const&) = delete;
 
-    //void setUp(NodeGraph* ng);
+    void setUp(NodeGraph::NodeGraphDataModel* model);
 
     void createStartupProject();
     void createNewProject();
@@ -44,6 +51,10 @@ public:
     void saveProject();
     void saveProjectAs();
 
+    // Saved with the project, new projects use Float32
+    void setImagePrecision(const Renderer::ImagePrecision precision);
+    Renderer::ImagePrecision getImagePrecision() const;
+
 private:
     ProjectManager() {}
     void updateProjectName();
@@ -52,18 +63,20 @@ private:
     QJsonObject getJsonFromNodeGraph();
     bool checkIfDiscardChanges();
 
-    //NodeGraph* mNodeGraph;
+    NodeGraph::NodeGraphDataModel* mModel = nullptr;
 
     QJsonDocument mProject;
     QString mCurrentProjectPath;
     QString mCurrentProject;
     bool mProjectIsDirty = true;
+    Renderer::ImagePrecision mImagePrecision = Renderer::ImagePrecision::Float32;
 
 signals:
     void projectTitleChanged(const QString& t);
     void requestCreateStartupProject();
     void requestCreateNewProject();
-    void requestLoadProject(const QJsonArray& jsonNodeGraph);
+    void requestLoadProject(const QJsonObject& jsonNodeGraph);
+    void imagePrecisionChanged(const Cascade::Renderer::ImagePrecision precision);
 
 public slots:
     void handleProjectIsDirty();
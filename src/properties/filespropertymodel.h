@@ -20,11 +20,8 @@
 #ifndef FILESPROPERTYMODEL_H
 #define FILESPROPERTYMODEL_H
 
-#include "filespropertyview.h"
 #include "propertymodel.h"
 
-using Cascade::Properties::PropertyView;
-
 namespace Cascade::Properties
 {
 
@@ -35,29 +32,24 @@ class FilesPropertyModel : public PropertyModel
 public:
     FilesPropertyModel(FilesPropertyData data)
         : mData(std::make_unique<FilesPropertyData>(data))
-    {
-        mView = new FilesPropertyView();
-        mView->setModel(this);
-    }
+    {}
 
     FilesPropertyData* getData() override
     {
         return mData.get();
     };
 
-    FilesPropertyView* getView() override
-    {
-        return mView;
-    };
-
     void addEntries(const QStringList& entries)
     {
         mData->append(entries);
+
+        emit valueChanged();
     }
 
     void removeEntry(const int index)
     {
-        mData->getFiles()->removeRows(index, 1);
+        if (mData->getFiles()->removeRows(index, 1))
+            emit valueChanged();
     }
 
     int numEntries()
@@ -67,7 +59,6 @@ public:
 
 private:
     std::unique_ptr<FilesPropertyData> mData;
-    FilesPropertyView* mView;
 };
 
 } // namespace Cascade::Properties
@@ -20,11 +20,8 @@
 #ifndef INTPROPERTYMODEL_H
 #define INTPROPERTYMODEL_H
 
-#include "intpropertyview.h"
 #include "propertymodel.h"
 
-using Cascade::Properties::IntPropertyView;
-
 namespace Cascade::Properties
 {
 
@@ -35,29 +32,25 @@ class IntPropertyModel : public PropertyModel
 public:
     IntPropertyModel(IntPropertyData data)
         : mData(std::make_unique<IntPropertyData>(data))
-    {
-        mView = new IntPropertyView();
-        mView->setModel(this);
-    }
+    {}
 
     IntPropertyData* getData() override
     {
         return mData.get();
     };
 
-    IntPropertyView* getView() override
-    {
-        return mView;
-    };
-
     void setValue(const int value)
     {
+        if (value == mData->getValue())
+            return;
+
         mData->setValue(value);
+
+        emit valueChanged();
     }
 
 private:
     std::unique_ptr<IntPropertyData> mData;
-    IntPropertyView* mView;
 };
 
 } // namespace Cascade::Properties
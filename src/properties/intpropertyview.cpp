@@ -45,6 +45,23 @@ void IntPropertyView::setModel(IntPropertyModel* model)
 {
     mModel = model;
     mSlider->setName(mModel->getData()->getName());
+    updateValue();
+
+    connect(mSlider, &Slider::valueChanged,
+            this, [this]()
+            {
+                mModel->setValue(static_cast<int>(mSlider->getValue()));
+            });
+    connect(mModel, &PropertyModel::valueRestored,
+            this, &IntPropertyView::updateValue);
+    connect(mSlider, &Slider::dragStarted,
+            mModel, &PropertyModel::interactionStarted);
+    connect(mSlider, &Slider::dragFinished,
+            mModel, &PropertyModel::interactionFinished);
+}
+
+void IntPropertyView::updateValue()
+{
     mSlider->setMinMaxStepValue(
         mModel->getData()->getMin(),
         mModel->getData()->getMax(),
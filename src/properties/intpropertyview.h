@@ -44,6 +44,9 @@ public:
 
     void setModel(IntPropertyModel* model);
 
+    // Shows the value of the model after it was changed from outside
+    void updateValue();
+
 private:
     IntPropertyModel*   mModel;
 
@@ -20,14 +20,51 @@
 #ifndef PROPERTYDATA_H
 #define PROPERTYDATA_H
 
+#include <algorithm>
+#include <memory>
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonValue>
 #include <QString>
 #include <QStringListModel>
+#include <QVariant>
+
+#include "../renderer/renderhash.h"
 
 namespace Cascade::Properties
 {
 
 class PropertyData
-{};
+{
+public:
+    virtual ~PropertyData() = default;
+
+    // Combines everything that has an influence on
+    // the rendered result into the seed
+    virtual uint64_t hash(const uint64_t seed) const
+    {
+        return seed;
+    }
+
+    // The user editable state, written to and read from project files
+    virtual QJsonValue save() const
+    {
+        return QJsonValue();
+    }
+
+    virtual void restore( [[maybe_unused]] const QJsonValue& json) {}
+
+    // A copy of the value for the render thread, which must
+    // not touch the property itself. Null if there is none.
+    virtual QVariant getRenderValue() const
+    {
+        return QVariant();
+    }
+};
 
 class TitlePropertyData : public PropertyData
 {
@@ -91,6 +128,26 @@ public:
         mValue = value;
     }
 
+    uint64_t hash(const uint64_t seed) const override
+    {
+        return Renderer::hashCombine(seed, static_cast<uint64_t>(mValue));
+    }
+
+    QJsonValue save() const override
+    {
+        return mValue;
+    }
+
+    void restore(const QJsonValue& json) override
+    {
+        mValue = std::clamp(json.toInt(mBaseValue), mMin, mMax);
+    }
+
+    QVariant getRenderValue() const override
+    {
+        return mValue;
+    }
+
 private:
     QString mName;
     int mMin;
@@ -100,12 +157,84 @@ private:
     int mBaseValue;
 };
 
+class TextPropertyData : public PropertyData
+{
+public:
+    TextPropertyData(
+        const QString& name,
+        const QString& value = QString())
+        : mName(name)
+        , mValue(value)
+    {}
+
+    QString getName() const
+    {
+        return mName;
+    }
+    QString getValue() const
+    {
+        return mValue;
+    }
+    void setValue(const QString& value)
+    {
+        mValue = value;
+    }
+
+    uint64_t hash(const uint64_t seed) const override
+    {
+        return Renderer::hashCombine(seed, Renderer::hashString(mValue));
+    }
+
+    QJsonValue save() const override
+    {
+        return mValue;
+    }
+
+    void restore(const QJsonValue& json) override
+    {
+        mValue = json.toString();
+    }
+
+    QVariant getRenderValue() const override
+    {
+        return mValue;
+    }
+
+private:
+    QString mName;
+    QString mValue;
+};
+
 class FilesPropertyData : public PropertyData
 {
 public:
     FilesPropertyData()
-        : mFiles(new QStringListModel())
-    {}
+        : mFiles(new QStringListModel()),
+          mTimes(std::make_shared<FileTimes>())
+    {
+        // Copies share the list, so they share the times as well
+        auto times = mTimes.get();
+        auto invalidate = [times]() { times->isStale = true; };
+
+        QObject::connect(mFiles, &QAbstractItemModel::dataChanged, &times->watcher, invalidate);
+        QObject::connect(mFiles, &QAbstractItemModel::rowsInserted, &times->watcher, invalidate);
+        QObject::connect(mFiles, &QAbstractItemModel::rowsRemoved, &times->watcher, invalidate);
+        QObject::connect(mFiles, &QAbstractItemModel::rowsMoved, &times->watcher, invalidate);
+        QObject::connect(mFiles, &QAbstractItemModel::modelReset, &times->watcher, invalidate);
+
+        QObject::connect(
+            &times->watcher,
+            &QFileSystemWatcher::fileChanged,
+            &times->watcher,
+            [times](const QString& file)
+            {
+                times->modified[file] = lastModified(file);
+
+                // Replacing a file removes it from the watcher
+                if (QFileInfo::exists(file))
+                    times->watcher.addPath(file);
+            });
+    }
 
     QStringListModel* getFiles() const
     {
@@ -122,8 +251,78 @@ public:
         }
     }
 
+    uint64_t hash(const uint64_t seed) const override
+    {
+        uint64_t h = seed;
+
+        const QStringList files = mFiles->stringList();
+
+        // Stat'ing every frame of a sequence for each snapshot is too
+        // slow, the times are only read again when something changed
+        if (mTimes->isStale)
+            updateTimes(files);
+
+        // The modification time makes sure that we pick up
+        // files that changed on disk under the same name
+        for (auto& file : files)
+        {
+            h = Renderer::hashCombine(h, Renderer::hashString(file));
+            h = Renderer::hashCombine(h, mTimes->modified.value(file));
+        }
+        return h;
+    }
+
+    QJsonValue save() const override
+    {
+        return QJsonArray::fromStringList(mFiles->stringList());
+    }
+
+    void restore(const QJsonValue& json) override
+    {
+        QStringList files;
+        for (const auto& file : json.toArray())
+            files.append(file.toString());
+
+        mFiles->setStringList(files);
+    }
+
+    QVariant getRenderValue() const override
+    {
+        return mFiles->stringList();
+    }
+
 private:
+    struct FileTimes
+    {
+        QFileSystemWatcher watcher;
+        QHash<QString, qint64> modified;
+        bool isStale = true;
+    };
+
+    static qint64 lastModified(const QString& file)
+    {
+        return QFileInfo(file).lastModified().toMSecsSinceEpoch();
+    }
+
+    void updateTimes(const QStringList& files) const
+    {
+        auto& times = *mTimes;
+
+        if (!times.watcher.files().isEmpty())
+            times.watcher.removePaths(times.watcher.files());
+
+        times.modified.clear();
+        for (auto& file : files)
+            times.modified.insert(file, lastModified(file));
+
+        if (!files.isEmpty())
+            times.watcher.addPaths(files);
+
+        times.isStale = false;
+    }
+
     QStringListModel* mFiles;
+    std::shared_ptr<FileTimes> mTimes;
 };
 
 } // namespace Cascade::Properties
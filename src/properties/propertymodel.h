@@ -25,7 +25,6 @@
 #include <QObject>
 
 #include "propertydata.h"
-#include "propertyview.h"
 
 namespace Cascade::Properties
 {
@@ -36,7 +35,26 @@ class PropertyModel : public QObject
 
 public:
     virtual PropertyData* getData() = 0;
-    virtual PropertyView* getView() = 0;
+
+    // Loads the state saved in a project, without emitting valueChanged()
+    void restore(const QJsonValue& json)
+    {
+        getData()->restore(json);
+
+        emit valueRestored();
+    }
+
+signals:
+    // Emitted whenever a change affects the rendered result
+    void valueChanged();
+
+    // Views, if there are any, have to show the restored value
+    void valueRestored();
+
+    // Brackets a continuous edit like dragging a slider, the
+    // values in between only have to be previewed roughly
+    void interactionStarted();
+    void interactionFinished();
 };
 
 } // namespace Cascade::Properties
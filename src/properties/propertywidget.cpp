@@ -19,6 +19,15 @@
 
 #include "propertywidget.h"
 
+#include "filespropertymodel.h"
+#include "filespropertyview.h"
+#include "intpropertymodel.h"
+#include "intpropertyview.h"
+#include "textpropertymodel.h"
+#include "textpropertyview.h"
+#include "titlepropertymodel.h"
+#include "titlepropertyview.h"
+
 namespace Cascade::Properties {
 
 PropertyWidget::PropertyWidget(QWidget *parent)
@@ -33,12 +42,43 @@ PropertyWidget::PropertyWidget(QWidget *parent)
     setLayout(mLayout);
 }
 
-void PropertyWidget::addPropertyViews(std::vector<PropertyView *> views)
+void PropertyWidget::addProperties(std::vector<PropertyModel*> models)
 {
-    for (auto& view : views)
+    for (auto& model : models)
     {
-        mLayout->addWidget(view);
+        if (auto view = createView(model))
+            mLayout->addWidget(view);
     }
 }
 
+PropertyView* PropertyWidget::createView(PropertyModel* model)
+{
+    if (auto title = qobject_cast<TitlePropertyModel*>(model))
+    {
+        auto view = new TitlePropertyView(this);
+        view->setModel(title);
+        return view;
+    }
+    if (auto files = qobject_cast<FilesPropertyModel*>(model))
+    {
+        auto view = new FilesPropertyView(this);
+        view->setModel(files);
+        return view;
+    }
+    if (auto integer = qobject_cast<IntPropertyModel*>(model))
+    {
+        auto view = new IntPropertyView(this);
+        view->setModel(integer);
+        return view;
+    }
+    if (auto text = qobject_cast<TextPropertyModel*>(model))
+    {
+        auto view = new TextPropertyView(this);
+        view->setModel(text);
+        return view;
+    }
+
+    return nullptr;
+}
+
 } //namespace Cascade::Properties
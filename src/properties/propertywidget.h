@@ -23,6 +23,7 @@
 #include <QWidget>
 #include <QVBoxLayout>
 
+#include "propertymodel.h"
 #include "propertyview.h"
 
 namespace Cascade::Properties {
@@ -34,9 +35,12 @@ class PropertyWidget : public QWidget
 public:
     explicit PropertyWidget(QWidget *parent = nullptr);
 
-    void addPropertyViews(std::vector<PropertyView*> views);
+    // Creates a view for every property of a node
+    void addProperties(std::vector<PropertyModel*> models);
 
 private:
+    PropertyView* createView(PropertyModel* model);
+
     QVBoxLayout* mLayout;
 
 };
@@ -0,0 +1,58 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEXTPROPERTYMODEL_H
+#define TEXTPROPERTYMODEL_H
+
+#include "propertymodel.h"
+
+namespace Cascade::Properties
+{
+
+class TextPropertyModel : public PropertyModel
+{
+    Q_OBJECT
+
+public:
+    TextPropertyModel(TextPropertyData data)
+        : mData(std::make_unique<TextPropertyData>(data))
+    {}
+
+    TextPropertyData* getData() override
+    {
+        return mData.get();
+    };
+
+    void setValue(const QString& value)
+    {
+        if (value == mData->getValue())
+            return;
+
+        mData->setValue(value);
+
+        emit valueChanged();
+    }
+
+private:
+    std::unique_ptr<TextPropertyData> mData;
+};
+
+} // namespace Cascade::Properties
+
+#endif // TEXTPROPERTYMODEL_H
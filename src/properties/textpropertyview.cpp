@@ -0,0 +1,63 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "textpropertyview.h"
+
+#include "textpropertymodel.h"
+
+namespace Cascade::Properties
+{
+
+TextPropertyView::TextPropertyView(QWidget* parent)
+    : PropertyView(parent)
+{
+    mLayout = new QGridLayout();
+    mLayout->setVerticalSpacing(0);
+    mLayout->setContentsMargins(0, 0, 0, 0);
+    setLayout(mLayout);
+
+    mNameLabel = new QLabel(this);
+    mLayout->addWidget(mNameLabel, 0, 0);
+
+    mLineEdit = new QLineEdit(this);
+    mLayout->addWidget(mLineEdit, 0, 1);
+}
+
+void TextPropertyView::setModel(TextPropertyModel* model)
+{
+    mModel = model;
+    mNameLabel->setText(mModel->getData()->getName());
+    updateValue();
+
+    // Only commit once the user is done typing, every change triggers a render
+    connect(mLineEdit, &QLineEdit::editingFinished,
+            this, [this]()
+            {
+                mModel->setValue(mLineEdit->text());
+            });
+    connect(mModel, &PropertyModel::valueRestored,
+            this, &TextPropertyView::updateValue);
+}
+
+void TextPropertyView::updateValue()
+{
+    mLineEdit->setText(mModel->getData()->getValue());
+}
+
+} // namespace Cascade::Properties
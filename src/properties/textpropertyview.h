@@ -0,0 +1,58 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEXTPROPERTYVIEW_H
+#define TEXTPROPERTYVIEW_H
+
+#include <QLineEdit>
+
+#include "propertyview.h"
+
+namespace Cascade::Properties
+{
+    class TextPropertyModel;
+}
+
+using Cascade::Properties::TextPropertyModel;
+
+namespace Cascade::Properties {
+
+class TextPropertyView : public PropertyView
+{
+    Q_OBJECT
+
+public:
+    TextPropertyView(QWidget *parent = nullptr);
+
+    void setModel(TextPropertyModel* model);
+
+    // Shows the value of the model after it was changed from outside
+    void updateValue();
+
+private:
+    TextPropertyModel*  mModel;
+
+    QGridLayout*        mLayout;
+    QLabel*             mNameLabel;
+    QLineEdit*          mLineEdit;
+};
+
+} // namespace Cascade::Properties
+
+#endif // TEXTPROPERTYVIEW_H
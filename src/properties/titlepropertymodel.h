@@ -21,9 +21,6 @@
 #define TITLEPROPERTYMODEL_H
 
 #include "propertymodel.h"
-#include "titlepropertyview.h"
-
-using Cascade::Properties::TitlePropertyView;
 
 namespace Cascade::Properties
 {
@@ -35,24 +32,15 @@ class TitlePropertyModel : public PropertyModel
 public:
     TitlePropertyModel(TitlePropertyData data)
         : mData(std::make_unique<TitlePropertyData>(data))
-    {
-        mView = new TitlePropertyView();
-        mView->setModel(this);
-    }
+    {}
 
     TitlePropertyData* getData() override
     {
         return mData.get();
     };
 
-    TitlePropertyView* getView() override
-    {
-        return mView;
-    };
-
 private:
     std::unique_ptr<TitlePropertyData> mData;
-    TitlePropertyView* mView;
 };
 
 } // namespace Cascade::Properties
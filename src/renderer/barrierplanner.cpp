@@ -0,0 +1,144 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "barrierplanner.h"
+
+namespace Cascade::Renderer
+{
+
+bool BarrierBatch::isEmpty() const
+{
+    return imageBarriers.empty();
+}
+
+void BarrierPlanner::addImage(const int image, const uint32_t layout, const bool mayBeWritten)
+{
+    ImageState state;
+    state.layout = layout;
+    state.writeStages = mayBeWritten ? allStages : 0;
+
+    mImages[image] = state;
+}
+
+BarrierBatch BarrierPlanner::planCommand(const std::vector<ImageAccess>& accesses)
+{
+    BarrierBatch batch;
+
+    for (const auto& access : accesses)
+    {
+        auto& state = mImages.at(access.image);
+
+        ImageBarrier barrier;
+        barrier.image = access.image;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = access.layout;
+
+        const bool isTransition = access.layout != state.layout;
+
+        if (isTransition || access.isWrite)
+        {
+            // Transitions write the image as well, so both
+            // wait for everything that accessed it before
+            barrier.srcStages = state.writeStages | state.readStages;
+            barrier.srcWrites = state.writeStages;
+        }
+        else if (state.writeStages && !(state.visibleTo & access.stage))
+        {
+            barrier.srcStages = state.writeStages;
+            barrier.srcWrites = state.writeStages;
+        }
+
+        if (isTransition || barrier.srcStages)
+        {
+            barrier.dstStages = access.stage;
+            barrier.dstReads = access.isRead;
+            barrier.dstWrites = access.isWrite;
+
+            addBarrier(batch, barrier);
+        }
+
+        state.layout = access.layout;
+
+        // Later submissions have to wait for transitions as well
+        if (isTransition)
+            state.isWritten = true;
+
+        if (access.isWrite)
+        {
+            state.writeStages = access.stage;
+            state.readStages = 0;
+            state.visibleTo = 0;
+            state.isWritten = true;
+        }
+        else
+        {
+            state.readStages |= access.stage;
+            state.visibleTo |= access.stage;
+        }
+    }
+
+    return batch;
+}
+
+BarrierBatch BarrierPlanner::planRelease(const std::vector<std::pair<int, uint32_t>>& layouts)
+{
+    BarrierBatch batch;
+
+    for (const auto& [image, layout] : layouts)
+    {
+        auto& state = mImages.at(image);
+
+        if (state.layout == layout && !state.isWritten)
+            continue;
+
+        ImageBarrier barrier;
+        barrier.image = image;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = layout;
+        barrier.srcStages = state.writeStages | state.readStages;
+        barrier.srcWrites = state.writeStages;
+        barrier.dstStages = allStages;
+        barrier.dstReads = true;
+        barrier.dstWrites = true;
+
+        addBarrier(batch, barrier);
+
+        state.layout = layout;
+        state.writeStages = allStages;
+        state.readStages = 0;
+        state.visibleTo = 0;
+        state.isWritten = false;
+    }
+
+    return batch;
+}
+
+uint32_t BarrierPlanner::getLayout(const int image) const
+{
+    return mImages.at(image).layout;
+}
+
+void BarrierPlanner::addBarrier(BarrierBatch& batch, const ImageBarrier& barrier)
+{
+    batch.srcStages |= barrier.srcStages;
+    batch.dstStages |= barrier.dstStages;
+    batch.imageBarriers.push_back(barrier);
+}
+
+} // namespace Cascade::Renderer
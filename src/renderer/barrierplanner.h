@@ -0,0 +1,124 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BARRIERPLANNER_H
+#define BARRIERPLANNER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Cascade::Renderer
+{
+
+// Bits of the pipeline stages images are accessed in
+using StageMask = uint32_t;
+
+inline constexpr StageMask transferStage = 1 << 0;
+inline constexpr StageMask computeStage = 1 << 1;
+inline constexpr StageMask allStages = transferStage | computeStage;
+
+// How a command uses one image. Layouts are VkImageLayout
+// values, the planner only compares them.
+struct ImageAccess
+{
+    int image;
+    StageMask stage;
+    uint32_t layout;
+    bool isRead;
+    bool isWrite;
+};
+
+struct ImageBarrier
+{
+    int image;
+    uint32_t oldLayout;
+    uint32_t newLayout;
+
+    // Everything that has to finish first, only the writes
+    // in it have to be made available
+    StageMask srcStages = 0;
+    StageMask srcWrites = 0;
+
+    StageMask dstStages = 0;
+    bool dstReads = false;
+    bool dstWrites = false;
+};
+
+// Everything to wait for before a command, recorded as one pipeline barrier
+struct BarrierBatch
+{
+    // No stages means nothing has to be waited for
+    StageMask srcStages = 0;
+    StageMask dstStages = 0;
+
+    std::vector<ImageBarrier> imageBarriers;
+
+    bool isEmpty() const;
+};
+
+// Tracks the accesses to the images of one command buffer and plans the
+// barriers between its commands. Only read-after-write and write-after-
+// write hazards make memory available, a write-after-read only waits for
+// the readers, and commands on different images don't wait for each
+// other. The transitions before a command all go into one barrier.
+// Not thread-safe.
+class BarrierPlanner
+{
+public:
+    // Has to be called for each image before it is used. Other submissions
+    // aren't waited for on the CPU, so unless the contents are discarded
+    // a write of an earlier one might still be running. Images whose
+    // producer released them don't have to wait for it, mayBeWritten is
+    // false for those and only a transition waits for earlier readers.
+    void addImage(const int image, const uint32_t layout, const bool mayBeWritten = true);
+
+    // The barrier to record before a command, each image used at most once
+    BarrierBatch planCommand(const std::vector<ImageAccess>& accesses);
+
+    // Moves images into the layouts later submissions expect them in and
+    // makes what this command buffer wrote visible to them. Images that
+    // were only read and are already in that layout get no barrier.
+    BarrierBatch planRelease(const std::vector<std::pair<int, uint32_t>>& layouts);
+
+    // The layout the image is in once the barriers planned so far ran
+    uint32_t getLayout(const int image) const;
+
+private:
+    struct ImageState
+    {
+        uint32_t layout;
+        // The last write, and the stages that read since
+        StageMask writeStages = 0;
+        StageMask readStages = 0;
+        // Stages that already waited for the last write
+        StageMask visibleTo = 0;
+        // Written or transitioned by this command buffer
+        bool isWritten = false;
+    };
+
+    void addBarrier(BarrierBatch& batch, const ImageBarrier& barrier);
+
+    std::unordered_map<int, ImageState> mImages;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // BARRIERPLANNER_H
@@ -19,18 +19,117 @@
 
 #include "cscommandbuffer.h"
 
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
 #include "../log.h"
+#include "../multithreading.h"
+#include "barrierplanner.h"
+#include "csgpuprofiler.h"
 #include "renderconfig.h"
 
 namespace Cascade::Renderer {
 
+// All command buffers submit to the same compute queue,
+// which has to be externally synchronized.
+static std::mutex queueMutex;
+static std::shared_ptr<CsSubmission> lastQueueSubmission;
+
+static uint32_t layoutId(const vk::ImageLayout layout)
+{
+    return static_cast<uint32_t>(layout);
+}
+
+static vk::PipelineStageFlags toStageFlags(const StageMask stages)
+{
+    vk::PipelineStageFlags flags;
+    if (stages & transferStage)
+        flags |= vk::PipelineStageFlagBits::eTransfer;
+    if (stages & computeStage)
+        flags |= vk::PipelineStageFlagBits::eComputeShader;
+
+    return flags;
+}
+
+static vk::AccessFlags toAccessFlags(
+        const StageMask stages,
+        const bool reads,
+        const bool writes)
+{
+    vk::AccessFlags flags;
+    if ((stages & transferStage) && reads)
+        flags |= vk::AccessFlagBits::eTransferRead;
+    if ((stages & transferStage) && writes)
+        flags |= vk::AccessFlagBits::eTransferWrite;
+    if ((stages & computeStage) && reads)
+        flags |= vk::AccessFlagBits::eShaderRead;
+    if ((stages & computeStage) && writes)
+        flags |= vk::AccessFlagBits::eShaderWrite;
+
+    return flags;
+}
+
+// Storage images are only ever accessed in the general layout
+static ImageAccess shaderAccess(const int image, const bool isRead, const bool isWrite)
+{
+    return { image, computeStage, layoutId(vk::ImageLayout::eGeneral), isRead, isWrite };
+}
+
+// Images are handed over to later submissions in the layout the shaders
+// access them in, the viewer samples that one as well. Readers of a
+// finished image then don't transition it, so branches reading the
+// same image don't wait for each other.
+static constexpr vk::ImageLayout finishedLayout = vk::ImageLayout::eGeneral;
+
+CsFence::CsFence(const vk::Device* d)
+{
+    fence = d->createFenceUnique(vk::FenceCreateInfo()).value;
+}
+
+CsSubmission::CsSubmission(
+        const vk::Device* d,
+        std::shared_ptr<CsFence> fence,
+        const uint64_t serial) :
+    mDevice(d),
+    mFence(std::move(fence)),
+    mSerial(serial)
+{
+}
+
+void CsSubmission::wait() const
+{
+    std::lock_guard<std::mutex> lock(mFence->mutex);
+
+    // The fence is only reset for a later submission once this one finished
+    if (mFence->serial != mSerial)
+        return;
+
+    vk::Result result = mDevice->waitForFences(1, &(*mFence->fence), true, UINT64_MAX);
+    if (result != vk::Result::eSuccess)
+        CS_LOG_WARNING("Problem waiting for fence.");
+}
+
+bool CsSubmission::isFinished() const
+{
+    std::lock_guard<std::mutex> lock(mFence->mutex);
+
+    if (mFence->serial != mSerial)
+        return true;
+
+    return mDevice->getFenceStatus(*mFence->fence) == vk::Result::eSuccess;
+}
+
 CsCommandBuffer::CsCommandBuffer(
         const vk::Device* d,
         const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
         vk::PipelineLayout* pipelineLayout,
         vk::DescriptorSet* descriptorSet) :
     device(d),
     physicalDevice(pd),
+    mMemoryAllocator(allocator),
     mComputePipelineLayout(pipelineLayout),
     mComputeDescriptorSet(descriptorSet)
 {
@@ -41,19 +140,35 @@ CsCommandBuffer::CsCommandBuffer(
     CS_LOG_INFO("Created compute command buffer.");
 }
 
-void CsCommandBuffer::createComputeQueue()
+CsCommandBuffer::CsCommandBuffer(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        vk::PipelineLayout* pipelineLayout,
+        vk::UniqueDescriptorSet descriptorSet) :
+    CsCommandBuffer(d, pd, allocator, pipelineLayout, &descriptorSet.get())
+{
+    mOwnedDescriptorSet = std::move(descriptorSet);
+    mComputeDescriptorSet = &mOwnedDescriptorSet.get();
+}
+
+uint32_t CsCommandBuffer::findComputeQueueFamily(const vk::PhysicalDevice* pd)
 {
-    auto queueFamilyProperties = physicalDevice->getQueueFamilyProperties();
+    auto queueFamilyProperties = pd->getQueueFamilyProperties();
 
     for (unsigned int i = 0; i < queueFamilyProperties.size(); ++i)
     {
         if (queueFamilyProperties[i].queueFlags & vk::QueueFlagBits::eCompute)
-        {
-            computeFamilyIndex = i;
-            break;
-        }
+            return i;
     }
 
+    return 0;
+}
+
+void CsCommandBuffer::createComputeQueue()
+{
+    computeFamilyIndex = findComputeQueueFamily(physicalDevice);
+
     // Get a compute queue from the device
     mComputeQueue = device->getQueue(computeFamilyIndex, 0);
 }
@@ -70,24 +185,32 @@ void CsCommandBuffer::createComputeCommandPool()
 
 void CsCommandBuffer::createComputeCommandBuffers()
 {
-    // Create the command buffer for loading an image from disk
     vk::CommandBufferAllocateInfo commandBufferAllocateInfo(
                 *mComputeCommandPool,
                 vk::CommandBufferLevel::ePrimary,
-                3);
+                maxSubmissionsInFlight + 3);
 
     std::vector<vk::UniqueCommandBuffer> buffers = device->allocateCommandBuffersUnique(
                 commandBufferAllocateInfo).value;
 
-    mCommandBufferImageLoad = vk::UniqueCommandBuffer(std::move(buffers.at(0)));
-    mCommandBufferGeneric = vk::UniqueCommandBuffer(std::move(buffers.at(1)));
-    mCommandBufferImageSave = vk::UniqueCommandBuffer(std::move(buffers.at(2)));
+    mImageLoad.commandBuffer = std::move(buffers.at(0));
+    mImageSave.commandBuffer = std::move(buffers.at(1));
+    mHash.commandBuffer = std::move(buffers.at(2));
+
+    mGeneric.resize(maxSubmissionsInFlight);
+    for (int i = 0; i < maxSubmissionsInFlight; ++i)
+        mGeneric.at(i).commandBuffer = std::move(buffers.at(3 + i));
 
-    // Fence for compute CB sync
-    vk::FenceCreateInfo fenceCreateInfo(
-                vk::FenceCreateFlagBits::eSignaled);
+    // A command buffer is only submitted again once its last
+    // submission finished, so one fence each is enough
+    mImageLoad.fence = std::make_shared<CsFence>(device);
+    mImageSave.fence = std::make_shared<CsFence>(device);
+    mHash.fence = std::make_shared<CsFence>(device);
 
-    mFence = device->createFenceUnique(fenceCreateInfo).value;
+    for (auto& recording : mGeneric)
+        recording.fence = std::make_shared<CsFence>(device);
+
+    mRecordedFence = std::make_shared<CsFence>(device);
 }
 
 void CsCommandBuffer::recordGeneric(
@@ -95,67 +218,63 @@ void CsCommandBuffer::recordGeneric(
         CsImage *const inputImageFront,
         CsImage *const outputImage,
         vk::Pipeline &pl,
-        int numShaderPasses,
-        int currentShaderPass)
+        [[maybe_unused]] int numShaderPasses,
+        [[maybe_unused]] int currentShaderPass)
 {
-    auto result = mComputeQueue.waitIdle();
-
-    vk::CommandBufferBeginInfo cmdBufferBeginInfo;
+    // The shared descriptor set is only updated after waiting for
+    // all submissions, see VulkanRenderer::updateComputeDescriptors()
+    auto& recording = nextGeneric();
+    auto& commandBuffer = begin(recording);
 
-    result = mCommandBufferGeneric->begin(cmdBufferBeginInfo);
+    const std::vector<CsImage*> images = { inputImageBack, outputImage, inputImageFront };
 
-    // Layout transitions before compute stage
-    inputImageBack->transitionLayoutTo(
-                mCommandBufferGeneric,
-                vk::ImageLayout::eGeneral);
+    // The producers of the inputs made their writes visible
+    BarrierPlanner planner;
+    planner.addImage(0, layoutId(inputImageBack->getLayout()), false);
+    planner.addImage(1, layoutId(outputImage->getLayout()));
 
-    outputImage->transitionLayoutTo(
-                mCommandBufferGeneric,
-                vk::ImageLayout::eGeneral);
+    std::vector<ImageAccess> accesses = {
+        shaderAccess(0, true, false),
+        shaderAccess(1, false, true) };
 
     if (inputImageFront)
     {
-        inputImageFront->transitionLayoutTo(
-                    mCommandBufferGeneric,
-                    vk::ImageLayout::eGeneral);
+        planner.addImage(2, layoutId(inputImageFront->getLayout()), false);
+        accesses.push_back(shaderAccess(2, true, false));
     }
 
-    mCommandBufferGeneric->bindPipeline(
+    recordBarriers(commandBuffer, images, planner.planCommand(accesses));
+
+    beginTiming(recording);
+
+    commandBuffer->bindPipeline(
                 vk::PipelineBindPoint::eCompute,
                 pl);
-    mCommandBufferGeneric->bindDescriptorSets(
+    commandBuffer->bindDescriptorSets(
                 vk::PipelineBindPoint::eCompute,
                 *mComputePipelineLayout,
                 0,
                 *mComputeDescriptorSet,
                 {});
-    mCommandBufferGeneric->dispatch(
-                outputImage->getWidth() / 16 + 1,
-                outputImage->getHeight() / 16 + 1,
-                1);
+    dispatchRegion(
+                commandBuffer,
+                outputImage,
+                QRect());
 
-    // Layout transitions after compute stage
-    inputImageBack->transitionLayoutTo(
-                mCommandBufferGeneric,
-                vk::ImageLayout::eShaderReadOnlyOptimal);
+    endTiming(recording);
 
-    auto layout = vk::ImageLayout::eGeneral;
-    if (currentShaderPass == numShaderPasses)
-        layout = vk::ImageLayout::eShaderReadOnlyOptimal;
-
-    outputImage->transitionLayoutTo(
-                mCommandBufferGeneric,
-                layout);
+    std::vector<std::pair<int, uint32_t>> layouts = {
+        { 0, layoutId(finishedLayout) },
+        { 1, layoutId(finishedLayout) } };
 
     if (inputImageFront)
-    {
-        inputImageFront->transitionLayoutTo(
-                    mCommandBufferGeneric,
-                    vk::ImageLayout::eShaderReadOnlyOptimal);
-    }
+        layouts.push_back({ 2, layoutId(finishedLayout) });
 
-    result = mCommandBufferGeneric->end();
-    Q_UNUSED(result);
+    recordBarriers(commandBuffer, images, planner.planRelease(layouts));
+
+    storeLayouts(images, planner);
+
+    [[maybe_unused]] auto result = commandBuffer->end();
 }
 
 void CsCommandBuffer::recordImageLoad(
@@ -164,19 +283,25 @@ void CsCommandBuffer::recordImageLoad(
         CsImage* const renderTarget,
         vk::Pipeline* const readNodePipeline)
 {
-     [[maybe_unused]] auto result = mComputeQueue.waitIdle();
+    // Only waits for the last image load, the shared descriptor
+    // set was updated after waiting for everything else
+    auto& commandBuffer = begin(mImageLoad);
 
-    vk::CommandBufferBeginInfo cmdBufferBeginInfo;
+    const std::vector<CsImage*> images = { loadImage, tmpImage, renderTarget };
 
-    result = mCommandBufferImageLoad->begin(cmdBufferBeginInfo);
+    BarrierPlanner planner;
+    planner.addImage(0, layoutId(loadImage->getLayout()));
+    planner.addImage(1, layoutId(tmpImage->getLayout()));
+    planner.addImage(2, layoutId(renderTarget->getLayout()));
 
-    loadImage->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eTransferSrcOptimal);
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planCommand({
+                    { 0, transferStage, layoutId(vk::ImageLayout::eTransferSrcOptimal), true, false },
+                    { 1, transferStage, layoutId(vk::ImageLayout::eTransferDstOptimal), false, true } }));
 
-    tmpImage->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eTransferDstOptimal);
+    beginTiming(mImageLoad, vk::PipelineStageFlagBits::eTransfer);
 
     vk::ImageCopy copyInfo;
     copyInfo.srcSubresource.aspectMask  = vk::ImageAspectFlagBits::eColor;
@@ -187,7 +312,7 @@ void CsCommandBuffer::recordImageLoad(
     copyInfo.extent.height              = loadImage->getHeight();
     copyInfo.extent.depth               = 1;
 
-    mCommandBufferImageLoad->copyImage(
+    commandBuffer->copyImage(
                 *loadImage->getImage(),
                 vk::ImageLayout::eTransferSrcOptimal,
                 *tmpImage->getImage(),
@@ -195,56 +320,83 @@ void CsCommandBuffer::recordImageLoad(
                 1,
                 &copyInfo);
 
-    tmpImage->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eGeneral);
-
-    renderTarget->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eGeneral);
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planCommand({
+                    shaderAccess(1, true, false),
+                    shaderAccess(2, false, true) }));
 
-    mCommandBufferImageLoad->bindPipeline(
+    commandBuffer->bindPipeline(
                 vk::PipelineBindPoint::eCompute,
                 *readNodePipeline);
-    mCommandBufferImageLoad->bindDescriptorSets(
+    commandBuffer->bindDescriptorSets(
                 vk::PipelineBindPoint::eCompute,
                 *mComputePipelineLayout,
                 0,
                 *mComputeDescriptorSet,
                 {});
-    mCommandBufferImageLoad->dispatch(
+    commandBuffer->dispatch(
                 loadImage->getWidth() / 16 + 1,
                 loadImage->getHeight() / 16 + 1,
                 1);
 
-    renderTarget->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eShaderReadOnlyOptimal);
+    endTiming(mImageLoad);
 
-    result = mCommandBufferImageLoad->end();
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planRelease({ { 2, layoutId(finishedLayout) } }));
+
+    storeLayouts(images, planner);
+
+    [[maybe_unused]] auto result = commandBuffer->end();
 }
 
-vk::DeviceMemory* CsCommandBuffer::recordImageSave(
+const void* CsCommandBuffer::recordImageSave(
         CsImage *const inputImage)
 {
     CS_LOG_INFO("Copying image GPU-->CPU.");
 
-    // This is for outputting an image to the CPU
-    auto result = mComputeQueue.waitIdle();
+    // The staging buffer may still be read by the last save
+    waitFor(mImageSave);
 
-    vk::CommandBufferBeginInfo cmdBufferBeginInfo;
+    auto outputImageSize = QSize(inputImage->getWidth(), inputImage->getHeight());
 
-    result = mCommandBufferImageSave->begin(cmdBufferBeginInfo);
+    vk::DeviceSize bufferSize =
+        outputImageSize.width() * outputImageSize.height() * getBytesPerPixel(inputImage->getPrecision());
 
-    auto outputImageSize = QSize(inputImage->getWidth(), inputImage->getHeight());
+    if (bufferSize != mOutputStagingBufferSize)
+    {
+        mOutputStagingBufferSize = 0;
+        if (!createBuffer(
+                    mOutputStagingBuffer,
+                    mOutputStagingBufferMemory,
+                    bufferSize,
+                    vk::BufferUsageFlagBits::eTransferDst |
+                    vk::BufferUsageFlagBits::eUniformBuffer,
+                    "Output Staging Buffer"))
+        {
+            CS_LOG_WARNING("Could not allocate the output staging buffer.");
+            return nullptr;
+        }
+        mOutputStagingBufferSize = bufferSize;
+    }
+
+    auto& commandBuffer = begin(mImageSave);
+
+    const std::vector<CsImage*> images = { inputImage };
 
-    vk::DeviceSize bufferSize = outputImageSize.width() * outputImageSize.height() * 16; // 4 channels * 4 bytes
+    BarrierPlanner planner;
+    planner.addImage(0, layoutId(inputImage->getLayout()));
 
-    createBuffer(mOutputStagingBuffer, mOutputStagingBufferMemory, bufferSize);
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planCommand({
+                    { 0, transferStage, layoutId(vk::ImageLayout::eTransferSrcOptimal), true, false } }));
 
-    inputImage->transitionLayoutTo(
-                mCommandBufferImageSave,
-                vk::ImageLayout::eTransferSrcOptimal);
+    beginTiming(mImageSave, vk::PipelineStageFlagBits::eTransfer);
 
     vk::ImageSubresourceLayers imageLayers(
                 vk::ImageAspectFlagBits::eColor,
@@ -263,89 +415,612 @@ vk::DeviceMemory* CsCommandBuffer::recordImageSave(
                     (uint32_t)outputImageSize.height(),
                     1
                 });
-    mCommandBufferImageSave->copyImageToBuffer(
+    commandBuffer->copyImageToBuffer(
                 *inputImage->getImage(),
                 vk::ImageLayout::eTransferSrcOptimal,
                 *mOutputStagingBuffer,
                 copyInfo);
 
-    inputImage->transitionLayoutTo(
-                mCommandBufferImageSave,
-                vk::ImageLayout::eShaderReadOnlyOptimal);
+    endTiming(mImageSave, vk::PipelineStageFlagBits::eTransfer);
 
-    result = mCommandBufferImageSave->end();
-    Q_UNUSED(result);
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planRelease({ { 0, layoutId(finishedLayout) } }));
+
+    storeLayouts(images, planner);
+
+    [[maybe_unused]] auto result = commandBuffer->end();
 
-    return &mOutputStagingBufferMemory.get();
+    return mOutputStagingBufferMemory->getMappedData();
 }
 
-void CsCommandBuffer::submitGeneric()
+bool CsCommandBuffer::recordImageUpload(
+        const float* const pixels,
+        CsImage* const outputImage)
 {
-    // Submit compute commands
-    // Use a fence to ensure that compute command buffer has finished executing before using it again
-    vk::Result result = device->waitForFences(1, &(*mFence), true, UINT64_MAX);
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Problem waiting for fence.");
-    result = device->resetFences(1, &(*mFence));
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Could not reset fence.");
+    // The staging buffer may still be read by the last upload
+    waitFor(mImageLoad);
 
-    // Do the copy on the compute queue
-    vk::SubmitInfo computeSubmitInfo;
-    computeSubmitInfo.commandBufferCount = 1;
+    const ImagePrecision precision = outputImage->getPrecision();
+    const size_t numPixels = static_cast<size_t>(outputImage->getWidth()) * outputImage->getHeight();
 
-    computeSubmitInfo.pCommandBuffers = &mCommandBufferGeneric.get();
+    vk::DeviceSize bufferSize = numPixels * getBytesPerPixel(precision);
 
-    result = mComputeQueue.submit(
-                1,
-                &computeSubmitInfo,
-                *mFence);
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Problem submitting compute queue.");
+    // Consecutive frames of a sequence mostly have the same size
+    if (bufferSize != mInputStagingBufferSize)
+    {
+        mInputStagingBufferSize = 0;
+        if (!createBuffer(
+                    mInputStagingBuffer,
+                    mInputStagingBufferMemory,
+                    bufferSize,
+                    vk::BufferUsageFlagBits::eTransferSrc,
+                    "Input Staging Buffer"))
+        {
+            CS_LOG_WARNING("Could not allocate the input staging buffer.");
+            return false;
+        }
+        mInputStagingBufferSize = bufferSize;
+    }
+
+    void* staging = mInputStagingBufferMemory->getMappedData();
+
+    // The GPU converts when sampling, but not when copying
+    if (precision == ImagePrecision::Float16)
+        parallelFloatToHalf(pixels, static_cast<uint16_t*>(staging), numPixels * 4);
+    else
+        memcpy(staging, pixels, bufferSize);
+
+    recordBufferUpload(*mInputStagingBuffer, 0, outputImage);
+
+    return true;
 }
 
-void CsCommandBuffer::submitImageLoad()
+void CsCommandBuffer::recordBufferUpload(
+        const vk::Buffer& buffer,
+        const vk::DeviceSize offset,
+        CsImage* const outputImage)
 {
-    vk::Result result = device->waitForFences(1, &(*mFence), true, UINT64_MAX);
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Problem waiting for fence.");
-    result = device->resetFences(1, &(*mFence));
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Could not reset fence.");
+    auto& commandBuffer = begin(mImageLoad);
 
-    // Do the copy on the compute queue
-    vk::SubmitInfo computeSubmitInfo;
-    computeSubmitInfo.commandBufferCount = 1;
+    const std::vector<CsImage*> images = { outputImage };
 
-    computeSubmitInfo.pCommandBuffers = &mCommandBufferImageLoad.get();
+    BarrierPlanner planner;
+    planner.addImage(0, layoutId(outputImage->getLayout()));
 
-    result = mComputeQueue.submit(
-                1,
-                &computeSubmitInfo,
-                *mFence);
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Problem submitting compute queue.");
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planCommand({
+                    { 0, transferStage, layoutId(vk::ImageLayout::eTransferDstOptimal), false, true } }));
+
+    beginTiming(mImageLoad, vk::PipelineStageFlagBits::eTransfer);
+
+    vk::ImageSubresourceLayers imageLayers(
+                vk::ImageAspectFlagBits::eColor,
+                {},
+                0,
+                1);
+
+    vk::BufferImageCopy copyInfo(
+                offset,
+                outputImage->getWidth(),
+                outputImage->getHeight(),
+                imageLayers,
+                { 0, 0, 0 },
+                {
+                    (uint32_t)outputImage->getWidth(),
+                    (uint32_t)outputImage->getHeight(),
+                    1
+                });
+    commandBuffer->copyBufferToImage(
+                buffer,
+                *outputImage->getImage(),
+                vk::ImageLayout::eTransferDstOptimal,
+                copyInfo);
+
+    endTiming(mImageLoad, vk::PipelineStageFlagBits::eTransfer);
+
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planRelease({ { 0, layoutId(finishedLayout) } }));
+
+    storeLayouts(images, planner);
+
+    [[maybe_unused]] auto result = commandBuffer->end();
+}
+
+void CsCommandBuffer::recordHash(
+        CsImage* const inputImage,
+        const QRect& region,
+        vk::Pipeline& pl,
+        vk::PipelineLayout& pipelineLayout,
+        const std::vector<vk::DescriptorSet>& descriptorSets,
+        vk::Buffer& resultBuffer)
+{
+    auto& commandBuffer = begin(mHash);
+
+    // The shader accumulates into the buffer
+    commandBuffer->fillBuffer(resultBuffer, 0, VK_WHOLE_SIZE, 0);
+
+    vk::BufferMemoryBarrier clearBarrier(
+                vk::AccessFlagBits::eTransferWrite,
+                vk::AccessFlagBits::eShaderRead |
+                vk::AccessFlagBits::eShaderWrite,
+                {},
+                {},
+                resultBuffer,
+                0,
+                VK_WHOLE_SIZE);
+
+    commandBuffer->pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eComputeShader,
+                {},
+                {},
+                clearBarrier,
+                {});
+
+    auto previousLayout = inputImage->getLayout();
+
+    const std::vector<CsImage*> images = { inputImage };
+
+    BarrierPlanner planner;
+    planner.addImage(0, layoutId(previousLayout), false);
+
+    recordBarriers(commandBuffer, images, planner.planCommand({ shaderAccess(0, true, false) }));
+
+    commandBuffer->bindPipeline(
+                vk::PipelineBindPoint::eCompute,
+                pl);
+    commandBuffer->bindDescriptorSets(
+                vk::PipelineBindPoint::eCompute,
+                pipelineLayout,
+                0,
+                descriptorSets,
+                {});
+
+    const std::array<int32_t, 4> regionConstants = {
+        region.x(), region.y(), region.width(), region.height() };
+
+    commandBuffer->pushConstants(
+                pipelineLayout,
+                vk::ShaderStageFlagBits::eCompute,
+                0,
+                sizeof(regionConstants),
+                regionConstants.data());
+    dispatchRegion(
+                commandBuffer,
+                inputImage,
+                region);
+
+    vk::BufferMemoryBarrier readBackBarrier(
+                vk::AccessFlagBits::eShaderWrite,
+                vk::AccessFlagBits::eHostRead,
+                {},
+                {},
+                resultBuffer,
+                0,
+                VK_WHOLE_SIZE);
+
+    commandBuffer->pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eHost,
+                {},
+                {},
+                readBackBarrier,
+                {});
+
+    if (previousLayout != vk::ImageLayout::eUndefined)
+    {
+        recordBarriers(
+                    commandBuffer,
+                    images,
+                    planner.planRelease({ { 0, layoutId(previousLayout) } }));
+    }
+
+    storeLayouts(images, planner);
+
+    [[maybe_unused]] auto result = commandBuffer->end();
+}
+
+void CsCommandBuffer::recordFused(
+        CsImage* const inputImage,
+        CsImage* const outputImage,
+        vk::Pipeline& pl,
+        vk::PipelineLayout& pipelineLayout,
+        const std::vector<vk::DescriptorSet>& descriptorSets,
+        const QRect& roi,
+        const QPoint& inputOffset)
+{
+    auto& recording = nextGeneric();
+    auto& commandBuffer = begin(recording);
+
+    releaseQueries(recording);
+    recording.queries = acquireQueries();
+    recording.profiledNode = mProfiledNode;
+
+    recordFusedCommands(
+                commandBuffer,
+                inputImage,
+                outputImage,
+                pl,
+                pipelineLayout,
+                descriptorSets,
+                roi,
+                inputOffset,
+                mProfiler,
+                recording.queries);
+
+    [[maybe_unused]] auto result = commandBuffer->end();
+}
+
+void CsCommandBuffer::recordFusedCommands(
+        vk::UniqueCommandBuffer& commandBuffer,
+        CsImage* const inputImage,
+        CsImage* const outputImage,
+        vk::Pipeline& pl,
+        vk::PipelineLayout& pipelineLayout,
+        const std::vector<vk::DescriptorSet>& descriptorSets,
+        const QRect& roi,
+        const QPoint& inputOffset,
+        CsGpuProfiler* const profiler,
+        const int queries)
+{
+    const std::vector<CsImage*> images = { inputImage, outputImage };
+
+    // Everything in the region is written again
+    BarrierPlanner planner;
+    planner.addImage(0, layoutId(inputImage->getLayout()), false);
+    planner.addImage(1, layoutId(vk::ImageLayout::eUndefined));
+
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planCommand({
+                    shaderAccess(0, true, false),
+                    shaderAccess(1, false, true) }));
+
+    if (queries >= 0)
+        profiler->recordBegin(*commandBuffer, queries);
+
+    commandBuffer->bindPipeline(
+                vk::PipelineBindPoint::eCompute,
+                pl);
+    commandBuffer->bindDescriptorSets(
+                vk::PipelineBindPoint::eCompute,
+                pipelineLayout,
+                0,
+                descriptorSets,
+                {});
+
+    const std::array<int32_t, 2> offset = { inputOffset.x(), inputOffset.y() };
+    commandBuffer->pushConstants(
+                pipelineLayout,
+                vk::ShaderStageFlagBits::eCompute,
+                0,
+                sizeof(offset),
+                offset.data());
+
+    dispatchRegion(
+                commandBuffer,
+                outputImage,
+                roi);
+
+    if (queries >= 0)
+        profiler->recordEnd(*commandBuffer, queries);
+
+    recordBarriers(
+                commandBuffer,
+                images,
+                planner.planRelease({
+                    { 0, layoutId(finishedLayout) },
+                    { 1, layoutId(finishedLayout) } }));
+
+    storeLayouts(images, planner);
+}
+
+void CsCommandBuffer::dispatchRegion(
+        vk::UniqueCommandBuffer& commandBuffer,
+        const CsImage* const image,
+        const QRect& roi)
+{
+    const QRect imageRect(0, 0, image->getWidth(), image->getHeight());
+    const QRect region = roi.isNull() ? imageRect : roi.intersected(imageRect);
+
+    if (region.isEmpty())
+        return;
+
+    // gl_GlobalInvocationID includes the base, so the shaders
+    // keep working with absolute pixel coordinates
+    const uint32_t firstGroupX = region.left() / 16;
+    const uint32_t firstGroupY = region.top() / 16;
+    const uint32_t lastGroupX = region.right() / 16;
+    const uint32_t lastGroupY = region.bottom() / 16;
+
+    commandBuffer->dispatchBase(
+                firstGroupX,
+                firstGroupY,
+                0,
+                lastGroupX - firstGroupX + 1,
+                lastGroupY - firstGroupY + 1,
+                1);
+}
+
+void CsCommandBuffer::recordBarriers(
+        vk::UniqueCommandBuffer& commandBuffer,
+        const std::vector<CsImage*>& images,
+        const BarrierBatch& batch)
+{
+    if (batch.isEmpty())
+        return;
+
+    std::vector<vk::ImageMemoryBarrier> barriers;
+    barriers.reserve(batch.imageBarriers.size());
+
+    for (const auto& imageBarrier : batch.imageBarriers)
+    {
+        auto image = images.at(imageBarrier.image);
+
+        barriers.emplace_back(
+                    toAccessFlags(imageBarrier.srcWrites, false, true),
+                    toAccessFlags(imageBarrier.dstStages, imageBarrier.dstReads, imageBarrier.dstWrites),
+                    static_cast<vk::ImageLayout>(imageBarrier.oldLayout),
+                    static_cast<vk::ImageLayout>(imageBarrier.newLayout),
+                    VK_QUEUE_FAMILY_IGNORED,
+                    VK_QUEUE_FAMILY_IGNORED,
+                    *image->getImage(),
+                    vk::ImageSubresourceRange
+                    {
+                        vk::ImageAspectFlagBits::eColor,
+                        0,
+                        1,
+                        0,
+                        1});
+    }
+
+    // Only layout transitions of images nothing accessed before
+    const vk::PipelineStageFlags srcStages = batch.srcStages ?
+        toStageFlags(batch.srcStages) :
+        vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe);
+
+    commandBuffer->pipelineBarrier(
+                srcStages,
+                toStageFlags(batch.dstStages),
+                {},
+                {},
+                {},
+                barriers);
+}
+
+void CsCommandBuffer::storeLayouts(
+        const std::vector<CsImage*>& images,
+        const BarrierPlanner& planner)
+{
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (!images[i])
+            continue;
+
+        // Images that were only read are back in the layout they were
+        // found in, finished images aren't transitioned by their readers
+        const auto layout = static_cast<vk::ImageLayout>(planner.getLayout(static_cast<int>(i)));
+
+        if (images[i]->getLayout() != layout)
+            images[i]->setLayout(layout);
+    }
+}
+
+void CsCommandBuffer::submitGeneric()
+{
+    submit(mGeneric.at(mCurrentGeneric));
+}
+
+void CsCommandBuffer::submitImageLoad()
+{
+    submit(mImageLoad);
 }
 
 void CsCommandBuffer::submitImageSave()
 {
-    vk::Result result = device->waitForFences(1, &(*mFence), true, UINT64_MAX);
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Problem waiting for fence.");
-    result = device->resetFences(1, &(*mFence));
+    submit(mImageSave);
+}
+
+void CsCommandBuffer::submitImageUpload()
+{
+    submit(mImageLoad);
+}
+
+std::shared_ptr<CsSubmission> CsCommandBuffer::submitHash()
+{
+    // begin() already waited for the previous hash, and
+    // nullptr is returned if this one can't be submitted
+    mHash.submission = nullptr;
+    submit(mHash);
+
+    return mHash.submission;
+}
+
+void CsCommandBuffer::submitFused()
+{
+    submit(mGeneric.at(mCurrentGeneric));
+}
+
+void CsCommandBuffer::submitRecorded(const vk::CommandBuffer& commandBuffer, const int queries)
+{
+    const bool isTimed = queries >= 0 && mProfiler && !mProfiledNode.isNull();
+
+    // The command buffer resets its queries. Its last submission
+    // has finished, so the previous timestamps can be read now.
+    if (queries >= 0 && mProfiler)
+        mProfiler->collect();
+
+    if (auto submission = submit(commandBuffer, mRecordedFence))
+    {
+        if (isTimed)
+            mProfiler->submitted(queries, mProfiledNode, submission, true);
+
+        mLastSubmission = std::move(submission);
+    }
+}
+
+void CsCommandBuffer::waitForPreviousSubmission()
+{
+    for (auto& recording : mGeneric)
+        waitFor(recording);
+
+    waitFor(mImageLoad);
+    waitFor(mImageSave);
+    waitFor(mHash);
+
+    // Can be a command buffer recorded elsewhere
+    if (mLastSubmission)
+        mLastSubmission->wait();
+}
+
+std::shared_ptr<CsSubmission> CsCommandBuffer::getLastSubmission() const
+{
+    return mLastSubmission;
+}
+
+std::shared_ptr<CsSubmission> CsCommandBuffer::getLastQueueSubmission()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+
+    return lastQueueSubmission;
+}
+
+CsCommandBuffer::Recording& CsCommandBuffer::nextGeneric()
+{
+    mCurrentGeneric = (mCurrentGeneric + 1) % mGeneric.size();
+
+    return mGeneric.at(mCurrentGeneric);
+}
+
+vk::UniqueCommandBuffer& CsCommandBuffer::begin(Recording& recording)
+{
+    // Only this command buffer has to be done, the
+    // ones recorded before it can keep running
+    waitFor(recording);
+
+    vk::CommandBufferBeginInfo cmdBufferBeginInfo(
+                vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+    auto result = recording.commandBuffer->begin(cmdBufferBeginInfo);
     if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Could not reset fence.");
+        CS_LOG_WARNING("Could not begin command buffer.");
 
+    return recording.commandBuffer;
+}
+
+void CsCommandBuffer::waitFor(Recording& recording)
+{
+    if (recording.submission)
+        recording.submission->wait();
+}
+
+void CsCommandBuffer::beginTiming(Recording& recording, const vk::PipelineStageFlagBits stage)
+{
+    releaseQueries(recording);
+
+    recording.queries = acquireQueries();
+    recording.profiledNode = mProfiledNode;
+
+    if (recording.queries >= 0)
+        mProfiler->recordBegin(*recording.commandBuffer, recording.queries, stage);
+}
+
+void CsCommandBuffer::endTiming(Recording& recording, const vk::PipelineStageFlagBits stage)
+{
+    if (recording.queries >= 0)
+        mProfiler->recordEnd(*recording.commandBuffer, recording.queries, stage);
+}
+
+void CsCommandBuffer::releaseQueries(Recording& recording)
+{
+    // Recorded but never submitted
+    if (recording.queries >= 0)
+        mProfiler->release(std::exchange(recording.queries, -1));
+}
+
+void CsCommandBuffer::submit(Recording& recording)
+{
+    auto submission = submit(*recording.commandBuffer, recording.fence);
+
+    const int queries = std::exchange(recording.queries, -1);
+
+    if (!submission)
+    {
+        if (queries >= 0)
+            mProfiler->release(queries);
+
+        return;
+    }
+
+    if (queries >= 0)
+        mProfiler->submitted(queries, recording.profiledNode, submission);
+
+    recording.submission = submission;
+    mLastSubmission = std::move(submission);
+}
+
+std::shared_ptr<CsSubmission> CsCommandBuffer::submit(
+        const vk::CommandBuffer& commandBuffer,
+        const std::shared_ptr<CsFence>& fence)
+{
     vk::SubmitInfo computeSubmitInfo;
     computeSubmitInfo.commandBufferCount = 1;
-    computeSubmitInfo.pCommandBuffers = &mCommandBufferImageSave.get();
+    computeSubmitInfo.pCommandBuffers = &commandBuffer;
 
-    result = mComputeQueue.submit(
-                1,
-                &computeSubmitInfo,
-                *mFence);
+    std::shared_ptr<CsSubmission> submission;
+    vk::Result result;
+    {
+        std::lock_guard<std::mutex> fenceLock(fence->mutex);
+
+        // Already the case for recordings, which are waited for before they
+        // are recorded again, but command buffers from elsewhere aren't
+        if (fence->isSubmitted)
+        {
+            result = device->waitForFences(1, &(*fence->fence), true, UINT64_MAX);
+            if (result != vk::Result::eSuccess)
+                CS_LOG_WARNING("Problem waiting for fence.");
+        }
+
+        // Submissions holding the old serial count as finished from here on
+        result = device->resetFences(1, &(*fence->fence));
+        if (result != vk::Result::eSuccess)
+            CS_LOG_WARNING("Problem resetting fence.");
+
+        fence->isSubmitted = false;
+        submission = std::make_shared<CsSubmission>(device, fence, ++fence->serial);
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        result = mComputeQueue.submit(
+                    1,
+                    &computeSubmitInfo,
+                    *fence->fence);
+
+        if (result == vk::Result::eSuccess)
+        {
+            fence->isSubmitted = true;
+            lastQueueSubmission = submission;
+        }
+    }
     if (result != vk::Result::eSuccess)
+    {
         CS_LOG_WARNING("Problem submitting compute queue.");
+        return nullptr;
+    }
+
+    return submission;
+}
+
+std::unique_lock<std::mutex> CsCommandBuffer::lockQueue()
+{
+    return std::unique_lock<std::mutex>(queueMutex);
 }
 
 vk::Queue* CsCommandBuffer::getQueue()
@@ -355,36 +1030,70 @@ vk::Queue* CsCommandBuffer::getQueue()
 
 vk::CommandBuffer* CsCommandBuffer::getGeneric()
 {
-    auto result = mComputeQueue.waitIdle();
-    Q_UNUSED(result);
+    // The other command buffers of the ring can keep running
+    auto& recording = nextGeneric();
+    waitFor(recording);
 
-    return &(*mCommandBufferGeneric);
+    return &recording.commandBuffer.get();
 }
 
 vk::CommandBuffer* CsCommandBuffer::getImageLoad()
 {
-    auto result = mComputeQueue.waitIdle();
-    Q_UNUSED(result);
+    waitFor(mImageLoad);
 
-    return &(*mCommandBufferImageLoad);
+    return &mImageLoad.commandBuffer.get();
 }
 
 vk::CommandBuffer* CsCommandBuffer::getImageSave()
 {
-    return &(*mCommandBufferImageSave);
+    return &mImageSave.commandBuffer.get();
+}
+
+vk::DescriptorSet* CsCommandBuffer::getDescriptorSet()
+{
+    return mComputeDescriptorSet;
+}
+
+uint32_t CsCommandBuffer::getQueueFamilyIndex() const
+{
+    return computeFamilyIndex;
+}
+
+void CsCommandBuffer::setProfiler(CsGpuProfiler* profiler)
+{
+    mProfiler = profiler;
+}
+
+void CsCommandBuffer::setProfiledNode(const QUuid& node)
+{
+    mProfiledNode = node;
+}
+
+CsGpuProfiler* CsCommandBuffer::getProfiler() const
+{
+    return mProfiler;
 }
 
-void CsCommandBuffer::createBuffer(
+int CsCommandBuffer::acquireQueries()
+{
+    return mProfiler && !mProfiledNode.isNull() ? mProfiler->acquire() : -1;
+}
+
+bool CsCommandBuffer::createBuffer(
         vk::UniqueBuffer& buffer,
-        vk::UniqueDeviceMemory& bufferMemory,
-        vk::DeviceSize& size)
+        std::unique_ptr<CsAllocation>& bufferMemory,
+        vk::DeviceSize& size,
+        vk::BufferUsageFlags usage,
+        const char* debugName)
 {
+    // Release the old buffer first so its memory can be reused
+    buffer.reset();
+    bufferMemory.reset();
+
     vk::BufferCreateInfo bufferInfo(
                 {},
                 size,
-                vk::BufferUsageFlags(
-                    vk::BufferUsageFlagBits::eTransferDst |
-                    vk::BufferUsageFlagBits::eUniformBuffer),
+                usage,
                 vk::SharingMode::eExclusive);
 
     buffer = device->createBufferUnique(bufferInfo).value;
@@ -394,7 +1103,7 @@ void CsCommandBuffer::createBuffer(
         vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
                     vk::ObjectType::eBuffer,
                     NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkBuffer, *buffer),
-                    "Output Staging Buffer");
+                    debugName);
         auto result = device->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
         Q_UNUSED(result);
     }
@@ -402,46 +1111,41 @@ void CsCommandBuffer::createBuffer(
 
     vk::MemoryRequirements memRequirements = device->getBufferMemoryRequirements(*buffer);
 
-    uint32_t memoryType = findMemoryType(
-                memRequirements.memoryTypeBits,
-                vk::MemoryPropertyFlags(
-                    vk::MemoryPropertyFlagBits::eHostVisible |
-                    vk::MemoryPropertyFlagBits::eHostCoherent));
-
-    vk::MemoryAllocateInfo allocInfo(memRequirements.size,
-                                     memoryType);
+    bufferMemory = mMemoryAllocator->allocate(
+                memRequirements,
+                vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+                true);
 
-    bufferMemory = device->allocateMemoryUnique(allocInfo).value;
-
-#ifdef QT_DEBUG
+    if (!bufferMemory)
     {
-        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-                    vk::ObjectType::eDeviceMemory,
-                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkDeviceMemory, *bufferMemory),
-                    "Output Staging Buffer Memory");
-        auto result = device->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
-        Q_UNUSED(result);
+        buffer.reset();
+        return false;
     }
-#endif
 
-    auto result = device->bindBufferMemory(*buffer, *bufferMemory, 0);
+    auto result = device->bindBufferMemory(
+                *buffer,
+                bufferMemory->getMemory(),
+                bufferMemory->getOffset());
     Q_UNUSED(result);
+
+    return true;
 }
 
-uint32_t CsCommandBuffer::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties)
+CsCommandBuffer::~CsCommandBuffer()
 {
-    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice->getMemoryProperties();
+    // Submissions can't be pending when their command buffers are freed
+    waitForPreviousSubmission();
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
+    // Everything before it has finished as well, and its
+    // fence mustn't outlive the device
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        if (lastQueueSubmission == mLastSubmission)
+            lastQueueSubmission = nullptr;
     }
-    throw std::runtime_error("Failed to find suitable memory type!");
-}
 
-CsCommandBuffer::~CsCommandBuffer()
-{
     CS_LOG_INFO("Destroying command buffer.");
 }
 
@@ -20,19 +20,73 @@
 #ifndef CSCOMMANDBUFFER_H
 #define CSCOMMANDBUFFER_H
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QPoint>
+#include <QUuid>
+
 #include "csimage.h"
 
 namespace Cascade::Renderer {
 
+struct BarrierBatch;
+class BarrierPlanner;
+class CsGpuProfiler;
+
+// Created once per command buffer and reset for each of its submissions,
+// the serial tells the submissions that used it apart
+struct CsFence
+{
+    explicit CsFence(const vk::Device* d);
+
+    vk::UniqueFence fence;
+    uint64_t serial = 0;
+    bool isSubmitted = false;
+    // Held while the fence is waited on, reset or submitted
+    std::mutex mutex;
+};
+
+// One submission to the compute queue, finished once the GPU has executed
+// it. Resources the submission uses can hold on to this to know when they
+// may be reused, even after the command buffer is gone.
+class CsSubmission
+{
+public:
+    CsSubmission(
+            const vk::Device* d,
+            std::shared_ptr<CsFence> fence,
+            const uint64_t serial);
+
+    void wait() const;
+    bool isFinished() const;
+
+private:
+    const vk::Device* mDevice;
+    std::shared_ptr<CsFence> mFence;
+    const uint64_t mSerial;
+};
+
 class CsCommandBuffer
 {
 public:
     CsCommandBuffer(
             const vk::Device* d,
             const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
             vk::PipelineLayout* pipelineLayout,
             vk::DescriptorSet* descriptorSet);
 
+    // Command buffer that brings its own descriptor set, used by the
+    // graph executor so that parallel branches don't share bindings
+    CsCommandBuffer(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            vk::PipelineLayout* pipelineLayout,
+            vk::UniqueDescriptorSet descriptorSet);
+
     void recordGeneric(
             CsImage* const inputImageBack,
             CsImage* const inputImageFront,
@@ -45,56 +99,215 @@ public:
             CsImage* const tmpImage,
             CsImage* const renderTarget,
             vk::Pipeline* const readNodePipeline);
-    vk::DeviceMemory* recordImageSave(
+    // The returned pixels are valid once the save has been
+    // submitted, until the next save. nullptr on failure.
+    const void* recordImageSave(
             CsImage* const inputImage);
+    // Copies RGBA32F pixels of the image's size from the CPU
+    // into the image, false if they can't be staged
+    bool recordImageUpload(
+            const float* const pixels,
+            CsImage* const outputImage);
+    // Copies pixels of the image's size and precision that were
+    // already staged in the buffer, starting at the offset
+    void recordBufferUpload(
+            const vk::Buffer& buffer,
+            const vk::DeviceSize offset,
+            CsImage* const outputImage);
+    // The descriptor sets are bound starting at set 0, only the
+    // region is dispatched and passed on as a push constant
+    void recordHash(
+            CsImage* const inputImage,
+            const QRect& region,
+            vk::Pipeline& pl,
+            vk::PipelineLayout& pipelineLayout,
+            const std::vector<vk::DescriptorSet>& descriptorSets,
+            vk::Buffer& resultBuffer);
+    // A chain of pointwise kernels in one dispatch, the descriptor sets
+    // come from the kernel fuser. Output pixel (0, 0) is computed from
+    // the input pixel at inputOffset.
+    void recordFused(
+            CsImage* const inputImage,
+            CsImage* const outputImage,
+            vk::Pipeline& pl,
+            vk::PipelineLayout& pipelineLayout,
+            const std::vector<vk::DescriptorSet>& descriptorSets,
+            const QRect& roi,
+            const QPoint& inputOffset);
+    // The commands of recordFused into a command buffer the caller
+    // owns and has begun. The result is treated as undefined before
+    // the dispatch, so the command buffer can be submitted again.
+    // The dispatch is timed with the queries if they aren't -1.
+    static void recordFusedCommands(
+            vk::UniqueCommandBuffer& commandBuffer,
+            CsImage* const inputImage,
+            CsImage* const outputImage,
+            vk::Pipeline& pl,
+            vk::PipelineLayout& pipelineLayout,
+            const std::vector<vk::DescriptorSet>& descriptorSets,
+            const QRect& roi,
+            const QPoint& inputOffset,
+            CsGpuProfiler* const profiler = nullptr,
+            const int queries = -1);
 
     void submitGeneric();
     void submitImageLoad();
     void submitImageSave();
+    void submitImageUpload();
+    // Doesn't wait for the GPU, the hash is in the result
+    // buffer once the returned submission has finished
+    std::shared_ptr<CsSubmission> submitHash();
+    // Doesn't wait for the GPU, the parameter buffer can be
+    // reused once getLastSubmission() has finished
+    void submitFused();
+    // Submits a command buffer recorded elsewhere, it counts as the last
+    // submission of this one. The queries it was recorded with are read
+    // back for the current node, they stay with the command buffer.
+    void submitRecorded(const vk::CommandBuffer& commandBuffer, const int queries = -1);
 
     ~CsCommandBuffer();
 
     vk::Queue* getQueue();
+    // The next command buffer of the ring, for submitGeneric(). Only
+    // waits until its own last submission has finished.
     vk::CommandBuffer* getGeneric();
     vk::CommandBuffer* getImageLoad();
     vk::CommandBuffer* getImageSave();
+    vk::DescriptorSet* getDescriptorSet();
+    uint32_t getQueueFamilyIndex() const;
+
+    // Blocks until all submissions of this command buffer have finished.
+    // Other command buffers on the same queue keep running.
+    void waitForPreviousSubmission();
+
+    // nullptr before anything was submitted
+    std::shared_ptr<CsSubmission> getLastSubmission() const;
+
+    // The last submission of any command buffer. Its fence also covers
+    // everything submitted to the queue before it, nullptr if there was none.
+    static std::shared_ptr<CsSubmission> getLastQueueSubmission();
+
+    // The first queue family that supports compute
+    static uint32_t findComputeQueueFamily(const vk::PhysicalDevice* pd);
+
+    // While a node is set, its submissions are timed on the GPU if the
+    // profiler is enabled. A null id stops the timing.
+    void setProfiler(CsGpuProfiler* profiler);
+    void setProfiledNode(const QUuid& node);
+    CsGpuProfiler* getProfiler() const;
+
+    // Queries for timing the current node in a command buffer recorded
+    // elsewhere, -1 if it isn't timed. They have to be released through
+    // the profiler.
+    int acquireQueries();
+
+    // The compute queue can be the one the viewer presents on. Anything
+    // else submitting to it from another thread has to hold this lock.
+    static std::unique_lock<std::mutex> lockQueue();
 
 private:
     void createComputeQueue();
     void createComputeCommandPool();
     void createComputeCommandBuffers();
 
-    void createBuffer(
-            vk::UniqueBuffer& buffer,
-            vk::UniqueDeviceMemory& bufferMemory,
-            vk::DeviceSize& size);
+    // A command buffer and the last submission it was part of,
+    // it can only be recorded again once that has finished
+    struct Recording
+    {
+        vk::UniqueCommandBuffer commandBuffer;
+        std::shared_ptr<CsFence> fence;
+        std::shared_ptr<CsSubmission> submission;
+        // Timestamps written by the recording and the node they are
+        // for, handed to the profiler when it is submitted
+        int queries = -1;
+        QUuid profiledNode;
+    };
+
+    Recording& nextGeneric();
+    vk::UniqueCommandBuffer& begin(Recording& recording);
+    // Around the work of the profiled node, after the barrier it waits at
+    void beginTiming(
+            Recording& recording,
+            const vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eComputeShader);
+    void endTiming(
+            Recording& recording,
+            const vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eComputeShader);
+    void releaseQueries(Recording& recording);
+    void waitFor(Recording& recording);
+    void submit(Recording& recording);
+    // Waits for the previous submission that used the fence.
+    // nullptr if the queue didn't accept it.
+    std::shared_ptr<CsSubmission> submit(
+            const vk::CommandBuffer& commandBuffer,
+            const std::shared_ptr<CsFence>& fence);
+
+    // Records a batch of the barrier planner as a single pipeline barrier,
+    // the planner's image ids are indices into images
+    static void recordBarriers(
+            vk::UniqueCommandBuffer& commandBuffer,
+            const std::vector<CsImage*>& images,
+            const BarrierBatch& batch);
 
-    uint32_t findMemoryType(
-            uint32_t typeFilter,
-            vk::MemoryPropertyFlags properties);
+    // Stores the layouts the images are left in once everything is
+    // recorded. The ones they pass through in between stay in the
+    // planner, other branches may read the same images meanwhile.
+    static void storeLayouts(
+            const std::vector<CsImage*>& images,
+            const BarrierPlanner& planner);
+
+    // Dispatches only the work groups that touch the region of interest,
+    // the whole image if it is null
+    static void dispatchRegion(
+            vk::UniqueCommandBuffer& commandBuffer,
+            const CsImage* const image,
+            const QRect& roi);
+
+    // Host visible buffer that stays mapped, false if
+    // there is no memory left for it
+    bool createBuffer(
+            vk::UniqueBuffer& buffer,
+            std::unique_ptr<CsAllocation>& bufferMemory,
+            vk::DeviceSize& size,
+            vk::BufferUsageFlags usage,
+            const char* debugName);
 
     const vk::Device* device;
     const vk::PhysicalDevice* physicalDevice;
+    CsMemoryAllocator* mMemoryAllocator;
     int computeFamilyIndex;
 
     vk::UniqueCommandPool mComputeCommandPool;
-    // Command buffer for all shaders except IO
-    vk::UniqueCommandBuffer mCommandBufferGeneric;
+    // Command buffers for all shaders except IO, used in turn so that the
+    // next node can be recorded while the GPU runs the previous ones
+    std::vector<Recording> mGeneric;
+    size_t mCurrentGeneric = 0;
     // Command buffer for loading images from disk
-    vk::UniqueCommandBuffer mCommandBufferImageLoad;
+    Recording mImageLoad;
     // Command buffer for writing images to disk
-    vk::UniqueCommandBuffer mCommandBufferImageSave;
+    Recording mImageSave;
+    // Command buffer for hashing node outputs
+    Recording mHash;
+    // For command buffers recorded elsewhere
+    std::shared_ptr<CsFence> mRecordedFence;
 
-    vk::CommandBuffer* mCurrentBuffer;
+    std::shared_ptr<CsSubmission> mLastSubmission;
+
+    CsGpuProfiler* mProfiler = nullptr;
+    QUuid mProfiledNode;
 
     vk::Queue mComputeQueue;
-    vk::UniqueFence mFence;
 
     vk::PipelineLayout* mComputePipelineLayout;
     vk::DescriptorSet* mComputeDescriptorSet;
+    vk::UniqueDescriptorSet mOwnedDescriptorSet;
 
+    std::unique_ptr<CsAllocation> mOutputStagingBufferMemory;
     vk::UniqueBuffer mOutputStagingBuffer;
-    vk::UniqueDeviceMemory mOutputStagingBufferMemory;
+    vk::DeviceSize mOutputStagingBufferSize = 0;
+
+    std::unique_ptr<CsAllocation> mInputStagingBufferMemory;
+    vk::UniqueBuffer mInputStagingBuffer;
+    vk::DeviceSize mInputStagingBufferSize = 0;
 };
 
 } // namespace Cascade::Renderer
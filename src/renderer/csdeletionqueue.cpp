@@ -0,0 +1,124 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csdeletionqueue.h"
+
+#include <vector>
+
+#include "cscommandbuffer.h"
+
+namespace Cascade::Renderer {
+
+CsDeletionQueue::CsDeletionQueue(const int framesInFlight) :
+    mFramesInFlight(framesInFlight)
+{
+}
+
+void CsDeletionQueue::retire(std::shared_ptr<void> object)
+{
+    if (!object)
+        return;
+
+    // The fence of the last submission covers all earlier
+    // ones, there is no need to know which used the object
+    auto submission = CsCommandBuffer::getLastQueueSubmission();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mEntries.push_back({ std::move(object), std::move(submission), mFrame });
+    }
+
+    // Keeps the queue short when nothing else collects
+    collect();
+}
+
+void CsDeletionQueue::advanceFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        ++mFrame;
+    }
+
+    collect();
+}
+
+uint64_t CsDeletionQueue::getFrame()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mFrame;
+}
+
+bool CsDeletionQueue::isFrameRetired(const uint64_t frame)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mFrame >= frame + static_cast<uint64_t>(mFramesInFlight);
+}
+
+void CsDeletionQueue::collect()
+{
+    std::vector<std::shared_ptr<void>> finished;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        while (!mEntries.empty() && isFinished(mEntries.front()))
+        {
+            finished.push_back(std::move(mEntries.front().object));
+            mEntries.pop_front();
+        }
+    }
+
+    // Destroyed outside the lock in the order they were retired,
+    // freeing memory takes the lock of the allocator
+    for (auto& object : finished)
+        object = nullptr;
+}
+
+void CsDeletionQueue::flush()
+{
+    std::deque<Entry> entries;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        entries.swap(mEntries);
+    }
+
+    while (!entries.empty())
+        entries.pop_front();
+}
+
+bool CsDeletionQueue::isFinished(const Entry& entry) const
+{
+    if (mFrame < entry.frame + static_cast<uint64_t>(mFramesInFlight))
+        return false;
+
+    return !entry.submission || entry.submission->isFinished();
+}
+
+CsDeletionQueue::~CsDeletionQueue()
+{
+    flush();
+}
+
+} // end namespace Cascade::Renderer
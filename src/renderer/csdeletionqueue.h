@@ -0,0 +1,87 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSDELETIONQUEUE_H
+#define CSDELETIONQUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace Cascade::Renderer {
+
+class CsSubmission;
+
+// Holds on to Vulkan objects that were released while the GPU may still
+// be using them, instead of waiting for the whole device to go idle.
+// An object is destroyed once the compute work submitted before it was
+// retired has finished, and the frames the viewer had in flight at that
+// point have been presented. Thread-safe.
+class CsDeletionQueue
+{
+public:
+    // Frames that can be in flight at once, 0 without a viewer
+    explicit CsDeletionQueue(const int framesInFlight = 0);
+
+    // Takes over the last reference to the object
+    void retire(std::shared_ptr<void> object);
+
+    // Has to be called when the viewer starts a new frame, after
+    // the one that used the same resources has finished
+    void advanceFrame();
+
+    // The frame the viewer is currently at
+    uint64_t getFrame();
+
+    // True once the frames the viewer had in flight at
+    // the given frame have all been presented
+    bool isFrameRetired(const uint64_t frame);
+
+    // Destroys the objects the GPU is done with, without waiting
+    void collect();
+
+    // Destroys everything, the device has to be idle
+    void flush();
+
+    ~CsDeletionQueue();
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<void> object;
+        std::shared_ptr<CsSubmission> submission;
+        uint64_t frame;
+    };
+
+    bool isFinished(const Entry& entry) const;
+
+    const int mFramesInFlight;
+
+    // Retired in submission order, so the ones
+    // that can be destroyed are at the front
+    std::deque<Entry> mEntries;
+    uint64_t mFrame = 0;
+
+    std::mutex mMutex;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSDELETIONQUEUE_H
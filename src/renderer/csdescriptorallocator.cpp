@@ -0,0 +1,159 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csdescriptorallocator.h"
+
+#include "../log.h"
+#include "csimage.h"
+
+namespace Cascade::Renderer {
+
+// Sets per pool, each holds a single storage image
+static constexpr uint32_t setsPerPool = 256;
+
+CsDescriptorSet::CsDescriptorSet(
+        CsDescriptorAllocator* allocator,
+        const vk::DescriptorPool pool,
+        const vk::DescriptorSet set) :
+    mAllocator(allocator),
+    mPool(pool),
+    mSet(set)
+{
+}
+
+const vk::DescriptorSet& CsDescriptorSet::getSet() const
+{
+    return mSet;
+}
+
+CsDescriptorSet::~CsDescriptorSet()
+{
+    mAllocator->free(*this);
+}
+
+CsDescriptorAllocator::CsDescriptorAllocator(const vk::Device* d) :
+    mDevice(d)
+{
+    vk::DescriptorSetLayoutBinding binding(
+                0,
+                vk::DescriptorType::eStorageImage,
+                1,
+                vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo({}, 1, &binding);
+
+    mImageSetLayout = mDevice->createDescriptorSetLayoutUnique(layoutInfo).value;
+}
+
+const vk::DescriptorSetLayout& CsDescriptorAllocator::getImageSetLayout() const
+{
+    return *mImageSetLayout;
+}
+
+vk::DescriptorSet CsDescriptorAllocator::getImageSet(CsImage* const image)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!image->getDescriptorSet())
+        image->setDescriptorSet(allocate(*image->getImageView()));
+
+    auto set = image->getDescriptorSet();
+
+    return set ? set->getSet() : vk::DescriptorSet();
+}
+
+std::unique_ptr<CsDescriptorSet> CsDescriptorAllocator::allocate(const vk::ImageView& view)
+{
+    vk::DescriptorSet set;
+    vk::DescriptorPool pool;
+
+    // The newest pool is the one most likely to have room
+    for (auto it = mPools.rbegin(); it != mPools.rend() && !set; ++it)
+    {
+        vk::DescriptorSetAllocateInfo allocInfo(**it, 1, &(*mImageSetLayout));
+
+        if (mDevice->allocateDescriptorSets(&allocInfo, &set) == vk::Result::eSuccess)
+            pool = **it;
+        else
+            set = vk::DescriptorSet();
+    }
+
+    if (!set)
+    {
+        auto newPool = createPool();
+        if (!newPool)
+            return nullptr;
+
+        vk::DescriptorSetAllocateInfo allocInfo(*newPool, 1, &(*mImageSetLayout));
+
+        if (mDevice->allocateDescriptorSets(&allocInfo, &set) != vk::Result::eSuccess)
+        {
+            CS_LOG_WARNING("Could not allocate image descriptor set.");
+            return nullptr;
+        }
+
+        pool = *newPool;
+        mPools.push_back(std::move(newPool));
+    }
+
+    vk::DescriptorImageInfo imageInfo({}, view, vk::ImageLayout::eGeneral);
+
+    vk::WriteDescriptorSet descWrite(set, 0, 0, 1, vk::DescriptorType::eStorageImage, &imageInfo);
+
+    mDevice->updateDescriptorSets(descWrite, {});
+
+    return std::unique_ptr<CsDescriptorSet>(new CsDescriptorSet(this, pool, set));
+}
+
+void CsDescriptorAllocator::free(CsDescriptorSet& set)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mDevice->freeDescriptorSets(set.mPool, set.mSet);
+}
+
+vk::UniqueDescriptorPool CsDescriptorAllocator::createPool()
+{
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageImage, setsPerPool);
+
+    vk::DescriptorPoolCreateInfo poolInfo(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        setsPerPool,
+        1,
+        &poolSize);
+
+    auto pool = mDevice->createDescriptorPoolUnique(poolInfo);
+    if (pool.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Could not create image descriptor pool.");
+        return {};
+    }
+
+    return std::move(pool.value);
+}
+
+CsDescriptorAllocator::~CsDescriptorAllocator()
+{
+    // Destroying the pools frees the sets that are left
+    mPools.clear();
+
+    CS_LOG_INFO("Destroying descriptor allocator.");
+}
+
+} // end namespace Cascade::Renderer
@@ -0,0 +1,100 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSDESCRIPTORALLOCATOR_H
+#define CSDESCRIPTORALLOCATOR_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsDescriptorAllocator;
+class CsImage;
+
+// A descriptor set handed out by CsDescriptorAllocator,
+// it goes back to the allocator when this is destroyed
+class CsDescriptorSet
+{
+public:
+    CsDescriptorSet(const CsDescriptorSet&) = delete;
+    CsDescriptorSet& operator=(const CsDescriptorSet&) = delete;
+
+    const vk::DescriptorSet& getSet() const;
+
+    ~CsDescriptorSet();
+
+private:
+    friend class CsDescriptorAllocator;
+
+    CsDescriptorSet(
+            CsDescriptorAllocator* allocator,
+            const vk::DescriptorPool pool,
+            const vk::DescriptorSet set);
+
+    CsDescriptorAllocator* mAllocator;
+    vk::DescriptorPool mPool;
+    vk::DescriptorSet mSet;
+};
+
+// Every image gets a descriptor set of its own that only holds the image
+// as a storage image. It is written once, the first time the image is
+// bound, and never changes afterwards. Dispatches bind the sets of their
+// inputs and outputs next to each other instead of rewriting a shared set,
+// so there are no descriptor updates between them and nothing has to wait
+// for the GPU to stop using a set. Thread-safe, it has to outlive all of
+// its sets.
+class CsDescriptorAllocator
+{
+public:
+    explicit CsDescriptorAllocator(const vk::Device* d);
+
+    // Layout of the sets of images, a storage image at binding 0
+    const vk::DescriptorSetLayout& getImageSetLayout() const;
+
+    // The set is kept by the image and retired with it,
+    // a null handle if there is no memory left for it
+    vk::DescriptorSet getImageSet(CsImage* const image);
+
+    ~CsDescriptorAllocator();
+
+private:
+    friend class CsDescriptorSet;
+
+    std::unique_ptr<CsDescriptorSet> allocate(const vk::ImageView& view);
+    void free(CsDescriptorSet& set);
+
+    vk::UniqueDescriptorPool createPool();
+
+    const vk::Device* mDevice;
+
+    vk::UniqueDescriptorSetLayout mImageSetLayout;
+
+    // New pools are added when the existing ones are full
+    std::vector<vk::UniqueDescriptorPool> mPools;
+
+    std::mutex mMutex;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSDESCRIPTORALLOCATOR_H
@@ -0,0 +1,209 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csgpuprofiler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "../log.h"
+#include "cscommandbuffer.h"
+
+namespace Cascade::Renderer {
+
+// Enough for every branch to have its submissions in flight
+// for a while before the results are collected
+static constexpr int numQueryPairs = 64;
+
+CsGpuProfiler::CsGpuProfiler(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        const uint32_t queueFamilyIndex) :
+    mDevice(d)
+{
+    const uint32_t validBits = pd->getQueueFamilyProperties().at(queueFamilyIndex).timestampValidBits;
+    if (validBits == 0)
+    {
+        CS_LOG_WARNING("The compute queue doesn't support timestamps, GPU profiling is disabled.");
+        return;
+    }
+
+    mTimestampPeriod = pd->getProperties().limits.timestampPeriod;
+    mTimestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+
+    createQueryPool();
+
+    for (int i = 0; i < numQueryPairs; ++i)
+        mFreePairs.push_back(i);
+
+    CS_LOG_INFO("Created GPU profiler.");
+}
+
+void CsGpuProfiler::createQueryPool()
+{
+    vk::QueryPoolCreateInfo queryPoolInfo({}, vk::QueryType::eTimestamp, 2 * numQueryPairs);
+
+    mQueryPool = mDevice->createQueryPoolUnique(queryPoolInfo).value;
+}
+
+bool CsGpuProfiler::isValid() const
+{
+    return bool(mQueryPool);
+}
+
+bool CsGpuProfiler::isEnabled() const
+{
+    return mIsEnabled;
+}
+
+void CsGpuProfiler::setEnabled(const bool enabled)
+{
+    mIsEnabled = enabled && isValid();
+}
+
+int CsGpuProfiler::acquire()
+{
+    if (!mIsEnabled)
+        return -1;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mFreePairs.empty())
+        collectLocked();
+
+    // Rather an untimed submission than a stall
+    if (mFreePairs.empty())
+        return -1;
+
+    const int pair = mFreePairs.back();
+    mFreePairs.pop_back();
+
+    return pair;
+}
+
+void CsGpuProfiler::recordBegin(
+        const vk::CommandBuffer& commandBuffer,
+        const int pair,
+        const vk::PipelineStageFlagBits stage)
+{
+    // Part of the command buffer, so a command buffer
+    // that is submitted again resets them every time
+    commandBuffer.resetQueryPool(*mQueryPool, 2 * pair, 2);
+    commandBuffer.writeTimestamp(stage, *mQueryPool, 2 * pair);
+}
+
+void CsGpuProfiler::recordEnd(
+        const vk::CommandBuffer& commandBuffer,
+        const int pair,
+        const vk::PipelineStageFlagBits stage)
+{
+    commandBuffer.writeTimestamp(stage, *mQueryPool, 2 * pair + 1);
+}
+
+void CsGpuProfiler::submitted(
+        const int pair,
+        const QUuid& node,
+        std::shared_ptr<CsSubmission> submission,
+        const bool isKept)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mPendingPairs.push_back({ pair, node, std::move(submission), isKept });
+}
+
+void CsGpuProfiler::release(const int pair)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // A kept pair might still be pending, its
+    // command buffer has finished by now
+    collectLocked();
+
+    mFreePairs.push_back(pair);
+}
+
+void CsGpuProfiler::collect()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    collectLocked();
+}
+
+void CsGpuProfiler::collectLocked()
+{
+    auto it = std::remove_if(
+        mPendingPairs.begin(),
+        mPendingPairs.end(),
+        [this](const PendingPair& pending)
+        {
+            if (!pending.submission->isFinished())
+                return false;
+
+            // A node can take several submissions, e.g. a load and an upload
+            double milliseconds = 0.0;
+            if (readPair(pending.pair, milliseconds))
+                mTimings[pending.node] += milliseconds;
+
+            if (!pending.isKept)
+                mFreePairs.push_back(pending.pair);
+
+            return true;
+        });
+
+    mPendingPairs.erase(it, mPendingPairs.end());
+}
+
+bool CsGpuProfiler::readPair(const int pair, double& milliseconds)
+{
+    uint64_t timestamps[2] = {};
+
+    auto result = mDevice->getQueryPoolResults(
+                *mQueryPool,
+                2 * pair,
+                2,
+                sizeof(timestamps),
+                timestamps,
+                sizeof(uint64_t),
+                vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+        return false;
+
+    const uint64_t ticks = (timestamps[1] - timestamps[0]) & mTimestampMask;
+    milliseconds = double(ticks) * mTimestampPeriod / 1.0e6;
+
+    return true;
+}
+
+QHash<QUuid, double> CsGpuProfiler::takeTimings()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return std::exchange(mTimings, {});
+}
+
+CsGpuProfiler::~CsGpuProfiler()
+{
+    // The command buffers might still be pending
+    for (const auto& pending : mPendingPairs)
+        pending.submission->wait();
+
+    CS_LOG_INFO("Destroying GPU profiler.");
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,124 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSGPUPROFILER_H
+#define CSGPUPROFILER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QHash>
+#include <QUuid>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsSubmission;
+
+// Measures how long the submissions of each node take on the GPU. A pair
+// of timestamps is written into the command buffer of the node, around
+// its work. The timestamps are read back once the submission has
+// finished, nothing ever waits for them.
+class CsGpuProfiler
+{
+public:
+    CsGpuProfiler(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            const uint32_t queueFamilyIndex);
+
+    // False if the queue can't write timestamps
+    bool isValid() const;
+
+    // Disabled profilers don't hand out any queries
+    bool isEnabled() const;
+    void setEnabled(const bool enabled);
+
+    // A free pair of queries, -1 if there is none.
+    // Has to be passed to submitted() or release().
+    int acquire();
+
+    // The begin goes after the barrier the work waits at and the end after
+    // the work. Both are written once the stage finished for everything
+    // before them, so waiting for earlier submissions doesn't count and
+    // nodes running one after the other don't overlap.
+    void recordBegin(
+            const vk::CommandBuffer& commandBuffer,
+            const int pair,
+            const vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eComputeShader);
+    void recordEnd(
+            const vk::CommandBuffer& commandBuffer,
+            const int pair,
+            const vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eComputeShader);
+
+    // Kept pairs are read back but stay with their command buffer, which
+    // is submitted again. It is only submitted again once this submission
+    // has finished, the results are collected before that.
+    void submitted(
+            const int pair,
+            const QUuid& node,
+            std::shared_ptr<CsSubmission> submission,
+            const bool isKept = false);
+    void release(const int pair);
+
+    // Reads back the timestamps of finished submissions
+    void collect();
+
+    // GPU milliseconds per node that were collected since the last call
+    QHash<QUuid, double> takeTimings();
+
+    ~CsGpuProfiler();
+
+private:
+    struct PendingPair
+    {
+        int pair;
+        QUuid node;
+        std::shared_ptr<CsSubmission> submission;
+        bool isKept;
+    };
+
+    void createQueryPool();
+
+    // Both have to be called with mMutex held
+    void collectLocked();
+    bool readPair(const int pair, double& milliseconds);
+
+    const vk::Device* mDevice;
+
+    // Nanoseconds per tick and the bits of a timestamp that are valid
+    float mTimestampPeriod = 0.0f;
+    uint64_t mTimestampMask = 0;
+
+    std::atomic<bool> mIsEnabled{false};
+
+    vk::UniqueQueryPool mQueryPool;
+
+    std::vector<int> mFreePairs;
+    std::vector<PendingPair> mPendingPairs;
+    QHash<QUuid, double> mTimings;
+    std::mutex mMutex;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSGPUPROFILER_H
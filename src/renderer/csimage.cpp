@@ -20,34 +20,36 @@
 #include "csimage.h"
 
 #include "../log.h"
+#include "csdeletionqueue.h"
+#include "csdescriptorallocator.h"
 #include "renderconfig.h"
 #include "../benchmark.h"
 
 namespace Cascade::Renderer {
 
-CsImage::CsImage(
-        VulkanWindow* win,
-        const vk::Device* d,
-        const vk::PhysicalDevice* pd,
+// What the GPU may still be using once the image is gone,
+// destroyed from the last member to the first
+struct RetiredImage
+{
+    std::unique_ptr<CsAllocation> allocation;
+    std::shared_ptr<const CsAllocation> sharedMemory;
+    vk::UniqueImage image;
+    vk::UniqueImageView view;
+    std::unique_ptr<CsDescriptorSet> descriptorSet;
+};
+
+static vk::ImageCreateInfo imageCreateInfo(
         const int w,
         const int h,
         const bool isLinear,
-        const char* debugName)
-        : mDevice(d),
-          mPhysicalDevice(pd),
-          mWidth(w),
-          mHeight(h)
+        const ImagePrecision precision,
+        const vk::ImageLayout initialLayout)
 {
-    mWindow = win;
-
-    isLinear ? mCurrentLayout = vk::ImageLayout::eUndefined :
-               mCurrentLayout = vk::ImageLayout::ePreinitialized;
-
-    vk::ImageCreateInfo imageInfo(
+    return vk::ImageCreateInfo(
                 {},
                 vk::ImageType::e2D,
-                vk::Format::eR32G32B32A32Sfloat,
-                vk::Extent3D(mWidth, mHeight, 1),
+                getImageFormat(precision),
+                vk::Extent3D(w, h, 1),
                 1,
                 1,
                 vk::SampleCountFlagBits::e1,
@@ -62,60 +64,120 @@ CsImage::CsImage(
                 vk::SharingMode::eExclusive,
                 {},
                 {},
-                mCurrentLayout);
-    mImage = mDevice->createImageUnique(imageInfo).value;
+                initialLayout);
+}
 
-#ifdef QT_DEBUG
-    {
-        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-                    vk::ObjectType::eImage,
-                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkImage, *mImage),
-                    debugName);
-         [[maybe_unused]] auto result = mDevice->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
-    }
-#endif
+CsImage::CsImage(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        CsDeletionQueue* deletionQueue,
+        const int w,
+        const int h,
+        const bool isLinear,
+        const char* debugName)
+        : mDevice(d),
+          mPhysicalDevice(pd),
+          mDeletionQueue(deletionQueue),
+          mWidth(w),
+          mHeight(h),
+          mPrecision(isLinear ? ImagePrecision::Float32 : getImagePrecision())
+{
+    isLinear ? mCurrentLayout = vk::ImageLayout::eUndefined :
+               mCurrentLayout = vk::ImageLayout::ePreinitialized;
+
+    createImage(isLinear, debugName);
 
     // Get how much memory we need and how it should aligned
     vk::MemoryRequirements memReq = mDevice->getImageMemoryRequirements(*mImage);
 
-    // Make sure linear images get memory visible to the CPU
-    uint32_t memIndex = 0;
-
-    isLinear ? memIndex = mWindow->hostVisibleMemoryIndex() :
-               memIndex = mWindow->deviceLocalMemoryIndex();
+    mSizeInBytes = memReq.size;
 
-    if (!(memReq.memoryTypeBits & (1 << memIndex)))
+    // Make sure linear images get memory visible to the CPU
+    mAllocation = allocator->allocate(
+                memReq,
+                isLinear ? vk::MemoryPropertyFlagBits::eHostVisible |
+                           vk::MemoryPropertyFlagBits::eHostCoherent :
+                           vk::MemoryPropertyFlagBits::eDeviceLocal,
+                isLinear);
+    if (!mAllocation)
     {
-        vk::PhysicalDeviceMemoryProperties physDevMemProps = mPhysicalDevice->getMemoryProperties();
-        for (uint32_t i = 0; i < physDevMemProps.memoryTypeCount; ++i)
-        {
-            if (!(memReq.memoryTypeBits & (1 << i)))
-                continue;
-            memIndex = i;
-        }
+        CS_LOG_WARNING("Could not allocate image memory.");
+        return;
     }
 
-    vk::MemoryAllocateInfo allocInfo(memReq.size, memIndex);
-    mMemory = mDevice->allocateMemoryUnique(allocInfo).value;
+    //Associate the image with this chunk of memory
+     [[maybe_unused]] auto result = mDevice->bindImageMemory(
+         *mImage, mAllocation->getMemory(), mAllocation->getOffset());
+
+    createView();
+}
+
+CsImage::CsImage(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsDeletionQueue* deletionQueue,
+        const int w,
+        const int h,
+        std::shared_ptr<const CsAllocation> memory,
+        const char* debugName)
+        : mDevice(d),
+          mPhysicalDevice(pd),
+          mDeletionQueue(deletionQueue),
+          mSharedMemory(std::move(memory)),
+          mWidth(w),
+          mHeight(h),
+          mPrecision(getImagePrecision())
+{
+    // Whatever the previous image left in the memory is meaningless
+    mCurrentLayout = vk::ImageLayout::eUndefined;
+
+    createImage(false, debugName);
+
+    mSizeInBytes = mDevice->getImageMemoryRequirements(*mImage).size;
+
+    [[maybe_unused]] auto result = mDevice->bindImageMemory(
+        *mImage, mSharedMemory->getMemory(), mSharedMemory->getOffset());
+
+    createView();
+}
+
+vk::MemoryRequirements CsImage::getMemoryRequirements(
+        const vk::Device* d,
+        const int w,
+        const int h)
+{
+    auto image = d->createImageUnique(
+        imageCreateInfo(w, h, false, getImagePrecision(), vk::ImageLayout::eUndefined)).value;
+
+    return d->getImageMemoryRequirements(*image);
+}
+
+void CsImage::createImage(const bool isLinear, const char* debugName)
+{
+    mImage = mDevice->createImageUnique(
+        imageCreateInfo(mWidth, mHeight, isLinear, mPrecision, mCurrentLayout)).value;
 
 #ifdef QT_DEBUG
     {
         vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-                    vk::ObjectType::eDeviceMemory,
-                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkDeviceMemory, *mMemory),
+                    vk::ObjectType::eImage,
+                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkImage, *mImage),
                     debugName);
          [[maybe_unused]] auto result = mDevice->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
     }
+#else
+    Q_UNUSED(debugName);
 #endif
+}
 
-    //Associate the image with this chunk of memory
-     [[maybe_unused]] auto result = mDevice->bindImageMemory(*mImage, *mMemory, 0);
-
+void CsImage::createView()
+{
     vk::ImageViewCreateInfo viewInfo(
                 { },
                 *mImage,
                 vk::ImageViewType::e2D,
-                vk::Format::eR32G32B32A32Sfloat,
+                getImageFormat(mPrecision),
                 vk::ComponentMapping(vk::ComponentSwizzle::eR,
                                      vk::ComponentSwizzle::eG,
                                      vk::ComponentSwizzle::eB,
@@ -139,9 +201,9 @@ const vk::UniqueImageView& CsImage::getImageView() const
     return mView;
 }
 
-const vk::UniqueDeviceMemory& CsImage::getMemory() const
+void* CsImage::getMappedData() const
 {
-    return mMemory;
+    return mAllocation ? mAllocation->getMappedData() : nullptr;
 }
 
 vk::ImageLayout CsImage::getLayout() const
@@ -149,37 +211,6 @@ vk::ImageLayout CsImage::getLayout() const
     return mCurrentLayout;
 }
 
-void CsImage::transitionLayoutTo(vk::UniqueCommandBuffer &cb, vk::ImageLayout layout)
-{
-    // Note: The command buffer must be active
-    vk::ImageMemoryBarrier barrier(
-                vk::AccessFlagBits::eMemoryRead,
-                vk::AccessFlagBits::eShaderRead |
-                vk::AccessFlagBits::eShaderWrite,
-                mCurrentLayout,
-                layout,
-                {},
-                {},
-                *mImage,
-                vk::ImageSubresourceRange
-                {
-                    vk::ImageAspectFlagBits::eColor,
-                    0,
-                    1,
-                    0,
-                    1});
-
-    cb->pipelineBarrier(
-                vk::PipelineStageFlagBits::eTopOfPipe,
-                vk::PipelineStageFlagBits::eComputeShader,
-                {},
-                {},
-                {},
-                barrier);
-
-    setLayout(layout);
-}
-
 void CsImage::setLayout(const vk::ImageLayout& layout)
 {
     mCurrentLayout = layout;
@@ -195,6 +226,89 @@ int CsImage::getHeight() const
     return mHeight;
 }
 
+ImagePrecision CsImage::getPrecision() const
+{
+    return mPrecision;
+}
+
+vk::DeviceSize CsImage::getSizeInBytes() const
+{
+    return mSizeInBytes;
+}
+
+uint64_t CsImage::getContentHash() const
+{
+    std::lock_guard<std::mutex> lock(mContentHashMutex);
+
+    if (mResolveContentHash)
+    {
+        mContentHash = mResolveContentHash(true);
+        mResolveContentHash = nullptr;
+    }
+
+    return mContentHash;
+}
+
+uint64_t CsImage::peekContentHash() const
+{
+    std::lock_guard<std::mutex> lock(mContentHashMutex);
+
+    if (mResolveContentHash)
+    {
+        mContentHash = mResolveContentHash(false);
+        if (mContentHash)
+            mResolveContentHash = nullptr;
+    }
+
+    return mContentHash;
+}
+
+void CsImage::setContentHash(const uint64_t hash)
+{
+    std::lock_guard<std::mutex> lock(mContentHashMutex);
+
+    mContentHash = hash;
+    mResolveContentHash = nullptr;
+}
+
+void CsImage::setContentHash(std::function<uint64_t(const bool wait)> resolve)
+{
+    std::lock_guard<std::mutex> lock(mContentHashMutex);
+
+    mContentHash = 0;
+    mResolveContentHash = std::move(resolve);
+}
+
+QRect CsImage::getValidRegion() const
+{
+    return mValidRegion;
+}
+
+void CsImage::setValidRegion(const QRect& region)
+{
+    mValidRegion = region;
+}
+
+bool CsImage::isRecycled() const
+{
+    return mIsRecycled;
+}
+
+void CsImage::setRecycled(const bool recycled)
+{
+    mIsRecycled = recycled;
+}
+
+CsDescriptorSet* CsImage::getDescriptorSet() const
+{
+    return mDescriptorSet.get();
+}
+
+void CsImage::setDescriptorSet(std::unique_ptr<CsDescriptorSet> set)
+{
+    mDescriptorSet = std::move(set);
+}
+
 void CsImage::destroy()
 {
 
@@ -202,9 +316,16 @@ void CsImage::destroy()
 
 CsImage::~CsImage()
 {
-    // Need to make sure this image is not used by any command buffer
-    auto result = mDevice->waitIdle();
-    Q_UNUSED(result);
+    // Command buffers that are still executing may use the image,
+    // so it is only destroyed once they have finished
+    auto retired = std::make_shared<RetiredImage>();
+    retired->allocation = std::move(mAllocation);
+    retired->sharedMemory = std::move(mSharedMemory);
+    retired->image = std::move(mImage);
+    retired->view = std::move(mView);
+    retired->descriptorSet = std::move(mDescriptorSet);
+
+    mDeletionQueue->retire(std::move(retired));
 }
 
 } // end namespace Cascade::Renderer
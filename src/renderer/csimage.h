@@ -20,55 +20,136 @@
 #ifndef CSIMAGE_H
 #define CSIMAGE_H
 
-#include <QVulkanDeviceFunctions>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 
-#include <vulkan/vulkan.h>
+#include <QRect>
 
-#include "../vulkanwindow.h"
 #include "vulkanhppinclude.h"
+#include "csmemoryallocator.h"
+#include "imageprecision.h"
 
 namespace Cascade::Renderer {
 
+class CsDeletionQueue;
+class CsDescriptorSet;
+
 class CsImage
 {
 public:
-    CsImage(VulkanWindow* win,
-            const vk::Device* d,
+    // Memory comes from the allocator, linear images are host visible.
+    // When the image is destroyed, its handles go to the deletion queue.
+    CsImage(const vk::Device* d,
             const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            CsDeletionQueue* deletionQueue,
             const int w = 100,
             const int h = 100,
             const bool isLinear = false,
             const char* debugName = "Unnamed");
 
+    // Bound to the start of an allocation that other images may have used
+    // before. It has to satisfy getMemoryRequirements() for the size.
+    CsImage(const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsDeletionQueue* deletionQueue,
+            const int w,
+            const int h,
+            std::shared_ptr<const CsAllocation> memory,
+            const char* debugName = "Unnamed");
+
+    // What a storage image of the given size needs, without allocating it
+    static vk::MemoryRequirements getMemoryRequirements(
+            const vk::Device* d,
+            const int w,
+            const int h);
+
     const vk::UniqueImage& getImage() const;
     const vk::UniqueImageView& getImageView() const;
-    const vk::UniqueDeviceMemory& getMemory() const;
-
+    // Start of the pixels of a linear image, nullptr for optimal ones
+    void* getMappedData() const;
+
+    // Layout the image is left in by the recorded command buffers. They
+    // keep the layouts in between in their BarrierPlanner and only store
+    // the final one. Finished images are in the general layout, which the
+    // shaders read them in, so readers don't transition them and branches
+    // reading the same image don't interfere.
     vk::ImageLayout getLayout() const;
-    void transitionLayoutTo(vk::UniqueCommandBuffer& cb,
-                            vk::ImageLayout layout);
     void setLayout(const vk::ImageLayout& layout);
 
     int getWidth() const;
     int getHeight() const;
 
+    // Fixed when the image is created, linear images are always Float32
+    ImagePrecision getPrecision() const;
+
+    // Device memory taken up by this image
+    vk::DeviceSize getSizeInBytes() const;
+
+    // Hash of the pixel data, 0 if it hasn't been computed
+    uint64_t getContentHash() const;
+    // Like getContentHash(), but 0 while the GPU is still computing it
+    uint64_t peekContentHash() const;
+    void setContentHash(const uint64_t hash);
+    // For a hash that is still being computed on the GPU. resolve is
+    // called with wait set by getContentHash() and without by
+    // peekContentHash(), it returns 0 if it didn't wait and the hash
+    // isn't there yet. The first hash it returns is kept.
+    void setContentHash(std::function<uint64_t(const bool wait)> resolve);
+
+    // The pixels that were actually computed, null if all of them were
+    QRect getValidRegion() const;
+    void setValidRegion(const QRect& region);
+
+    // Owned by a recorded command buffer that writes to it again once
+    // nothing else holds it, so it must not go into the render cache
+    bool isRecycled() const;
+    void setRecycled(const bool recycled);
+
+    // Set by CsDescriptorAllocator the first time the image is bound
+    CsDescriptorSet* getDescriptorSet() const;
+    void setDescriptorSet(std::unique_ptr<CsDescriptorSet> set);
+
     void destroy();
 
     ~CsImage();
 
 private:
+    void createImage(const bool isLinear, const char* debugName);
+    void createView();
+
+    // Declared first so that it outlives the image bound to it
+    std::unique_ptr<CsAllocation> mAllocation;
     vk::UniqueImage mImage;
     vk::UniqueImageView mView;
-    vk::UniqueDeviceMemory mMemory;
+    std::unique_ptr<CsDescriptorSet> mDescriptorSet;
 
-    VulkanWindow* mWindow;
     const vk::Device* mDevice;
     const vk::PhysicalDevice* mPhysicalDevice;
+    CsDeletionQueue* mDeletionQueue;
+
+    // Set instead of mAllocation for aliased images
+    std::shared_ptr<const CsAllocation> mSharedMemory;
 
-    vk::ImageLayout mCurrentLayout = vk::ImageLayout::eUndefined;
+    std::atomic<vk::ImageLayout> mCurrentLayout = vk::ImageLayout::eUndefined;
 
     const int mWidth;
     const int mHeight;
+
+    const ImagePrecision mPrecision;
+
+    vk::DeviceSize mSizeInBytes = 0;
+
+    mutable uint64_t mContentHash = 0;
+    mutable std::function<uint64_t(const bool wait)> mResolveContentHash;
+    // Branches that read the image can ask for the hash at the same time
+    mutable std::mutex mContentHashMutex;
+
+    QRect mValidRegion;
+
+    bool mIsRecycled = false;
 };
 
 } // end namespace Cascade::Renderer
@@ -0,0 +1,375 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csimagehasher.h"
+
+#include <algorithm>
+
+#include <QFile>
+
+#include "../log.h"
+#include "../shadercompiler/SpvShaderCompiler.h"
+#include "cscommandbuffer.h"
+#include "csdescriptorallocator.h"
+#include "csimage.h"
+#include "renderconfig.h"
+#include "renderhash.h"
+
+namespace Cascade::Renderer {
+
+// Hashes are read back when the next node needs them, so a
+// branch can have more than one in flight
+static constexpr int maxHashesInFlight = 2 * maxParallelBranches;
+
+CsImageHasher::CsImageHasher(
+        const vk::Device* d,
+        CsMemoryAllocator* allocator,
+        CsDescriptorAllocator* descriptorAllocator,
+        vk::PipelineCache* pipelineCache) :
+    mDevice(d),
+    mMemoryAllocator(allocator),
+    mDescriptorAllocator(descriptorAllocator)
+{
+    createDescriptors();
+
+    if (createPipeline(pipelineCache))
+        CS_LOG_INFO("Created image hasher.");
+}
+
+void CsImageHasher::createDescriptors()
+{
+    // The buffer the hash is accumulated in, the image brings its own set
+    vk::DescriptorSetLayoutBinding binding(
+        0,
+        vk::DescriptorType::eStorageBuffer,
+        1,
+        vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutCreateInfo descSetLayoutCreateInfo({}, 1, &binding);
+
+    mDescriptorSetLayout =
+        mDevice->createDescriptorSetLayoutUnique(descSetLayoutCreateInfo).value;
+
+    // One slot per hash in flight
+    std::vector<vk::DescriptorPoolSize> descPoolSizes = {
+        {vk::DescriptorType::eStorageBuffer, uint32_t(maxHashesInFlight)}};
+
+    vk::DescriptorPoolCreateInfo descPoolInfo(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        maxHashesInFlight,
+        static_cast<uint32_t>(descPoolSizes.size()),
+        descPoolSizes.data());
+
+    mDescriptorPool = mDevice->createDescriptorPoolUnique(descPoolInfo).value;
+}
+
+bool CsImageHasher::createPipeline(vk::PipelineCache* pipelineCache)
+{
+    // There is no build step for SPIR-V, the shader gets compiled when it is needed
+    QFile file(":/shaders/hash.comp");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        CS_LOG_WARNING("Failed to read hash shader.");
+        return false;
+    }
+    QByteArray code = file.readAll();
+    file.close();
+
+    SpvCompiler compiler;
+    if (!compiler.compileGLSLFromCode(code.toStdString(), "comp"))
+    {
+        CS_LOG_WARNING("Failed to compile hash shader:");
+        CS_LOG_WARNING(QString::fromStdString(compiler.getError()));
+        return false;
+    }
+    std::vector<unsigned int> spirV = compiler.getSpirV();
+    patchStorageImageFormat(spirV);
+
+    vk::ShaderModuleCreateInfo shaderInfo(
+        {}, spirV.size() * sizeof(unsigned int), spirV.data());
+
+    vk::UniqueShaderModule shaderModule = mDevice->createShaderModuleUnique(shaderInfo).value;
+
+    // The image to hash and the result buffer
+    std::vector<vk::DescriptorSetLayout> setLayouts = {
+        mDescriptorAllocator->getImageSetLayout(),
+        *mDescriptorSetLayout};
+
+    // Offset and size of the region that is hashed
+    vk::PushConstantRange pushConstantRange(
+        vk::ShaderStageFlagBits::eCompute, 0, sizeof(int32_t) * 4);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
+        {}, static_cast<uint32_t>(setLayouts.size()), setLayouts.data(), 1, &pushConstantRange);
+
+    mPipelineLayout = mDevice->createPipelineLayoutUnique(pipelineLayoutInfo).value;
+
+    vk::PipelineShaderStageCreateInfo computeStage(
+        {}, vk::ShaderStageFlagBits::eCompute, *shaderModule, "main");
+
+    // The dispatch starts at the region
+    vk::ComputePipelineCreateInfo pipelineInfo(
+        vk::PipelineCreateFlagBits::eDispatchBase, computeStage, *mPipelineLayout);
+
+    mPipeline = mDevice->createComputePipelineUnique(*pipelineCache, pipelineInfo).value;
+
+    return isValid();
+}
+
+bool CsImageHasher::isValid() const
+{
+    return static_cast<bool>(mPipeline);
+}
+
+std::function<uint64_t(const bool wait)> CsImageHasher::hash(
+        CsImage* const image,
+        CsCommandBuffer* const commandBuffer)
+{
+    if (!isValid() || !image || !commandBuffer)
+        return nullptr;
+
+    const auto imageSet = mDescriptorAllocator->getImageSet(image);
+    if (!imageSet)
+        return nullptr;
+
+    const QRect imageRect(0, 0, image->getWidth(), image->getHeight());
+    const QRect validRegion = image->getValidRegion();
+    const QRect region = validRegion.isNull() ? imageRect : validRegion.intersected(imageRect);
+
+    auto slot = acquireSlot();
+    if (!slot)
+        return nullptr;
+
+    commandBuffer->recordHash(
+        image,
+        region,
+        *mPipeline,
+        *mPipelineLayout,
+        { imageSet, *slot->descriptorSet },
+        *slot->buffer);
+
+    auto pending = std::make_shared<PendingHash>();
+    pending->submission = commandBuffer->submitHash();
+    pending->slot = std::move(slot);
+    pending->region = region;
+
+    if (!pending->submission)
+    {
+        releaseSlot(*mSlots, std::move(pending->slot));
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mSlots->mutex);
+
+        auto& all = mSlots->pending;
+        all.erase(
+            std::remove_if(
+                all.begin(),
+                all.end(),
+                [](const auto& p) { return p->isResolved.load(); }),
+            all.end());
+        all.push_back(pending);
+    }
+
+    // Once the hasher is gone everything is resolved,
+    // only the shared slots are touched after that
+    return [slots = mSlots, pending](const bool wait)
+    {
+        return resolve(*slots, *pending, wait);
+    };
+}
+
+uint64_t CsImageHasher::resolve(Slots& slots, PendingHash& pending, const bool wait)
+{
+    std::lock_guard<std::mutex> lock(pending.mutex);
+
+    if (pending.isResolved)
+        return pending.value;
+
+    if (!wait && !pending.submission->isFinished())
+        return 0;
+
+    pending.submission->wait();
+
+    uint64_t hash = static_cast<uint64_t>(pending.slot->lanes[0]) << 32 | pending.slot->lanes[1];
+
+    // Regions of different size or position can sum up to the same value
+    hash = hashCombine(hash, static_cast<uint64_t>(pending.region.x()));
+    hash = hashCombine(hash, static_cast<uint64_t>(pending.region.y()));
+    hash = hashCombine(hash, static_cast<uint64_t>(pending.region.width()));
+    hash = hashCombine(hash, static_cast<uint64_t>(pending.region.height()));
+
+    // 0 is reserved for "unknown"
+    pending.value = hash ? hash : 1;
+    pending.submission = nullptr;
+    releaseSlot(slots, std::move(pending.slot));
+    pending.isResolved = true;
+
+    return pending.value;
+}
+
+std::unique_ptr<CsImageHasher::Slot> CsImageHasher::acquireSlot()
+{
+    while (true)
+    {
+        std::shared_ptr<PendingHash> oldest;
+        {
+            std::lock_guard<std::mutex> lock(mSlots->mutex);
+
+            if (!mSlots->free.empty())
+            {
+                auto slot = std::move(mSlots->free.back());
+                mSlots->free.pop_back();
+
+                return slot;
+            }
+
+            if (mSlots->count < maxHashesInFlight)
+            {
+                mSlots->count++;
+                break;
+            }
+
+            // Nobody asked for the oldest hash yet, read it back now
+            auto& pending = mSlots->pending;
+            const auto it = std::find_if(
+                pending.begin(),
+                pending.end(),
+                [](const auto& p) { return !p->isResolved.load(); });
+
+            if (it == pending.end())
+            {
+                CS_LOG_WARNING("No free slot for hashing image.");
+                return nullptr;
+            }
+            oldest = *it;
+            pending.erase(pending.begin(), it + 1);
+        }
+
+        // Puts its slot back, unless someone else was faster
+        resolve(*mSlots, *oldest, true);
+    }
+
+    auto slot = createSlot();
+
+    // Out of memory, the slot can be created again later
+    if (!slot)
+    {
+        std::lock_guard<std::mutex> lock(mSlots->mutex);
+        mSlots->count--;
+    }
+
+    return slot;
+}
+
+void CsImageHasher::releaseSlot(Slots& slots, std::unique_ptr<Slot> slot)
+{
+    std::lock_guard<std::mutex> lock(slots.mutex);
+
+    slots.free.push_back(std::move(slot));
+}
+
+std::unique_ptr<CsImageHasher::Slot> CsImageHasher::createSlot()
+{
+    auto slot = std::make_unique<Slot>();
+
+    vk::DescriptorSetAllocateInfo descSetAllocInfo(
+        *mDescriptorPool, 1, &(*mDescriptorSetLayout));
+
+    slot->descriptorSet =
+        std::move(mDevice->allocateDescriptorSetsUnique(descSetAllocInfo).value.front());
+
+    vk::BufferCreateInfo bufferInfo(
+                {},
+                sizeof(uint32_t) * 2,
+                vk::BufferUsageFlags(
+                    vk::BufferUsageFlagBits::eStorageBuffer |
+                    vk::BufferUsageFlagBits::eTransferDst),
+                vk::SharingMode::eExclusive);
+
+    slot->buffer = mDevice->createBufferUnique(bufferInfo).value;
+
+#ifdef QT_DEBUG
+    {
+        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
+                    vk::ObjectType::eBuffer,
+                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkBuffer, *slot->buffer),
+                    "Image Hash Buffer");
+        auto result = mDevice->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
+        Q_UNUSED(result);
+    }
+#endif
+
+    vk::MemoryRequirements memRequirements = mDevice->getBufferMemoryRequirements(*slot->buffer);
+
+    slot->memory = mMemoryAllocator->allocate(
+                memRequirements,
+                vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+                true);
+    if (!slot->memory || !slot->memory->getMappedData())
+    {
+        CS_LOG_WARNING("Could not allocate image hash buffer.");
+        return nullptr;
+    }
+
+    auto result = mDevice->bindBufferMemory(
+                *slot->buffer,
+                slot->memory->getMemory(),
+                slot->memory->getOffset());
+    if (result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Could not bind image hash buffer.");
+        return nullptr;
+    }
+
+    slot->lanes = static_cast<uint32_t*>(slot->memory->getMappedData());
+
+    vk::DescriptorBufferInfo bufferInfo(*slot->buffer, 0, VK_WHOLE_SIZE);
+
+    vk::WriteDescriptorSet descWrite(
+        *slot->descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo);
+
+    mDevice->updateDescriptorSets(descWrite, {});
+
+    return slot;
+}
+
+CsImageHasher::~CsImageHasher()
+{
+    // Images can still hold on to pending hashes, their
+    // slots go back into the free list
+    std::vector<std::shared_ptr<PendingHash>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mSlots->mutex);
+
+        pending.swap(mSlots->pending);
+    }
+    for (auto& p : pending)
+        resolve(*mSlots, *p, true);
+
+    // Slots hold descriptor sets from the pool, free them first
+    std::lock_guard<std::mutex> lock(mSlots->mutex);
+    mSlots->free.clear();
+
+    CS_LOG_INFO("Destroying image hasher.");
+}
+
+} // namespace Cascade::Renderer
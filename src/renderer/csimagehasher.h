@@ -0,0 +1,128 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSIMAGEHASHER_H
+#define CSIMAGEHASHER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QRect>
+
+#include "csmemoryallocator.h"
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsCommandBuffer;
+class CsDescriptorAllocator;
+class CsImage;
+class CsSubmission;
+
+// Computes a content hash of an image on the GPU, so that
+// bit-identical node outputs can be detected without a readback
+class CsImageHasher
+{
+public:
+    CsImageHasher(
+            const vk::Device* d,
+            CsMemoryAllocator* allocator,
+            CsDescriptorAllocator* descriptorAllocator,
+            vk::PipelineCache* pipelineCache);
+
+    // False if the hash shader could not be set up,
+    // hash() always returns 0 in that case
+    bool isValid() const;
+
+    // Records into and submits the command buffer without waiting for
+    // it. Only the valid region of the image is hashed. The returned
+    // function blocks until the hash is available if wait is set and
+    // returns 0 if it isn't available yet otherwise. It can still be
+    // called once the hasher is gone. nullptr if nothing was submitted.
+    // Can be called from several threads.
+    std::function<uint64_t(const bool wait)> hash(
+            CsImage* const image,
+            CsCommandBuffer* const commandBuffer);
+
+    ~CsImageHasher();
+
+private:
+    // Result buffer for one hash in flight, its descriptor
+    // set is written once when it is created
+    struct Slot
+    {
+        vk::UniqueDescriptorSet descriptorSet;
+        vk::UniqueBuffer buffer;
+        std::unique_ptr<CsAllocation> memory;
+        uint32_t* lanes = nullptr;
+    };
+
+    // A hash that was submitted but hasn't been read back,
+    // it holds on to its slot until then
+    struct PendingHash
+    {
+        std::mutex mutex;
+        std::unique_ptr<Slot> slot;
+        std::shared_ptr<CsSubmission> submission;
+        QRect region;
+        std::atomic<bool> isResolved{false};
+        uint64_t value = 0;
+    };
+
+    // Shared with the functions hash() returns, which
+    // images can hold on to after the hasher is gone
+    struct Slots
+    {
+        std::vector<std::unique_ptr<Slot>> free;
+        // Oldest first, resolved ones are only removed now and then
+        std::vector<std::shared_ptr<PendingHash>> pending;
+        int count = 0;
+        std::mutex mutex;
+    };
+
+    void createDescriptors();
+    bool createPipeline(vk::PipelineCache* pipelineCache);
+
+    std::unique_ptr<Slot> acquireSlot();
+    static void releaseSlot(Slots& slots, std::unique_ptr<Slot> slot);
+    std::unique_ptr<Slot> createSlot();
+
+    // Reads the hash back and releases its slot, 0 if it
+    // isn't available yet and wait isn't set
+    static uint64_t resolve(Slots& slots, PendingHash& pending, const bool wait);
+
+
+    const vk::Device* mDevice;
+    CsMemoryAllocator* mMemoryAllocator;
+    CsDescriptorAllocator* mDescriptorAllocator;
+
+    vk::UniqueDescriptorSetLayout mDescriptorSetLayout;
+    vk::UniqueDescriptorPool mDescriptorPool;
+    vk::UniquePipelineLayout mPipelineLayout;
+    vk::UniquePipeline mPipeline;
+
+    std::shared_ptr<Slots> mSlots = std::make_shared<Slots>();
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSIMAGEHASHER_H
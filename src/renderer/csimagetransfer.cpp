@@ -0,0 +1,122 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csimagetransfer.h"
+
+#include "../multithreading.h"
+#include "cscommandbuffer.h"
+#include "csimage.h"
+#include "csstagingbuffer.h"
+#include "imageprecision.h"
+#include "renderconfig.h"
+
+namespace Cascade::Renderer {
+
+CsImageTransfer::CsImageTransfer(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        CsDeletionQueue* deletionQueue,
+        CsCommandBuffer* readbackCommandBuffer,
+        CsCommandBuffer* uploadCommandBuffer) :
+    mDevice(d),
+    mPhysicalDevice(pd),
+    mMemoryAllocator(allocator),
+    mDeletionQueue(deletionQueue),
+    mReadbackCommandBuffer(readbackCommandBuffer),
+    mUploadCommandBuffer(uploadCommandBuffer),
+    mStagingBuffer(std::make_unique<CsStagingBuffer>(d, allocator, stagingBufferSize))
+{
+}
+
+bool CsImageTransfer::readImage(CsImage* const image, std::vector<float>& pixels)
+{
+    std::lock_guard<std::mutex> lock(mReadImageMutex);
+
+    auto pInput = static_cast<const float*>(mReadbackCommandBuffer->recordImageSave(image));
+    if (!pInput)
+        return false;
+
+    mReadbackCommandBuffer->submitImageSave();
+
+    // Not the whole device, batches upload and compute the next frames meanwhile
+    mReadbackCommandBuffer->waitForPreviousSubmission();
+
+    const int width  = image->getWidth();
+    const int height = image->getHeight();
+
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    if (image->getPrecision() == ImagePrecision::Float16)
+        parallelHalfToFloat(reinterpret_cast<const uint16_t*>(pInput), pixels.data(), pixels.size());
+    else
+        parallelArrayCopy(pInput, pixels.data(), width, height);
+
+    return true;
+}
+
+std::shared_ptr<CsImage> CsImageTransfer::uploadImage(const float* pixels, const QSize& size)
+{
+    auto image = createImage(size);
+
+    if (!mUploadCommandBuffer->recordImageUpload(pixels, image.get()))
+        return nullptr;
+
+    mUploadCommandBuffer->submitImageUpload();
+    mUploadCommandBuffer->waitForPreviousSubmission();
+
+    return image;
+}
+
+std::unique_ptr<CsStagingRegion> CsImageTransfer::acquireStagingRegion(const QSize& size)
+{
+    return mStagingBuffer->acquire(
+        static_cast<vk::DeviceSize>(size.width()) * size.height() * getBytesPerPixel());
+}
+
+std::shared_ptr<CsImage> CsImageTransfer::uploadStagedImage(
+        std::unique_ptr<CsStagingRegion> region,
+        const QSize& size)
+{
+    auto image = createImage(size);
+
+    mUploadCommandBuffer->recordBufferUpload(region->getBuffer(), region->getOffset(), image.get());
+
+    mUploadCommandBuffer->submitImageUpload();
+    mUploadCommandBuffer->waitForPreviousSubmission();
+
+    return image;
+}
+
+std::shared_ptr<CsImage> CsImageTransfer::createImage(const QSize& size)
+{
+    return std::make_shared<CsImage>(
+        mDevice,
+        mPhysicalDevice,
+        mMemoryAllocator,
+        mDeletionQueue,
+        size.width(),
+        size.height(),
+        false,
+        "Uploaded Image");
+}
+
+CsImageTransfer::~CsImageTransfer() = default;
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,84 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSIMAGETRANSFER_H
+#define CSIMAGETRANSFER_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QSize>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsCommandBuffer;
+class CsDeletionQueue;
+class CsImage;
+class CsMemoryAllocator;
+class CsStagingBuffer;
+class CsStagingRegion;
+
+// Moves pixels between the CPU and images on the GPU, the part of
+// RenderDevice that the viewer's renderer and the headless one share.
+// Reading back and uploading use command buffers of their own, so that
+// they don't wait for each other. See RenderDevice for the functions.
+class CsImageTransfer
+{
+public:
+    CsImageTransfer(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            CsDeletionQueue* deletionQueue,
+            CsCommandBuffer* readbackCommandBuffer,
+            CsCommandBuffer* uploadCommandBuffer);
+
+    bool readImage(CsImage* const image, std::vector<float>& pixels);
+
+    std::shared_ptr<CsImage> uploadImage(const float* pixels, const QSize& size);
+
+    std::unique_ptr<CsStagingRegion> acquireStagingRegion(const QSize& size);
+
+    std::shared_ptr<CsImage> uploadStagedImage(
+            std::unique_ptr<CsStagingRegion> region,
+            const QSize& size);
+
+    ~CsImageTransfer();
+
+private:
+    std::shared_ptr<CsImage> createImage(const QSize& size);
+
+    const vk::Device* mDevice;
+    const vk::PhysicalDevice* mPhysicalDevice;
+    CsMemoryAllocator* mMemoryAllocator;
+    CsDeletionQueue* mDeletionQueue;
+
+    CsCommandBuffer* mReadbackCommandBuffer;
+    CsCommandBuffer* mUploadCommandBuffer;
+    std::mutex mReadImageMutex;
+
+    std::unique_ptr<CsStagingBuffer> mStagingBuffer;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSIMAGETRANSFER_H
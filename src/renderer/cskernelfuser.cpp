@@ -0,0 +1,551 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "cskernelfuser.h"
+
+#include <algorithm>
+
+#include "../log.h"
+#include "../shadercompiler/SpvShaderCompiler.h"
+#include "cscommandbuffer.h"
+#include "csdescriptorallocator.h"
+#include "csgpuprofiler.h"
+#include "csimage.h"
+#include "kernelfusion.h"
+#include "renderconfig.h"
+
+namespace Cascade::Renderer {
+
+// Two per chain that is being edited, the viewer can still
+// show the result of one while the other is written
+static constexpr size_t maxRecordedDispatches = 2 * maxParallelBranches;
+
+// Every branch can have a few dispatches in flight,
+// the recorded dispatches keep their slots
+static constexpr int maxFusedSlots =
+    maxParallelBranches * maxSubmissionsInFlight + maxRecordedDispatches;
+
+CsKernelFuser::CsKernelFuser(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        CsDeletionQueue* deletionQueue,
+        CsDescriptorAllocator* descriptorAllocator,
+        vk::PipelineCache* pipelineCache) :
+    mDevice(d),
+    mPhysicalDevice(pd),
+    mMemoryAllocator(allocator),
+    mDeletionQueue(deletionQueue),
+    mDescriptorAllocator(descriptorAllocator),
+    mPipelineCache(pipelineCache)
+{
+    createDescriptors();
+
+    CS_LOG_INFO("Created kernel fuser.");
+}
+
+void CsKernelFuser::createDescriptors()
+{
+    // The parameters of all kernels, the images bring their own sets
+    vk::DescriptorSetLayoutBinding binding(
+        0,
+        vk::DescriptorType::eUniformBuffer,
+        1,
+        vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutCreateInfo descSetLayoutCreateInfo({}, 1, &binding);
+
+    mDescriptorSetLayout =
+        mDevice->createDescriptorSetLayoutUnique(descSetLayoutCreateInfo).value;
+
+    // One slot per submission the graph executor can have in flight
+    std::vector<vk::DescriptorPoolSize> descPoolSizes = {
+        {vk::DescriptorType::eUniformBuffer, uint32_t(maxFusedSlots)}};
+
+    vk::DescriptorPoolCreateInfo descPoolInfo(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        maxFusedSlots,
+        static_cast<uint32_t>(descPoolSizes.size()),
+        descPoolSizes.data());
+
+    mDescriptorPool = mDevice->createDescriptorPoolUnique(descPoolInfo).value;
+
+    // Input image, result image and parameters
+    std::vector<vk::DescriptorSetLayout> setLayouts = {
+        mDescriptorAllocator->getImageSetLayout(),
+        mDescriptorAllocator->getImageSetLayout(),
+        *mDescriptorSetLayout};
+
+    // The input offset of the region
+    vk::PushConstantRange pushConstantRange(
+        vk::ShaderStageFlagBits::eCompute, 0, 2 * sizeof(int32_t));
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
+        {},
+        static_cast<uint32_t>(setLayouts.size()),
+        setLayouts.data(),
+        1,
+        &pushConstantRange);
+
+    mPipelineLayout = mDevice->createPipelineLayoutUnique(pipelineLayoutInfo).value;
+}
+
+vk::Pipeline* CsKernelFuser::getPipeline(const std::vector<PointwiseKernel>& kernels)
+{
+    const std::string signature = fusedKernelSignature(kernels);
+
+    // Compiling blocks the other branches, but only once per chain
+    std::lock_guard<std::mutex> lock(mPipelineMutex);
+
+    if (auto it = mPipelines.find(signature); it != mPipelines.end())
+        return it->second ? &(*it->second) : nullptr;
+
+    auto& pipeline = mPipelines[signature];
+
+    SpvCompiler compiler;
+    if (!compiler.compileGLSLFromCode(generateFusedShader(kernels), "comp"))
+    {
+        CS_LOG_WARNING("Failed to compile fused kernel " + QString::fromStdString(signature) + ":");
+        CS_LOG_WARNING(QString::fromStdString(compiler.getError()));
+        return nullptr;
+    }
+    std::vector<unsigned int> spirV = compiler.getSpirV();
+    patchStorageImageFormat(spirV);
+
+    vk::ShaderModuleCreateInfo shaderInfo(
+        {}, spirV.size() * sizeof(unsigned int), spirV.data());
+
+    vk::UniqueShaderModule shaderModule = mDevice->createShaderModuleUnique(shaderInfo).value;
+
+    vk::PipelineShaderStageCreateInfo computeStage(
+        {}, vk::ShaderStageFlagBits::eCompute, *shaderModule, "main");
+
+    vk::ComputePipelineCreateInfo pipelineInfo(
+        vk::PipelineCreateFlagBits::eDispatchBase, computeStage, *mPipelineLayout);
+
+    pipeline = mDevice->createComputePipelineUnique(*mPipelineCache, pipelineInfo).value;
+
+    CS_LOG_INFO("Created fused kernel " + QString::fromStdString(signature));
+
+    return pipeline ? &(*pipeline) : nullptr;
+}
+
+std::shared_ptr<CsImage> CsKernelFuser::allocateOutput(
+        const CsImage* const input,
+        const QSize& size,
+        const char* debugName,
+        const OutputFactory& createOutput)
+{
+    // Pointwise, so the output has the size of the input unless
+    // it is a tile that only covers part of the input
+    const QSize outputSize = size.isEmpty() ?
+        QSize(input->getWidth(), input->getHeight()) : size;
+
+    if (createOutput)
+    {
+        if (auto output = createOutput(outputSize))
+            return output;
+    }
+
+    return std::make_shared<CsImage>(
+        mDevice,
+        mPhysicalDevice,
+        mMemoryAllocator,
+        mDeletionQueue,
+        outputSize.width(),
+        outputSize.height(),
+        false,
+        debugName);
+}
+
+std::shared_ptr<CsImage> CsKernelFuser::execute(
+        const std::vector<PointwiseKernel>& kernels,
+        const std::shared_ptr<CsImage>& input,
+        CsCommandBuffer* const commandBuffer,
+        const FusedRegion& region,
+        const bool isParameterUpdate,
+        const OutputFactory& createOutput)
+{
+    if (!input || !commandBuffer)
+        return nullptr;
+
+    const auto parameters = packFusedParameters(kernels);
+    if (parameters.size() > maxFusedParameters)
+        return nullptr;
+
+    auto pipeline = getPipeline(kernels);
+    if (!pipeline)
+        return nullptr;
+
+    if (isParameterUpdate)
+    {
+        return executeRecorded(
+            fusedKernelSignature(kernels),
+            parameters,
+            *pipeline,
+            input,
+            commandBuffer,
+            region);
+    }
+
+    auto slot = acquireSlot();
+    if (!slot)
+        return nullptr;
+
+    auto output = allocateOutput(
+        input.get(), region.outputSize, "Fused Kernel Result", createOutput);
+
+    // Nothing is written to the sets, they only have to be bound
+    const std::vector<vk::DescriptorSet> descriptorSets = {
+        mDescriptorAllocator->getImageSet(input.get()),
+        mDescriptorAllocator->getImageSet(output.get()),
+        *slot->descriptorSet};
+
+    if (!descriptorSets[0] || !descriptorSets[1])
+    {
+        releaseSlot(std::move(slot));
+        return nullptr;
+    }
+
+    std::copy(parameters.begin(), parameters.end(), slot->parameters);
+
+    commandBuffer->recordFused(
+        input.get(),
+        output.get(),
+        *pipeline,
+        *mPipelineLayout,
+        descriptorSets,
+        region.roi,
+        region.inputOffset);
+    commandBuffer->submitFused();
+
+    // Not reused before the GPU is done with the parameters
+    slot->submission = commandBuffer->getLastSubmission();
+    releaseSlot(std::move(slot));
+
+    return output;
+}
+
+std::shared_ptr<CsImage> CsKernelFuser::executeRecorded(
+        const std::string& signature,
+        const std::vector<float>& parameters,
+        vk::Pipeline& pipeline,
+        const std::shared_ptr<CsImage>& input,
+        CsCommandBuffer* const commandBuffer,
+        const FusedRegion& region)
+{
+    // Held while waiting for the GPU, parameter
+    // updates rarely run on several branches at once
+    std::lock_guard<std::mutex> lock(mRecordingMutex);
+
+    // Their input is gone, so they can't match anymore
+    for (auto it = mRecordedDispatches.begin(); it != mRecordedDispatches.end();)
+        it = it->input.expired() ? dropRecordedDispatch(it) : std::next(it);
+
+    // Nobody holding a reference doesn't mean the viewer is done with the
+    // output, frames it recorded before dropping it can still sample it
+    for (auto& d : mRecordedDispatches)
+    {
+        if (d.output.use_count() == 1 && !d.releaseFrame)
+            d.releaseFrame = mDeletionQueue->getFrame();
+    }
+
+    // The command buffer only stays valid for the layout the input had
+    // when it was recorded. Whoever still holds the output expects its
+    // pixels to stay the same, so it can't be written to again.
+    auto it = std::find_if(
+        mRecordedDispatches.begin(),
+        mRecordedDispatches.end(),
+        [&](const RecordedDispatch& d)
+        {
+            return d.signature == signature &&
+                   d.input.lock() == input &&
+                   d.inputLayout == input->getLayout() &&
+                   d.region == region &&
+                   d.output.use_count() == 1 &&
+                   d.releaseFrame &&
+                   mDeletionQueue->isFrameRetired(*d.releaseFrame);
+        });
+
+    if (it != mRecordedDispatches.end())
+    {
+        mRecordedDispatches.splice(mRecordedDispatches.begin(), mRecordedDispatches, it);
+    }
+    else
+    {
+        while (mRecordedDispatches.size() >= maxRecordedDispatches)
+            dropRecordedDispatch(std::prev(mRecordedDispatches.end()));
+
+        RecordedDispatch dispatch;
+        dispatch.signature = signature;
+        dispatch.input = input;
+        dispatch.inputLayout = input->getLayout();
+        dispatch.region = region;
+
+        if (!recordDispatch(dispatch, pipeline, input, commandBuffer))
+            return nullptr;
+
+        mRecordedDispatches.push_front(std::move(dispatch));
+    }
+
+    auto& dispatch = mRecordedDispatches.front();
+
+    // The command buffer can't be pending twice and the
+    // GPU might still read the previous parameters
+    if (dispatch.slot->submission)
+        dispatch.slot->submission->wait();
+
+    std::copy(parameters.begin(), parameters.end(), dispatch.slot->parameters);
+
+    commandBuffer->submitRecorded(*dispatch.commandBuffer, dispatch.queries);
+
+    dispatch.slot->submission = commandBuffer->getLastSubmission();
+
+    // Handed out again, so it has to be released again before the next reuse
+    dispatch.releaseFrame.reset();
+
+    return dispatch.output;
+}
+
+bool CsKernelFuser::recordDispatch(
+        RecordedDispatch& dispatch,
+        vk::Pipeline& pipeline,
+        const std::shared_ptr<CsImage>& input,
+        CsCommandBuffer* const commandBuffer)
+{
+    if (!mCommandPool)
+    {
+        vk::CommandPoolCreateInfo cmdPoolInfo({}, commandBuffer->getQueueFamilyIndex());
+
+        mCommandPool = mDevice->createCommandPoolUnique(cmdPoolInfo).value;
+    }
+
+    dispatch.slot = acquireSlot();
+    if (!dispatch.slot)
+        return false;
+
+    dispatch.output = allocateOutput(
+        input.get(), dispatch.region.outputSize, "Recycled Fused Kernel Result");
+    dispatch.output->setRecycled(true);
+
+    const std::vector<vk::DescriptorSet> descriptorSets = {
+        mDescriptorAllocator->getImageSet(input.get()),
+        mDescriptorAllocator->getImageSet(dispatch.output.get()),
+        *dispatch.slot->descriptorSet};
+
+    if (!descriptorSets[0] || !descriptorSets[1])
+    {
+        releaseSlot(std::move(dispatch.slot));
+        return false;
+    }
+
+    vk::CommandBufferAllocateInfo commandBufferAllocateInfo(
+                *mCommandPool,
+                vk::CommandBufferLevel::ePrimary,
+                1);
+
+    dispatch.commandBuffer = std::move(
+        mDevice->allocateCommandBuffersUnique(commandBufferAllocateInfo).value.front());
+
+    // Not one time submit, it is submitted again for every update
+    auto result = dispatch.commandBuffer->begin(vk::CommandBufferBeginInfo());
+    if (result != vk::Result::eSuccess)
+        CS_LOG_WARNING("Could not begin command buffer.");
+
+    // Recorded while the profiler is disabled, it stays untimed
+    dispatch.profiler = commandBuffer->getProfiler();
+    dispatch.queries = commandBuffer->acquireQueries();
+
+    CsCommandBuffer::recordFusedCommands(
+                dispatch.commandBuffer,
+                input.get(),
+                dispatch.output.get(),
+                pipeline,
+                *mPipelineLayout,
+                descriptorSets,
+                dispatch.region.roi,
+                dispatch.region.inputOffset,
+                dispatch.profiler,
+                dispatch.queries);
+
+    result = dispatch.commandBuffer->end();
+    if (result != vk::Result::eSuccess)
+        CS_LOG_WARNING("Could not end command buffer.");
+
+    return true;
+}
+
+std::list<CsKernelFuser::RecordedDispatch>::iterator CsKernelFuser::dropRecordedDispatch(
+        std::list<RecordedDispatch>::iterator it)
+{
+    // A pending command buffer can't be freed
+    if (it->slot->submission)
+        it->slot->submission->wait();
+
+    releaseSlot(std::move(it->slot));
+
+    if (it->queries >= 0)
+        it->profiler->release(it->queries);
+
+    return mRecordedDispatches.erase(it);
+}
+
+std::unique_ptr<CsKernelFuser::Slot> CsKernelFuser::acquireSlot()
+{
+    std::unique_ptr<Slot> slot;
+
+    {
+        std::lock_guard<std::mutex> lock(mSlotMutex);
+
+        // One the GPU is done with, otherwise the one released first
+        auto it = std::find_if(
+            mFreeSlots.begin(),
+            mFreeSlots.end(),
+            [](const auto& s) { return !s->submission || s->submission->isFinished(); });
+
+        if (it == mFreeSlots.end() && mNumSlots >= maxFusedSlots && !mFreeSlots.empty())
+            it = mFreeSlots.begin();
+
+        if (it != mFreeSlots.end())
+        {
+            slot = std::move(*it);
+            mFreeSlots.erase(it);
+        }
+    }
+
+    if (slot)
+    {
+        if (slot->submission)
+            slot->submission->wait();
+
+        return slot;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mSlotMutex);
+
+        if (mNumSlots >= maxFusedSlots)
+        {
+            CS_LOG_WARNING("No free slot for fused kernel.");
+            return nullptr;
+        }
+        mNumSlots++;
+    }
+
+    slot = createSlot();
+
+    // Out of memory, the slot can be created again later
+    if (!slot)
+    {
+        std::lock_guard<std::mutex> lock(mSlotMutex);
+        mNumSlots--;
+    }
+
+    return slot;
+}
+
+void CsKernelFuser::releaseSlot(std::unique_ptr<Slot> slot)
+{
+    std::lock_guard<std::mutex> lock(mSlotMutex);
+
+    mFreeSlots.push_back(std::move(slot));
+}
+
+std::unique_ptr<CsKernelFuser::Slot> CsKernelFuser::createSlot()
+{
+    auto slot = std::make_unique<Slot>();
+
+    vk::DescriptorSetAllocateInfo descSetAllocInfo(
+        *mDescriptorPool, 1, &(*mDescriptorSetLayout));
+
+    slot->descriptorSet =
+        std::move(mDevice->allocateDescriptorSetsUnique(descSetAllocInfo).value.front());
+
+    vk::BufferCreateInfo bufferInfo(
+                {},
+                sizeof(float) * maxFusedParameters,
+                vk::BufferUsageFlagBits::eUniformBuffer,
+                vk::SharingMode::eExclusive);
+
+    slot->buffer = mDevice->createBufferUnique(bufferInfo).value;
+
+#ifdef QT_DEBUG
+    {
+        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
+                    vk::ObjectType::eBuffer,
+                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkBuffer, *slot->buffer),
+                    "Fused Kernel Parameter Buffer");
+        auto result = mDevice->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
+        Q_UNUSED(result);
+    }
+#endif
+
+    vk::MemoryRequirements memRequirements = mDevice->getBufferMemoryRequirements(*slot->buffer);
+
+    slot->memory = mMemoryAllocator->allocate(
+                memRequirements,
+                vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+                true);
+    if (!slot->memory || !slot->memory->getMappedData())
+    {
+        CS_LOG_WARNING("Could not allocate fused kernel parameters.");
+        return nullptr;
+    }
+
+    auto result = mDevice->bindBufferMemory(
+                *slot->buffer,
+                slot->memory->getMemory(),
+                slot->memory->getOffset());
+    if (result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Could not bind fused kernel parameters.");
+        return nullptr;
+    }
+
+    slot->parameters = static_cast<float*>(slot->memory->getMappedData());
+
+    vk::DescriptorBufferInfo bufferInfo(*slot->buffer, 0, VK_WHOLE_SIZE);
+
+    vk::WriteDescriptorSet descWrite(
+        *slot->descriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &bufferInfo);
+
+    mDevice->updateDescriptorSets(descWrite, {});
+
+    return slot;
+}
+
+CsKernelFuser::~CsKernelFuser()
+{
+    // Their command buffers might still be pending
+    for (auto& dispatch : mRecordedDispatches)
+    {
+        if (dispatch.slot->submission)
+            dispatch.slot->submission->wait();
+    }
+    mRecordedDispatches.clear();
+
+    // Slots hold descriptor sets from the pool, free them first
+    mFreeSlots.clear();
+    mPipelines.clear();
+
+    CS_LOG_INFO("Destroying kernel fuser.");
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,178 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSKERNELFUSER_H
+#define CSKERNELFUSER_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QRect>
+
+#include "kernelfusion.h"
+#include "rendertask.h"
+#include "csmemoryallocator.h"
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsCommandBuffer;
+class CsImage;
+class CsMemoryAllocator;
+class CsDeletionQueue;
+class CsDescriptorAllocator;
+class CsGpuProfiler;
+class CsSubmission;
+
+// Runs a chain of pointwise kernels as a single compute dispatch, so the
+// image only makes one round trip through memory instead of one per node.
+// The shader for a chain is generated and compiled the first time it is
+// seen and reused for all chains with the same signature.
+class CsKernelFuser
+{
+public:
+    CsKernelFuser(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            CsDeletionQueue* deletionQueue,
+            CsDescriptorAllocator* descriptorAllocator,
+            vk::PipelineCache* pipelineCache);
+
+    // Records into and submits the command buffer without waiting for the
+    // GPU. Returns nullptr if the chain can't be fused, the kernels have
+    // to be executed one by one in that case.
+    // For parameter updates the dispatch is only recorded once and then
+    // submitted again with new parameters, as long as the chain, the input
+    // and the region stay the same. Its result is recycled for that.
+    // The result is created with createOutput if it is set and returns
+    // an image, and gets an image of its own otherwise.
+    // Can be called from several threads.
+    std::shared_ptr<CsImage> execute(
+            const std::vector<PointwiseKernel>& kernels,
+            const std::shared_ptr<CsImage>& input,
+            CsCommandBuffer* const commandBuffer,
+            const FusedRegion& region,
+            const bool isParameterUpdate = false,
+            const OutputFactory& createOutput = nullptr);
+
+    ~CsKernelFuser();
+
+private:
+    // Parameter buffer for one dispatch in flight, its
+    // descriptor set is written once when it is created
+    struct Slot
+    {
+        vk::UniqueDescriptorSet descriptorSet;
+        vk::UniqueBuffer buffer;
+        std::unique_ptr<CsAllocation> memory;
+        float* parameters = nullptr;
+        // The last dispatch that used the slot
+        std::shared_ptr<CsSubmission> submission;
+    };
+
+    // A dispatch that is submitted again for every parameter update,
+    // only the parameters in its slot are rewritten
+    struct RecordedDispatch
+    {
+        std::string signature;
+        std::weak_ptr<CsImage> input;
+        vk::ImageLayout inputLayout;
+        FusedRegion region;
+        std::unique_ptr<Slot> slot;
+        std::shared_ptr<CsImage> output;
+        // Deletion queue frame at which the output was first seen
+        // without other owners, the viewer may still sample it
+        // until the frames in flight at that point have retired
+        std::optional<uint64_t> releaseFrame;
+        vk::UniqueCommandBuffer commandBuffer;
+        // Timestamps the command buffer writes, -1 if it isn't timed
+        CsGpuProfiler* profiler = nullptr;
+        int queries = -1;
+    };
+
+    void createDescriptors();
+
+    std::shared_ptr<CsImage> allocateOutput(
+            const CsImage* const input,
+            const QSize& size,
+            const char* debugName,
+            const OutputFactory& createOutput = nullptr);
+
+    std::shared_ptr<CsImage> executeRecorded(
+            const std::string& signature,
+            const std::vector<float>& parameters,
+            vk::Pipeline& pipeline,
+            const std::shared_ptr<CsImage>& input,
+            CsCommandBuffer* const commandBuffer,
+            const FusedRegion& region);
+
+    // False if there is no slot or no descriptor set for the images
+    bool recordDispatch(
+            RecordedDispatch& dispatch,
+            vk::Pipeline& pipeline,
+            const std::shared_ptr<CsImage>& input,
+            CsCommandBuffer* const commandBuffer);
+
+    std::list<RecordedDispatch>::iterator dropRecordedDispatch(
+            std::list<RecordedDispatch>::iterator it);
+
+    // nullptr if the shader for the chain doesn't compile
+    vk::Pipeline* getPipeline(const std::vector<PointwiseKernel>& kernels);
+
+    std::unique_ptr<Slot> acquireSlot();
+    void releaseSlot(std::unique_ptr<Slot> slot);
+    std::unique_ptr<Slot> createSlot();
+
+
+    const vk::Device* mDevice;
+    const vk::PhysicalDevice* mPhysicalDevice;
+    CsMemoryAllocator* mMemoryAllocator;
+    CsDeletionQueue* mDeletionQueue;
+    CsDescriptorAllocator* mDescriptorAllocator;
+    vk::PipelineCache* mPipelineCache;
+
+    vk::UniqueDescriptorSetLayout mDescriptorSetLayout;
+    vk::UniqueDescriptorPool mDescriptorPool;
+    vk::UniquePipelineLayout mPipelineLayout;
+
+    // By chain signature, failed compilations are kept as
+    // null pipelines so they are not attempted again
+    std::unordered_map<std::string, vk::UniquePipeline> mPipelines;
+    std::mutex mPipelineMutex;
+
+    std::vector<std::unique_ptr<Slot>> mFreeSlots;
+    int mNumSlots = 0;
+    std::mutex mSlotMutex;
+
+    // Created with the first recorded dispatch, it needs the queue family
+    vk::UniqueCommandPool mCommandPool;
+    // Most recently used first
+    std::list<RecordedDispatch> mRecordedDispatches;
+    std::mutex mRecordingMutex;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSKERNELFUSER_H
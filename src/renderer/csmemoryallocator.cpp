@@ -0,0 +1,267 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csmemoryallocator.h"
+
+#include <algorithm>
+
+#include "../log.h"
+
+namespace Cascade::Renderer {
+
+// Large enough for a few 4K RGBA32F intermediates
+static constexpr vk::DeviceSize deviceLocalBlockSize = 256 * 1024 * 1024;
+static constexpr vk::DeviceSize hostVisibleBlockSize = 64 * 1024 * 1024;
+
+vk::DeviceMemory CsAllocation::getMemory() const
+{
+    return mMemory;
+}
+
+vk::DeviceSize CsAllocation::getOffset() const
+{
+    return mOffset;
+}
+
+vk::DeviceSize CsAllocation::getSize() const
+{
+    return mSize;
+}
+
+void* CsAllocation::getMappedData() const
+{
+    return mMappedData;
+}
+
+CsAllocation::~CsAllocation()
+{
+    if (mAllocator)
+        mAllocator->free(*this);
+}
+
+CsMemoryAllocator::CsMemoryAllocator(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd) :
+    mDevice(d),
+    mPhysicalDevice(pd),
+    mMemoryProperties(pd->getMemoryProperties())
+{
+}
+
+std::unique_ptr<CsAllocation> CsMemoryAllocator::allocate(
+        const vk::MemoryRequirements& requirements,
+        const vk::MemoryPropertyFlags properties,
+        const bool isLinear)
+{
+    auto memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+
+    // Device local is a preference, e.g. integrated GPUs may not have it
+    if (!memoryType && !(properties & vk::MemoryPropertyFlagBits::eHostVisible))
+        memoryType = findMemoryType(requirements.memoryTypeBits, {});
+
+    if (!memoryType)
+    {
+        CS_LOG_WARNING("No suitable memory type.");
+        return nullptr;
+    }
+
+    const auto& type = mMemoryProperties.memoryTypes[*memoryType];
+    const bool isHostVisible =
+        static_cast<bool>(type.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+
+    // Small heaps must not be taken up by a single block
+    const vk::DeviceSize blockSize = std::min(
+        isHostVisible ? hostVisibleBlockSize : deviceLocalBlockSize,
+        mMemoryProperties.memoryHeaps[type.heapIndex].size / 8);
+
+    // Only returned to the allocator once it was handed out
+    auto allocation = std::unique_ptr<CsAllocation>(new CsAllocation());
+    allocation->mSize = requirements.size;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Sharing a block with it would leave too little room for anything else
+    if (requirements.size > blockSize / 2)
+    {
+        allocation->mDedicatedMemory = allocateDeviceMemory(
+            requirements.size, *memoryType, &allocation->mMappedData);
+        if (!allocation->mDedicatedMemory)
+            return nullptr;
+
+        allocation->mMemory = *allocation->mDedicatedMemory;
+        allocation->mAllocator = this;
+        ++mNumDedicatedAllocations;
+        ++mNumAllocations;
+
+        return allocation;
+    }
+
+    auto pool = std::find_if(
+        mPools.begin(),
+        mPools.end(),
+        [&](const Pool& p) { return p.memoryType == *memoryType && p.isLinear == isLinear; });
+
+    if (pool == mPools.end())
+    {
+        mPools.push_back({ *memoryType, isLinear, blockSize, {} });
+        pool = std::prev(mPools.end());
+    }
+
+    for (auto& block : pool->blocks)
+    {
+        if (auto offset = block->ranges.allocate(requirements.size, requirements.alignment))
+        {
+            allocation->mBlock = block.get();
+            allocation->mMemory = *block->memory;
+            allocation->mOffset = *offset;
+            if (block->mappedData)
+                allocation->mMappedData = static_cast<char*>(block->mappedData) + *offset;
+            allocation->mAllocator = this;
+            ++mNumAllocations;
+
+            return allocation;
+        }
+    }
+
+    auto block = std::make_unique<Block>(Block{
+        {}, RangeAllocator(pool->blockSize), nullptr, static_cast<size_t>(pool - mPools.begin()) });
+
+    block->memory = allocateDeviceMemory(pool->blockSize, *memoryType, &block->mappedData);
+    if (!block->memory)
+        return nullptr;
+
+    // Blocks start at offset 0, which satisfies any alignment
+    const auto offset = block->ranges.allocate(requirements.size, requirements.alignment);
+    if (!offset)
+        return nullptr;
+
+    allocation->mBlock = block.get();
+    allocation->mMemory = *block->memory;
+    allocation->mOffset = *offset;
+    if (block->mappedData)
+        allocation->mMappedData = static_cast<char*>(block->mappedData) + *offset;
+    allocation->mAllocator = this;
+    ++mNumAllocations;
+
+    pool->blocks.push_back(std::move(block));
+
+    return allocation;
+}
+
+size_t CsMemoryAllocator::getNumDeviceAllocations() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    size_t count = mNumDedicatedAllocations;
+
+    for (const auto& pool : mPools)
+        count += pool.blocks.size();
+
+    return count;
+}
+
+void CsMemoryAllocator::free(CsAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    --mNumAllocations;
+
+    if (!allocation.mBlock)
+    {
+        // Freed with the allocation itself
+        --mNumDedicatedAllocations;
+        return;
+    }
+
+    auto block = static_cast<Block*>(allocation.mBlock);
+    block->ranges.free(allocation.mOffset);
+
+    if (!block->ranges.isEmpty())
+        return;
+
+    // Keeps one empty block, batches free and allocate all the time
+    auto& blocks = mPools[block->pool].blocks;
+
+    const auto numEmpty = std::count_if(
+        blocks.begin(),
+        blocks.end(),
+        [](const auto& b) { return b->ranges.isEmpty(); });
+
+    if (numEmpty > 1)
+    {
+        blocks.erase(std::find_if(
+            blocks.begin(),
+            blocks.end(),
+            [block](const auto& b) { return b.get() == block; }));
+    }
+}
+
+std::optional<uint32_t> CsMemoryAllocator::findMemoryType(
+        uint32_t typeFilter,
+        vk::MemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1 << i)) &&
+            (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
+vk::UniqueDeviceMemory CsMemoryAllocator::allocateDeviceMemory(
+        const vk::DeviceSize size,
+        const uint32_t memoryType,
+        void** mappedData)
+{
+    vk::MemoryAllocateInfo allocInfo(size, memoryType);
+
+    auto memory = mDevice->allocateMemoryUnique(allocInfo);
+    if (memory.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Could not allocate device memory.");
+        return {};
+    }
+
+    *mappedData = nullptr;
+
+    if (mMemoryProperties.memoryTypes[memoryType].propertyFlags &
+        vk::MemoryPropertyFlagBits::eHostVisible)
+    {
+        auto result = mDevice->mapMemory(*memory.value, 0, VK_WHOLE_SIZE, {}, mappedData);
+        if (result != vk::Result::eSuccess)
+        {
+            CS_LOG_WARNING("Failed to map memory.");
+            return {};
+        }
+    }
+
+    return std::move(memory.value);
+}
+
+CsMemoryAllocator::~CsMemoryAllocator()
+{
+    if (mNumAllocations > 0)
+        CS_LOG_WARNING("Memory allocator destroyed while its memory is still in use.");
+}
+
+} // end namespace Cascade::Renderer
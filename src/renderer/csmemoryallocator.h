@@ -0,0 +1,142 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSMEMORYALLOCATOR_H
+#define CSMEMORYALLOCATOR_H
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "rangeallocator.h"
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsMemoryAllocator;
+
+// A range of device memory handed out by CsMemoryAllocator,
+// it goes back to the allocator when this is destroyed
+class CsAllocation
+{
+public:
+    CsAllocation(const CsAllocation&) = delete;
+    CsAllocation& operator=(const CsAllocation&) = delete;
+
+    vk::DeviceMemory getMemory() const;
+    vk::DeviceSize getOffset() const;
+    vk::DeviceSize getSize() const;
+
+    // Stays mapped for the lifetime of the allocation,
+    // nullptr if the memory isn't host visible
+    void* getMappedData() const;
+
+    ~CsAllocation();
+
+private:
+    friend class CsMemoryAllocator;
+
+    CsAllocation() = default;
+
+    CsMemoryAllocator* mAllocator = nullptr;
+
+    // Set for sub-allocations, the block they belong to
+    void* mBlock = nullptr;
+
+    // Set instead for allocations too large to share a block
+    vk::UniqueDeviceMemory mDedicatedMemory;
+
+    vk::DeviceMemory mMemory;
+    vk::DeviceSize mOffset = 0;
+    vk::DeviceSize mSize = 0;
+    void* mMappedData = nullptr;
+};
+
+// Places images and buffers in a few large blocks of device memory instead
+// of allocating memory for each of them, which is slow and runs into
+// maxMemoryAllocationCount with the intermediates of batch renders.
+// Thread-safe, it has to outlive all of its allocations.
+class CsMemoryAllocator
+{
+public:
+    CsMemoryAllocator(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd);
+
+    // Memory for a resource with the given requirements, bound by the caller
+    // at getOffset(). Linear resources are buffers and linear images, they
+    // never share a block with optimal images so that bufferImageGranularity
+    // can't be violated. Host visible memory comes mapped. nullptr if the
+    // device is out of memory.
+    std::unique_ptr<CsAllocation> allocate(
+            const vk::MemoryRequirements& requirements,
+            const vk::MemoryPropertyFlags properties,
+            const bool isLinear);
+
+    // Number of vkAllocateMemory calls that are currently alive
+    size_t getNumDeviceAllocations() const;
+
+    ~CsMemoryAllocator();
+
+private:
+    friend class CsAllocation;
+
+    struct Block
+    {
+        vk::UniqueDeviceMemory memory;
+        RangeAllocator ranges;
+        void* mappedData = nullptr;
+        size_t pool = 0;
+    };
+
+    struct Pool
+    {
+        uint32_t memoryType = 0;
+        bool isLinear = false;
+        vk::DeviceSize blockSize = 0;
+        std::vector<std::unique_ptr<Block>> blocks;
+    };
+
+    void free(CsAllocation& allocation);
+
+    std::optional<uint32_t> findMemoryType(
+            uint32_t typeFilter,
+            vk::MemoryPropertyFlags properties) const;
+
+    vk::UniqueDeviceMemory allocateDeviceMemory(
+            const vk::DeviceSize size,
+            const uint32_t memoryType,
+            void** mappedData);
+
+    const vk::Device* mDevice;
+    const vk::PhysicalDevice* mPhysicalDevice;
+
+    vk::PhysicalDeviceMemoryProperties mMemoryProperties;
+
+    std::vector<Pool> mPools;
+    size_t mNumDedicatedAllocations = 0;
+    size_t mNumAllocations = 0;
+
+    mutable std::mutex mMutex;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSMEMORYALLOCATOR_H
@@ -30,7 +30,8 @@ namespace Cascade::Renderer {
 
 CsSettingsBuffer::CsSettingsBuffer(
         vk::Device* d,
-        vk::PhysicalDevice* pd)
+        vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator)
 {
     mDevice = d;
     mPhysicalDevice = pd;
@@ -50,39 +51,23 @@ CsSettingsBuffer::CsSettingsBuffer(
 
     vk::MemoryRequirements memRequirements = mDevice->getBufferMemoryRequirements(*mBuffer);
 
-    vk::MemoryPropertyFlags properties =
-            vk::MemoryPropertyFlagBits::eHostVisible |
-            vk::MemoryPropertyFlagBits::eHostCoherent;
+    mMemory = allocator->allocate(
+                memRequirements,
+                vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+                true);
 
-    vk::PhysicalDeviceMemoryProperties memProperties = mPhysicalDevice->getMemoryProperties();
-
-    uint32_t memTypeIndex = 0;
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    if (!mMemory || !mMemory->getMappedData())
     {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-        {
-            memTypeIndex = i;
-        }
+        CS_LOG_WARNING("Failed to allocate the settings buffer");
+        return;
     }
 
-    vk::MemoryAllocateInfo allocInfo(
-                memRequirements.size,
-                memTypeIndex);
-
-   mMemory = mDevice->allocateMemoryUnique(allocInfo).value;
-
-    auto result = mDevice->bindBufferMemory(*mBuffer, *mMemory, 0);
+    auto result = mDevice->bindBufferMemory(
+                *mBuffer, mMemory->getMemory(), mMemory->getOffset());
+    Q_UNUSED(result);
 
-    result = mDevice->mapMemory(
-                *mMemory,
-                0,
-                VK_WHOLE_SIZE,
-                {},
-                reinterpret_cast<void **>(&mBufferStart));
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Failed to map memory");
+    mBufferStart = static_cast<float*>(mMemory->getMappedData());
 }
 
 void CsSettingsBuffer::fillBuffer(const QString &s)
@@ -121,11 +106,6 @@ vk::UniqueBuffer& CsSettingsBuffer::getBuffer()
     return mBuffer;
 }
 
-vk::UniqueDeviceMemory& CsSettingsBuffer::getMemory()
-{
-    return mMemory;
-}
-
 CsSettingsBuffer::~CsSettingsBuffer()
 {
 
@@ -24,6 +24,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include "csmemoryallocator.h"
 #include "vulkanhppinclude.h"
 
 namespace Cascade::Renderer {
@@ -33,20 +34,20 @@ class CsSettingsBuffer
 public:
     CsSettingsBuffer(
             vk::Device* d,
-            vk::PhysicalDevice* pd);
+            vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator);
 
     void fillBuffer(const QString& s);
     void appendValue(float f);
     void incrementLastValue();
 
     vk::UniqueBuffer& getBuffer();
-    vk::UniqueDeviceMemory& getMemory();
 
     ~CsSettingsBuffer();
 
 private:
+    std::unique_ptr<CsAllocation> mMemory;
     vk::UniqueBuffer mBuffer;
-    vk::UniqueDeviceMemory mMemory;
 
     vk::Device* mDevice;
     vk::PhysicalDevice* mPhysicalDevice;
@@ -0,0 +1,149 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csstagingbuffer.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer {
+
+// Meets the copy alignment of both image formats
+// and optimalBufferCopyOffsetAlignment of common devices
+static constexpr vk::DeviceSize regionAlignment = 256;
+
+CsStagingRegion::CsStagingRegion(
+        CsStagingBuffer* owner,
+        const vk::DeviceSize offset,
+        const vk::DeviceSize size) :
+    mOwner(owner),
+    mOffset(offset),
+    mSize(size)
+{
+}
+
+const vk::Buffer& CsStagingRegion::getBuffer() const
+{
+    return *mOwner->mBuffer;
+}
+
+vk::DeviceSize CsStagingRegion::getOffset() const
+{
+    return mOffset;
+}
+
+vk::DeviceSize CsStagingRegion::getSize() const
+{
+    return mSize;
+}
+
+void* CsStagingRegion::getData() const
+{
+    return static_cast<char*>(mOwner->mMemory->getMappedData()) + mOffset;
+}
+
+CsStagingRegion::~CsStagingRegion()
+{
+    mOwner->release(mOffset);
+}
+
+CsStagingBuffer::CsStagingBuffer(
+        const vk::Device* d,
+        CsMemoryAllocator* allocator,
+        const vk::DeviceSize capacity) :
+    mDevice(d),
+    mMemoryAllocator(allocator),
+    mRanges(capacity)
+{
+}
+
+std::unique_ptr<CsStagingRegion> CsStagingBuffer::acquire(const vk::DeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (size > mRanges.getSize() || mIsUnavailable)
+        return nullptr;
+
+    if (!mBuffer && !createBuffer())
+    {
+        CS_LOG_WARNING("Could not allocate the staging buffer.");
+        mIsUnavailable = true;
+        return nullptr;
+    }
+
+    const auto offset = mRanges.allocate(size, regionAlignment);
+    if (!offset)
+        return nullptr;
+
+    return std::unique_ptr<CsStagingRegion>(new CsStagingRegion(this, *offset, size));
+}
+
+bool CsStagingBuffer::createBuffer()
+{
+    vk::BufferCreateInfo bufferInfo(
+                {},
+                mRanges.getSize(),
+                vk::BufferUsageFlagBits::eTransferSrc,
+                vk::SharingMode::eExclusive);
+
+    auto buffer = mDevice->createBufferUnique(bufferInfo);
+    if (buffer.result != vk::Result::eSuccess)
+        return false;
+
+    vk::MemoryRequirements memRequirements = mDevice->getBufferMemoryRequirements(*buffer.value);
+
+    mMemory = mMemoryAllocator->allocate(
+                memRequirements,
+                vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+                true);
+    if (!mMemory || !mMemory->getMappedData())
+    {
+        mMemory = nullptr;
+        return false;
+    }
+
+    auto result = mDevice->bindBufferMemory(
+                *buffer.value,
+                mMemory->getMemory(),
+                mMemory->getOffset());
+    if (result != vk::Result::eSuccess)
+    {
+        mMemory = nullptr;
+        return false;
+    }
+
+    mBuffer = std::move(buffer.value);
+
+    return true;
+}
+
+void CsStagingBuffer::release(const vk::DeviceSize offset)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mRanges.free(offset);
+}
+
+CsStagingBuffer::~CsStagingBuffer()
+{
+    if (!mRanges.isEmpty())
+        CS_LOG_WARNING("Staging buffer destroyed while regions were still in use.");
+}
+
+} // end namespace Cascade::Renderer
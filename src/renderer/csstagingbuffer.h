@@ -0,0 +1,105 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSSTAGINGBUFFER_H
+#define CSSTAGINGBUFFER_H
+
+#include <memory>
+#include <mutex>
+
+#include "csmemoryallocator.h"
+#include "rangeallocator.h"
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsStagingBuffer;
+
+// Part of the staging buffer, it is returned when this is destroyed.
+// Has to stay alive until the GPU is done copying from it.
+class CsStagingRegion
+{
+public:
+    CsStagingRegion(const CsStagingRegion&) = delete;
+    CsStagingRegion& operator=(const CsStagingRegion&) = delete;
+
+    const vk::Buffer& getBuffer() const;
+    vk::DeviceSize getOffset() const;
+    vk::DeviceSize getSize() const;
+
+    // Where the CPU writes to, mapped for as long as the region lives
+    void* getData() const;
+
+    ~CsStagingRegion();
+
+private:
+    friend class CsStagingBuffer;
+
+    CsStagingRegion(
+            CsStagingBuffer* owner,
+            const vk::DeviceSize offset,
+            const vk::DeviceSize size);
+
+    CsStagingBuffer* mOwner;
+    vk::DeviceSize mOffset;
+    vk::DeviceSize mSize;
+};
+
+// A large buffer that stays mapped, uploads are staged in regions of it.
+// Decoders can write straight into it instead of into memory of their own
+// that has to be copied once more. Regions are taken in the order frames
+// are decoded and can be returned in any order. Thread-safe.
+class CsStagingBuffer
+{
+public:
+    CsStagingBuffer(
+            const vk::Device* d,
+            CsMemoryAllocator* allocator,
+            const vk::DeviceSize capacity);
+
+    // Never waits for regions to be returned, nullptr if there is no room
+    // right now. The memory is allocated by the first call.
+    std::unique_ptr<CsStagingRegion> acquire(const vk::DeviceSize size);
+
+    ~CsStagingBuffer();
+
+private:
+    friend class CsStagingRegion;
+
+    bool createBuffer();
+
+    void release(const vk::DeviceSize offset);
+
+    const vk::Device* mDevice;
+    CsMemoryAllocator* mMemoryAllocator;
+
+    // Declared first so that it outlives the buffer bound to it
+    std::unique_ptr<CsAllocation> mMemory;
+    vk::UniqueBuffer mBuffer;
+    RangeAllocator mRanges;
+
+    // Don't try again for every frame if the memory isn't there
+    bool mIsUnavailable = false;
+
+    std::mutex mMutex;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSSTAGINGBUFFER_H
@@ -0,0 +1,124 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "cstransientimagepool.h"
+
+#include <algorithm>
+
+#include "../log.h"
+#include "csimage.h"
+#include "csmemoryallocator.h"
+
+namespace Cascade::Renderer {
+
+CsTransientImagePool::CsTransientImagePool(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        CsDeletionQueue* deletionQueue) :
+    mDevice(d),
+    mPhysicalDevice(pd),
+    mMemoryAllocator(allocator),
+    mDeletionQueue(deletionQueue)
+{
+}
+
+void CsTransientImagePool::reserve(const std::vector<uint64_t>& blockSizes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mBlocks.resize(std::max(mBlocks.size(), blockSizes.size()));
+
+    for (size_t i = 0; i < blockSizes.size(); ++i)
+        mBlocks[i].plannedSize = blockSizes[i];
+}
+
+std::shared_ptr<CsImage> CsTransientImagePool::createImage(const int block, const QSize& size)
+{
+    if (block < 0 || size.isEmpty())
+        return nullptr;
+
+    const vk::MemoryRequirements requirements =
+        CsImage::getMemoryRequirements(mDevice, size.width(), size.height());
+
+    std::shared_ptr<const CsAllocation> memory;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (static_cast<size_t>(block) >= mBlocks.size())
+            return nullptr;
+
+        auto& b = mBlocks[block];
+
+        const bool fits = b.memory &&
+            b.allocatedSize >= requirements.size &&
+            (requirements.memoryTypeBits & b.memoryTypeBits) == b.memoryTypeBits;
+
+        if (!fits)
+        {
+            // The plan's estimate leaves out alignment and padding
+            const vk::MemoryRequirements blockRequirements(
+                std::max<uint64_t>(requirements.size, b.plannedSize + requirements.alignment),
+                requirements.alignment,
+                requirements.memoryTypeBits);
+
+            auto allocation = mMemoryAllocator->allocate(
+                blockRequirements,
+                vk::MemoryPropertyFlagBits::eDeviceLocal,
+                false);
+            if (!allocation)
+            {
+                CS_LOG_WARNING("Could not allocate transient image memory.");
+                return nullptr;
+            }
+
+            b.memory = std::move(allocation);
+            b.allocatedSize = blockRequirements.size;
+            b.memoryTypeBits = requirements.memoryTypeBits;
+        }
+
+        memory = b.memory;
+    }
+
+    return std::make_shared<CsImage>(
+        mDevice,
+        mPhysicalDevice,
+        mDeletionQueue,
+        size.width(),
+        size.height(),
+        std::move(memory),
+        "Transient Image");
+}
+
+void CsTransientImagePool::release()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mBlocks.clear();
+}
+
+CsTransientImagePool::~CsTransientImagePool()
+{
+    release();
+
+    CS_LOG_INFO("Destroying transient image pool.");
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,85 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSTRANSIENTIMAGEPOOL_H
+#define CSTRANSIENTIMAGEPOOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QSize>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsAllocation;
+class CsDeletionQueue;
+class CsImage;
+class CsMemoryAllocator;
+
+// Allocations shared by intermediate images whose lifetimes
+// don't overlap, laid out by planImageAliasing(). An image only keeps
+// its block alive, the contents are overwritten by the next image
+// created in the same block.
+class CsTransientImagePool
+{
+public:
+    CsTransientImagePool(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            CsDeletionQueue* deletionQueue);
+
+    // Makes room for the blocks of a plan. Memory is only
+    // allocated once the first image is created in a block.
+    void reserve(const std::vector<uint64_t>& blockSizes);
+
+    // An image placed at the start of the block, a block that turns out
+    // too small is replaced by a larger one. Can be called from several threads.
+    std::shared_ptr<CsImage> createImage(const int block, const QSize& size);
+
+    // Frees the blocks, images that are still alive keep theirs
+    void release();
+
+    ~CsTransientImagePool();
+
+private:
+    struct Block
+    {
+        uint64_t plannedSize = 0;
+        uint64_t allocatedSize = 0;
+        // The allocator picked one of these for the memory
+        uint32_t memoryTypeBits = 0;
+        std::shared_ptr<const CsAllocation> memory;
+    };
+
+    const vk::Device* mDevice;
+    const vk::PhysicalDevice* mPhysicalDevice;
+    CsMemoryAllocator* mMemoryAllocator;
+    CsDeletionQueue* mDeletionQueue;
+
+    std::vector<Block> mBlocks;
+    std::mutex mMutex;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSTRANSIENTIMAGEPOOL_H
@@ -0,0 +1,117 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "fileoutput.h"
+
+#include <vector>
+
+#include "../log.h"
+#include "csimage.h"
+#include "graphexecutor.h"
+#include "renderdevice.h"
+#include "rendergraph.h"
+#include "tiledimagewriter.h"
+#include "tiling.h"
+
+namespace Cascade::Renderer
+{
+
+bool renderToFile(
+    GraphExecutor& executor,
+    RenderDevice& device,
+    RenderGraph& graph,
+    const int target,
+    const QString& path,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace)
+{
+    const QSize canvasSize = graph.outputSizeOf(target);
+    const int maxDimension = device.getMaxImageDimension();
+    const uint64_t budget = device.getDeviceMemoryBudget();
+
+    if (canvasSize.isEmpty() ||
+        !needsTiling(graph, target, canvasSize, maxDimension, budget))
+    {
+        graph.setRegionOfInterest(target, QRect());
+        executor.render(graph, target);
+
+        auto task = graph.getNode(target).task;
+        auto result = task ? task->getResult() : nullptr;
+        if (!result)
+            return false;
+
+        std::vector<float> pixels;
+        if (!device.readImage(result.get(), pixels))
+            return false;
+
+        // The whole image is a single tile
+        const QRect region(0, 0, result->getWidth(), result->getHeight());
+
+        auto writer = device.createTiledImageWriter(path, region.size(), attributes, colorSpace);
+        if (!writer->isOpen())
+            return false;
+
+        const bool success = writer->addTile(region, pixels.data(), region);
+
+        return writer->close() && success;
+    }
+
+    const auto plan = planTiles(graph, target, canvasSize, maxDimension, budget);
+    if (plan.tiles.empty())
+        return false;
+
+    CS_LOG_INFO("Rendering " + path + " in tiles of " + QString::number(plan.tileSize) +
+                " pixels with a halo of " + QString::number(plan.halo) + ".");
+
+    auto writer = device.createTiledImageWriter(path, canvasSize, attributes, colorSpace);
+    if (!writer->isOpen())
+        return false;
+
+    bool success = true;
+    std::vector<float> pixels;
+
+    executor.renderTiled(
+        graph,
+        target,
+        plan,
+        [&device, &writer, &pixels, &success](const QRect& tile, RenderTask* task)
+        {
+            auto result = task ? task->getResult() : nullptr;
+
+            // Reading back a whole canvas for every tile would hide a task
+            // that ignores the tile, and it may not even fit on the GPU
+            if (result && (result->getWidth() != tile.width() || result->getHeight() != tile.height()))
+            {
+                CS_LOG_WARNING("The result of a tile doesn't have the size of the tile.");
+                result = nullptr;
+            }
+
+            if (!result || !device.readImage(result.get(), pixels))
+            {
+                success = false;
+                return;
+            }
+
+            success &= writer->addTile(tile, pixels.data(), tile);
+        });
+
+    return writer->close() && success;
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,49 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEOUTPUT_H
+#define FILEOUTPUT_H
+
+#include <string>
+
+#include <QMap>
+#include <QString>
+
+namespace Cascade::Renderer
+{
+
+class GraphExecutor;
+class RenderDevice;
+class RenderGraph;
+
+// Renders the target at full resolution and writes it to disk, converted
+// from linear to the given color space. Images too large for the GPU
+// are rendered in tiles and streamed out.
+bool renderToFile(
+    GraphExecutor& executor,
+    RenderDevice& device,
+    RenderGraph& graph,
+    const int target,
+    const QString& path,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace);
+
+} // namespace Cascade::Renderer
+
+#endif // FILEOUTPUT_H
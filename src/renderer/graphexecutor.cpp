@@ -0,0 +1,648 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "graphexecutor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <set>
+
+// Prevent tbb emit() from clashing with Qt.
+#ifndef Q_MOC_RUN
+#if defined(emit)
+    #undef emit
+    #include <tbb/flow_graph.h>
+    #include <tbb/task_arena.h>
+    #define emit
+#else
+    #include <tbb/flow_graph.h>
+    #include <tbb/task_arena.h>
+#endif // defined(emit)
+#endif // Q_MOC_RUN
+
+#include "../log.h"
+#include "cscommandbuffer.h"
+#include "csimage.h"
+#include "cstransientimagepool.h"
+#include "imageprecision.h"
+#include "kernelfusion.h"
+#include "rendercache.h"
+#include "renderhash.h"
+
+using tbb::flow::continue_msg;
+using tbb::flow::continue_node;
+
+namespace Cascade::Renderer
+{
+
+// What the result of an input contains, for the early cutoff. Waiting for
+// its content hash would stall the branch until the GPU is done with the
+// input, so until the hash is read back the node's hash stands in. That
+// only changes with the settings upstream, equal keys still mean equal pixels.
+static uint64_t inputKey(const RenderGraphNode& node, const CsImage& result)
+{
+    if (const auto hash = result.peekContentHash())
+        return hash;
+
+    return node.hash;
+}
+
+GraphExecutor::GraphExecutor(
+    CommandBufferFactory factory,
+    const int maxConcurrency)
+    : mCommandBufferFactory(std::move(factory))
+    , mMaxConcurrency(maxConcurrency)
+{
+}
+
+GraphExecutor::~GraphExecutor() = default;
+
+void GraphExecutor::setCache(RenderCache* cache)
+{
+    mCache = cache;
+}
+
+void GraphExecutor::setContentHasher(ContentHasher hasher)
+{
+    mContentHasher = std::move(hasher);
+}
+
+void GraphExecutor::setNodeTimer(NodeTimer timer)
+{
+    mNodeTimer = std::move(timer);
+}
+
+void GraphExecutor::setKernelFuser(KernelFuser fuser)
+{
+    mKernelFuser = std::move(fuser);
+}
+
+void GraphExecutor::setTransientImagePool(CsTransientImagePool* pool)
+{
+    mTransientImagePool = pool;
+}
+
+uint64_t GraphExecutor::startGeneration()
+{
+    return ++mGeneration;
+}
+
+bool GraphExecutor::isStale(const uint64_t generation) const
+{
+    return generation < mGeneration.load();
+}
+
+bool GraphExecutor::render(
+    const RenderGraph& graph,
+    const int target,
+    const uint64_t generation)
+{
+    return run(graph, plan(graph, target), false, generation);
+}
+
+std::vector<int> GraphExecutor::plan(const RenderGraph& graph, const int target)
+{
+    std::vector<bool> visited(graph.size(), false);
+    std::vector<bool> needed(graph.size(), false);
+
+    std::vector<int> stack = { target };
+
+    while (!stack.empty())
+    {
+        const int current = stack.back();
+        stack.pop_back();
+
+        if (visited[current])
+            continue;
+
+        visited[current] = true;
+
+        const auto& node = graph.getNode(current);
+
+        if (!node.dirty && node.task && node.task->getResult() &&
+            roiCovers(node.task->getResult()->getValidRegion(), node.roi))
+            continue;
+
+        if (mCache && node.task)
+        {
+            auto cached = mCache->find(node.hash);
+            if (cached && roiCovers(cached->getValidRegion(), node.roi))
+            {
+                node.task->setResult(std::move(cached));
+                continue;
+            }
+        }
+
+        needed[current] = true;
+
+        for (const auto input : node.inputs)
+        {
+            if (input >= 0)
+                stack.push_back(input);
+        }
+    }
+
+    std::vector<int> nodes;
+
+    for (const auto index : graph.topologicalOrder())
+    {
+        if (needed[index])
+            nodes.push_back(index);
+    }
+
+    return nodes;
+}
+
+void GraphExecutor::execute(const RenderGraph& graph, const std::vector<int>& nodes)
+{
+    run(graph, nodes, false);
+}
+
+bool GraphExecutor::renderTiled(
+    RenderGraph& graph,
+    const int target,
+    const TilePlan& plan,
+    const TileCallback& onTileRendered,
+    const uint64_t generation)
+{
+    const auto nodes = graph.upstreamOf(target);
+
+    CS_LOG_INFO("Rendering " + QString::number(plan.tiles.size()) + " tiles.");
+
+    if (mTransientImagePool)
+    {
+        // Every block has to fit the largest tile of the nodes in it
+        std::vector<uint64_t> bytes(graph.size(), 0);
+
+        for (const auto& tile : plan.tiles)
+        {
+            graph.setRegionOfInterest(target, tile);
+
+            for (const auto index : nodes)
+            {
+                const QRect& roi = graph.getNode(index).roi;
+                const uint64_t tileBytes = static_cast<uint64_t>(roi.width()) *
+                    static_cast<uint64_t>(roi.height()) * getBytesPerPixel();
+
+                bytes[index] = std::max(bytes[index], tileBytes);
+            }
+        }
+
+        mAliasPlan = planImageAliasing(graph, nodes, bytes, { target });
+        mTransientImagePool->reserve(mAliasPlan.blockSizes);
+
+        uint64_t unaliasedBytes = 0;
+        for (const auto index : nodes)
+        {
+            if (mAliasPlan.blockOf[index] >= 0)
+                unaliasedBytes += bytes[index];
+        }
+
+        CS_LOG_INFO("Intermediates take up " +
+                    QString::number(mAliasPlan.getTotalBytes() / (1024 * 1024)) +
+                    " MB instead of " +
+                    QString::number(unaliasedBytes / (1024 * 1024)) + " MB.");
+    }
+
+    bool isComplete = true;
+
+    for (const auto& tile : plan.tiles)
+    {
+        graph.setRegionOfInterest(target, tile);
+
+        if (!run(graph, nodes, true, generation))
+        {
+            CS_LOG_INFO("Tiled render superseded, stopping.");
+            isComplete = false;
+            break;
+        }
+
+        onTileRendered(tile, graph.getNode(target).task);
+    }
+
+    // Tile sized results would only get in the way of the viewer
+    for (const auto index : nodes)
+    {
+        if (auto task = graph.getNode(index).task)
+            task->setResult(nullptr);
+    }
+
+    mAliasPlan = AliasPlan();
+
+    if (mTransientImagePool)
+        mTransientImagePool->release();
+
+    return isComplete;
+}
+
+bool GraphExecutor::run(
+    const RenderGraph& graph,
+    const std::vector<int>& nodes,
+    const bool isTile,
+    const uint64_t generation)
+{
+    // Set once a node is skipped. Staleness only ever grows,
+    // so nothing downstream of a skipped node runs either.
+    std::atomic<bool> isCancelled(false);
+
+    // The flow graph attaches to the arena it is created in,
+    // so everything has to happen inside of it.
+    tbb::task_arena arena(mMaxConcurrency);
+
+    arena.execute(
+        [this, &graph, &nodes, isTile, generation, &isCancelled]()
+        {
+            tbb::flow::graph flowGraph;
+
+            // A fused chain is scheduled as its last node, which depends
+            // on what the first node depends on. Pointwise nodes have no
+            // pipeline of their own, one without pointwise neighbours
+            // runs as a chain of one.
+            std::vector<std::vector<int>> chains;
+            if (mKernelFuser)
+                chains = findFusableChains(graph, nodes, true);
+
+            std::vector<int> chainEndingAt(graph.size(), -1);
+            std::vector<bool> isInsideChain(graph.size(), false);
+
+            for (size_t i = 0; i < chains.size(); ++i)
+            {
+                chainEndingAt[chains[i].back()] = static_cast<int>(i);
+
+                for (size_t j = 0; j + 1 < chains[i].size(); ++j)
+                    isInsideChain[chains[i][j]] = true;
+            }
+
+            std::vector<std::unique_ptr<continue_node<continue_msg>>> flowNodes(graph.size());
+
+            for (const auto index : nodes)
+            {
+                if (isInsideChain[index])
+                    continue;
+
+                const int chain = chainEndingAt[index];
+
+                flowNodes[index] = std::make_unique<continue_node<continue_msg>>(
+                    flowGraph,
+                    [this, &graph, &chains, index, chain, isTile, generation, &isCancelled](
+                        const continue_msg&)
+                    {
+                        if (isStale(generation))
+                        {
+                            isCancelled = true;
+                            return;
+                        }
+
+                        if (chain >= 0)
+                            executeChain(graph, chains[chain], isTile);
+                        else
+                            executeNode(graph, index, isTile);
+                    });
+            }
+
+            std::vector<int> roots;
+
+            for (const auto index : nodes)
+            {
+                if (isInsideChain[index])
+                    continue;
+
+                const auto& first = chainEndingAt[index] >= 0 ?
+                    graph.getNode(chains[chainEndingAt[index]].front()) :
+                    graph.getNode(index);
+
+                // The same upstream node can be connected to several ports
+                const std::set<int> inputs(
+                    first.inputs.begin(),
+                    first.inputs.end());
+
+                bool hasScheduledInput = false;
+
+                for (const auto input : inputs)
+                {
+                    if (input >= 0 && flowNodes[input])
+                    {
+                        tbb::flow::make_edge(*flowNodes[input], *flowNodes[index]);
+                        hasScheduledInput = true;
+                    }
+                }
+
+                if (!hasScheduledInput)
+                    roots.push_back(index);
+            }
+
+            for (const auto root : roots)
+                flowNodes[root]->try_put(continue_msg());
+
+            flowGraph.wait_for_all();
+        });
+
+    // Nodes don't wait for the GPU, so that the next one is recorded while
+    // the previous ones run. Results have to be complete once this returns.
+    waitForCommandBuffers();
+
+    return !isCancelled;
+}
+
+void GraphExecutor::executeNode(const RenderGraph& graph, const int index, const bool isTile)
+{
+    const auto& node = graph.getNode(index);
+
+    // Nodes without a task only pass on the dependency
+    if (!node.task)
+        return;
+
+    RenderContext context;
+    context.settings = node.settings;
+    context.roi = node.roi;
+    context.isTile = isTile;
+    context.proxyScale = graph.getProxyScale();
+
+    context.createOutput = getOutputFactory(index, isTile);
+
+    // A chain of its own, the fuser is the only place kernels are compiled
+    if (mKernelFuser)
+    {
+        context.runKernel = [this, &graph, &node, &context, isTile](
+            const PointwiseKernel& kernel,
+            const std::shared_ptr<CsImage>& input)
+        {
+            const bool hasInput = !node.inputs.empty() && node.inputs.front() >= 0;
+            const QRect inputRoi = hasInput ? graph.getNode(node.inputs.front()).roi : QRect();
+
+            return mKernelFuser(
+                { kernel },
+                input,
+                context.commandBuffer,
+                getFusedRegion(node.roi, inputRoi, isTile),
+                false,
+                context.createOutput);
+        };
+    }
+
+    // What the inputs contain right now, an unconnected port is a known state
+    std::vector<uint64_t> inputHashes;
+
+    for (const auto input : node.inputs)
+    {
+        auto task = input >= 0 ? graph.getNode(input).task : nullptr;
+        context.inputs.push_back(task);
+
+        if (!task)
+            inputHashes.push_back(std::numeric_limits<uint64_t>::max());
+        else if (auto result = task->getResult())
+            inputHashes.push_back(inputKey(graph.getNode(input), *result));
+        else
+            inputHashes.push_back(0);
+    }
+
+    // Early cutoff, the inputs were re-executed but came out the same.
+    // The result is still added to the cache under the new key below.
+    const bool isUpToDate = !isTile && mContentHasher &&
+        node.task->isUpToDate(node.settingsHash, inputHashes) &&
+        roiCovers(node.task->getResult()->getValidRegion(), node.roi);
+
+    if (!isUpToDate)
+    {
+        auto commandBuffer = acquireCommandBuffer();
+        context.commandBuffer = commandBuffer.get();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // Hashing the result doesn't count towards the node
+        if (commandBuffer)
+            commandBuffer->setProfiledNode(node.id);
+
+        node.task->execute(context);
+
+        if (commandBuffer)
+            commandBuffer->setProfiledNode(QUuid());
+
+        if (mNodeTimer)
+        {
+            const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+            mNodeTimer(index, elapsed.count());
+        }
+
+        // Siblings may still read the input, its region and hash stay
+        if (auto result = node.task->getResult(); result && !node.task->isPassThrough())
+        {
+            result->setValidRegion(node.task->getComputedRegion(context));
+
+            // Tiles are never compared against each other
+            if (mContentHasher && !isTile)
+                result->setContentHash(mContentHasher(result.get(), commandBuffer.get()));
+        }
+        node.task->setExecutedWith(node.settingsHash, std::move(inputHashes));
+
+        releaseCommandBuffer(std::move(commandBuffer));
+    }
+
+    if (auto result = node.task->getResult();
+        mCache && result && !isTile && !node.task->isPassThrough())
+    {
+        mCache->insert(node.hash, result, result->getSizeInBytes());
+    }
+}
+
+void GraphExecutor::executeChain(
+    const RenderGraph& graph,
+    const std::vector<int>& chain,
+    const bool isTile)
+{
+    const auto& first = graph.getNode(chain.front());
+    const auto& last = graph.getNode(chain.back());
+
+    // Chains only start at nodes with their first port connected
+    const auto inputTask = graph.getNode(first.inputs.front()).task;
+    const auto input = inputTask ? inputTask->getResult() : nullptr;
+
+    std::vector<PointwiseKernel> kernels;
+    uint64_t settingsHash = 0;
+
+    for (const auto index : chain)
+    {
+        const auto& node = graph.getNode(index);
+        kernels.push_back(*node.task->getPointwiseKernel(node.settings));
+        settingsHash = hashCombine(settingsHash, node.settingsHash);
+    }
+
+    std::vector<uint64_t> inputHashes = {
+        input ? inputKey(graph.getNode(first.inputs.front()), *input) : 0 };
+
+    const bool isUpToDate = !isTile && mContentHasher &&
+        last.task->isUpToDate(settingsHash, inputHashes) &&
+        roiCovers(last.task->getResult()->getValidRegion(), last.roi);
+
+    if (!isUpToDate)
+    {
+        // Only a slider moved, the fuser can submit the command buffer
+        // it recorded last time again if the old result is let go of
+        const bool isParameterUpdate = !isTile && last.task->hasSameInputs(inputHashes);
+        if (isParameterUpdate)
+            last.task->setResult(nullptr);
+
+        auto commandBuffer = acquireCommandBuffer();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // The whole chain is a single dispatch, it is timed as its last node
+        if (commandBuffer)
+            commandBuffer->setProfiledNode(last.id);
+
+        // Tiles are addressed from their own origin, not the canvas
+        const auto region = getFusedRegion(
+            last.roi, graph.getNode(first.inputs.front()).roi, isTile);
+
+        auto result = input ?
+            mKernelFuser(
+                kernels,
+                input,
+                commandBuffer.get(),
+                region,
+                isParameterUpdate,
+                getOutputFactory(chain.back(), isTile)) :
+            nullptr;
+
+        if (commandBuffer)
+            commandBuffer->setProfiledNode(QUuid());
+
+        if (!result)
+        {
+            releaseCommandBuffer(std::move(commandBuffer));
+
+            for (const auto index : chain)
+                executeNode(graph, index, isTile);
+
+            return;
+        }
+
+        if (mNodeTimer)
+        {
+            const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+            mNodeTimer(chain.back(), elapsed.count());
+        }
+
+        result->setValidRegion(last.roi);
+
+        if (mContentHasher && !isTile)
+            result->setContentHash(mContentHasher(result.get(), commandBuffer.get()));
+
+        last.task->setResult(std::move(result));
+        last.task->setExecutedWith(settingsHash, std::move(inputHashes));
+
+        releaseCommandBuffer(std::move(commandBuffer));
+    }
+
+    // Nothing was computed for the nodes inside of the chain, old results
+    // would be mistaken for current ones if they are viewed on their own
+    for (size_t i = 0; i + 1 < chain.size(); ++i)
+        graph.getNode(chain[i]).task->setResult(nullptr);
+
+    // Recycled results are overwritten by the next parameter update
+    if (auto result = last.task->getResult(); mCache && result && !isTile && !result->isRecycled())
+    {
+        mCache->insert(last.hash, result, result->getSizeInBytes());
+    }
+}
+
+OutputFactory GraphExecutor::getOutputFactory(const int index, const bool isTile) const
+{
+    if (!isTile || mAliasPlan.blockOf.empty() || mAliasPlan.blockOf[index] < 0)
+        return nullptr;
+
+    // The CPU doesn't wait for the previous image in the block to be read.
+    // Its readers were submitted to the same queue before, and the barrier
+    // that moves the new image out of the undefined layout waits for them.
+    return [this, block = mAliasPlan.blockOf[index]](const QSize& size)
+    {
+        return mTransientImagePool->createImage(block, size);
+    };
+}
+
+std::unique_ptr<CsCommandBuffer> GraphExecutor::acquireCommandBuffer()
+{
+    if (!mCommandBufferFactory)
+        return nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock(mCommandBufferMutex);
+
+        // Workers never hold more than one, so this can only block if
+        // something else shares the executor's descriptor pool
+        mCommandBufferReleased.wait(lock, [this]()
+        {
+            return !mFreeCommandBuffers.empty() || mNumCommandBuffers < mMaxConcurrency;
+        });
+
+        if (!mFreeCommandBuffers.empty())
+        {
+            auto commandBuffer = std::move(mFreeCommandBuffers.back());
+            mFreeCommandBuffers.pop_back();
+
+            return commandBuffer;
+        }
+
+        ++mNumCommandBuffers;
+    }
+
+    CS_LOG_INFO("Creating additional command buffer for graph execution.");
+
+    auto commandBuffer = mCommandBufferFactory();
+
+    if (!commandBuffer)
+    {
+        CS_LOG_WARNING("Could not create a command buffer for graph execution.");
+
+        {
+            std::lock_guard<std::mutex> lock(mCommandBufferMutex);
+            --mNumCommandBuffers;
+        }
+        mCommandBufferReleased.notify_one();
+    }
+
+    return commandBuffer;
+}
+
+void GraphExecutor::releaseCommandBuffer(std::unique_ptr<CsCommandBuffer> commandBuffer)
+{
+    if (!commandBuffer)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mCommandBufferMutex);
+
+        mFreeCommandBuffers.push_back(std::move(commandBuffer));
+    }
+
+    mCommandBufferReleased.notify_one();
+}
+
+void GraphExecutor::waitForCommandBuffers()
+{
+    std::lock_guard<std::mutex> lock(mCommandBufferMutex);
+
+    for (auto& commandBuffer : mFreeCommandBuffers)
+        commandBuffer->waitForPreviousSubmission();
+}
+
+} // namespace Cascade::Renderer
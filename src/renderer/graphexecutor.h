@@ -0,0 +1,185 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef GRAPHEXECUTOR_H
+#define GRAPHEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "imagealiasing.h"
+#include "kernelfusion.h"
+#include "rendergraph.h"
+#include "rendertask.h"
+#include "tiling.h"
+
+namespace Cascade::Renderer
+{
+
+class CsCommandBuffer;
+class CsImage;
+class CsTransientImagePool;
+class RenderCache;
+
+// Runs the tasks of a render graph in dependency order.
+// Independent branches are executed concurrently, each
+// worker records into a command buffer of its own.
+class GraphExecutor
+{
+public:
+    using CommandBufferFactory = std::function<std::unique_ptr<CsCommandBuffer>()>;
+    // Starts hashing the image and returns what reads the hash back, see
+    // CsImage::setContentHash(), or nullptr if it can't be hashed. The
+    // next node only uses the hash if it is there by the time it runs.
+    using ContentHasher = std::function<std::function<uint64_t(const bool wait)>(CsImage*, CsCommandBuffer*)>;
+    using TileCallback = std::function<void(const QRect& tile, RenderTask* target)>;
+    using NodeTimer = std::function<void(const int index, const double milliseconds)>;
+    // isParameterUpdate is set when the chain runs on the same input as
+    // last time and only its settings changed, the old result has already
+    // been released then. createOutput is set when the result has to go
+    // into the memory the alias plan gave the last node of the chain.
+    using KernelFuser = std::function<std::shared_ptr<CsImage>(
+        const std::vector<PointwiseKernel>& kernels,
+        const std::shared_ptr<CsImage>& input,
+        CsCommandBuffer* commandBuffer,
+        const FusedRegion& region,
+        const bool isParameterUpdate,
+        const OutputFactory& createOutput)>;
+
+    // Without a factory tasks are executed without a command buffer.
+    // The factory is called at most maxConcurrency times, it hands out
+    // descriptor sets from a pool that is sized for that many.
+    explicit GraphExecutor(
+        CommandBufferFactory factory = nullptr,
+        const int maxConcurrency = 4);
+
+    ~GraphExecutor();
+
+    // Results are looked up in and added to the cache, can be nullptr
+    void setCache(RenderCache* cache);
+
+    // Hashes the output of every executed node. A node whose settings and
+    // input contents are unchanged since it last ran is not executed again,
+    // so re-executions that produce identical output stop propagating.
+    void setContentHasher(ContentHasher hasher);
+
+    // Receives the wall-clock time of every node that was executed,
+    // called from the worker thread that executed it. A fused chain
+    // is reported as a single execution of its last node.
+    void setNodeTimer(NodeTimer timer);
+
+    // Runs chains of pointwise nodes as a single kernel, only the last
+    // node of a chain gets a result. If the fuser returns nullptr the
+    // nodes are executed one by one. Without a fuser nothing is fused.
+    void setKernelFuser(KernelFuser fuser);
+
+    // Intermediates of tiled renders are created in memory shared by
+    // outputs whose lifetimes don't overlap. Can be nullptr, then every
+    // task allocates its own output.
+    void setTransientImagePool(CsTransientImagePool* pool);
+
+    // Renders stamped with this are never stopped
+    static constexpr uint64_t unstamped = std::numeric_limits<uint64_t>::max();
+
+    // Returns a new render generation. Renders stamped with an older one
+    // stop at the next node or tile boundary, nodes they did not reach
+    // keep their previous results. Can be called from any thread.
+    uint64_t startGeneration();
+
+    // True once a newer generation was started. Can be called from any thread.
+    bool isStale(const uint64_t generation) const;
+
+    // Brings the target up to date. Nodes that are clean or whose output
+    // is found in the cache are not executed, and neither is anything above them.
+    // Only the regions of interest set on the graph are computed.
+    // Returns false if the render was stopped by a newer generation.
+    bool render(
+        const RenderGraph& graph,
+        const int target,
+        const uint64_t generation = unstamped);
+
+    // Executes the given subset of nodes. Inputs outside
+    // of the subset are considered to be up to date.
+    void execute(const RenderGraph& graph, const std::vector<int>& nodes);
+
+    // Renders the target one tile at a time, each tile grown by the halo
+    // the nodes need. The callback receives every finished tile, results
+    // bypass the cache and are dropped once all tiles are done. With a
+    // transient image pool, intermediates share memory as planned by
+    // planImageAliasing().
+    // Returns false if the render was stopped by a newer generation.
+    bool renderTiled(
+        RenderGraph& graph,
+        const int target,
+        const TilePlan& plan,
+        const TileCallback& onTileRendered,
+        const uint64_t generation = unstamped);
+
+private:
+    bool run(
+        const RenderGraph& graph,
+        const std::vector<int>& nodes,
+        const bool isTile,
+        const uint64_t generation = unstamped);
+
+    // The nodes that need to be executed for the target, in topological order
+    std::vector<int> plan(const RenderGraph& graph, const int target);
+
+    void executeNode(const RenderGraph& graph, const int index, const bool isTile);
+
+    void executeChain(const RenderGraph& graph, const std::vector<int>& chain, const bool isTile);
+
+    // Allocates the output of the node in its block of the alias
+    // plan, nullptr if the node has a memory of its own
+    OutputFactory getOutputFactory(const int index, const bool isTile) const;
+
+    // Waits for one to be released once maxConcurrency were created
+    std::unique_ptr<CsCommandBuffer> acquireCommandBuffer();
+    void releaseCommandBuffer(std::unique_ptr<CsCommandBuffer> commandBuffer);
+    // All of them are released once a run has finished
+    void waitForCommandBuffers();
+
+    CommandBufferFactory mCommandBufferFactory;
+    const int mMaxConcurrency;
+
+    RenderCache* mCache = nullptr;
+    ContentHasher mContentHasher;
+    NodeTimer mNodeTimer;
+    KernelFuser mKernelFuser;
+    CsTransientImagePool* mTransientImagePool = nullptr;
+
+    // Only set while renderTiled() runs
+    AliasPlan mAliasPlan;
+
+    std::vector<std::unique_ptr<CsCommandBuffer>> mFreeCommandBuffers;
+    int mNumCommandBuffers = 0;
+    std::mutex mCommandBufferMutex;
+    std::condition_variable mCommandBufferReleased;
+
+    std::atomic<uint64_t> mGeneration { 0 };
+};
+
+} // namespace Cascade::Renderer
+
+#endif // GRAPHEXECUTOR_H
@@ -0,0 +1,150 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "imagealiasing.h"
+
+#include <algorithm>
+
+namespace Cascade::Renderer
+{
+
+uint64_t AliasPlan::getTotalBytes() const
+{
+    uint64_t total = 0;
+
+    for (const auto size : blockSizes)
+        total += size;
+
+    return total;
+}
+
+AliasPlan planImageAliasing(
+    const RenderGraph& graph,
+    const std::vector<int>& nodes,
+    const std::vector<uint64_t>& bytesPerNode,
+    const std::vector<int>& keptNodes)
+{
+    AliasPlan plan;
+    plan.blockOf.assign(graph.size(), -1);
+
+    // Positions in the given order, -1 for nodes that are not executed
+    std::vector<int> position(graph.size(), -1);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        position[nodes[i]] = static_cast<int>(i);
+
+    // isAncestor[b][a] if a always finishes before b starts. Only
+    // dependencies between executed nodes order anything.
+    std::vector<std::vector<bool>> isAncestor(
+        nodes.size(), std::vector<bool>(nodes.size(), false));
+
+    std::vector<std::vector<int>> consumers(nodes.size());
+
+    for (size_t b = 0; b < nodes.size(); ++b)
+    {
+        for (const auto input : graph.getNode(nodes[b]).inputs)
+        {
+            if (input < 0 || position[input] < 0)
+                continue;
+
+            const int a = position[input];
+
+            isAncestor[b][a] = true;
+
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                if (isAncestor[a][i])
+                    isAncestor[b][i] = true;
+            }
+
+            // The same node can be connected to several ports
+            if (std::find(consumers[a].begin(), consumers[a].end(), b) == consumers[a].end())
+                consumers[a].push_back(static_cast<int>(b));
+        }
+    }
+
+    // Occupant a is done with its block once b can't start before it
+    // and all of its consumers have finished
+    auto isDoneBefore = [&](const int a, const int b)
+    {
+        if (!isAncestor[b][a])
+            return false;
+
+        for (const auto consumer : consumers[a])
+        {
+            if (!isAncestor[b][consumer])
+                return false;
+        }
+
+        return true;
+    };
+
+    // The position of the node that took over each block last
+    std::vector<int> lastOccupant;
+
+    for (size_t b = 0; b < nodes.size(); ++b)
+    {
+        const int index = nodes[b];
+        const uint64_t bytes = bytesPerNode[index];
+
+        if (bytes == 0 ||
+            std::find(keptNodes.begin(), keptNodes.end(), index) != keptNodes.end())
+            continue;
+
+        // The smallest free block that fits, otherwise the largest
+        // free one, which grows. New blocks only if none is free.
+        int best = -1;
+
+        for (size_t block = 0; block < plan.blockSizes.size(); ++block)
+        {
+            if (!isDoneBefore(lastOccupant[block], static_cast<int>(b)))
+                continue;
+
+            if (best < 0)
+            {
+                best = static_cast<int>(block);
+                continue;
+            }
+
+            const uint64_t size = plan.blockSizes[block];
+            const uint64_t bestSize = plan.blockSizes[best];
+
+            const bool fits = size >= bytes;
+            const bool bestFits = bestSize >= bytes;
+
+            if ((fits && (!bestFits || size < bestSize)) ||
+                (!fits && !bestFits && size > bestSize))
+                best = static_cast<int>(block);
+        }
+
+        if (best < 0)
+        {
+            best = static_cast<int>(plan.blockSizes.size());
+            plan.blockSizes.push_back(0);
+            lastOccupant.push_back(-1);
+        }
+
+        plan.blockSizes[best] = std::max(plan.blockSizes[best], bytes);
+        lastOccupant[best] = static_cast<int>(b);
+        plan.blockOf[index] = best;
+    }
+
+    return plan;
+}
+
+} // namespace Cascade::Renderer
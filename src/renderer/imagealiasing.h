@@ -0,0 +1,57 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEALIASING_H
+#define IMAGEALIASING_H
+
+#include <cstdint>
+#include <vector>
+
+#include "rendergraph.h"
+
+namespace Cascade::Renderer
+{
+
+// Which memory block each transient node output lives in.
+// Outputs in the same block are never alive at the same time.
+struct AliasPlan
+{
+    // Per node of the graph, -1 if the output has a memory of its own
+    std::vector<int> blockOf;
+
+    // Large enough for every output assigned to the block
+    std::vector<uint64_t> blockSizes;
+
+    uint64_t getTotalBytes() const;
+};
+
+// Assigns the outputs of the given nodes, in topological order, to as
+// few and as small memory blocks as possible. An output only takes over
+// a block once the previous one in it and everything reading that were
+// executed, whichever order independent branches end up running in.
+// Kept nodes and those with a size of 0 get no block.
+AliasPlan planImageAliasing(
+    const RenderGraph& graph,
+    const std::vector<int>& nodes,
+    const std::vector<uint64_t>& bytesPerNode,
+    const std::vector<int>& keptNodes);
+
+} // namespace Cascade::Renderer
+
+#endif // IMAGEALIASING_H
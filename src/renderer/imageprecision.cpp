@@ -0,0 +1,194 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "imageprecision.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace Cascade::Renderer
+{
+
+namespace
+{
+
+std::atomic<ImagePrecision> currentPrecision(ImagePrecision::Float32);
+
+// From the SPIR-V specification
+constexpr uint32_t spirVMagicNumber = 0x07230203;
+constexpr uint32_t spirVHeaderWords = 5;
+constexpr uint32_t opTypeImage = 25;
+constexpr uint32_t imageFormatOperand = 8;
+constexpr uint32_t imageFormatRgba32f = 1;
+constexpr uint32_t imageFormatRgba16f = 2;
+
+} // namespace
+
+void setImagePrecision(const ImagePrecision precision)
+{
+    currentPrecision = precision;
+}
+
+ImagePrecision getImagePrecision()
+{
+    return currentPrecision;
+}
+
+uint64_t getBytesPerPixel(const ImagePrecision precision)
+{
+    return precision == ImagePrecision::Float16 ? 8 : 16;
+}
+
+QString getImageFormatName(const ImagePrecision precision)
+{
+    return precision == ImagePrecision::Float16 ? "rgba16f" : "rgba32f";
+}
+
+std::optional<ImagePrecision> imagePrecisionFromName(const QString& name)
+{
+    if (name == "rgba32f")
+        return ImagePrecision::Float32;
+    if (name == "rgba16f")
+        return ImagePrecision::Float16;
+
+    return std::nullopt;
+}
+
+uint16_t floatToHalf(const float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint16_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // Infinity and NaN, NaN stays a NaN
+    if (((bits >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+    // Too large, becomes infinity
+    if (exponent >= 0x1f)
+        return sign | 0x7c00;
+
+    // Denormal or zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return sign;
+
+        mantissa |= 0x800000;
+
+        const uint32_t shift = 14 - exponent;
+        const uint32_t half = 1u << (shift - 1);
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+
+        uint16_t result = static_cast<uint16_t>(mantissa >> shift);
+
+        if (rest > half || (rest == half && (result & 1)))
+            ++result;
+
+        return sign | result;
+    }
+
+    uint16_t result = static_cast<uint16_t>((exponent << 10) | (mantissa >> 13));
+
+    // Rounding may carry into the exponent, which is still correct
+    const uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (result & 1)))
+        ++result;
+
+    return sign | result;
+}
+
+float halfToFloat(const uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    uint32_t bits;
+
+    if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Denormal, normalize it
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+bool patchStorageImageFormat(std::vector<uint32_t>& spirV, const ImagePrecision precision)
+{
+    if (spirV.size() < spirVHeaderWords || spirV[0] != spirVMagicNumber)
+        return false;
+
+    const uint32_t format = precision == ImagePrecision::Float16 ?
+        imageFormatRgba16f : imageFormatRgba32f;
+
+    size_t i = spirVHeaderWords;
+
+    while (i < spirV.size())
+    {
+        const uint32_t numWords = spirV[i] >> 16;
+        const uint32_t opCode = spirV[i] & 0xffff;
+
+        if (numWords == 0 || i + numWords > spirV.size())
+            return false;
+
+        if (opCode == opTypeImage && numWords > imageFormatOperand)
+        {
+            uint32_t& imageFormat = spirV[i + imageFormatOperand];
+
+            // Other formats were chosen on purpose, e.g. r32ui
+            if (imageFormat == imageFormatRgba32f || imageFormat == imageFormatRgba16f)
+                imageFormat = format;
+        }
+
+        i += numWords;
+    }
+
+    return true;
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,65 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEPRECISION_H
+#define IMAGEPRECISION_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <QString>
+
+namespace Cascade::Renderer
+{
+
+// Format of all images the nodes compute into. Half precision takes up
+// half the memory and bandwidth, which is enough for most grading and
+// compositing. Images on the CPU are always RGBA32F.
+enum class ImagePrecision
+{
+    Float32,
+    Float16
+};
+
+// Process-wide, images and shaders created afterwards use it. Whoever
+// changes it has to recreate the pipelines and drop existing results.
+void setImagePrecision(const ImagePrecision precision);
+ImagePrecision getImagePrecision();
+
+uint64_t getBytesPerPixel(const ImagePrecision precision = getImagePrecision());
+
+// The layout qualifier of storage images in GLSL, also used in project files
+QString getImageFormatName(const ImagePrecision precision = getImagePrecision());
+std::optional<ImagePrecision> imagePrecisionFromName(const QString& name);
+
+// IEEE 754 binary16, rounding to nearest even
+uint16_t floatToHalf(const float value);
+float halfToFloat(const uint16_t value);
+
+// Rewrites the format of the rgba32f and rgba16f storage images declared
+// in a SPIR-V module to match the precision, so shaders compiled ahead of
+// time run on either. Returns false if the module is malformed.
+bool patchStorageImageFormat(
+    std::vector<uint32_t>& spirV,
+    const ImagePrecision precision = getImagePrecision());
+
+} // namespace Cascade::Renderer
+
+#endif // IMAGEPRECISION_H
@@ -0,0 +1,233 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "kernelfusion.h"
+
+#include <algorithm>
+
+#include "imageprecision.h"
+
+namespace Cascade::Renderer
+{
+
+namespace
+{
+
+// The node connected to the first port, -1 if there is none or
+// another port is connected as well. A kernel only sees its first
+// input, one with a connected mask can not be fused.
+int singleConnectedInput(const RenderGraphNode& node)
+{
+    if (node.inputs.empty() || node.inputs.front() < 0)
+        return -1;
+
+    for (size_t port = 1; port < node.inputs.size(); ++port)
+    {
+        if (node.inputs[port] >= 0)
+            return -1;
+    }
+
+    return node.inputs.front();
+}
+
+// Rounded up to whole vec4s, the array in the shader can't be empty
+size_t numParameterVectors(const size_t numParameters)
+{
+    return std::max<size_t>(1, (numParameters + 3) / 4);
+}
+
+} // namespace
+
+FusedRegion getFusedRegion(const QRect& roi, const QRect& inputRoi, const bool isTile)
+{
+    if (!isTile)
+        return { roi, QPoint(), QSize() };
+
+    // The first pixel of a tile is the top left of its roi
+    const QPoint inputOrigin = inputRoi.isNull() ? QPoint() : inputRoi.topLeft();
+
+    if (roi.isNull())
+        return { QRect(), -inputOrigin, QSize() };
+
+    return { QRect(QPoint(0, 0), roi.size()), roi.topLeft() - inputOrigin, roi.size() };
+}
+
+std::vector<std::vector<int>> findFusableChains(
+    const RenderGraph& graph,
+    const std::vector<int>& nodes,
+    const bool includeSingleNodes)
+{
+    std::vector<bool> isScheduled(graph.size(), false);
+    std::vector<bool> isPointwise(graph.size(), false);
+
+    for (const auto index : nodes)
+    {
+        isScheduled[index] = true;
+
+        const auto& node = graph.getNode(index);
+        isPointwise[index] = node.task && node.task->getPointwiseKernel(node.settings).has_value();
+    }
+
+    std::vector<int> next(graph.size(), -1);
+    std::vector<int> previous(graph.size(), -1);
+
+    for (const auto index : nodes)
+    {
+        if (!isPointwise[index])
+            continue;
+
+        const int input = singleConnectedInput(graph.getNode(index));
+
+        if (input < 0 || !isScheduled[input] || !isPointwise[input])
+            continue;
+
+        if (graph.getNode(input).outputs.size() != 1)
+            continue;
+
+        next[input] = index;
+        previous[index] = input;
+    }
+
+    std::vector<std::vector<int>> chains;
+
+    // Walking the heads in order keeps the chains topologically sorted
+    for (const auto index : nodes)
+    {
+        if (previous[index] >= 0)
+            continue;
+
+        // A single node still needs its input on the first port
+        const bool isSingle = next[index] < 0;
+        if (isSingle && (!includeSingleNodes || !isPointwise[index] ||
+                         singleConnectedInput(graph.getNode(index)) < 0))
+            continue;
+
+        std::vector<int> chain;
+
+        for (int current = index; current >= 0; current = next[current])
+            chain.push_back(current);
+
+        chains.push_back(std::move(chain));
+    }
+
+    return chains;
+}
+
+std::string fusedKernelSignature(const std::vector<PointwiseKernel>& kernels)
+{
+    // The parameter offsets are baked into the shader
+    std::string signature;
+
+    for (const auto& kernel : kernels)
+    {
+        signature += kernel.name.toStdString();
+        signature += ":" + std::to_string(kernel.parameters.size()) + "|";
+    }
+
+    return signature;
+}
+
+std::string generateFusedShader(const std::vector<PointwiseKernel>& kernels)
+{
+    size_t numParameters = 0;
+
+    for (const auto& kernel : kernels)
+        numParameters += kernel.parameters.size();
+
+    const std::string format = getImageFormatName().toStdString();
+
+    std::string code =
+        "#version 430\n"
+        "\n"
+        "layout (local_size_x = 16, local_size_y = 16) in;\n"
+        "layout (set = 0, binding = 0, " + format + ") uniform readonly image2D inputImage;\n"
+        "layout (set = 1, binding = 0, " + format + ") uniform image2D resultImage;\n"
+        "\n"
+        "layout (set = 2, binding = 0) uniform InputBuffer\n"
+        "{\n"
+        "    vec4 parameters[" + std::to_string(numParameterVectors(numParameters)) + "];\n"
+        "} sb;\n"
+        "\n"
+        "layout (push_constant) uniform Region\n"
+        "{\n"
+        "    ivec2 inputOffset;\n"
+        "} region;\n"
+        "\n"
+        "float parameterAt(const int i)\n"
+        "{\n"
+        "    return sb.parameters[i / 4][i % 4];\n"
+        "}\n";
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < kernels.size(); ++i)
+    {
+        // Every kernel in a function of its own, so that
+        // local variables of different kernels don't clash
+        code +=
+            "\n"
+            "// " + kernels[i].name.toStdString() + "\n"
+            "vec4 stage" + std::to_string(i) + "(vec4 pixel)\n"
+            "{\n"
+            "#define parameter(i) parameterAt(" + std::to_string(offset) + " + (i))\n" +
+            kernels[i].source.toStdString() + "\n"
+            "#undef parameter\n"
+            "    return pixel;\n"
+            "}\n";
+
+        offset += kernels[i].parameters.size();
+    }
+
+    code +=
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    vec4 pixel = imageLoad(inputImage, pixelCoords + region.inputOffset).rgba;\n";
+
+    for (size_t i = 0; i < kernels.size(); ++i)
+        code += "    pixel = stage" + std::to_string(i) + "(pixel);\n";
+
+    code +=
+        "\n"
+        "    imageStore(resultImage, pixelCoords, pixel);\n"
+        "}\n";
+
+    return code;
+}
+
+std::vector<float> packFusedParameters(const std::vector<PointwiseKernel>& kernels)
+{
+    std::vector<float> parameters;
+
+    for (const auto& kernel : kernels)
+    {
+        parameters.insert(
+            parameters.end(),
+            kernel.parameters.begin(),
+            kernel.parameters.end());
+    }
+
+    parameters.resize(numParameterVectors(parameters.size()) * 4, 0.0f);
+
+    return parameters;
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,89 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef KERNELFUSION_H
+#define KERNELFUSION_H
+
+#include <string>
+#include <vector>
+
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+#include "rendergraph.h"
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+// More parameters than fit into the uniform buffer of a
+// fused kernel and the chain is executed node by node
+constexpr size_t maxFusedParameters = 256;
+
+// Where a fused chain reads and writes, in pixels of its images.
+// Tiles start at their roi, and the input of a chain covers more
+// than its output if it has other consumers that need more.
+struct FusedRegion
+{
+    // The part of the output to compute, null for all of it
+    QRect roi;
+    // The input pixel that output pixel (0, 0) is computed from
+    QPoint inputOffset;
+    // Empty for the size of the input
+    QSize outputSize;
+
+    bool operator==(const FusedRegion& other) const
+    {
+        return roi == other.roi &&
+               inputOffset == other.inputOffset &&
+               outputSize == other.outputSize;
+    }
+};
+
+// The region for a chain whose last node has the given roi and whose
+// input has inputRoi. Outside of tiles images cover the whole canvas.
+FusedRegion getFusedRegion(const QRect& roi, const QRect& inputRoi, const bool isTile);
+
+// Runs of pointwise nodes among the given ones, each in order from the
+// node closest to the inputs to the one whose result is needed. Every
+// node but the last has no other consumer, so its result is never needed.
+// Runs of a single node are left out unless includeSingleNodes is set.
+std::vector<std::vector<int>> findFusableChains(
+    const RenderGraph& graph,
+    const std::vector<int>& nodes,
+    const bool includeSingleNodes = false);
+
+// Identifies the fused shader, the same for chains that
+// only differ in the values of their parameters
+std::string fusedKernelSignature(const std::vector<PointwiseKernel>& kernels);
+
+// Compute shader that applies all kernels to every pixel, reading the input
+// from set 0, writing to set 1 and taking the parameters from the uniform
+// buffer in set 2. The images are the only binding of their sets. The
+// input offset of the FusedRegion is an ivec2 push constant.
+std::string generateFusedShader(const std::vector<PointwiseKernel>& kernels);
+
+// The contents of the uniform buffer for the fused shader
+std::vector<float> packFusedParameters(const std::vector<PointwiseKernel>& kernels);
+
+} // namespace Cascade::Renderer
+
+#endif // KERNELFUSION_H
@@ -0,0 +1,79 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LATESTVALUEMAILBOX_H
+#define LATESTVALUEMAILBOX_H
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+namespace Cascade::Renderer
+{
+
+// Hands values from one producer thread to one consumer thread without
+// locking. Only the latest value is kept, posting again before the
+// consumer took the previous value replaces it.
+//
+// Triple buffered: producer and consumer each own a slot, the third one
+// is swapped atomically between them together with a flag telling
+// whether it holds a value that was not taken yet.
+template <typename T>
+class LatestValueMailbox
+{
+public:
+    // Producer side only
+    void post(T value)
+    {
+        mSlots[mWriteSlot] = std::move(value);
+
+        const int previous = mMiddle.exchange(
+            mWriteSlot | freshBit, std::memory_order_acq_rel);
+
+        mWriteSlot = previous & slotMask;
+    }
+
+    // Consumer side only. The latest value posted since
+    // the last call, nothing if there is none.
+    std::optional<T> take()
+    {
+        if (!(mMiddle.load(std::memory_order_acquire) & freshBit))
+            return std::nullopt;
+
+        const int previous = mMiddle.exchange(mReadSlot, std::memory_order_acq_rel);
+
+        mReadSlot = previous & slotMask;
+
+        return std::move(mSlots[mReadSlot]);
+    }
+
+private:
+    static constexpr int slotMask = 3;
+    static constexpr int freshBit = 4;
+
+    std::array<T, 3> mSlots;
+
+    int mWriteSlot = 0;
+    std::atomic<int> mMiddle { 1 };
+    int mReadSlot = 2;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // LATESTVALUEMAILBOX_H
@@ -0,0 +1,492 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "offscreenrenderer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "../log.h"
+#include "../multithreading.h"
+#include "cscommandbuffer.h"
+#include "csdeletionqueue.h"
+#include "csdescriptorallocator.h"
+#include "csimage.h"
+#include "csimagehasher.h"
+#include "csimagetransfer.h"
+#include "cskernelfuser.h"
+#include "csmemoryallocator.h"
+#include "csstagingbuffer.h"
+#include "cstransientimagepool.h"
+#include "pipelinecachefile.h"
+#include "renderconfig.h"
+#include "tiledimagewriter.h"
+
+namespace Cascade::Renderer
+{
+
+OffscreenRenderer::OffscreenRenderer() {}
+
+bool OffscreenRenderer::initialize(const QString& preferredDevice)
+{
+    if (!createInstance() || !pickPhysicalDevice(preferredDevice) || !createDevice())
+        return false;
+
+    mMemoryAllocator = std::make_unique<CsMemoryAllocator>(&mDevice, &mPhysicalDevice);
+    mDeletionQueue = std::make_unique<CsDeletionQueue>();
+    mDescriptorAllocator = std::make_unique<CsDescriptorAllocator>(&mDevice);
+
+    createComputeDescriptors();
+    createComputePipelineLayout();
+    createPipelineCache();
+
+    mImageHasher = std::make_unique<CsImageHasher>(
+        &mDevice, mMemoryAllocator.get(), mDescriptorAllocator.get(), &mPipelineCache.get());
+
+    mKernelFuser = std::make_unique<CsKernelFuser>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        mDescriptorAllocator.get(),
+        &mPipelineCache.get());
+
+    mTransientImagePool = std::make_unique<CsTransientImagePool>(
+        &mDevice, &mPhysicalDevice, mMemoryAllocator.get(), mDeletionQueue.get());
+
+    mComputeCommandBuffer = createComputeCommandBuffer();
+    mUploadCommandBuffer = createComputeCommandBuffer();
+    if (!mComputeCommandBuffer || !mUploadCommandBuffer)
+        return false;
+
+    mImageTransfer = std::make_unique<CsImageTransfer>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        mComputeCommandBuffer.get(),
+        mUploadCommandBuffer.get());
+
+    // Load OCIO config
+    try
+    {
+        const char* file = "ocio/config.ocio";
+        mOcioConfig      = OCIO::Config::CreateFromFile(file);
+    }
+    catch (OCIO::Exception& exception)
+    {
+        CS_LOG_WARNING("OpenColorIO Error: " + QString(exception.what()));
+    }
+
+    return true;
+}
+
+bool OffscreenRenderer::createInstance()
+{
+    // Set up Dynamic Dispatch Loader to use with vulkan.hpp
+    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr =
+        mLoader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
+    if (!vkGetInstanceProcAddr)
+    {
+        CS_LOG_WARNING("Could not find the Vulkan loader.");
+        return false;
+    }
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+
+    // Layers and extensions are optional here, CI machines rarely have them
+    const auto availableLayers = vk::enumerateInstanceLayerProperties().value;
+    std::vector<const char*> layers;
+    for (const auto& layer : instanceLayers)
+    {
+        for (const auto& available : availableLayers)
+        {
+            if (layer == available.layerName.data())
+                layers.push_back(layer.constData());
+        }
+    }
+
+    const auto availableExtensions = vk::enumerateInstanceExtensionProperties().value;
+    std::vector<const char*> extensions;
+    for (const auto& extension : instanceExtensions)
+    {
+        const bool isAvailable = std::any_of(
+            availableExtensions.begin(),
+            availableExtensions.end(),
+            [&extension](const vk::ExtensionProperties& available)
+            {
+                return extension == available.extensionName.data();
+            });
+
+        if (isAvailable)
+            extensions.push_back(extension.constData());
+        else
+            CS_LOG_WARNING("Instance extension " + QString(extension) + " is not available.");
+    }
+
+    // Vulkan 1.1 for vkCmdDispatchBase
+    vk::ApplicationInfo appInfo("Cascade", 0, "Cascade", 0, VK_API_VERSION_1_1);
+
+    vk::InstanceCreateInfo instanceInfo(
+        {},
+        &appInfo,
+        static_cast<uint32_t>(layers.size()),
+        layers.data(),
+        static_cast<uint32_t>(extensions.size()),
+        extensions.data());
+
+    auto instance = vk::createInstanceUnique(instanceInfo);
+    if (instance.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Failed to create Vulkan instance.");
+        return false;
+    }
+    mInstance = std::move(instance.value);
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(*mInstance);
+
+    return true;
+}
+
+bool OffscreenRenderer::pickPhysicalDevice(const QString& preferredDevice)
+{
+    const auto physicalDevices = mInstance->enumeratePhysicalDevices().value;
+
+    // Lower is better, software rasterizers are the last resort
+    auto rank = [](const vk::PhysicalDeviceType type)
+    {
+        switch (type)
+        {
+            case vk::PhysicalDeviceType::eDiscreteGpu:   return 0;
+            case vk::PhysicalDeviceType::eIntegratedGpu: return 1;
+            case vk::PhysicalDeviceType::eVirtualGpu:    return 2;
+            case vk::PhysicalDeviceType::eCpu:           return 3;
+            default:                                     return 4;
+        }
+    };
+
+    int bestRank = std::numeric_limits<int>::max();
+
+    for (const auto& physicalDevice : physicalDevices)
+    {
+        const auto properties = physicalDevice.getProperties();
+
+        if (properties.apiVersion < VK_API_VERSION_1_1)
+            continue;
+
+        const auto queueFamilies = physicalDevice.getQueueFamilyProperties();
+        const bool hasCompute = std::any_of(
+            queueFamilies.begin(),
+            queueFamilies.end(),
+            [](const vk::QueueFamilyProperties& family)
+            {
+                return bool(family.queueFlags & vk::QueueFlagBits::eCompute);
+            });
+        if (!hasCompute)
+            continue;
+
+        const QString name = QString::fromLatin1(properties.deviceName.data());
+
+        if (!preferredDevice.isEmpty() && name.contains(preferredDevice, Qt::CaseInsensitive))
+        {
+            mPhysicalDevice = physicalDevice;
+            break;
+        }
+
+        if (rank(properties.deviceType) < bestRank)
+        {
+            bestRank = rank(properties.deviceType);
+            mPhysicalDevice = physicalDevice;
+        }
+    }
+
+    if (!mPhysicalDevice)
+    {
+        CS_LOG_WARNING("No Vulkan 1.1 device with compute support found.");
+        return false;
+    }
+
+    CS_LOG_INFO("Rendering on " + getGpuName());
+
+    return true;
+}
+
+bool OffscreenRenderer::createDevice()
+{
+    // The command buffers use the first queue of the first compute family
+    const auto queueFamilies = mPhysicalDevice.getQueueFamilyProperties();
+
+    uint32_t computeFamilyIndex = 0;
+    for (uint32_t i = 0; i < queueFamilies.size(); ++i)
+    {
+        if (queueFamilies[i].queueFlags & vk::QueueFlagBits::eCompute)
+        {
+            computeFamilyIndex = i;
+            break;
+        }
+    }
+
+    const float priority = 1.0f;
+    vk::DeviceQueueCreateInfo queueInfo({}, computeFamilyIndex, 1, &priority);
+
+    vk::DeviceCreateInfo deviceInfo({}, 1, &queueInfo);
+
+    auto device = mPhysicalDevice.createDeviceUnique(deviceInfo);
+    if (device.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Failed to create Vulkan device.");
+        return false;
+    }
+    mUniqueDevice = std::move(device.value);
+    mDevice = *mUniqueDevice;
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(mDevice);
+
+    return true;
+}
+
+void OffscreenRenderer::createComputeDescriptors()
+{
+    // Same layout as the viewer's renderer, the shaders are shared.
+    // 2 images to read, 1 image to write, settings
+    std::vector<vk::DescriptorSetLayoutBinding> bindings(4);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        bindings.at(i).binding         = i;
+        bindings.at(i).descriptorType  = vk::DescriptorType::eStorageImage;
+        bindings.at(i).descriptorCount = 1;
+        bindings.at(i).stageFlags      = vk::ShaderStageFlagBits::eCompute;
+    }
+
+    bindings.at(3).binding         = 3;
+    bindings.at(3).descriptorType  = vk::DescriptorType::eUniformBuffer;
+    bindings.at(3).descriptorCount = 1;
+    bindings.at(3).stageFlags      = vk::ShaderStageFlagBits::eCompute;
+
+    vk::DescriptorSetLayoutCreateInfo descSetLayoutCreateInfo(
+        {}, static_cast<uint32_t>(bindings.size()), bindings.data());
+
+    mComputeDescriptorSetLayout =
+        mDevice.createDescriptorSetLayoutUnique(descSetLayoutCreateInfo).value;
+
+    // One set per parallel branch plus the ones for reading back and uploading
+    const uint32_t maxSets = maxParallelBranches + 2;
+
+    std::vector<vk::DescriptorPoolSize> descPoolSizes = {
+        {vk::DescriptorType::eUniformBuffer, 1 * maxSets},
+        {vk::DescriptorType::eStorageImage, 3 * maxSets}};
+
+    vk::DescriptorPoolCreateInfo descPoolInfo(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        maxSets,
+        static_cast<uint32_t>(descPoolSizes.size()),
+        descPoolSizes.data());
+
+    mExecutorDescriptorPool = mDevice.createDescriptorPoolUnique(descPoolInfo).value;
+}
+
+void OffscreenRenderer::createComputePipelineLayout()
+{
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, 1, &(*mComputeDescriptorSetLayout));
+
+    mComputePipelineLayout = mDevice.createPipelineLayoutUnique(pipelineLayoutInfo).value;
+}
+
+void OffscreenRenderer::createPipelineCache()
+{
+    mPipelineCache = loadPipelineCache(mDevice, mPhysicalDevice);
+}
+
+QString OffscreenRenderer::getGpuName() const
+{
+    return QString::fromLatin1(mPhysicalDevice.getProperties().deviceName.data());
+}
+
+std::unique_ptr<CsCommandBuffer> OffscreenRenderer::createComputeCommandBuffer()
+{
+    vk::DescriptorSetAllocateInfo descSetAllocInfo(
+        *mExecutorDescriptorPool, 1, &(*mComputeDescriptorSetLayout));
+
+    auto descriptorSets = mDevice.allocateDescriptorSetsUnique(descSetAllocInfo);
+    if (descriptorSets.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Could not allocate descriptor set for command buffer.");
+        return nullptr;
+    }
+
+    return std::make_unique<CsCommandBuffer>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        &mComputePipelineLayout.get(),
+        std::move(descriptorSets.value.front()));
+}
+
+CsImageHasher* OffscreenRenderer::getImageHasher()
+{
+    return mImageHasher.get();
+}
+
+CsKernelFuser* OffscreenRenderer::getKernelFuser()
+{
+    return mKernelFuser.get();
+}
+
+CsTransientImagePool* OffscreenRenderer::getTransientImagePool()
+{
+    return mTransientImagePool.get();
+}
+
+CsGpuProfiler* OffscreenRenderer::getGpuProfiler()
+{
+    // Batch renders report CPU timings
+    return nullptr;
+}
+
+void OffscreenRenderer::setImagePrecision(const ImagePrecision precision)
+{
+    if (precision == getImagePrecision())
+        return;
+
+    [[maybe_unused]] auto result = mDevice.waitIdle();
+
+    Renderer::setImagePrecision(precision);
+
+    // Their shaders are patched for the storage image format
+    mImageHasher = std::make_unique<CsImageHasher>(
+        &mDevice, mMemoryAllocator.get(), mDescriptorAllocator.get(), &mPipelineCache.get());
+
+    mKernelFuser = std::make_unique<CsKernelFuser>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        mDescriptorAllocator.get(),
+        &mPipelineCache.get());
+}
+
+bool OffscreenRenderer::readImage(CsImage* const image, std::vector<float>& pixels)
+{
+    return mImageTransfer->readImage(image, pixels);
+}
+
+std::shared_ptr<CsImage> OffscreenRenderer::uploadImage(const float* pixels, const QSize& size)
+{
+    return mImageTransfer->uploadImage(pixels, size);
+}
+
+std::unique_ptr<CsStagingRegion> OffscreenRenderer::acquireStagingRegion(const QSize& size)
+{
+    return mImageTransfer->acquireStagingRegion(size);
+}
+
+std::shared_ptr<CsImage> OffscreenRenderer::uploadStagedImage(
+    std::unique_ptr<CsStagingRegion> region,
+    const QSize& size)
+{
+    return mImageTransfer->uploadStagedImage(std::move(region), size);
+}
+
+std::unique_ptr<TiledImageWriter> OffscreenRenderer::createTiledImageWriter(
+    const QString& path,
+    const QSize& canvasSize,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace)
+{
+    return std::make_unique<TiledImageWriter>(
+        path,
+        canvasSize,
+        attributes,
+        [this, colorSpace](OIIO::ImageBuf& strip)
+        {
+            transformColorSpace("linear", colorSpaces.at(colorSpace), strip);
+        });
+}
+
+void OffscreenRenderer::transformColorSpace(
+    const QString& from,
+    const QString& to,
+    OIIO::ImageBuf& image)
+{
+    if (!mOcioConfig)
+        return;
+
+    parallelApplyColorSpace(
+        mOcioConfig,
+        from,
+        to,
+        static_cast<float*>(image.localpixels()),
+        image.xend(),
+        image.yend());
+}
+
+int OffscreenRenderer::getMaxImageDimension() const
+{
+    return static_cast<int>(mPhysicalDevice.getProperties().limits.maxImageDimension2D);
+}
+
+uint64_t OffscreenRenderer::getDeviceMemoryBudget() const
+{
+    auto memProperties = mPhysicalDevice.getMemoryProperties();
+
+    vk::DeviceSize largestHeap = 0;
+
+    for (uint32_t i = 0; i < memProperties.memoryHeapCount; ++i)
+    {
+        if (memProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+            largestHeap = std::max(largestHeap, memProperties.memoryHeaps[i].size);
+    }
+
+    // Nothing else is competing for memory without a viewer
+    return largestHeap * 3 / 4;
+}
+
+void OffscreenRenderer::shutdown()
+{
+    if (!mDevice)
+        return;
+
+    [[maybe_unused]] auto result = mDevice.waitIdle();
+
+    mImageTransfer              = nullptr;
+    mComputeCommandBuffer       = nullptr;
+    mUploadCommandBuffer        = nullptr;
+    mTransientImagePool         = nullptr;
+    mKernelFuser                = nullptr;
+    mImageHasher                = nullptr;
+    if (mPipelineCache)
+        savePipelineCache(mDevice, mPhysicalDevice, *mPipelineCache);
+    mPipelineCache              = {};
+    mComputePipelineLayout      = {};
+    mExecutorDescriptorPool     = {};
+    mComputeDescriptorSetLayout = {};
+    mDeletionQueue              = nullptr;
+    mDescriptorAllocator        = nullptr;
+    mMemoryAllocator            = nullptr;
+    mUniqueDevice               = {};
+    mDevice                     = nullptr;
+    mInstance                   = {};
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    shutdown();
+}
+
+} // namespace Cascade::Renderer
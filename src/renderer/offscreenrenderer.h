@@ -0,0 +1,135 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include <memory>
+
+#include <QString>
+
+#include <OpenColorIO/OpenColorIO.h>
+#include <OpenImageIO/imagebuf.h>
+
+#include "renderdevice.h"
+#include "vulkanhppinclude.h"
+
+namespace OCIO = OCIO_NAMESPACE;
+
+namespace Cascade::Renderer
+{
+
+class CsDeletionQueue;
+class CsDescriptorAllocator;
+class CsImageTransfer;
+class CsMemoryAllocator;
+
+// Runs the graph executor on a Vulkan device of its own, without a
+// window or swapchain. Used for batch rendering, where any device that
+// can do compute will do, including software ones like lavapipe.
+class OffscreenRenderer : public RenderDevice
+{
+public:
+    OffscreenRenderer();
+
+    // Picks the first device whose name contains preferredDevice,
+    // otherwise the fastest one available
+    bool initialize(const QString& preferredDevice = QString());
+
+    QString getGpuName() const;
+
+    std::unique_ptr<CsCommandBuffer> createComputeCommandBuffer() override;
+
+    CsImageHasher* getImageHasher() override;
+    CsKernelFuser* getKernelFuser() override;
+    CsTransientImagePool* getTransientImagePool() override;
+    CsGpuProfiler* getGpuProfiler() override;
+
+    void setImagePrecision(const ImagePrecision precision) override;
+
+    bool readImage(CsImage* const image, std::vector<float>& pixels) override;
+
+    std::shared_ptr<CsImage> uploadImage(const float* pixels, const QSize& size) override;
+
+    std::unique_ptr<CsStagingRegion> acquireStagingRegion(const QSize& size) override;
+
+    std::shared_ptr<CsImage> uploadStagedImage(
+        std::unique_ptr<CsStagingRegion> region,
+        const QSize& size) override;
+
+    std::unique_ptr<TiledImageWriter> createTiledImageWriter(
+        const QString& path,
+        const QSize& canvasSize,
+        const QMap<std::string, std::string>& attributes,
+        const int colorSpace) override;
+
+    int getMaxImageDimension() const override;
+    uint64_t getDeviceMemoryBudget() const override;
+
+    // Everything created from the device has to be
+    // destroyed before, e.g. the graph executor
+    void shutdown();
+
+    ~OffscreenRenderer();
+
+private:
+    bool createInstance();
+    bool pickPhysicalDevice(const QString& preferredDevice);
+    bool createDevice();
+
+    void createComputeDescriptors();
+    void createComputePipelineLayout();
+    void createPipelineCache();
+
+    void transformColorSpace(const QString& from, const QString& to, OIIO::ImageBuf& image);
+
+    vk::DynamicLoader mLoader;
+
+    vk::UniqueInstance mInstance;
+    vk::PhysicalDevice mPhysicalDevice;
+    vk::UniqueDevice mUniqueDevice;
+    // Command buffers and images keep a pointer to this
+    vk::Device mDevice;
+
+    std::unique_ptr<CsMemoryAllocator> mMemoryAllocator;
+    std::unique_ptr<CsDeletionQueue> mDeletionQueue;
+    std::unique_ptr<CsDescriptorAllocator> mDescriptorAllocator;
+
+    vk::UniqueDescriptorSetLayout mComputeDescriptorSetLayout;
+    vk::UniqueDescriptorPool mExecutorDescriptorPool;
+    vk::UniquePipelineLayout mComputePipelineLayout;
+    vk::UniquePipelineCache mPipelineCache;
+
+    std::unique_ptr<CsImageHasher> mImageHasher;
+    std::unique_ptr<CsKernelFuser> mKernelFuser;
+    std::unique_ptr<CsTransientImagePool> mTransientImagePool;
+
+    // Only used for reading back results
+    std::unique_ptr<CsCommandBuffer> mComputeCommandBuffer;
+    // Only used for uploading images, so that reading back
+    // and uploading at the same time don't wait for each other
+    std::unique_ptr<CsCommandBuffer> mUploadCommandBuffer;
+    std::unique_ptr<CsImageTransfer> mImageTransfer;
+
+    OCIO::ConstConfigRcPtr mOcioConfig;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // OFFSCREENRENDERER_H
@@ -0,0 +1,147 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pipelinecachefile.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "../log.h"
+#include "pipelinecacheheader.h"
+
+namespace Cascade::Renderer
+{
+
+static_assert(pipelineCacheUuidSize == VK_UUID_SIZE);
+static_assert(pipelineCacheHeaderVersionOne == VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+
+static bool isCompatible(
+    const QByteArray& data,
+    const vk::PhysicalDeviceProperties& properties)
+{
+    PipelineCacheDevice device;
+    device.vendorId = properties.vendorID;
+    device.deviceId = properties.deviceID;
+    std::copy(
+        properties.pipelineCacheUUID.begin(),
+        properties.pipelineCacheUUID.end(),
+        device.uuid.begin());
+
+    return isPipelineCacheCompatible(
+        data.constData(), static_cast<size_t>(data.size()), device);
+}
+
+QString getPipelineCachePath(const vk::PhysicalDeviceProperties& properties)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+
+    if (dir.isEmpty())
+        return QString();
+
+    const QByteArray uuid(
+        reinterpret_cast<const char*>(properties.pipelineCacheUUID.data()),
+        VK_UUID_SIZE);
+
+    return dir + QString("/cascade/pipelinecache-%1-%2-%3.bin")
+        .arg(properties.vendorID, 4, 16, QChar('0'))
+        .arg(properties.deviceID, 4, 16, QChar('0'))
+        .arg(QString::fromLatin1(uuid.toHex()));
+}
+
+vk::UniquePipelineCache loadPipelineCache(
+    const vk::Device& device,
+    const vk::PhysicalDevice& physicalDevice)
+{
+    const auto properties = physicalDevice.getProperties();
+
+    QByteArray data;
+
+    QFile file(getPipelineCachePath(properties));
+    if (file.exists() && file.open(QIODevice::ReadOnly))
+    {
+        data = file.readAll();
+
+        if (isCompatible(data, properties))
+        {
+            CS_LOG_INFO("Loaded pipeline cache.");
+        }
+        else
+        {
+            CS_LOG_INFO("Pipeline cache was written for another GPU or driver, ignoring it.");
+            data.clear();
+        }
+    }
+
+    vk::PipelineCacheCreateInfo pipelineCacheInfo(
+        {},
+        static_cast<size_t>(data.size()),
+        data.constData());
+
+    auto pipelineCache = device.createPipelineCacheUnique(pipelineCacheInfo);
+
+    if (pipelineCache.result == vk::Result::eSuccess)
+        return std::move(pipelineCache.value);
+
+    CS_LOG_WARNING("Could not create the pipeline cache from disk, starting empty.");
+
+    return device.createPipelineCacheUnique(vk::PipelineCacheCreateInfo()).value;
+}
+
+void savePipelineCache(
+    const vk::Device& device,
+    const vk::PhysicalDevice& physicalDevice,
+    const vk::PipelineCache& pipelineCache)
+{
+    const QString path = getPipelineCachePath(physicalDevice.getProperties());
+
+    if (path.isEmpty() || !pipelineCache)
+        return;
+
+    auto data = device.getPipelineCacheData(pipelineCache);
+
+    if (data.result != vk::Result::eSuccess || data.value.empty())
+    {
+        CS_LOG_WARNING("Could not get the pipeline cache data.");
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Written to a temporary file first, so another instance
+    // never reads half of it
+    QSaveFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        CS_LOG_WARNING("Could not open " + path + " to save the pipeline cache.");
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(data.value.data()), data.value.size());
+
+    if (!file.commit())
+        CS_LOG_WARNING("Could not save the pipeline cache.");
+}
+
+} // namespace Cascade::Renderer
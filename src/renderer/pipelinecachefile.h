@@ -0,0 +1,50 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPELINECACHEFILE_H
+#define PIPELINECACHEFILE_H
+
+#include <QString>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer
+{
+
+// Where the pipeline cache is kept between launches, shared by the
+// editor and the command line renderer. Each GPU and driver gets its
+// own file, so switching between them doesn't throw the cache away.
+QString getPipelineCachePath(const vk::PhysicalDeviceProperties& properties);
+
+// Creates the pipeline cache from the one saved by an earlier launch.
+// Data written by another driver or GPU is ignored, the cache starts
+// empty then.
+vk::UniquePipelineCache loadPipelineCache(
+    const vk::Device& device,
+    const vk::PhysicalDevice& physicalDevice);
+
+// Has to be called before the cache is destroyed
+void savePipelineCache(
+    const vk::Device& device,
+    const vk::PhysicalDevice& physicalDevice,
+    const vk::PipelineCache& pipelineCache);
+
+} // namespace Cascade::Renderer
+
+#endif // PIPELINECACHEFILE_H
@@ -0,0 +1,62 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pipelinecacheheader.h"
+
+#include <cstring>
+
+namespace Cascade::Renderer
+{
+
+// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+static constexpr size_t cacheHeaderSize = 16 + pipelineCacheUuidSize;
+
+static uint32_t readUint32(const char* const data, const size_t offset)
+{
+    uint32_t value;
+    std::memcpy(&value, data + offset, sizeof(value));
+
+    return value;
+}
+
+bool isPipelineCacheCompatible(
+    const char* const data,
+    const size_t size,
+    const PipelineCacheDevice& device)
+{
+    if (!data || size < cacheHeaderSize)
+        return false;
+
+    const uint32_t headerSize = readUint32(data, 0);
+    const uint32_t headerVersion = readUint32(data, 4);
+
+    if (headerSize < cacheHeaderSize || headerSize > size)
+        return false;
+
+    if (headerVersion != pipelineCacheHeaderVersionOne)
+        return false;
+
+    if (readUint32(data, 8) != device.vendorId ||
+        readUint32(data, 12) != device.deviceId)
+        return false;
+
+    return std::memcmp(data + 16, device.uuid.data(), pipelineCacheUuidSize) == 0;
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,52 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPELINECACHEHEADER_H
+#define PIPELINECACHEHEADER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cascade::Renderer
+{
+
+// VK_UUID_SIZE and VK_PIPELINE_CACHE_HEADER_VERSION_ONE, kept
+// here so the header check can be tested without a device
+inline constexpr size_t pipelineCacheUuidSize = 16;
+inline constexpr uint32_t pipelineCacheHeaderVersionOne = 1;
+
+// The GPU and driver a pipeline cache is written for
+struct PipelineCacheDevice
+{
+    uint32_t vendorId;
+    uint32_t deviceId;
+    std::array<uint8_t, pipelineCacheUuidSize> uuid;
+};
+
+// Whether the data starts with a header the device wrote. The driver is
+// supposed to reject foreign data by itself, not all of them do.
+bool isPipelineCacheCompatible(
+    const char* const data,
+    const size_t size,
+    const PipelineCacheDevice& device);
+
+} // namespace Cascade::Renderer
+
+#endif // PIPELINECACHEHEADER_H
@@ -0,0 +1,153 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rangeallocator.h"
+
+namespace Cascade::Renderer
+{
+
+RangeAllocator::RangeAllocator(const uint64_t size) :
+    mSize(size)
+{
+    if (size > 0)
+    {
+        mRanges[0] = { size, true };
+        insertFree(0, size);
+    }
+}
+
+std::optional<uint64_t> RangeAllocator::allocate(const uint64_t size, const uint64_t alignment)
+{
+    if (size == 0)
+        return std::nullopt;
+
+    // Best fit first, larger ranges only if the alignment doesn't fit
+    for (auto it = mFreeRanges.lower_bound(size); it != mFreeRanges.end(); ++it)
+    {
+        const uint64_t rangeOffset = it->second;
+        const uint64_t rangeSize = it->first;
+
+        const uint64_t offset = alignment > 1 ?
+            (rangeOffset + alignment - 1) / alignment * alignment : rangeOffset;
+        const uint64_t padding = offset - rangeOffset;
+
+        if (padding + size > rangeSize)
+            continue;
+
+        mFreeRanges.erase(it);
+
+        // The padding stays free in front of the allocation
+        if (padding > 0)
+        {
+            mRanges[rangeOffset] = { padding, true };
+            insertFree(rangeOffset, padding);
+        }
+        else
+        {
+            mRanges.erase(rangeOffset);
+        }
+
+        mRanges[offset] = { size, false };
+
+        const uint64_t rest = rangeSize - padding - size;
+        if (rest > 0)
+        {
+            mRanges[offset + size] = { rest, true };
+            insertFree(offset + size, rest);
+        }
+
+        mUsedBytes += size;
+
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void RangeAllocator::free(const uint64_t offset)
+{
+    auto it = mRanges.find(offset);
+    if (it == mRanges.end() || it->second.isFree)
+        return;
+
+    mUsedBytes -= it->second.size;
+
+    uint64_t freeOffset = offset;
+    uint64_t freeSize = it->second.size;
+
+    auto next = std::next(it);
+    if (next != mRanges.end() && next->second.isFree)
+    {
+        eraseFree(next->first, next->second.size);
+        freeSize += next->second.size;
+        mRanges.erase(next);
+    }
+
+    if (it != mRanges.begin())
+    {
+        auto previous = std::prev(it);
+        if (previous->second.isFree)
+        {
+            eraseFree(previous->first, previous->second.size);
+            freeOffset = previous->first;
+            freeSize += previous->second.size;
+            mRanges.erase(it);
+            it = previous;
+        }
+    }
+
+    it->second = { freeSize, true };
+    insertFree(freeOffset, freeSize);
+}
+
+uint64_t RangeAllocator::getSize() const
+{
+    return mSize;
+}
+
+uint64_t RangeAllocator::getUsedBytes() const
+{
+    return mUsedBytes;
+}
+
+bool RangeAllocator::isEmpty() const
+{
+    return mUsedBytes == 0;
+}
+
+void RangeAllocator::insertFree(const uint64_t offset, const uint64_t size)
+{
+    mFreeRanges.emplace(size, offset);
+}
+
+void RangeAllocator::eraseFree(const uint64_t offset, const uint64_t size)
+{
+    auto [begin, end] = mFreeRanges.equal_range(size);
+
+    for (auto it = begin; it != end; ++it)
+    {
+        if (it->second == offset)
+        {
+            mFreeRanges.erase(it);
+            return;
+        }
+    }
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,71 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RANGEALLOCATOR_H
+#define RANGEALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace Cascade::Renderer
+{
+
+// Hands out aligned ranges of a fixed size block, e.g. one vkDeviceMemory.
+// Picks the smallest free range that fits and merges neighbouring free
+// ranges again, so images of odd sizes don't waste what a buddy
+// allocator would round away. Not thread-safe.
+class RangeAllocator
+{
+public:
+    explicit RangeAllocator(const uint64_t size);
+
+    // Offset of the range, nullopt if no free range is large enough
+    std::optional<uint64_t> allocate(const uint64_t size, const uint64_t alignment = 1);
+
+    // Takes the offset allocate() returned
+    void free(const uint64_t offset);
+
+    uint64_t getSize() const;
+    uint64_t getUsedBytes() const;
+    bool isEmpty() const;
+
+private:
+    struct Range
+    {
+        uint64_t size;
+        bool isFree;
+    };
+
+    void insertFree(const uint64_t offset, const uint64_t size);
+    void eraseFree(const uint64_t offset, const uint64_t size);
+
+    // Covers the whole block without gaps, by offset
+    std::map<uint64_t, Range> mRanges;
+
+    // Offsets of the free ranges by their size
+    std::multimap<uint64_t, uint64_t> mFreeRanges;
+
+    const uint64_t mSize;
+    uint64_t mUsedBytes = 0;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RANGEALLOCATOR_H
@@ -0,0 +1,148 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rendercache.h"
+
+namespace Cascade::Renderer
+{
+
+RenderCache::RenderCache(const uint64_t budgetInBytes)
+    : mBudget(budgetInBytes)
+{
+}
+
+std::shared_ptr<CsImage> RenderCache::find(const uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mLookup.find(key);
+    if (it == mLookup.end())
+        return nullptr;
+
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+
+    return it->second->image;
+}
+
+bool RenderCache::contains(const uint64_t key) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mLookup.find(key) != mLookup.end();
+}
+
+void RenderCache::insert(
+    const uint64_t key,
+    std::shared_ptr<CsImage> image,
+    const uint64_t sizeInBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mLookup.find(key);
+    if (it != mLookup.end())
+    {
+        removeBytes(*it->second);
+        mEntries.erase(it->second);
+        mLookup.erase(it);
+    }
+
+    mEntries.push_front({ key, std::move(image), sizeInBytes });
+    mLookup[key] = mEntries.begin();
+    addBytes(mEntries.front());
+
+    evict();
+}
+
+void RenderCache::setBudget(const uint64_t budgetInBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mBudget = budgetInBytes;
+
+    evict();
+}
+
+uint64_t RenderCache::getBudget() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mBudget;
+}
+
+uint64_t RenderCache::getUsedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mUsedBytes;
+}
+
+size_t RenderCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mEntries.size();
+}
+
+void RenderCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mEntries.clear();
+    mLookup.clear();
+    mImageEntries.clear();
+    mUsedBytes = 0;
+}
+
+void RenderCache::evict()
+{
+    // The most recent entry is kept even if it is over budget on its own
+    while (mUsedBytes > mBudget && mEntries.size() > 1)
+    {
+        auto& entry = mEntries.back();
+
+        removeBytes(entry);
+        mLookup.erase(entry.key);
+        mEntries.pop_back();
+    }
+}
+
+void RenderCache::addBytes(const Entry& entry)
+{
+    if (!entry.image || ++mImageEntries[entry.image.get()] == 1)
+        mUsedBytes += entry.sizeInBytes;
+}
+
+void RenderCache::removeBytes(const Entry& entry)
+{
+    if (!entry.image)
+    {
+        mUsedBytes -= entry.sizeInBytes;
+        return;
+    }
+
+    auto it = mImageEntries.find(entry.image.get());
+
+    if (--it->second == 0)
+    {
+        mUsedBytes -= entry.sizeInBytes;
+        mImageEntries.erase(it);
+    }
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,92 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Cascade::Renderer
+{
+
+class CsImage;
+
+// Keeps node outputs around, keyed by the content hash of the node.
+// Once the memory budget is exceeded, the least recently used
+// entries are dropped. Images that are still referenced
+// elsewhere stay alive until they are released. An image that is
+// cached under several keys, e.g. the input a Write node passes
+// through, only counts once against the budget.
+class RenderCache
+{
+public:
+    explicit RenderCache(const uint64_t budgetInBytes);
+
+    // Returns nullptr on a miss, marks the entry as recently used on a hit
+    std::shared_ptr<CsImage> find(const uint64_t key);
+
+    bool contains(const uint64_t key) const;
+
+    void insert(
+        const uint64_t key,
+        std::shared_ptr<CsImage> image,
+        const uint64_t sizeInBytes);
+
+    void setBudget(const uint64_t budgetInBytes);
+
+    uint64_t getBudget() const;
+
+    uint64_t getUsedBytes() const;
+
+    size_t size() const;
+
+    void clear();
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        std::shared_ptr<CsImage> image;
+        uint64_t sizeInBytes;
+    };
+
+    void evict();
+
+    void addBytes(const Entry& entry);
+    void removeBytes(const Entry& entry);
+
+    // Most recently used entries at the front
+    std::list<Entry> mEntries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> mLookup;
+    // Number of entries of each image
+    std::unordered_map<const CsImage*, int> mImageEntries;
+
+    uint64_t mBudget;
+    uint64_t mUsedBytes = 0;
+
+    mutable std::mutex mMutex;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERCACHE_H
@@ -24,6 +24,7 @@
 #include <QByteArrayList>
 
 #include "vulkanhppinclude.h"
+#include "imageprecision.h"
 
 #define NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(type, x) reinterpret_cast<uint64_t>(static_cast<type>(x))
 
@@ -41,12 +42,35 @@ inline const QByteArrayList instanceExtensions =
 #endif
 };
 
-inline constexpr vk::Format globalImageFormat(vk::Format::eR32G32B32A32Sfloat);
+inline vk::Format getImageFormat(const ImagePrecision precision = getImagePrecision())
+{
+    return precision == ImagePrecision::Float16 ?
+        vk::Format::eR16G16B16A16Sfloat : vk::Format::eR32G32B32A32Sfloat;
+}
 
 inline const vk::ClearColorValue clearColor(std::array<float, 4>({ 0.05f, 0.05f, 0.05f, 0.0f }));
 
 inline constexpr int uniformDataSize = 16 * sizeof(float);
 
+// How many independent branches of the node graph are rendered at the same time.
+// Every branch gets its own command buffer and compute descriptor set.
+inline constexpr int maxParallelBranches = 4;
+
+// How many submissions of one command buffer can be in flight, so that
+// the CPU records the next node while the GPU still runs the previous ones
+inline constexpr int maxSubmissionsInFlight = 3;
+
+// How many frames of a sequence are in flight at the same time, enough for
+// one to be read, uploaded, computed and written each. Bounds the memory
+// a batch takes up no matter how many files it has.
+inline constexpr int maxFramesInFlight = 4;
+
+// Room for the frames in flight of a UHD RGBA32F sequence to be decoded
+// straight into memory the GPU copies from. Larger ones are staged in a
+// buffer of their own.
+inline constexpr uint64_t stagingBufferSize =
+    static_cast<uint64_t>(maxFramesInFlight) * 3840 * 2160 * 16;
+
 inline const std::unordered_map<int, QString> colorSpaces =
 {
     { 0, "sRGB" },
@@ -0,0 +1,107 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERDEVICE_H
+#define RENDERDEVICE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QMap>
+#include <QSize>
+#include <QString>
+
+#include "imageprecision.h"
+
+namespace Cascade::Renderer
+{
+
+class CsCommandBuffer;
+class CsGpuProfiler;
+class CsImage;
+class CsImageHasher;
+class CsKernelFuser;
+class CsStagingRegion;
+class CsTransientImagePool;
+class TiledImageWriter;
+
+// What graph execution and writing images to disk need from the GPU.
+// Implemented by the viewer's renderer and by the headless one
+// that runs without a window.
+class RenderDevice
+{
+public:
+    virtual ~RenderDevice() = default;
+
+    // Used by the graph executor, one per parallel branch
+    virtual std::unique_ptr<CsCommandBuffer> createComputeCommandBuffer() = 0;
+
+    // Content hashes of node outputs for early cutoff, can be nullptr
+    virtual CsImageHasher* getImageHasher() = 0;
+
+    // Runs chains of pointwise nodes as a single dispatch, can be nullptr
+    virtual CsKernelFuser* getKernelFuser() = 0;
+
+    // Memory shared by the intermediates of tiled renders, can be nullptr
+    virtual CsTransientImagePool* getTransientImagePool() = 0;
+
+    // Times the submissions of each node on the GPU, can be nullptr
+    virtual CsGpuProfiler* getGpuProfiler() = 0;
+
+    // Waits for the GPU to be idle and recreates the pipelines for the
+    // storage image format. Images created before keep their precision,
+    // they can't be processed anymore.
+    virtual void setImagePrecision(const ImagePrecision precision) = 0;
+
+    // Copies the pixels of an image to the CPU as RGBA32F, thread-safe
+    virtual bool readImage(CsImage* const image, std::vector<float>& pixels) = 0;
+
+    // Copies RGBA32F pixels from the CPU into a new image of the current
+    // precision. Only waits for the copy itself, work submitted by others
+    // keeps running. One upload at a time, nullptr if it failed.
+    virtual std::shared_ptr<CsImage> uploadImage(const float* pixels, const QSize& size) = 0;
+
+    // Mapped memory for the pixels of an image of the given size in the
+    // current precision, so that decoders can write them where the GPU
+    // copies from. nullptr if there is no room, use uploadImage() then.
+    virtual std::unique_ptr<CsStagingRegion> acquireStagingRegion(const QSize& size) = 0;
+
+    // Like uploadImage(), but the pixels are already staged.
+    // The region is returned once the copy has finished.
+    virtual std::shared_ptr<CsImage> uploadStagedImage(
+        std::unique_ptr<CsStagingRegion> region,
+        const QSize& size) = 0;
+
+    // Streams an image to disk that arrives in tiles,
+    // converting it from linear to the given color space
+    virtual std::unique_ptr<TiledImageWriter> createTiledImageWriter(
+        const QString& path,
+        const QSize& canvasSize,
+        const QMap<std::string, std::string>& attributes,
+        const int colorSpace) = 0;
+
+    // Limits that decide whether an image has to be rendered in tiles
+    virtual int getMaxImageDimension() const = 0;
+    virtual uint64_t getDeviceMemoryBudget() const = 0;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERDEVICE_H
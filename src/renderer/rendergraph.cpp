@@ -0,0 +1,349 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rendergraph.h"
+
+#include <algorithm>
+#include <queue>
+
+#include "../log.h"
+#include "renderhash.h"
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+void RenderGraph::setProxyScale(const int scale)
+{
+    mProxyScale = std::max(scale, 1);
+
+    for (auto& node : mNodes)
+    {
+        if (mProxyScale != 1)
+            node.settingsHash = hashCombine(node.settingsHash, mProxyScale);
+
+        node.dirty = true;
+    }
+
+    computeHashes();
+}
+
+int RenderGraph::getProxyScale() const
+{
+    return mProxyScale;
+}
+
+int RenderGraph::addNode(
+    const QUuid& id,
+    RenderTask* task,
+    const size_t numInputs,
+    const uint64_t settingsHash,
+    const bool dirty,
+    std::vector<QVariant> settings)
+{
+    RenderGraphNode node;
+    node.id = id;
+    node.task = task;
+    node.settingsHash = settingsHash;
+    node.settings = std::move(settings);
+    node.dirty = dirty;
+    node.inputs = std::vector<int>(numInputs, -1);
+
+    mNodes.push_back(std::move(node));
+
+    const int index = static_cast<int>(mNodes.size()) - 1;
+    mIndices.insert(id, index);
+
+    return index;
+}
+
+void RenderGraph::connect(const int from, const int to, const size_t inputPort)
+{
+    auto& inputs = mNodes.at(to).inputs;
+
+    if (inputPort >= inputs.size())
+        inputs.resize(inputPort + 1, -1);
+
+    // Replaces the edge from whatever was connected to the port before.
+    // A node feeding several ports of the same consumer is listed once per port.
+    if (const int previous = inputs[inputPort]; previous >= 0)
+    {
+        auto& outputs = mNodes[previous].outputs;
+        outputs.erase(std::find(outputs.begin(), outputs.end(), to));
+    }
+
+    inputs[inputPort] = from;
+
+    mNodes.at(from).outputs.push_back(to);
+}
+
+void RenderGraph::computeHashes()
+{
+    for (const auto index : topologicalOrder())
+    {
+        auto& node = mNodes[index];
+
+        uint64_t hash = node.settingsHash;
+
+        // Unconnected ports are part of the hash too,
+        // so that disconnecting an input changes it
+        for (const auto input : node.inputs)
+        {
+            hash = hashCombine(hash, input >= 0 ? mNodes[input].hash : 0);
+        }
+
+        node.hash = hash;
+    }
+}
+
+void RenderGraph::setSettingsHash(const int index, const uint64_t settingsHash)
+{
+    mNodes.at(index).settingsHash = settingsHash;
+
+    std::vector<bool> isVisited(mNodes.size(), false);
+    std::vector<int> stack = { index };
+
+    while (!stack.empty())
+    {
+        const int current = stack.back();
+        stack.pop_back();
+
+        if (isVisited[current])
+            continue;
+        isVisited[current] = true;
+
+        mNodes[current].dirty = true;
+
+        stack.insert(stack.end(), mNodes[current].outputs.begin(), mNodes[current].outputs.end());
+    }
+
+    computeHashes();
+}
+
+const std::vector<RenderGraphNode>& RenderGraph::getNodes() const
+{
+    return mNodes;
+}
+
+const RenderGraphNode& RenderGraph::getNode(const int index) const
+{
+    return mNodes.at(index);
+}
+
+int RenderGraph::indexOf(const QUuid& id) const
+{
+    return mIndices.value(id, -1);
+}
+
+size_t RenderGraph::size() const
+{
+    return mNodes.size();
+}
+
+std::vector<int> RenderGraph::topologicalOrder() const
+{
+    // Kahn's algorithm
+    std::vector<int> inDegree(mNodes.size(), 0);
+
+    for (const auto& node : mNodes)
+    {
+        for (const auto output : node.outputs)
+            ++inDegree[output];
+    }
+
+    std::queue<int> ready;
+
+    for (size_t i = 0; i < mNodes.size(); ++i)
+    {
+        if (inDegree[i] == 0)
+            ready.push(static_cast<int>(i));
+    }
+
+    std::vector<int> order;
+    order.reserve(mNodes.size());
+
+    while (!ready.empty())
+    {
+        const int current = ready.front();
+        ready.pop();
+
+        order.push_back(current);
+
+        for (const auto output : mNodes[current].outputs)
+        {
+            if (--inDegree[output] == 0)
+                ready.push(output);
+        }
+    }
+
+    if (order.size() != mNodes.size())
+    {
+        CS_LOG_WARNING("Render graph contains a cycle.");
+
+        return {};
+    }
+
+    return order;
+}
+
+std::vector<int> RenderGraph::upstreamOf(const int target) const
+{
+    std::vector<bool> needed(mNodes.size(), false);
+
+    std::vector<int> stack = { target };
+
+    while (!stack.empty())
+    {
+        const int current = stack.back();
+        stack.pop_back();
+
+        if (needed[current])
+            continue;
+
+        needed[current] = true;
+
+        for (const auto input : mNodes[current].inputs)
+        {
+            if (input >= 0)
+                stack.push_back(input);
+        }
+    }
+
+    std::vector<int> nodes;
+
+    for (const auto index : topologicalOrder())
+    {
+        if (needed[index])
+            nodes.push_back(index);
+    }
+
+    return nodes;
+}
+
+std::vector<int> RenderGraph::criticalPath(const std::vector<double>& costs) const
+{
+    // Longest path in a DAG, every node extends its costliest input
+    std::vector<double> pathCost(mNodes.size(), 0.0);
+    std::vector<int> previous(mNodes.size(), -1);
+
+    int last = -1;
+
+    for (const auto index : topologicalOrder())
+    {
+        for (const auto input : mNodes[index].inputs)
+        {
+            if (input >= 0 && (previous[index] < 0 || pathCost[input] > pathCost[previous[index]]))
+                previous[index] = input;
+        }
+
+        pathCost[index] = costs[index];
+        if (previous[index] >= 0)
+            pathCost[index] += pathCost[previous[index]];
+
+        if (mNodes[index].outputs.empty() && (last < 0 || pathCost[index] > pathCost[last]))
+            last = index;
+    }
+
+    std::vector<int> path;
+
+    for (int index = last; index >= 0; index = previous[index])
+        path.push_back(index);
+
+    std::reverse(path.begin(), path.end());
+
+    return path;
+}
+
+void RenderGraph::setRegionOfInterest(const int target, const QRect& roi)
+{
+    auto nodes = upstreamOf(target);
+
+    std::vector<bool> assigned(mNodes.size(), false);
+
+    for (auto& node : mNodes)
+        node.roi = QRect();
+
+    mNodes[target].roi = roi;
+    assigned[target] = true;
+
+    // Consumers come before their inputs in reverse order
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+    {
+        const auto& node = mNodes[*it];
+
+        for (size_t port = 0; port < node.inputs.size(); ++port)
+        {
+            const int input = node.inputs[port];
+            if (input < 0)
+                continue;
+
+            // A null roi stands for all of the image, growing it
+            // by a footprint would turn it into a few pixels
+            const QRect inputRoi = node.task && !node.roi.isNull() ?
+                roiScaledDown(
+                    node.task->getInputRoi(
+                        roiScaledUp(node.roi, mProxyScale),
+                        static_cast<int>(port)),
+                    mProxyScale) :
+                node.roi;
+
+            if (assigned[input])
+            {
+                mNodes[input].roi = roiUnited(mNodes[input].roi, inputRoi);
+            }
+            else
+            {
+                mNodes[input].roi = inputRoi;
+                assigned[input] = true;
+            }
+        }
+    }
+}
+
+QSize RenderGraph::outputSizeOf(const int target) const
+{
+    std::vector<QSize> sizes(mNodes.size());
+
+    for (const auto index : upstreamOf(target))
+    {
+        const auto& node = mNodes[index];
+
+        std::vector<QSize> inputSizes;
+
+        for (const auto input : node.inputs)
+            inputSizes.push_back(input >= 0 ? sizes[input] : QSize());
+
+        if (node.task)
+        {
+            sizes[index] = node.task->getOutputSize(inputSizes);
+        }
+        else
+        {
+            for (const auto& inputSize : inputSizes)
+                sizes[index] = sizes[index].expandedTo(inputSize);
+        }
+    }
+
+    if (sizes[target].isEmpty())
+        return sizes[target];
+
+    return roiScaledDown(QRect(QPoint(0, 0), sizes[target]), mProxyScale).size();
+}
+
+} // namespace Cascade::Renderer
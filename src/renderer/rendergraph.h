@@ -0,0 +1,185 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QHash>
+#include <QRect>
+#include <QSize>
+#include <QUuid>
+#include <QVariant>
+
+namespace Cascade::Renderer
+{
+
+class RenderTask;
+
+// A null region of interest stands for the whole image
+inline bool roiCovers(const QRect& available, const QRect& needed)
+{
+    if (available.isNull())
+        return true;
+
+    return !needed.isNull() && available.contains(needed);
+}
+
+inline QRect roiUnited(const QRect& a, const QRect& b)
+{
+    if (a.isNull() || b.isNull())
+        return QRect();
+
+    return a.united(b);
+}
+
+// The same part of the image at 1/scale of the resolution,
+// partly covered pixels at the edges are included
+inline QRect roiScaledDown(const QRect& roi, const int scale)
+{
+    if (roi.isNull() || scale == 1)
+        return roi;
+
+    const auto floorDiv = [scale](const int value)
+    {
+        return value >= 0 ? value / scale : -((-value + scale - 1) / scale);
+    };
+
+    return QRect(
+        QPoint(floorDiv(roi.left()), floorDiv(roi.top())),
+        QPoint(floorDiv(roi.right()), floorDiv(roi.bottom())));
+}
+
+inline QRect roiScaledUp(const QRect& roi, const int scale)
+{
+    if (roi.isNull() || scale == 1)
+        return roi;
+
+    return QRect(roi.topLeft() * scale, roi.size() * scale);
+}
+
+struct RenderGraphNode
+{
+    QUuid id;
+    RenderTask* task = nullptr;
+
+    // Node type and property values
+    uint64_t settingsHash = 0;
+
+    // Copies of the property values taken with the snapshot, in the order
+    // the node declares them. Tasks get these, the properties themselves
+    // belong to the GUI thread and may have changed since.
+    std::vector<QVariant> settings;
+
+    // Settings of this node combined with the hashes of all inputs,
+    // identifies the content of the output
+    uint64_t hash = 0;
+
+    // Settings or inputs changed since the task was last executed
+    bool dirty = true;
+
+    // The part of the output that is needed, null for all of it
+    QRect roi;
+
+    // Index of the upstream node for every input port, -1 if unconnected
+    std::vector<int> inputs;
+
+    // Indices of all nodes that consume this node's output
+    std::vector<int> outputs;
+};
+
+// A flat snapshot of the node graph that the renderer can
+// walk without touching the GUI side objects.
+class RenderGraph
+{
+public:
+    RenderGraph() = default;
+
+    // Renders every node at 1/scale of its resolution for quick previews,
+    // regions of interest are in proxy pixels then. Has to be called once
+    // the graph is complete. The scale becomes part of the settings, so
+    // proxy and full resolution results never pass for each other. All
+    // nodes become dirty, the tasks may still hold results of the other
+    // resolution, the render cache has the ones of this one.
+    void setProxyScale(const int scale);
+
+    int getProxyScale() const;
+
+    int addNode(
+        const QUuid& id,
+        RenderTask* task,
+        const size_t numInputs,
+        const uint64_t settingsHash = 0,
+        const bool dirty = true,
+        std::vector<QVariant> settings = {});
+
+    // Replaces the connection the port already had
+    void connect(const int from, const int to, const size_t inputPort);
+
+    // Has to be called once all nodes and connections were added
+    void computeHashes();
+
+    // Changes what a node depends on after the graph was built, e.g. the
+    // file a Read node is on in a sequence. The node and everything
+    // downstream of it become dirty and the hashes are updated.
+    void setSettingsHash(const int index, const uint64_t settingsHash);
+
+    const std::vector<RenderGraphNode>& getNodes() const;
+
+    const RenderGraphNode& getNode(const int index) const;
+
+    int indexOf(const QUuid& id) const;
+
+    size_t size() const;
+
+    // All nodes in an order where every node comes after its inputs.
+    // Returns an empty vector if the graph contains a cycle.
+    std::vector<int> topologicalOrder() const;
+
+    // The target and everything it depends on, in topological order
+    std::vector<int> upstreamOf(const int target) const;
+
+    // The chain of connected nodes with the highest summed cost, from a
+    // node without inputs down to one without consumers. Costs are
+    // indexed like the nodes. Empty if the graph contains a cycle.
+    std::vector<int> criticalPath(const std::vector<double>& costs) const;
+
+    // Sets the region of the target that is needed and passes it upstream.
+    // Every node grows the region by its kernel footprint, nodes
+    // feeding several consumers get the union of what they need.
+    // Footprints are in full resolution pixels and shrink with a proxy.
+    void setRegionOfInterest(const int target, const QRect& roi);
+
+    // Size of the target's output, asked from the tasks without executing
+    // them. Smaller by the proxy scale if one is set.
+    QSize outputSizeOf(const int target) const;
+
+private:
+    std::vector<RenderGraphNode> mNodes;
+
+    int mProxyScale = 1;
+
+    QHash<QUuid, int> mIndices;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERGRAPH_H
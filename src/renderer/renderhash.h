@@ -0,0 +1,46 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERHASH_H
+#define RENDERHASH_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <QString>
+
+namespace Cascade::Renderer
+{
+
+// 64 bit variant of boost::hash_combine
+inline uint64_t hashCombine(const uint64_t seed, const uint64_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 12) + (seed >> 4));
+}
+
+inline uint64_t hashString(const QString& s)
+{
+    return std::hash<std::u16string>()(
+        std::u16string(reinterpret_cast<const char16_t*>(s.utf16()), s.size()));
+}
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERHASH_H
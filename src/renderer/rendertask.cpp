@@ -19,9 +19,82 @@
 
 #include "rendertask.h"
 
+#include <algorithm>
+
 namespace Cascade::Renderer
 {
 
 RenderTask::RenderTask() {}
 
+std::shared_ptr<CsImage> RenderTask::getResult() const
+{
+    return mResult;
+}
+
+void RenderTask::setResult(std::shared_ptr<CsImage> result)
+{
+    mResult = std::move(result);
+    mHasExecuted = false;
+}
+
+QRect RenderTask::getInputRoi(
+    const QRect& outputRoi,
+    [[maybe_unused]] const int port) const
+{
+    return outputRoi;
+}
+
+QRect RenderTask::getComputedRegion(const RenderContext& context) const
+{
+    return context.roi;
+}
+
+bool RenderTask::isPassThrough() const
+{
+    return false;
+}
+
+QSize RenderTask::getOutputSize(const std::vector<QSize>& inputSizes) const
+{
+    QSize size;
+
+    for (const auto& inputSize : inputSizes)
+        size = size.expandedTo(inputSize);
+
+    return size;
+}
+
+std::optional<PointwiseKernel> RenderTask::getPointwiseKernel(
+    [[maybe_unused]] const std::vector<QVariant>& settings) const
+{
+    return std::nullopt;
+}
+
+bool RenderTask::isUpToDate(
+    const uint64_t settingsHash,
+    const std::vector<uint64_t>& inputHashes) const
+{
+    return settingsHash == mExecutedSettingsHash && hasSameInputs(inputHashes);
+}
+
+bool RenderTask::hasSameInputs(const std::vector<uint64_t>& inputHashes) const
+{
+    if (!mResult || !mHasExecuted)
+        return false;
+
+    if (std::find(inputHashes.begin(), inputHashes.end(), 0) != inputHashes.end())
+        return false;
+
+    return inputHashes == mExecutedInputHashes;
+}
+
+void RenderTask::setExecutedWith(
+    const uint64_t settingsHash,
+    std::vector<uint64_t> inputHashes)
+{
+    mHasExecuted = true;
+    mExecutedSettingsHash = settingsHash;
+    mExecutedInputHashes = std::move(inputHashes);
+}
+
 } // namespace Cascade::Renderer
@@ -20,23 +20,143 @@
 #ifndef RENDERTASK_H
 #define RENDERTASK_H
 
+#include <functional>
+#include <memory>
+#include <optional>
 #include <vector>
 
-#include "../properties/propertydata.h"
-
-using Cascade::Properties::PropertyData;
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVariant>
 
 namespace Cascade::Renderer
 {
 
+class CsCommandBuffer;
+class CsImage;
+class RenderTask;
+struct PointwiseKernel;
+
+// Creates an image of the given size, may return nullptr
+using OutputFactory = std::function<std::shared_ptr<CsImage>(const QSize& size)>;
+
+// Everything a task gets handed by the executor when it runs
+struct RenderContext
+{
+    // The tasks feeding each input port, nullptr if unconnected
+    std::vector<RenderTask*> inputs;
+
+    // Property values of the node from the graph snapshot, see
+    // RenderGraphNode::settings. Tasks must not read the properties.
+    std::vector<QVariant> settings;
+
+    // Owned by the executing thread, nullptr for CPU-only execution
+    CsCommandBuffer* commandBuffer = nullptr;
+
+    // The part of the output that has to be computed, null for all of it
+    QRect roi;
+
+    // Rendering one tile of a canvas too large for the GPU. The output only
+    // has to cover roi, with its first pixel being roi.topLeft().
+    bool isTile = false;
+
+    // Rendering a preview at 1/proxyScale of the full resolution. The roi
+    // is in proxy pixels, kernels have to divide the radius they sample by
+    // the scale. getInputRoi() stays in full resolution pixels.
+    int proxyScale = 1;
+
+    // Creates the image the output is written to, set for intermediates
+    // of tiled renders. Those share memory with outputs that are no longer
+    // needed. Tasks allocate an image of their own if it is not set or
+    // returns nullptr.
+    OutputFactory createOutput;
+
+    // Runs a pointwise kernel on an input image over roi, for tasks whose
+    // kernel could not be fused with its neighbours. Writes into the image
+    // from createOutput. Not set without a kernel fuser, returns nullptr
+    // if the kernel can't be run.
+    std::function<std::shared_ptr<CsImage>(
+        const PointwiseKernel& kernel,
+        const std::shared_ptr<CsImage>& input)> runKernel;
+};
+
+// A per-pixel operation that the executor can fuse with its neighbours
+// into a single shader. The source is a block of GLSL statements that
+// modifies vec4 pixel and reads its settings with parameter(i).
+struct PointwiseKernel
+{
+    // Identifies the source, kernels with the same name have to share it
+    QString name;
+    QString source;
+    std::vector<float> parameters;
+};
+
 class RenderTask
 {
 public:
     RenderTask();
 
-    virtual void initialize(std::vector<PropertyData*> data) = 0;
+    virtual ~RenderTask() = default;
+
+    virtual void execute(RenderContext& context) = 0;
+
+    // The region of an input needed to compute the given region of the
+    // output. Point operations need exactly the same pixels, kernels
+    // like blurs or erodes have to grow it by their footprint.
+    virtual QRect getInputRoi(const QRect& outputRoi, const int port) const;
+
+    // The part of the output that execute() computed for the context, null
+    // for all of it. Becomes the valid region of the result. Tasks that
+    // produce more than the roi asked for report it, so that their result
+    // is not computed again when the roi moves.
+    virtual QRect getComputedRegion(const RenderContext& context) const;
+
+    // Tasks whose result is the image of an input, not one of their own.
+    // The executor leaves its valid region and hash alone and doesn't
+    // cache it again, it already belongs to the input.
+    virtual bool isPassThrough() const;
+
+    // Size of the output given the sizes of the inputs, empty ones are
+    // unconnected. Known before executing, which tiled rendering relies on.
+    virtual QSize getOutputSize(const std::vector<QSize>& inputSizes) const;
+
+    // Only tasks that map every pixel of their first input to the same
+    // output pixel, independent of all other pixels, can provide a kernel.
+    // The settings are the node's, like RenderContext::settings.
+    virtual std::optional<PointwiseKernel> getPointwiseKernel(
+        const std::vector<QVariant>& settings) const;
+
+    // The image this task produced, either by executing
+    // or handed in by the executor from the cache
+    std::shared_ptr<CsImage> getResult() const;
+
+    void setResult(std::shared_ptr<CsImage> result);
+
+    // True if the task has a result that was produced from the same
+    // settings and bit-identical inputs, executing it again is pointless.
+    // Input hashes of 0 are unknown and never match.
+    bool isUpToDate(
+        const uint64_t settingsHash,
+        const std::vector<uint64_t>& inputHashes) const;
+
+    // Like isUpToDate, but the settings may have changed since
+    bool hasSameInputs(const std::vector<uint64_t>& inputHashes) const;
+
+    // Remembers what the current result was produced from,
+    // has to be called after every execution
+    void setExecutedWith(
+        const uint64_t settingsHash,
+        std::vector<uint64_t> inputHashes);
+
+protected:
+    std::shared_ptr<CsImage> mResult;
 
-    virtual void execute() = 0;
+private:
+    // Only valid as long as the result was produced by executing
+    bool mHasExecuted = false;
+    uint64_t mExecutedSettingsHash = 0;
+    std::vector<uint64_t> mExecutedInputHashes;
 };
 
 } // namespace Cascade::Renderer
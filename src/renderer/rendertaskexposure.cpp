@@ -0,0 +1,67 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rendertaskexposure.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer
+{
+
+RenderTaskExposure::RenderTaskExposure() {}
+
+void RenderTaskExposure::execute(RenderContext& context)
+{
+    const auto source = context.inputs.empty() ? nullptr : context.inputs.front();
+    const auto input = source ? source->getResult() : nullptr;
+
+    if (!input)
+    {
+        setResult(nullptr);
+
+        return;
+    }
+
+    // Usually fused with its neighbours and not executed at all,
+    // on its own the kernel is still a single dispatch
+    if (!context.runKernel)
+    {
+        CS_LOG_WARNING("Exposure node can't render without the kernel fuser.");
+        setResult(nullptr);
+
+        return;
+    }
+
+    auto result = context.runKernel(*getPointwiseKernel(context.settings), input);
+    if (!result)
+        CS_LOG_WARNING("Exposure node could not run its kernel.");
+
+    setResult(std::move(result));
+}
+
+std::optional<PointwiseKernel> RenderTaskExposure::getPointwiseKernel(
+    const std::vector<QVariant>& settings) const
+{
+    // The title comes first, the exposure is in hundredths of a stop
+    const float stops = settings.size() > 1 ? settings[1].toInt() / 100.0f : 0.0f;
+
+    return PointwiseKernel{ "exposure", "    pixel.rgb *= exp2(parameter(0));", { stops } };
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,43 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERTASKEXPOSURE_H
+#define RENDERTASKEXPOSURE_H
+
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+// Scales the color by a power of two, leaves alpha alone. A pointwise
+// kernel, the executor fuses it with its pointwise neighbours.
+class RenderTaskExposure : public RenderTask
+{
+public:
+    RenderTaskExposure();
+
+    void execute(RenderContext& context) override;
+
+    std::optional<PointwiseKernel> getPointwiseKernel(
+        const std::vector<QVariant>& settings) const override;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERTASKEXPOSURE_H
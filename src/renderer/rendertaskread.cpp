@@ -1,17 +1,78 @@
 #include "rendertaskread.h"
 
 #include "../log.h"
+#include "csimage.h"
+#include "rendergraph.h"
 
 namespace Cascade::Renderer
 {
 
 RenderTaskRead::RenderTaskRead() {}
 
-void RenderTaskRead::initialize( [[maybe_unused]] std::vector<PropertyData*> data) {}
-
-void RenderTaskRead::execute()
+void RenderTaskRead::execute(RenderContext& context)
 {
     CS_LOG_INFO("Exec");
+
+    const QRect imageRect = roiScaledDown(
+        QRect(QPoint(0, 0), getOutputSize({})),
+        context.proxyScale);
+
+    // A tile only covers its region and the halo the nodes downstream
+    // need, the whole file would not fit on the GPU
+    if (context.isTile)
+    {
+        if (!mRegionLoader)
+            CS_LOG_WARNING("Read node can't render tiles without a file to read them from.");
+
+        const QRect region = context.roi.isNull() ? imageRect : context.roi;
+
+        setResult(mRegionLoader ? mRegionLoader(region, context) : nullptr);
+
+        return;
+    }
+
+    // Proxies are decoded at their resolution, downscaling
+    // the uploaded image would still upload all of it
+    if (mRegionLoader && (!mImage || context.proxyScale != 1))
+    {
+        setResult(mRegionLoader(imageRect, context));
+
+        return;
+    }
+
+    if (context.proxyScale != 1)
+    {
+        CS_LOG_WARNING("Read node can't render a proxy without a file to read it from.");
+        setResult(nullptr);
+
+        return;
+    }
+
+    setResult(mImage);
+}
+
+QRect RenderTaskRead::getComputedRegion(const RenderContext& context) const
+{
+    return context.isTile ? context.roi : QRect();
+}
+
+QSize RenderTaskRead::getOutputSize( [[maybe_unused]] const std::vector<QSize>& inputSizes) const
+{
+    if (!mImage)
+        return mFileSize;
+
+    return QSize(mImage->getWidth(), mImage->getHeight());
+}
+
+void RenderTaskRead::setImage(std::shared_ptr<CsImage> image)
+{
+    mImage = std::move(image);
+}
+
+void RenderTaskRead::setRegionLoader(const QSize& size, RegionLoader loader)
+{
+    mFileSize = size;
+    mRegionLoader = std::move(loader);
 }
 
 } // namespace Cascade::Renderer
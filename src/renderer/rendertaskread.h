@@ -9,11 +9,40 @@ namespace Cascade::Renderer
 class RenderTaskRead : public RenderTask
 {
 public:
+    // Decodes a region of the file and uploads it, with the first pixel
+    // of the image being region.topLeft(). Pixels outside of the file
+    // are transparent black. The region is in pixels of the file scaled
+    // down by context.proxyScale, every pixel is the average of the file
+    // pixels it covers. The image comes from context.createOutput if
+    // that is set. nullptr if reading failed.
+    using RegionLoader = std::function<std::shared_ptr<CsImage>(
+        const QRect& region,
+        const RenderContext& context)>;
+
     RenderTaskRead();
 
-    void initialize(std::vector<PropertyData*> data) override;
+    void execute(RenderContext& context) override;
+
+    // Tiles cover their roi, everything else is the whole file
+    QRect getComputedRegion(const RenderContext& context) const override;
+
+    QSize getOutputSize(const std::vector<QSize>& inputSizes) const override;
+
+    // The decoded file that execute() passes on,
+    // set by whoever reads the files from disk
+    void setImage(std::shared_ptr<CsImage> image);
+
+    // Reads tiles straight from the file, so that files too large for
+    // the GPU are never uploaded in one piece. Also loads the whole file
+    // if no image is set, and proxies, which the image can't provide.
+    // size is the size of the whole file.
+    void setRegionLoader(const QSize& size, RegionLoader loader);
+
+private:
+    std::shared_ptr<CsImage> mImage;
 
-    void execute() override;
+    QSize mFileSize;
+    RegionLoader mRegionLoader;
 };
 
 } // namespace Cascade::Renderer
@@ -0,0 +1,42 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERTASKWRITE_H
+#define RENDERTASKWRITE_H
+
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+// Passes its input on unchanged, writing it to disk
+// is left to whoever renders the node
+class RenderTaskWrite : public RenderTask
+{
+public:
+    RenderTaskWrite();
+
+    void execute(RenderContext& context) override;
+
+    bool isPassThrough() const override;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERTASKWRITE_H
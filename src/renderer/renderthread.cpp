@@ -0,0 +1,106 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "renderthread.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer
+{
+
+RenderThread::RenderThread(Handler handler) :
+    mHandler(std::move(handler))
+{
+    mThread = std::thread(&RenderThread::loop, this);
+
+    CS_LOG_INFO("Started render thread.");
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+void RenderThread::post(RenderRequest request)
+{
+    mMailbox.post(std::move(request));
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mHasPosted = true;
+    }
+    mWakeCondition.notify_one();
+}
+
+void RenderThread::postJob(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mWakeCondition.notify_one();
+}
+
+void RenderThread::stop()
+{
+    if (!mThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mIsStopping = true;
+    }
+    mWakeCondition.notify_one();
+
+    mThread.join();
+
+    mJobs.clear();
+
+    CS_LOG_INFO("Stopped render thread.");
+}
+
+void RenderThread::loop()
+{
+    while (true)
+    {
+        std::deque<Job> jobs;
+        {
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWakeCondition.wait(
+                lock, [this]() { return mHasPosted || !mJobs.empty() || mIsStopping; });
+
+            if (mIsStopping)
+                return;
+
+            mHasPosted = false;
+            jobs.swap(mJobs);
+        }
+
+        // The pending request usually came after the jobs,
+        // like the one that shows a new precision
+        for (auto& job : jobs)
+            job();
+
+        // Everything posted up to here is covered by a single take
+        if (auto request = mMailbox.take())
+            mHandler(*request);
+    }
+}
+
+} // namespace Cascade::Renderer
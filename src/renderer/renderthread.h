@@ -0,0 +1,96 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <QMatrix4x4>
+
+#include "latestvaluemailbox.h"
+#include "rendergraph.h"
+
+namespace Cascade::Renderer
+{
+
+// A snapshot of the node graph taken when the request was made, so the
+// render thread never has to look at the GUI side of the nodes
+struct RenderRequest
+{
+    RenderGraph graph;
+    int target = -1;
+    uint64_t generation = 0;
+
+    // Previews are rendered at 1/proxyScale, see RenderGraph::setProxyScale()
+    int proxyScale = 1;
+
+    // Pan and zoom of the viewer, only what is visible is computed
+    QMatrix4x4 viewMatrix;
+};
+
+// Evaluates render requests on a thread of its own. Requests posted while
+// a render is running replace each other, once it is done only the
+// latest one is handled. Jobs are for everything else that has to wait
+// for the running render, like file renders or device changes.
+class RenderThread
+{
+public:
+    using Handler = std::function<void(RenderRequest& request)>;
+    using Job = std::function<void()>;
+
+    explicit RenderThread(Handler handler);
+
+    ~RenderThread();
+
+    // Only to be called from a single thread, usually the GUI thread
+    void post(RenderRequest request);
+
+    // Runs the job once the current request is done and before the next
+    // one. Jobs are never replaced and run in the order they were posted.
+    void postJob(Job job);
+
+    // Waits for the current request or job to finish, pending ones are
+    // dropped, which destroys whatever their jobs hold on to
+    void stop();
+
+private:
+    void loop();
+
+    Handler mHandler;
+
+    LatestValueMailbox<RenderRequest> mMailbox;
+
+    // Only used to sleep while there is nothing to do
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    bool mHasPosted = false;
+    bool mIsStopping = false;
+    std::deque<Job> mJobs;
+
+    std::thread mThread;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERTHREAD_H
@@ -0,0 +1,605 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sequenceoutput.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imageio.h>
+
+// Prevent tbb emit() from clashing with Qt.
+#ifndef Q_MOC_RUN
+#if defined(emit)
+    #undef emit
+    #include <tbb/parallel_pipeline.h>
+    #define emit
+#else
+    #include <tbb/parallel_pipeline.h>
+#endif // defined(emit)
+#endif // Q_MOC_RUN
+
+#include "../log.h"
+#include "../multithreading.h"
+#include "cscommandbuffer.h"
+#include "csimage.h"
+#include "csstagingbuffer.h"
+#include "fileoutput.h"
+#include "graphexecutor.h"
+#include "renderconfig.h"
+#include "renderdevice.h"
+#include "rendergraph.h"
+#include "renderhash.h"
+#include "rendertaskread.h"
+#include "tiledimagewriter.h"
+#include "tiling.h"
+
+namespace Cascade::Renderer
+{
+
+namespace
+{
+
+// What the stages hand on to each other for one frame,
+// every stage drops what the next ones don't need
+struct Frame
+{
+    int index = 0;
+    bool success = true;
+
+    // Decoded straight into staging memory if there was room,
+    // otherwise into an image buffer that gets copied there
+    std::unique_ptr<CsStagingRegion> staged;
+    OIIO::ImageBuf decoded;
+    QSize decodedSize;
+    std::shared_ptr<CsImage> uploaded;
+    std::shared_ptr<CsImage> result;
+    std::vector<float> pixels;
+    QSize size;
+
+    // Frames too large for the GPU are written in tiles
+    // while computing, like renderToFile() does
+    bool isWritten = false;
+
+    // Too large to be uploaded in one piece, the tiles
+    // are read from the file while computing
+    bool isReadInTiles = false;
+};
+
+using FramePtr = std::shared_ptr<Frame>;
+
+// The device uploads one image at a time, Read tasks of parallel
+// branches load their files while the next frame is uploaded
+std::mutex uploadMutex;
+
+bool decodeFile(const QString& file, OIIO::ImageBuf& image)
+{
+    image = OIIO::ImageBuf(file.toStdString());
+
+    if (!image.read(0, 0, 0, 4, true, OIIO::TypeDesc::FLOAT))
+    {
+        CS_LOG_WARNING("There was a problem reading the image from disk.");
+        CS_LOG_WARNING(QString::fromStdString(image.geterror()));
+        return false;
+    }
+
+    // Add alpha channel if it doesn't exist
+    if (image.nchannels() == 3)
+    {
+        int channelorder[]         = {0, 1, 2, -1};
+        float channelvalues[]      = {0 /*ignore*/, 0 /*ignore*/, 0 /*ignore*/, 1.0};
+        std::string channelnames[] = {"R", "G", "B", "A"};
+
+        image = OIIO::ImageBufAlgo::channels(image, 4, channelorder, channelvalues, channelnames);
+    }
+
+    if (image.nchannels() != 4)
+    {
+        CS_LOG_WARNING("Only RGB and RGBA images can be read.");
+        return false;
+    }
+
+    return true;
+}
+
+// Decodes RGB or RGBA in the current image precision into memory the GPU
+// copies from, which saves a copy of every frame on the CPU. Leaves staged
+// empty if there is no room or the file is larger than maxDimension,
+// nothing has been read from the file then.
+bool decodeFileStaged(
+    const QString& file,
+    RenderDevice& device,
+    const int maxDimension,
+    std::unique_ptr<CsStagingRegion>& staged,
+    QSize& size)
+{
+    auto input = OIIO::ImageInput::open(file.toStdString());
+    if (!input)
+    {
+        CS_LOG_WARNING("There was a problem reading the image from disk.");
+        CS_LOG_WARNING(QString::fromStdString(OIIO::geterror()));
+        return false;
+    }
+
+    const auto& spec = input->spec();
+
+    if (spec.nchannels < 3)
+    {
+        CS_LOG_WARNING("Only RGB and RGBA images can be read.");
+        return false;
+    }
+
+    size = QSize(spec.width, spec.height);
+
+    // Has to be read in tiles
+    if (spec.width > maxDimension || spec.height > maxDimension)
+        return true;
+
+    staged = device.acquireStagingRegion(size);
+    if (!staged)
+        return true;
+
+    const bool isHalf = getImagePrecision() == ImagePrecision::Float16;
+    const OIIO::TypeDesc format = isHalf ? OIIO::TypeDesc::HALF : OIIO::TypeDesc::FLOAT;
+    const int numChannels = std::min(spec.nchannels, 4);
+
+    // Always four values per pixel, the decoder skips alpha if there is none
+    if (!input->read_image(0, 0, 0, numChannels, format, staged->getData(), 4 * format.size()))
+    {
+        CS_LOG_WARNING("There was a problem reading the image from disk.");
+        CS_LOG_WARNING(QString::fromStdString(input->geterror()));
+        return false;
+    }
+
+    if (numChannels == 3)
+    {
+        const size_t numPixels = static_cast<size_t>(size.width()) * size.height();
+
+        if (isHalf)
+            parallelFillAlpha(static_cast<uint16_t*>(staged->getData()), numPixels, floatToHalf(1.0f));
+        else
+            parallelFillAlpha(static_cast<float*>(staged->getData()), numPixels, 1.0f);
+    }
+
+    return true;
+}
+
+// Decodes a region of the file as RGBA32F, pixels outside of it stay
+// transparent black. Backed by OIIO's image cache, so only the scanlines
+// or tiles of the file the region touches are read.
+bool decodeRegion(const OIIO::ImageBuf& file, const QRect& region, std::vector<float>& pixels)
+{
+    pixels.assign(static_cast<size_t>(region.width()) * region.height() * 4, 0.0f);
+
+    const auto& spec = file.spec();
+    const QRect inside = region.intersected(QRect(0, 0, spec.width, spec.height));
+
+    if (inside.isEmpty())
+        return true;
+
+    const int numChannels = std::min(spec.nchannels, 4);
+    const size_t rowLength = static_cast<size_t>(region.width()) * 4;
+
+    float* const first = pixels.data() +
+        (inside.top() - region.top()) * rowLength +
+        (inside.left() - region.left()) * 4;
+
+    const OIIO::ROI roi(
+        spec.x + inside.left(),
+        spec.x + inside.right() + 1,
+        spec.y + inside.top(),
+        spec.y + inside.bottom() + 1,
+        0,
+        1,
+        0,
+        numChannels);
+
+    if (!file.get_pixels(
+            roi, OIIO::TypeDesc::FLOAT, first, 4 * sizeof(float), rowLength * sizeof(float)))
+    {
+        CS_LOG_WARNING("There was a problem reading the image from disk.");
+        CS_LOG_WARNING(QString::fromStdString(file.geterror()));
+        return false;
+    }
+
+    if (numChannels == 3)
+    {
+        for (int y = 0; y < inside.height(); ++y)
+        {
+            for (int x = 0; x < inside.width(); ++x)
+                first[y * rowLength + x * 4 + 3] = 1.0f;
+        }
+    }
+
+    return true;
+}
+
+// Averages blocks of scale x scale pixels of a region decoded by
+// decodeRegion(), the region starts and ends on block boundaries.
+// Only pixels inside of the file count, so edges don't darken.
+void downscaleRegion(
+    const std::vector<float>& pixels,
+    const QRect& region,
+    const QRect& fileRect,
+    const int scale,
+    std::vector<float>& scaled)
+{
+    const int width = region.width() / scale;
+    const int height = region.height() / scale;
+    const size_t rowLength = static_cast<size_t>(region.width()) * 4;
+
+    scaled.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const QRect block = QRect(
+                region.left() + x * scale,
+                region.top() + y * scale,
+                scale,
+                scale).intersected(fileRect);
+
+            if (block.isEmpty())
+                continue;
+
+            float* const sum = scaled.data() + (static_cast<size_t>(y) * width + x) * 4;
+
+            for (int v = block.top(); v <= block.bottom(); ++v)
+            {
+                const float* row = pixels.data() +
+                    (v - region.top()) * rowLength +
+                    (block.left() - region.left()) * 4;
+
+                for (int u = 0; u < block.width() * 4; ++u)
+                    sum[u % 4] += row[u];
+            }
+
+            const float weight = 1.0f / (block.width() * block.height());
+
+            for (int c = 0; c < 4; ++c)
+                sum[c] *= weight;
+        }
+    }
+}
+
+} // namespace
+
+QString framePath(const QString& path, const int frame)
+{
+    const QFileInfo info(path);
+    QString name = info.fileName();
+
+    const auto match = QRegularExpression("#+").match(name);
+
+    if (match.hasMatch())
+    {
+        name.replace(
+            match.capturedStart(),
+            match.capturedLength(),
+            QString::number(frame).rightJustified(match.capturedLength(), '0'));
+    }
+    else
+    {
+        const QString number = QString::number(frame).rightJustified(4, '0');
+        const QString suffix = info.suffix();
+
+        name = suffix.isEmpty() ?
+            name + "." + number :
+            name.left(name.size() - suffix.size()) + number + "." + suffix;
+    }
+
+    return path.left(path.size() - info.fileName().size()) + name;
+}
+
+std::shared_ptr<CsImage> uploadFile(
+    RenderDevice& device,
+    const QString& file)
+{
+    // Decoded without the lock, parallel branches decode at the same time
+    std::unique_ptr<CsStagingRegion> staged;
+    QSize size;
+
+    if (!decodeFileStaged(file, device, device.getMaxImageDimension(), staged, size))
+        return nullptr;
+
+    if (size.width() > device.getMaxImageDimension() ||
+        size.height() > device.getMaxImageDimension())
+    {
+        CS_LOG_WARNING("The image is too large to be uploaded.");
+        return nullptr;
+    }
+
+    if (staged)
+    {
+        std::lock_guard<std::mutex> lock(uploadMutex);
+
+        return device.uploadStagedImage(std::move(staged), size);
+    }
+
+    OIIO::ImageBuf decoded;
+    if (!decodeFile(file, decoded))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(uploadMutex);
+
+    return device.uploadImage(static_cast<const float*>(decoded.localpixels()), size);
+}
+
+RenderTaskRead::RegionLoader createRegionLoader(
+    RenderDevice& device,
+    const QString& file,
+    QSize& size)
+{
+    auto input = OIIO::ImageInput::open(file.toStdString());
+    if (!input)
+    {
+        CS_LOG_WARNING("There was a problem reading the image from disk.");
+        CS_LOG_WARNING(QString::fromStdString(OIIO::geterror()));
+        return nullptr;
+    }
+
+    if (input->spec().nchannels < 3)
+    {
+        CS_LOG_WARNING("Only RGB and RGBA images can be read.");
+        return nullptr;
+    }
+
+    size = QSize(input->spec().width, input->spec().height);
+
+    const QRect fileRect(QPoint(0, 0), size);
+
+    // Shared by all tiles, nothing is decoded before the first one
+    auto source = std::make_shared<OIIO::ImageBuf>(file.toStdString());
+    auto sourceMutex = std::make_shared<std::mutex>();
+
+    return [&device, file, fileRect, source, sourceMutex](
+        const QRect& region,
+        const RenderContext& context) -> std::shared_ptr<CsImage>
+    {
+        const int scale = context.proxyScale;
+
+        // Decoded straight into staging memory
+        if (scale == 1 && region == fileRect && !context.createOutput)
+            return uploadFile(device, file);
+
+        std::vector<float> pixels;
+
+        {
+            std::lock_guard<std::mutex> lock(*sourceMutex);
+
+            if (!decodeRegion(*source, roiScaledUp(region, scale), pixels))
+                return nullptr;
+        }
+
+        // Only the proxy is uploaded and processed
+        if (scale != 1)
+        {
+            std::vector<float> scaled;
+            downscaleRegion(pixels, roiScaledUp(region, scale), fileRect, scale, scaled);
+            pixels = std::move(scaled);
+        }
+
+        auto output = context.createOutput ? context.createOutput(region.size()) : nullptr;
+
+        if (!output || !context.commandBuffer)
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex);
+
+            return device.uploadImage(pixels.data(), region.size());
+        }
+
+        // The pixels are copied into staging memory before this returns
+        if (!context.commandBuffer->recordImageUpload(pixels.data(), output.get()))
+            return nullptr;
+
+        context.commandBuffer->submitImageUpload();
+
+        return output;
+    };
+}
+
+bool renderSequenceToFiles(
+    GraphExecutor& executor,
+    RenderDevice& device,
+    RenderGraph& graph,
+    const int target,
+    const int read,
+    const QStringList& files,
+    const QString& path,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace)
+{
+    auto readTask = dynamic_cast<RenderTaskRead*>(graph.getNode(read).task);
+    if (!readTask)
+        return false;
+
+    // Every frame changes the output of the Read node, this keeps
+    // frames from being mistaken for each other in the cache
+    const uint64_t readSettingsHash = graph.getNode(read).settingsHash;
+
+    const int maxDimension = device.getMaxImageDimension();
+    const uint64_t budget = device.getDeviceMemoryBudget();
+
+    std::atomic<bool> success(true);
+    int nextFrame = 0;
+
+    auto source = [&nextFrame, &files](tbb::flow_control& control) -> FramePtr
+    {
+        if (nextFrame == files.size())
+        {
+            control.stop();
+            return nullptr;
+        }
+
+        auto frame = std::make_shared<Frame>();
+        frame->index = nextFrame++;
+
+        return frame;
+    };
+
+    auto decode = [&files, &device, maxDimension](FramePtr frame)
+    {
+        const QString& file = files.at(frame->index);
+
+        frame->success = decodeFileStaged(
+            file, device, maxDimension, frame->staged, frame->decodedSize);
+
+        frame->isReadInTiles =
+            frame->decodedSize.width() > maxDimension ||
+            frame->decodedSize.height() > maxDimension;
+
+        if (frame->success && !frame->staged && !frame->isReadInTiles)
+            frame->success = decodeFile(file, frame->decoded);
+
+        return frame;
+    };
+
+    auto upload = [&device](FramePtr frame)
+    {
+        std::lock_guard<std::mutex> lock(uploadMutex);
+
+        if (frame->success && frame->staged)
+        {
+            frame->uploaded = device.uploadStagedImage(std::move(frame->staged), frame->decodedSize);
+            frame->success = frame->uploaded != nullptr;
+        }
+        else if (frame->success && !frame->isReadInTiles)
+        {
+            frame->uploaded = device.uploadImage(
+                static_cast<const float*>(frame->decoded.localpixels()),
+                frame->decodedSize);
+            frame->success = frame->uploaded != nullptr;
+        }
+
+        frame->staged = nullptr;
+        frame->decoded.clear();
+
+        return frame;
+    };
+
+    auto compute = [&](FramePtr frame)
+    {
+        if (!frame->success)
+            return frame;
+
+        readTask->setImage(std::move(frame->uploaded));
+        readTask->setRegionLoader(frame->decodedSize, nullptr);
+        graph.setSettingsHash(
+            read,
+            hashCombine(readSettingsHash, hashString(files.at(frame->index))));
+
+        const QSize canvasSize = graph.outputSizeOf(target);
+
+        if (needsTiling(graph, target, canvasSize, maxDimension, budget))
+        {
+            // Tiles are read from the file, not cut out of the uploaded frame
+            QSize size;
+            auto loader = createRegionLoader(device, files.at(frame->index), size);
+
+            readTask->setImage(nullptr);
+            readTask->setRegionLoader(size, std::move(loader));
+
+            frame->success = renderToFile(
+                executor,
+                device,
+                graph,
+                target,
+                framePath(path, frame->index + 1),
+                attributes,
+                colorSpace);
+            frame->isWritten = true;
+
+            return frame;
+        }
+
+        graph.setRegionOfInterest(target, QRect());
+        executor.render(graph, target);
+
+        // Tasks put every execution into a new image, so the result stays
+        // untouched while it is read back and the next frame is computed
+        auto task = graph.getNode(target).task;
+        frame->result = task ? task->getResult() : nullptr;
+        frame->success = frame->result != nullptr;
+
+        return frame;
+    };
+
+    auto readBack = [&device](FramePtr frame)
+    {
+        if (frame->success && !frame->isWritten)
+        {
+            frame->size = QSize(frame->result->getWidth(), frame->result->getHeight());
+            frame->success = device.readImage(frame->result.get(), frame->pixels);
+        }
+
+        frame->result = nullptr;
+
+        return frame;
+    };
+
+    // Color conversion and encoding are CPU bound, several frames at once
+    auto encode = [&](FramePtr frame)
+    {
+        if (frame->success && !frame->isWritten)
+        {
+            const QRect region(QPoint(0, 0), frame->size);
+
+            auto writer = device.createTiledImageWriter(
+                framePath(path, frame->index + 1), frame->size, attributes, colorSpace);
+
+            frame->success = writer->isOpen() &&
+                writer->addTile(region, frame->pixels.data(), region);
+            frame->success = writer->close() && frame->success;
+        }
+
+        if (!frame->success)
+        {
+            CS_LOG_WARNING("Failed to render frame " + QString::number(frame->index + 1) +
+                           " from " + files.at(frame->index));
+            success = false;
+        }
+    };
+
+    // The stages using the GPU see one frame at a time and in order,
+    // decoding and encoding run on as many frames as there are tokens
+    tbb::parallel_pipeline(
+        maxFramesInFlight,
+        tbb::make_filter<void, FramePtr>(tbb::filter_mode::serial_in_order, source) &
+        tbb::make_filter<FramePtr, FramePtr>(tbb::filter_mode::parallel, decode) &
+        tbb::make_filter<FramePtr, FramePtr>(tbb::filter_mode::serial_in_order, upload) &
+        tbb::make_filter<FramePtr, FramePtr>(tbb::filter_mode::serial_in_order, compute) &
+        tbb::make_filter<FramePtr, FramePtr>(tbb::filter_mode::serial_in_order, readBack) &
+        tbb::make_filter<FramePtr, void>(tbb::filter_mode::parallel, encode));
+
+    readTask->setImage(nullptr);
+    readTask->setRegionLoader(QSize(), nullptr);
+
+    return success;
+}
+
+} // namespace Cascade::Renderer
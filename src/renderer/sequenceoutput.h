@@ -0,0 +1,77 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEQUENCEOUTPUT_H
+#define SEQUENCEOUTPUT_H
+
+#include <memory>
+#include <string>
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "rendertaskread.h"
+
+namespace Cascade::Renderer
+{
+
+class CsImage;
+class GraphExecutor;
+class RenderDevice;
+class RenderGraph;
+
+// The path one frame of a sequence is written to. A run of # in the
+// file name is replaced by the zero padded frame number, otherwise the
+// number is put in front of the extension. Frames are numbered from 1.
+QString framePath(const QString& path, const int frame);
+
+// Decodes a single file like the frames of renderSequenceToFiles() and
+// uploads it. nullptr on failure, or if the file is too large for the GPU.
+std::shared_ptr<CsImage> uploadFile(
+    RenderDevice& device,
+    const QString& file);
+
+// Lets a Read task decode regions of the file on demand, which only reads
+// the scanlines or tiles of the file a region touches. Sets size to the
+// size of the file, nullptr if it can't be read. The device has to
+// outlive the loader.
+RenderTaskRead::RegionLoader createRegionLoader(
+    RenderDevice& device,
+    const QString& file,
+    QSize& size);
+
+// Renders the target once for every file of the Read node and writes the
+// frames to disk like renderToFile(). Reading, uploading, computing and
+// writing of consecutive frames overlap, with at most maxFramesInFlight
+// of them in memory. Frames that fail are skipped.
+bool renderSequenceToFiles(
+    GraphExecutor& executor,
+    RenderDevice& device,
+    RenderGraph& graph,
+    const int target,
+    const int read,
+    const QStringList& files,
+    const QString& path,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace);
+
+} // namespace Cascade::Renderer
+
+#endif // SEQUENCEOUTPUT_H
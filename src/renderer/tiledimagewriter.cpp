@@ -0,0 +1,149 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "tiledimagewriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../log.h"
+
+namespace Cascade::Renderer
+{
+
+static constexpr int numChannels = 4;
+
+TiledImageWriter::TiledImageWriter(
+    const QString& path,
+    const QSize& canvasSize,
+    const QMap<std::string, std::string>& attributes,
+    StripTransform transform)
+    : mSpec(canvasSize.width(), canvasSize.height(), numChannels, OIIO::TypeDesc::FLOAT)
+    , mTransform(std::move(transform))
+{
+    for (auto it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        mSpec.attribute(it.key(), it.value());
+    }
+
+    mOutput = OIIO::ImageOutput::create(path.toStdString());
+
+    if (!mOutput || !mOutput->open(path.toStdString(), mSpec))
+    {
+        CS_LOG_WARNING("Could not open " + path + " for writing.");
+        mOutput = nullptr;
+        mSuccess = false;
+    }
+}
+
+bool TiledImageWriter::isOpen() const
+{
+    return mOutput != nullptr;
+}
+
+bool TiledImageWriter::addTile(const QRect& tile, const float* pixels, const QRect& pixelsRegion)
+{
+    if (!isOpen() || !pixels || !pixelsRegion.contains(tile))
+    {
+        mSuccess = false;
+        return false;
+    }
+
+    // A new row of tiles starts
+    if (tile.top() != mStripTop || mStrip.empty())
+    {
+        if (!mStrip.empty())
+            flushStrip();
+
+        mStripTop = tile.top();
+        mStripHeight = tile.height();
+        mStrip.assign(static_cast<size_t>(mSpec.width) * mStripHeight * numChannels, 0.0f);
+    }
+
+    const size_t rowLength = static_cast<size_t>(tile.width()) * numChannels;
+
+    for (int y = 0; y < tile.height(); ++y)
+    {
+        const size_t sourceOffset =
+            (static_cast<size_t>(tile.top() - pixelsRegion.top() + y) * pixelsRegion.width() +
+             (tile.left() - pixelsRegion.left())) * numChannels;
+        const size_t targetOffset =
+            (static_cast<size_t>(y) * mSpec.width + tile.left()) * numChannels;
+
+        std::memcpy(&mStrip[targetOffset], &pixels[sourceOffset], rowLength * sizeof(float));
+    }
+
+    // Last tile of the row
+    if (tile.right() == mSpec.width - 1)
+        return flushStrip();
+
+    return true;
+}
+
+bool TiledImageWriter::flushStrip()
+{
+    if (mStrip.empty())
+        return true;
+
+    if (mTransform)
+    {
+        OIIO::ImageSpec stripSpec(mSpec.width, mStripHeight, numChannels, OIIO::TypeDesc::FLOAT);
+        OIIO::ImageBuf strip(stripSpec, mStrip.data());
+
+        mTransform(strip);
+    }
+
+    if (!mOutput->write_scanlines(
+            mStripTop,
+            mStripTop + mStripHeight,
+            0,
+            OIIO::TypeDesc::FLOAT,
+            mStrip.data()))
+    {
+        CS_LOG_WARNING("Problem writing scanlines: " + QString::fromStdString(mOutput->geterror()));
+        mSuccess = false;
+    }
+
+    mStrip.clear();
+
+    return mSuccess;
+}
+
+bool TiledImageWriter::close()
+{
+    if (!isOpen())
+        return false;
+
+    flushStrip();
+
+    if (!mOutput->close())
+        mSuccess = false;
+
+    mOutput = nullptr;
+
+    return mSuccess;
+}
+
+TiledImageWriter::~TiledImageWriter()
+{
+    if (isOpen())
+        close();
+}
+
+} // namespace Cascade::Renderer
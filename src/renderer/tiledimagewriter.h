@@ -0,0 +1,79 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILEDIMAGEWRITER_H
+#define TILEDIMAGEWRITER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QMap>
+#include <QRect>
+#include <QString>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imageio.h>
+
+namespace Cascade::Renderer
+{
+
+// Streams an image to disk that is rendered tile by tile. Only one row
+// of tiles is kept in memory and written out as soon as it is complete.
+class TiledImageWriter
+{
+public:
+    // Applied to every row of tiles before it is written, e.g. a color transform
+    using StripTransform = std::function<void(OIIO::ImageBuf&)>;
+
+    TiledImageWriter(
+        const QString& path,
+        const QSize& canvasSize,
+        const QMap<std::string, std::string>& attributes,
+        StripTransform transform = nullptr);
+
+    bool isOpen() const;
+
+    // Tiles have to arrive in scanline order. The RGBA32F pixels
+    // cover pixelsRegion of the canvas, which has to contain the tile.
+    bool addTile(const QRect& tile, const float* pixels, const QRect& pixelsRegion);
+
+    // Writes what is left, false if anything went wrong along the way
+    bool close();
+
+    ~TiledImageWriter();
+
+private:
+    bool flushStrip();
+
+    std::unique_ptr<OIIO::ImageOutput> mOutput;
+    OIIO::ImageSpec mSpec;
+    StripTransform mTransform;
+
+    std::vector<float> mStrip;
+    int mStripTop = 0;
+    int mStripHeight = 0;
+
+    bool mSuccess = true;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // TILEDIMAGEWRITER_H
@@ -0,0 +1,138 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "tiling.h"
+
+#include <algorithm>
+
+#include "../log.h"
+#include "imagealiasing.h"
+#include "imageprecision.h"
+
+namespace Cascade::Renderer
+{
+
+// Smaller tiles spend more time on halos than on the tile itself
+static constexpr int minTileSize = 64;
+
+static uint64_t bytesPerTile(const int tileSize, const int halo, const size_t numImages)
+{
+    const uint64_t edge = static_cast<uint64_t>(tileSize) + 2 * static_cast<uint64_t>(halo);
+
+    return edge * edge * getBytesPerPixel() * numImages;
+}
+
+// Tiles are rendered with aliased intermediates, so only the images
+// that are alive at the same time count: the blocks and the target
+static size_t numImagesPerTile(const RenderGraph& graph, const int target)
+{
+    const auto nodes = graph.upstreamOf(target);
+    const std::vector<uint64_t> bytes(graph.size(), 1);
+
+    return planImageAliasing(graph, nodes, bytes, { target }).blockSizes.size() + 1;
+}
+
+int measureHalo(RenderGraph& graph, const int target)
+{
+    // A single pixel at the origin, whatever nodes add around it is their footprint
+    graph.setRegionOfInterest(target, QRect(0, 0, 1, 1));
+
+    int halo = 0;
+
+    for (const auto index : graph.upstreamOf(target))
+    {
+        const QRect& roi = graph.getNode(index).roi;
+
+        if (roi.isNull())
+            continue;
+
+        halo = std::max({ halo, -roi.left(), -roi.top(), roi.right(), roi.bottom() });
+    }
+
+    return halo;
+}
+
+TilePlan planTiles(
+    RenderGraph& graph,
+    const int target,
+    const QSize& canvasSize,
+    const int maxImageDimension,
+    const uint64_t budgetInBytes)
+{
+    TilePlan plan;
+
+    if (canvasSize.isEmpty())
+        return plan;
+
+    plan.halo = measureHalo(graph, target);
+
+    const size_t numImages = numImagesPerTile(graph, target);
+
+    int tileSize = std::min(
+        std::max(canvasSize.width(), canvasSize.height()),
+        maxImageDimension - 2 * plan.halo);
+
+    while (tileSize >= minTileSize &&
+           bytesPerTile(tileSize, plan.halo, numImages) > budgetInBytes)
+    {
+        tileSize /= 2;
+    }
+
+    if (tileSize < minTileSize)
+    {
+        CS_LOG_WARNING("Could not find a tile size that fits the memory budget.");
+        return plan;
+    }
+
+    plan.tileSize = tileSize;
+
+    for (int y = 0; y < canvasSize.height(); y += tileSize)
+    {
+        for (int x = 0; x < canvasSize.width(); x += tileSize)
+        {
+            plan.tiles.push_back(QRect(
+                x,
+                y,
+                std::min(tileSize, canvasSize.width() - x),
+                std::min(tileSize, canvasSize.height() - y)));
+        }
+    }
+
+    return plan;
+}
+
+bool needsTiling(
+    const RenderGraph& graph,
+    const int target,
+    const QSize& canvasSize,
+    const int maxImageDimension,
+    const uint64_t budgetInBytes)
+{
+    if (canvasSize.width() > maxImageDimension || canvasSize.height() > maxImageDimension)
+        return true;
+
+    const uint64_t pixels =
+        static_cast<uint64_t>(canvasSize.width()) * static_cast<uint64_t>(canvasSize.height());
+
+    // Counted like planTiles() does, otherwise a canvas could need tiling
+    // and still fit into a single tile, or the other way round
+    return pixels * getBytesPerPixel() * numImagesPerTile(graph, target) > budgetInBytes;
+}
+
+} // namespace Cascade::Renderer
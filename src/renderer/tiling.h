@@ -0,0 +1,71 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILING_H
+#define TILING_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QRect>
+#include <QSize>
+
+#include "rendergraph.h"
+
+namespace Cascade::Renderer
+{
+
+struct TilePlan
+{
+    // Edge length of a tile without halo
+    int tileSize = 0;
+
+    // Largest footprint any node adds around a tile
+    int halo = 0;
+
+    // Tiles in scanline order, so finished rows can be streamed out
+    std::vector<QRect> tiles;
+};
+
+// The amount of pixels the nodes upstream of the target
+// need around a region, measured through the region of interest
+int measureHalo(RenderGraph& graph, const int target);
+
+// Splits the canvas into tiles that, including their halo, stay below
+// maxImageDimension and together with the intermediate images of a tile
+// fit into the memory budget. Intermediates whose lifetimes don't overlap
+// share memory, see planImageAliasing(). Returns no tiles if that is impossible.
+TilePlan planTiles(
+    RenderGraph& graph,
+    const int target,
+    const QSize& canvasSize,
+    const int maxImageDimension,
+    const uint64_t budgetInBytes);
+
+// True if the canvas can't be rendered in one piece
+bool needsTiling(
+    const RenderGraph& graph,
+    const int target,
+    const QSize& canvasSize,
+    const int maxImageDimension,
+    const uint64_t budgetInBytes);
+
+} // namespace Cascade::Renderer
+
+#endif // TILING_H
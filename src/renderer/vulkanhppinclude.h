@@ -22,6 +22,16 @@
 
 #define VULKAN_HPP_NO_EXCEPTIONS
 
+// All Vulkan functions are resolved at runtime through the dynamic
+// dispatcher, like QVulkanInstance does. This has to hold for every
+// translation unit, including those that never see a Qt Vulkan header.
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+#ifndef VULKAN_HPP_DISPATCH_LOADER_DYNAMIC
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#endif
+
 #include <vulkan/vulkan.hpp>
 
 #endif // VULKANHPPINCLUDE_H
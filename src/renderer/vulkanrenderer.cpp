@@ -31,8 +31,8 @@
 #include "../benchmark.h"
 #include "../log.h"
 #include "../multithreading.h"
-#include "../uientities/fileboxentity.h"
 #include "../vulkanwindow.h"
+#include "pipelinecachefile.h"
 #include "renderutility.h"
 
 namespace Cascade::Renderer
@@ -63,6 +63,10 @@ void VulkanRenderer::initResources()
     mDevice         = mWindow->device();
     mPhysicalDevice = mWindow->physicalDevice();
 
+    mMemoryAllocator = std::make_unique<CsMemoryAllocator>(&mDevice, &mPhysicalDevice);
+    mDeletionQueue = std::make_unique<CsDeletionQueue>(mConcurrentFrameCount);
+    mDescriptorAllocator = std::make_unique<CsDescriptorAllocator>(&mDevice);
+
     // Init all the permanent parts of the renderer
     createVertexBuffer();
     createSampler();
@@ -75,6 +79,7 @@ void VulkanRenderer::initResources()
     createGraphicsPipeline(mGraphicsPipelineAlpha, ":/shaders/texture_alpha_frag.spv");
 
     createComputeDescriptors();
+    createExecutorDescriptorPool();
     createComputePipelineLayout();
 
     // Load all the shaders we need and create their pipelines
@@ -86,10 +91,51 @@ void VulkanRenderer::initResources()
     createComputePipelines();
 
     mComputeCommandBuffer = std::unique_ptr<CsCommandBuffer>(new CsCommandBuffer(
-        &mDevice, &mPhysicalDevice, &mComputePipelineLayout.get(), &mComputeDescriptorSet.get()));
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        &mComputePipelineLayout.get(),
+        &mComputeDescriptorSet.get()));
+
+    // Never binds the descriptor set, copies don't need one
+    mUploadCommandBuffer = std::unique_ptr<CsCommandBuffer>(new CsCommandBuffer(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        &mComputePipelineLayout.get(),
+        &mComputeDescriptorSet.get()));
+
+    mImageTransfer = std::make_unique<CsImageTransfer>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        mComputeCommandBuffer.get(),
+        mUploadCommandBuffer.get());
 
     mSettingsBuffer =
-        std::unique_ptr<CsSettingsBuffer>(new CsSettingsBuffer(&mDevice, &mPhysicalDevice));
+        std::unique_ptr<CsSettingsBuffer>(new CsSettingsBuffer(
+            &mDevice, &mPhysicalDevice, mMemoryAllocator.get()));
+
+    mImageHasher = std::make_unique<CsImageHasher>(
+        &mDevice, mMemoryAllocator.get(), mDescriptorAllocator.get(), &mPipelineCache.get());
+
+    mKernelFuser = std::make_unique<CsKernelFuser>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        mDescriptorAllocator.get(),
+        &mPipelineCache.get());
+
+    mTransientImagePool = std::make_unique<CsTransientImagePool>(
+        &mDevice, &mPhysicalDevice, mMemoryAllocator.get(), mDeletionQueue.get());
+
+    // Disabled until someone looks at the timings
+    mGpuProfiler = std::make_unique<CsGpuProfiler>(
+        &mDevice,
+        &mPhysicalDevice,
+        CsCommandBuffer::findComputeQueueFamily(&mPhysicalDevice));
 
     // Load OCIO config
     try
@@ -115,9 +161,16 @@ QString VulkanRenderer::getGpuName()
 
 void VulkanRenderer::createVertexBuffer()
 {
-    // The current vertexBuffer will be destroyed,
-    // so we have to wait here.
-    auto result = mDevice.waitIdle();
+    // Frames in flight may still draw with the current one
+    if (mVertexBuffer)
+    {
+        mDeletionQueue->retire(std::make_shared<vk::UniqueBuffer>(std::move(mVertexBuffer)));
+        mDeletionQueue->retire(
+            std::make_shared<vk::UniqueDeviceMemory>(std::move(mVertexBufferMemory)));
+    }
+    mGraphicsDescriptorsOutdated.fill(true);
+
+    vk::Result result;
 
     const vk::PhysicalDeviceLimits pdevLimits(mPhysicalDevice.getProperties().limits);
     const vk::DeviceSize uniAlign = pdevLimits.minUniformBufferOffsetAlignment;
@@ -236,9 +289,8 @@ void VulkanRenderer::createGraphicsDescriptors()
 
 void VulkanRenderer::createGraphicsPipelineCache()
 {
-    // Pipeline cache
-    vk::PipelineCacheCreateInfo pipelineCacheInfo;
-    mPipelineCache = mDevice.createPipelineCacheUnique(pipelineCacheInfo).value;
+    // Filled by earlier launches, saved again in shutdown()
+    mPipelineCache = loadPipelineCache(mDevice, mPhysicalDevice);
 }
 
 void VulkanRenderer::createGraphicsPipelineLayout()
@@ -365,16 +417,23 @@ vk::UniqueShaderModule VulkanRenderer::createShaderFromFile(const QString& name)
     QByteArray blob = file.readAll();
     file.close();
 
+    // Compiled for RGBA32F, storage images have to match the precision
+    std::vector<uint32_t> code(blob.size() / sizeof(uint32_t));
+    memcpy(code.data(), blob.constData(), code.size() * sizeof(uint32_t));
+    patchStorageImageFormat(code);
+
     vk::ShaderModuleCreateInfo shaderInfo(
-        {}, blob.size(), reinterpret_cast<const uint32_t*>(blob.constData()));
+        {}, code.size() * sizeof(uint32_t), code.data());
 
     vk::UniqueShaderModule shaderModule = mDevice.createShaderModuleUnique(shaderInfo).value;
 
     return shaderModule;
 }
 
-vk::UniqueShaderModule VulkanRenderer::createShaderFromCode(const std::vector<unsigned int>& code)
+vk::UniqueShaderModule VulkanRenderer::createShaderFromCode(std::vector<unsigned int> code)
 {
+    patchStorageImageFormat(code);
+
     auto codeChar = uintVecToCharVec(code);
 
     QByteArray codeArray =
@@ -403,7 +462,14 @@ void VulkanRenderer::loadShadersFromDisk()
 bool VulkanRenderer::createComputeRenderTarget(uint32_t width, uint32_t height)
 {
     mComputeRenderTarget = std::unique_ptr<CsImage>(new CsImage(
-        mWindow, &mDevice, &mPhysicalDevice, width, height, false, "Compute Render Target"));
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        width,
+        height,
+        false,
+        "Compute Render Target"));
 
     emit mWindow->renderTargetHasBeenCreated(width, height);
 
@@ -436,33 +502,21 @@ bool VulkanRenderer::createImageFromFile(const QString& path, const int colorSpa
 
     updateVertexData(mCpuImage->xend(), mCpuImage->yend());
 
-    vk::FormatProperties props = mPhysicalDevice.getFormatProperties(globalImageFormat);
-    const bool canSampleLinear =
-        (bool)(props.linearTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
-    const bool canSampleOptimal =
-        (bool)(props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
-    if (!canSampleLinear && !canSampleOptimal)
+    vk::FormatProperties props = mPhysicalDevice.getFormatProperties(getImageFormat());
+    if (!(props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
     {
-        CS_LOG_WARNING("Neither linear nor optimal image sampling is supported for image");
+        CS_LOG_WARNING("Optimal image sampling is not supported for image");
         return false;
     }
 
-    // The image that gets the data from the CPU
-    mLoadImageStaging = std::unique_ptr<CsImage>(new CsImage(
-        mWindow,
-        &mDevice,
-        &mPhysicalDevice,
-        mCpuImage->xend(),
-        mCpuImage->yend(),
-        true,
-        "Load Image Staging"));
-
-    if (!writeLinearImage(
-            static_cast<float*>(mCpuImage->localpixels()),
-            QSize(mCpuImage->xend(), mCpuImage->yend()),
-            mLoadImageStaging))
+    // Copied from a staging buffer into an optimally tiled image,
+    // sampling linear images is slow on many GPUs
+    mLoadedImage = uploadImage(
+        static_cast<const float*>(mCpuImage->localpixels()),
+        QSize(mCpuImage->xend(), mCpuImage->yend()));
+    if (!mLoadedImage)
     {
-        CS_LOG_WARNING("Failed to write linear image");
+        CS_LOG_WARNING("Failed to upload image");
         return false;
     }
     return true;
@@ -536,39 +590,123 @@ void VulkanRenderer::createComputeDescriptors()
         std::move(mDevice.allocateDescriptorSetsUnique(descSetAllocInfoCompute).value.front());
 }
 
+void VulkanRenderer::createExecutorDescriptorPool()
+{
+    // Sets handed out to the command buffers of the graph executor.
+    // They are freed individually when a command buffer is destroyed.
+    std::vector<vk::DescriptorPoolSize> descPoolSizes = {
+        {vk::DescriptorType::eUniformBuffer, 1 * uint32_t(maxParallelBranches)},
+        {vk::DescriptorType::eStorageImage, 3 * uint32_t(maxParallelBranches)}};
+
+    vk::DescriptorPoolCreateInfo descPoolInfo(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        maxParallelBranches,
+        static_cast<uint32_t>(descPoolSizes.size()),
+        descPoolSizes.data());
+
+    mExecutorDescriptorPool = mDevice.createDescriptorPoolUnique(descPoolInfo).value;
+}
+
+std::unique_ptr<CsCommandBuffer> VulkanRenderer::createComputeCommandBuffer()
+{
+    vk::DescriptorSetAllocateInfo descSetAllocInfo(
+        *mExecutorDescriptorPool, 1, &(*mComputeDescriptorSetLayout));
+
+    auto descriptorSets = mDevice.allocateDescriptorSetsUnique(descSetAllocInfo);
+    if (descriptorSets.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Could not allocate descriptor set for command buffer.");
+        return nullptr;
+    }
+
+    auto commandBuffer = std::make_unique<CsCommandBuffer>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        &mComputePipelineLayout.get(),
+        std::move(descriptorSets.value.front()));
+
+    commandBuffer->setProfiler(mGpuProfiler.get());
+
+    return commandBuffer;
+}
+
+CsImageHasher* VulkanRenderer::getImageHasher()
+{
+    return mImageHasher.get();
+}
+
+CsKernelFuser* VulkanRenderer::getKernelFuser()
+{
+    return mKernelFuser.get();
+}
+
+CsTransientImagePool* VulkanRenderer::getTransientImagePool()
+{
+    return mTransientImagePool.get();
+}
+
+CsGpuProfiler* VulkanRenderer::getGpuProfiler()
+{
+    return mGpuProfiler.get();
+}
+
+void VulkanRenderer::setImagePrecision(const ImagePrecision precision)
+{
+    if (precision == getImagePrecision())
+        return;
+
+    // The viewer presents on the same queue
+    auto queueLock = CsCommandBuffer::lockQueue();
+    [[maybe_unused]] auto result = mDevice.waitIdle();
+    queueLock.unlock();
+
+    Renderer::setImagePrecision(precision);
+
+    // Their shaders are patched for the storage image format
+    mImageHasher = std::make_unique<CsImageHasher>(
+        &mDevice, mMemoryAllocator.get(), mDescriptorAllocator.get(), &mPipelineCache.get());
+
+    mKernelFuser = std::make_unique<CsKernelFuser>(
+        &mDevice,
+        &mPhysicalDevice,
+        mMemoryAllocator.get(),
+        mDeletionQueue.get(),
+        mDescriptorAllocator.get(),
+        &mPipelineCache.get());
+}
+
 void VulkanRenderer::updateGraphicsDescriptors(
+    const int frame,
     const CsImage* const outputImage,
     const CsImage* const upstreamImage)
 {
-    for (int i = 0; i < mConcurrentFrameCount; ++i)
-    {
-        std::vector<vk::WriteDescriptorSet> descWrite(3);
-        descWrite.at(0).dstSet          = *mGraphicsDescriptorSet.at(i);
-        descWrite.at(0).dstBinding      = 0;
-        descWrite.at(0).descriptorCount = 1;
-        descWrite.at(0).descriptorType  = vk::DescriptorType::eUniformBuffer;
-        descWrite.at(0).pBufferInfo     = &mUniformBufferInfo[i];
-
-        vk::DescriptorImageInfo descImageInfo(
-            *mSampler, *outputImage->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
-
-        descWrite.at(1).dstSet          = *mGraphicsDescriptorSet.at(i);
-        descWrite.at(1).dstBinding      = 1;
-        descWrite.at(1).descriptorCount = 1;
-        descWrite.at(1).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
-        descWrite.at(1).pImageInfo      = &descImageInfo;
-
-        vk::DescriptorImageInfo descImageInfoUpstream(
-            *mSampler, *upstreamImage->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
-
-        descWrite.at(2).dstSet          = *mGraphicsDescriptorSet.at(i);
-        descWrite.at(2).dstBinding      = 2;
-        descWrite.at(2).descriptorCount = 1;
-        descWrite.at(2).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
-        descWrite.at(2).pImageInfo      = &descImageInfoUpstream;
-
-        mDevice.updateDescriptorSets(descWrite, {});
-    }
+    std::vector<vk::WriteDescriptorSet> descWrite(3);
+    descWrite.at(0).dstSet          = *mGraphicsDescriptorSet.at(frame);
+    descWrite.at(0).dstBinding      = 0;
+    descWrite.at(0).descriptorCount = 1;
+    descWrite.at(0).descriptorType  = vk::DescriptorType::eUniformBuffer;
+    descWrite.at(0).pBufferInfo     = &mUniformBufferInfo[frame];
+
+    vk::DescriptorImageInfo descImageInfo(
+        *mSampler, *outputImage->getImageView(), vk::ImageLayout::eGeneral);
+
+    descWrite.at(1).dstSet          = *mGraphicsDescriptorSet.at(frame);
+    descWrite.at(1).dstBinding      = 1;
+    descWrite.at(1).descriptorCount = 1;
+    descWrite.at(1).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+    descWrite.at(1).pImageInfo      = &descImageInfo;
+
+    vk::DescriptorImageInfo descImageInfoUpstream(
+        *mSampler, *upstreamImage->getImageView(), vk::ImageLayout::eGeneral);
+
+    descWrite.at(2).dstSet          = *mGraphicsDescriptorSet.at(frame);
+    descWrite.at(2).dstBinding      = 2;
+    descWrite.at(2).descriptorCount = 1;
+    descWrite.at(2).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+    descWrite.at(2).pImageInfo      = &descImageInfoUpstream;
+
+    mDevice.updateDescriptorSets(descWrite, {});
 }
 
 void VulkanRenderer::updateComputeDescriptors(
@@ -576,8 +714,8 @@ void VulkanRenderer::updateComputeDescriptors(
     const CsImage* const inputImageFront,
     const CsImage* const outputImage)
 {
-    auto result = mDevice.waitIdle();
-    Q_UNUSED(result);
+    // Only the command buffer that binds the set can be using it
+    mComputeCommandBuffer->waitForPreviousSubmission();
 
     vk::DescriptorImageInfo sourceInfoBack(
         *mSampler, *inputImageBack->getImageView(), vk::ImageLayout::eGeneral);
@@ -647,7 +785,9 @@ vk::UniquePipeline VulkanRenderer::createComputePipeline(const vk::ShaderModule&
     vk::PipelineShaderStageCreateInfo computeStage(
         {}, vk::ShaderStageFlagBits::eCompute, shaderModule, "main");
 
-    vk::ComputePipelineCreateInfo pipelineInfo({}, computeStage, *mComputePipelineLayout);
+    // Needed to dispatch over a region of interest
+    vk::ComputePipelineCreateInfo pipelineInfo(
+        vk::PipelineCreateFlagBits::eDispatchBase, computeStage, *mComputePipelineLayout);
 
     vk::UniquePipeline pl =
         mDevice.createComputePipelineUnique(*mPipelineCache, pipelineInfo).value;
@@ -655,53 +795,6 @@ vk::UniquePipeline VulkanRenderer::createComputePipeline(const vk::ShaderModule&
     return pl;
 }
 
-void VulkanRenderer::createQueryPool()
-{
-    vk::QueryPoolCreateInfo queryPoolInfo({}, vk::QueryType::eTimestamp, 2);
-
-    mQueryPool = mDevice.createQueryPoolUnique(queryPoolInfo).value;
-}
-
-bool VulkanRenderer::writeLinearImage(
-    float* imgStart,
-    QSize imgSize,
-    std::unique_ptr<CsImage>& image)
-{
-    vk::ImageSubresource subres(
-        vk::ImageAspectFlagBits::eColor,
-        0, // mip level
-        0);
-
-    vk::SubresourceLayout layout = mDevice.getImageSubresourceLayout(*image->getImage(), subres);
-
-    float* p;
-    vk::Result err = mDevice.mapMemory(
-        *image->getMemory(), layout.offset, layout.size, {}, reinterpret_cast<void**>(&p));
-    if (err != vk::Result::eSuccess)
-    {
-        CS_LOG_WARNING("Failed to map memory for linear image.");
-        return false;
-    }
-
-    int pad = (layout.rowPitch - imgSize.width() * 16) / 4;
-
-    // TODO: Parallelize this
-    float* pixels = imgStart;
-    int lineWidth = imgSize.width() * 16; // 4 channels * 4 bytes
-    int w         = imgSize.width();
-    int h         = imgSize.height();
-    for (int y = 0; y < h; ++y)
-    {
-        memcpy(p, pixels, lineWidth);
-        pixels += w * 4;
-        p += w * 4 + pad;
-    }
-
-    mDevice.unmapMemory(*image->getMemory());
-
-    return true;
-}
-
 void VulkanRenderer::updateVertexData(const int w, const int h)
 {
     vertexData[0]  = -0.002 * w;
@@ -743,16 +836,12 @@ bool VulkanRenderer::saveImageToDisk(
 {
     bool success = true;
 
-    auto mem = mComputeCommandBuffer->recordImageSave(inputImage);
+    auto pInput = static_cast<const float*>(mComputeCommandBuffer->recordImageSave(inputImage));
+    if (!pInput)
+        return false;
 
     mComputeCommandBuffer->submitImageSave();
-
-    auto result = mDevice.waitIdle();
-
-    float* pInput;
-    result = mDevice.mapMemory(*mem, 0, VK_WHOLE_SIZE, {}, reinterpret_cast<void**>(&pInput));
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Failed to map memory.");
+    mComputeCommandBuffer->waitForPreviousSubmission();
 
     int width     = inputImage->getWidth();
     int height    = inputImage->getHeight();
@@ -761,7 +850,10 @@ bool VulkanRenderer::saveImageToDisk(
     float* output  = new float[numValues];
     float* pOutput = &output[0];
 
-    parallelArrayCopy(pInput, pOutput, width, height);
+    if (inputImage->getPrecision() == ImagePrecision::Float16)
+        parallelHalfToFloat(reinterpret_cast<const uint16_t*>(pInput), pOutput, numValues);
+    else
+        parallelArrayCopy(pInput, pOutput, width, height);
 
     OIIO::ImageSpec spec(width, height, 4, OIIO::TypeDesc::FLOAT);
     QMap<std::string, std::string>::const_iterator it;
@@ -782,11 +874,68 @@ bool VulkanRenderer::saveImageToDisk(
 
     delete[] output;
 
-    mDevice.unmapMemory(*mem);
-
     return success;
 }
 
+std::unique_ptr<TiledImageWriter> VulkanRenderer::createTiledImageWriter(
+    const QString& path,
+    const QSize& canvasSize,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace)
+{
+    return std::make_unique<TiledImageWriter>(
+        path,
+        canvasSize,
+        attributes,
+        [this, colorSpace](ImageBuf& strip)
+        {
+            transformColorSpace("linear", colorSpaces.at(colorSpace), strip);
+        });
+}
+
+bool VulkanRenderer::readImage(CsImage* const image, std::vector<float>& pixels)
+{
+    return mImageTransfer->readImage(image, pixels);
+}
+
+std::shared_ptr<CsImage> VulkanRenderer::uploadImage(const float* pixels, const QSize& size)
+{
+    return mImageTransfer->uploadImage(pixels, size);
+}
+
+std::unique_ptr<CsStagingRegion> VulkanRenderer::acquireStagingRegion(const QSize& size)
+{
+    return mImageTransfer->acquireStagingRegion(size);
+}
+
+std::shared_ptr<CsImage> VulkanRenderer::uploadStagedImage(
+    std::unique_ptr<CsStagingRegion> region,
+    const QSize& size)
+{
+    return mImageTransfer->uploadStagedImage(std::move(region), size);
+}
+
+int VulkanRenderer::getMaxImageDimension() const
+{
+    return static_cast<int>(mPhysicalDevice.getProperties().limits.maxImageDimension2D);
+}
+
+uint64_t VulkanRenderer::getDeviceMemoryBudget() const
+{
+    auto memProperties = mPhysicalDevice.getMemoryProperties();
+
+    vk::DeviceSize largestHeap = 0;
+
+    for (uint32_t i = 0; i < memProperties.memoryHeapCount; ++i)
+    {
+        if (memProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+            largestHeap = std::max(largestHeap, memProperties.memoryHeaps[i].size);
+    }
+
+    // Leave room for the viewer, the cache and other applications
+    return largestHeap / 2;
+}
+
 void VulkanRenderer::createRenderPass()
 {
     vk::CommandBuffer cb = mWindow->currentCommandBuffer();
@@ -823,20 +972,7 @@ void VulkanRenderer::createRenderPass()
         CS_LOG_WARNING("Failed to map memory for vertex buffer.");
     }
 
-    QMatrix4x4 m = mProjection;
-
-    QMatrix4x4 rotation;
-    rotation.setToIdentity();
-
-    QMatrix4x4 translation;
-    translation.setToIdentity();
-    translation.translate(mPositionX, mPositionY, mPositionZ);
-
-    QMatrix4x4 scale;
-    scale.setToIdentity();
-    scale.scale(mScaleXY, mScaleXY, mScaleXY);
-
-    m = m * translation * scale;
+    QMatrix4x4 m = getViewMatrix();
 
     memcpy(p, m.constData(), 16 * sizeof(float));
     mDevice.unmapMemory(*mVertexBufferMemory);
@@ -855,6 +991,15 @@ void VulkanRenderer::createRenderPass()
         sizeof(mViewerPushConstants),
         mViewerPushConstants.data());
     cb.bindPipeline(vk::PipelineBindPoint::eGraphics, *pl);
+
+    // The previous frame with this index has finished by now
+    const int frame = mWindow->currentFrame();
+    if (mGraphicsDescriptorsOutdated[frame])
+    {
+        updateGraphicsDescriptors(frame, mDisplayedImage.get(), mDisplayedImage.get());
+        mGraphicsDescriptorsOutdated[frame] = false;
+    }
+
     cb.bindDescriptorSets(
         vk::PipelineBindPoint::eGraphics,
         *mGraphicsPipelineLayout,
@@ -926,7 +1071,7 @@ void VulkanRenderer::processReadNode( [[maybe_unused]] NodeBase* node)
     //        updateComputeDescriptors(mTmpCacheImage.get(), nullptr, mComputeRenderTarget.get());
 
     //        mComputeCommandBuffer->recordImageLoad(
-    //                    mLoadImageStaging.get(),
+    //                    mLoadedImage.get(),
     //                    mTmpCacheImage.get(),
     //                    mComputeRenderTarget.get(),
     //                    &mPipelines[NodeType::eRead].get());
@@ -939,7 +1084,7 @@ void VulkanRenderer::processReadNode( [[maybe_unused]] NodeBase* node)
     //        auto result = mDevice.waitIdle();
     //        Q_UNUSED(result);
 
-    //        mLoadImageStaging = nullptr;
+    //        mLoadedImage = nullptr;
     //    }
     //    else
     //    {
@@ -1119,6 +1264,35 @@ void VulkanRenderer::displayNode( [[maybe_unused]] const NodeBase* node)
     //    }
 }
 
+void VulkanRenderer::displayImage(std::shared_ptr<CsImage> image, const int proxyScale)
+{
+    if (!image)
+    {
+        doClearScreen();
+        return;
+    }
+
+    mClearScreen = false;
+
+    if (!mDisplayedImage ||
+        mDisplayedImage->getWidth() != image->getWidth() ||
+        mDisplayedImage->getHeight() != image->getHeight() ||
+        mDisplayedProxyScale != proxyScale)
+    {
+        updateVertexData(image->getWidth() * proxyScale, image->getHeight() * proxyScale);
+        createVertexBuffer();
+    }
+
+    // The previous image goes to the deletion queue if
+    // nothing else holds it, frames in flight still show it
+    mDisplayedImage = std::move(image);
+    mDisplayedProxyScale = proxyScale;
+
+    mGraphicsDescriptorsOutdated.fill(true);
+
+    mWindow->requestUpdate();
+}
+
 void VulkanRenderer::doClearScreen()
 {
     mClearScreen = true;
@@ -1128,6 +1302,9 @@ void VulkanRenderer::doClearScreen()
 
 void VulkanRenderer::startNextFrame()
 {
+    // Frees what the frame that last used this slot was drawing with
+    mDeletionQueue->advanceFrame();
+
     if (mClearScreen)
     {
         const QSize sz = mWindow->swapChainImageSize();
@@ -1157,6 +1334,10 @@ void VulkanRenderer::startNextFrame()
         createRenderPass();
     }
 
+    // Presenting submits to the graphics queue, which
+    // the render thread may be using for compute
+    auto queueLock = CsCommandBuffer::lockQueue();
+
     mWindow->frameReady();
 }
 
@@ -1165,6 +1346,53 @@ void VulkanRenderer::logicalDeviceLost()
     emit mWindow->deviceLost();
 }
 
+QMatrix4x4 VulkanRenderer::getViewMatrix() const
+{
+    QMatrix4x4 translation;
+    translation.setToIdentity();
+    translation.translate(mPositionX, mPositionY, mPositionZ);
+
+    QMatrix4x4 scale;
+    scale.setToIdentity();
+    scale.scale(mScaleXY, mScaleXY, mScaleXY);
+
+    return mProjection * translation * scale;
+}
+
+QRect VulkanRenderer::getVisibleRegion(const QSize& imageSize, const QMatrix4x4& viewMatrix)
+{
+    const QRect imageRect(QPoint(0, 0), imageSize);
+
+    bool isInvertible = false;
+    const QMatrix4x4 inverse = viewMatrix.inverted(&isInvertible);
+
+    if (!isInvertible || imageSize.isEmpty())
+        return imageRect;
+
+    // Corners of the viewport in the coordinates of the image quad
+    const QPointF a = inverse.map(QPointF(-1.0, -1.0));
+    const QPointF b = inverse.map(QPointF(1.0, 1.0));
+
+    // The quad spans 0.002 * size in each direction, see updateVertexData
+    auto toPixel = [&imageSize](const QPointF& p)
+    {
+        return QPointF(
+            (p.x() / 0.002 + imageSize.width()) / 2.0,
+            (imageSize.height() - p.y() / 0.002) / 2.0);
+    };
+
+    const QRectF visible = QRectF(toPixel(a), toPixel(b)).normalized();
+
+    // Grow by a pixel so filtering at the border has its neighbours
+    const QRect region = visible.toAlignedRect().adjusted(-1, -1, 1, 1).intersected(imageRect);
+
+    // Nothing visible, compute as little as possible
+    if (region.isEmpty())
+        return QRect(0, 0, 1, 1);
+
+    return region;
+}
+
 void VulkanRenderer::translate(float dx, float dy)
 {
     const QSize sz = mWindow->size();
@@ -1173,6 +1401,7 @@ void VulkanRenderer::translate(float dx, float dy)
     mPositionY += 2.0 * -dy / sz.height();
 
     mWindow->requestUpdate();
+    emit mWindow->viewChanged();
 }
 
 void VulkanRenderer::scale(float s)
@@ -1180,6 +1409,7 @@ void VulkanRenderer::scale(float s)
     mScaleXY = s;
     mWindow->requestUpdate();
     emit mWindow->requestZoomTextUpdate(s);
+    emit mWindow->viewChanged();
 }
 
 void VulkanRenderer::releaseSwapChainResources()
@@ -1196,16 +1426,23 @@ void VulkanRenderer::shutdown()
 {
      [[maybe_unused]] auto result = mDevice.waitIdle();
 
-    mLoadImageStaging    = nullptr;
+    mLoadedImage         = nullptr;
     mTmpCacheImage       = nullptr;
     mComputeRenderTarget = nullptr;
+    mDisplayedImage      = nullptr;
     mSettingsBuffer      = nullptr;
+    mTransientImagePool  = nullptr;
+    // Recorded fused dispatches write the profiler's queries
+    mKernelFuser         = nullptr;
+    mGpuProfiler         = nullptr;
+    mImageHasher         = nullptr;
     //    for(auto& pl : mPipelines)
     //        mDevice.destroy(*pl.second);
     mDevice.destroy(*mComputePipelineNoop);
     mDevice.destroy(*mComputePipelineUser);
     mDevice.destroy(*mGraphicsPipelineRGB);
     mDevice.destroy(*mGraphicsPipelineAlpha);
+    savePipelineCache(mDevice, mPhysicalDevice, *mPipelineCache);
     mDevice.destroy(*mPipelineCache);
     mDevice.destroy(*mDescriptorPool);
     //    for(auto& sh : mShaders)
@@ -1215,10 +1452,15 @@ void VulkanRenderer::shutdown()
     mDevice.destroy(*mComputePipelineLayout);
     mDevice.destroy(*mGraphicsDescriptorSetLayout);
     mDevice.destroy(*mComputeDescriptorSetLayout);
+    mImageTransfer = nullptr;
     mComputeCommandBuffer = nullptr;
+    mUploadCommandBuffer = nullptr;
     mDevice.destroy(*mSampler);
     mDevice.free(*mVertexBufferMemory);
     mDevice.destroy(*mVertexBuffer);
+    mDeletionQueue = nullptr;
+    mDescriptorAllocator = nullptr;
+    mMemoryAllocator = nullptr;
 
     result = mDevice.waitIdle();
 }
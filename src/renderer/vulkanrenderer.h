@@ -33,10 +33,21 @@
 #include "renderconfig.h"
 //#include "../nodegraph/nodedefinitions.h"
 //#include "../nodegraph/nodebase.h"
-#include "../windowmanager.h"
+#include "../global.h"
 #include "cscommandbuffer.h"
+#include "csdeletionqueue.h"
+#include "csdescriptorallocator.h"
+#include "csgpuprofiler.h"
 #include "csimage.h"
+#include "csimagehasher.h"
+#include "csimagetransfer.h"
+#include "cskernelfuser.h"
+#include "csmemoryallocator.h"
+#include "cstransientimagepool.h"
 #include "cssettingsbuffer.h"
+#include "csstagingbuffer.h"
+#include "renderdevice.h"
+#include "tiledimagewriter.h"
 
 namespace OCIO = OCIO_NAMESPACE;
 
@@ -47,7 +58,7 @@ class VulkanWindow;
 namespace Cascade::Renderer
 {
 
-class VulkanRenderer : public QVulkanWindowRenderer
+class VulkanRenderer : public QVulkanWindowRenderer, public RenderDevice
 {
 public:
     static VulkanRenderer& getInstance();
@@ -67,7 +78,27 @@ public:
         const QString& path,
         const QMap<std::string, std::string>& attributes,
         const int colorSpace);
+    std::unique_ptr<TiledImageWriter> createTiledImageWriter(
+        const QString& path,
+        const QSize& canvasSize,
+        const QMap<std::string, std::string>& attributes,
+        const int colorSpace) override;
+    bool readImage(CsImage* const image, std::vector<float>& pixels) override;
+
+    std::shared_ptr<CsImage> uploadImage(const float* pixels, const QSize& size) override;
+
+    std::unique_ptr<CsStagingRegion> acquireStagingRegion(const QSize& size) override;
+
+    std::shared_ptr<CsImage> uploadStagedImage(
+        std::unique_ptr<CsStagingRegion> region,
+        const QSize& size) override;
+
+    int getMaxImageDimension() const override;
+    uint64_t getDeviceMemoryBudget() const override;
+
     void displayNode(const NodeBase* node);
+    // A proxy image is stretched to the size of the full resolution one
+    void displayImage(std::shared_ptr<CsImage> image, const int proxyScale = 1);
     void doClearScreen();
     void setDisplayMode(const DisplayMode mode);
 
@@ -77,9 +108,25 @@ public:
 
     QString getGpuName();
 
+    std::unique_ptr<CsCommandBuffer> createComputeCommandBuffer() override;
+
+    CsImageHasher* getImageHasher() override;
+    CsKernelFuser* getKernelFuser() override;
+    CsTransientImagePool* getTransientImagePool() override;
+    CsGpuProfiler* getGpuProfiler() override;
+
+    void setImagePrecision(const ImagePrecision precision) override;
+
     void translate(float dx, float dy);
     void scale(float s);
 
+    // The current pan and zoom
+    QMatrix4x4 getViewMatrix() const;
+
+    // The pixels of an image of the given size that are on screen
+    // with the pan and zoom of the view matrix
+    static QRect getVisibleRegion(const QSize& imageSize, const QMatrix4x4& viewMatrix);
+
     void shutdown();
 
     ~VulkanRenderer();
@@ -109,20 +156,21 @@ private:
 
     // Load image
     bool createImageFromFile(const QString& path, const int colorSpace);
-    bool writeLinearImage(float* imgStart, QSize imgSize, std::unique_ptr<CsImage>& image);
 
     // Compute setup
     void createComputePipelineLayout();
-    void createQueryPool();
 
     // Recurring compute
     vk::UniqueShaderModule createShaderFromFile(const QString& name);
-    vk::UniqueShaderModule createShaderFromCode(const std::vector<unsigned int>& code);
+    vk::UniqueShaderModule createShaderFromCode(std::vector<unsigned int> code);
 
     bool createComputeRenderTarget(uint32_t width, uint32_t height);
 
     void createComputeDescriptors();
+    void createExecutorDescriptorPool();
+    // Only for the set of the given frame, the others may still be in use
     void updateGraphicsDescriptors(
+        const int frame,
         const CsImage* const outputImage,
         const CsImage* const upstreamImage);
     void updateComputeDescriptors(
@@ -145,6 +193,10 @@ private:
     vk::Device mDevice;
     vk::PhysicalDevice mPhysicalDevice;
 
+    std::unique_ptr<CsMemoryAllocator> mMemoryAllocator;
+    std::unique_ptr<CsDeletionQueue> mDeletionQueue;
+    std::unique_ptr<CsDescriptorAllocator> mDescriptorAllocator;
+
     vk::UniqueBuffer mVertexBuffer;
     vk::UniqueDeviceMemory mVertexBufferMemory;
     vk::DescriptorBufferInfo mUniformBufferInfo[QVulkanWindow::MAX_CONCURRENT_FRAME_COUNT];
@@ -152,12 +204,13 @@ private:
     vk::UniqueDescriptorPool mDescriptorPool;
     vk::UniqueDescriptorSetLayout mGraphicsDescriptorSetLayout;
     std::vector<vk::UniqueDescriptorSet> mGraphicsDescriptorSet;
+    // Written when their frame is recorded next
+    std::array<bool, QVulkanWindow::MAX_CONCURRENT_FRAME_COUNT> mGraphicsDescriptorsOutdated{};
 
     vk::UniquePipelineCache mPipelineCache;
     vk::UniquePipelineLayout mGraphicsPipelineLayout;
     vk::UniquePipeline mGraphicsPipelineRGB;
     vk::UniquePipeline mGraphicsPipelineAlpha;
-    vk::UniqueQueryPool mQueryPool;
 
     vk::UniqueSampler mSampler;
 
@@ -187,16 +240,29 @@ private:
     DisplayMode mDisplayMode = DisplayMode::eRgb;
 
     std::unique_ptr<CsCommandBuffer> mComputeCommandBuffer;
+    std::unique_ptr<CsCommandBuffer> mUploadCommandBuffer;
+    std::unique_ptr<CsImageTransfer> mImageTransfer;
 
     vk::UniquePipelineLayout mComputePipelineLayout;
     vk::UniquePipeline mComputePipeline;
     vk::UniqueDescriptorSetLayout mComputeDescriptorSetLayout;
     vk::UniqueDescriptorSet mComputeDescriptorSet;
+    vk::UniqueDescriptorPool mExecutorDescriptorPool;
+
+    std::unique_ptr<CsImageHasher> mImageHasher;
+    std::unique_ptr<CsKernelFuser> mKernelFuser;
+    std::unique_ptr<CsTransientImagePool> mTransientImagePool;
+    std::unique_ptr<CsGpuProfiler> mGpuProfiler;
 
-    std::unique_ptr<CsImage> mLoadImageStaging;
+    std::shared_ptr<CsImage> mLoadedImage;
     std::unique_ptr<CsImage> mTmpCacheImage;
     std::unique_ptr<CsImage> mComputeRenderTarget;
 
+    // Kept alive for as long as it is on screen,
+    // even if the cache drops it in the meantime
+    std::shared_ptr<CsImage> mDisplayedImage;
+    int mDisplayedProxyScale = 1;
+
     //std::map<NodeType, vk::UniqueShaderModule>  mShaders;
     //std::map<NodeType, vk::UniquePipeline>      mPipelines;
 
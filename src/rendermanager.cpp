@@ -19,12 +19,24 @@
 
 #include "rendermanager.h"
 
+#include <algorithm>
+#include <utility>
+
 #include <QFile>
+#include <QTimer>
 
 #include "uientities/uientity.h"
 #include "uientities/fileboxentity.h"
+#include "renderer/csgpuprofiler.h"
+#include "renderer/fileoutput.h"
 #include "renderer/vulkanrenderer.h"
+#include "renderer/renderconfig.h"
+#include "renderer/rendertaskread.h"
+#include "renderer/sequenceoutput.h"
+#include "log.h"
+#include "nodegraph/nodegraphdatamodel.h"
 #include "popupmessages.h"
+#include "preferencesmanager.h"
 
 namespace Cascade {
 
@@ -35,13 +47,226 @@ RenderManager& RenderManager::getInstance()
     return instance;
 }
 
-//void RenderManager::setUp(VulkanRenderer *r, NodeGraph* ng)
-//{
-//    mRenderer = r;
-//    mNodeGraph = ng;
+void RenderManager::setUp(VulkanRenderer* r, NodeGraph::NodeGraphDataModel* model)
+{
+    mRenderer = r;
+    mModel = model;
 
-//    mWindowManager = &WindowManager::getInstance();
-//}
+    mExecutor = std::make_unique<GraphExecutor>(
+        [this]() { return mRenderer->createComputeCommandBuffer(); },
+        maxParallelBranches);
+
+    const uint64_t budget = PreferencesManager::getInstance().getRenderCacheBudget();
+    mCache = std::make_unique<RenderCache>(budget * 1024 * 1024);
+    mExecutor->setCache(mCache.get());
+
+    connectDeviceFeatures();
+
+    mExecutor->setTransientImagePool(mRenderer->getTransientImagePool());
+
+    mRenderThread = std::make_unique<RenderThread>(
+        [this](RenderRequest& request) { processRenderRequest(request); });
+
+    connect(mModel, &NodeGraph::NodeGraphDataModel::renderRequested,
+            this, &RenderManager::handleNodeRenderRequest);
+    connect(mModel, &NodeGraph::NodeGraphDataModel::nodeDeleted,
+            this, &RenderManager::handleNodeDeleted);
+    connect(mModel, &NodeGraph::NodeGraphDataModel::interactionStarted,
+            this, &RenderManager::handleInteractionStarted);
+    connect(mModel, &NodeGraph::NodeGraphDataModel::interactionFinished,
+            this, &RenderManager::handleInteractionFinished);
+
+    mTimingsTimer = new QTimer(this);
+    mTimingsTimer->setInterval(250);
+    connect(mTimingsTimer, &QTimer::timeout,
+            this, &RenderManager::updateTimings);
+
+    //mWindowManager = &WindowManager::getInstance();
+}
+
+void RenderManager::connectDeviceFeatures()
+{
+    GraphExecutor::ContentHasher contentHasher;
+    if (auto hasher = mRenderer->getImageHasher(); hasher && hasher->isValid())
+    {
+        contentHasher = [hasher](CsImage* image, CsCommandBuffer* commandBuffer)
+        {
+            return hasher->hash(image, commandBuffer);
+        };
+    }
+    mExecutor->setContentHasher(std::move(contentHasher));
+
+    GraphExecutor::KernelFuser kernelFuser;
+    if (auto fuser = mRenderer->getKernelFuser())
+    {
+        kernelFuser = [fuser](const std::vector<PointwiseKernel>& kernels,
+                              const std::shared_ptr<CsImage>& input,
+                              CsCommandBuffer* commandBuffer,
+                              const FusedRegion& region,
+                              const bool isParameterUpdate,
+                              const OutputFactory& createOutput)
+        {
+            return fuser->execute(
+                kernels, input, commandBuffer, region, isParameterUpdate, createOutput);
+        };
+    }
+    mExecutor->setKernelFuser(std::move(kernelFuser));
+}
+
+void RenderManager::setImagePrecision(const ImagePrecision precision)
+{
+    if (!mExecutor || precision == getImagePrecision())
+        return;
+
+    mExecutor->startGeneration();
+
+    // Deleted nodes hand their task to the render thread, so
+    // these are still alive when the job gets to them
+    std::vector<RenderTask*> tasks;
+
+    for (const auto& node : mModel->getData()->getNodes())
+    {
+        if (auto task = node.second->nodeDataModel()->getRenderTask())
+            tasks.push_back(task);
+
+        node.second->setIsDirty(true);
+    }
+
+    mRenderThread->postJob(
+        [this, precision, tasks = std::move(tasks)]()
+        {
+            mRenderer->setImagePrecision(precision);
+
+            // Results in the other format can't be bound to the new pipelines
+            mCache->clear();
+
+            for (auto task : tasks)
+                task->setResult(nullptr);
+
+            connectDeviceFeatures();
+        });
+
+    // Handled after the job
+    handleViewChanged();
+}
+
+void RenderManager::setGpuProfiling(const bool enabled)
+{
+    mIsGpuProfilerShown = enabled;
+
+    updateProfiling();
+}
+
+void RenderManager::setCostHeatmap(const bool shown)
+{
+    mIsCostHeatmapShown = shown;
+
+    updateProfiling();
+
+    if (shown)
+        mModel->updateCostHeatmap();
+}
+
+void RenderManager::updateProfiling()
+{
+    const bool isProfiling = mIsGpuProfilerShown || mIsCostHeatmapShown;
+
+    auto profiler = mRenderer->getGpuProfiler();
+
+    if (profiler && profiler->isValid())
+        profiler->setEnabled(isProfiling);
+
+    if (isProfiling)
+    {
+        mTimingsTimer->start();
+        return;
+    }
+
+    mTimingsTimer->stop();
+
+    // Drop what is still pending so it doesn't show up next time
+    if (profiler)
+    {
+        profiler->collect();
+        profiler->takeTimings();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mCpuTimingsMutex);
+        mCpuTimings.clear();
+    }
+
+    for (const auto& node : mModel->getData()->getNodes())
+    {
+        node.second->setGpuTime(-1.0);
+        node.second->setCpuTime(-1.0);
+    }
+
+    emit gpuTimingsChanged({});
+}
+
+void RenderManager::updateTimings()
+{
+    QHash<QUuid, double> cpuTimings;
+    {
+        std::lock_guard<std::mutex> lock(mCpuTimingsMutex);
+        cpuTimings = std::exchange(mCpuTimings, {});
+    }
+
+    QHash<QUuid, double> gpuTimings;
+    if (auto profiler = mRenderer->getGpuProfiler())
+    {
+        profiler->collect();
+        gpuTimings = profiler->takeTimings();
+    }
+
+    if (cpuTimings.isEmpty() && gpuTimings.isEmpty())
+        return;
+
+    const auto& nodes = mModel->getData()->getNodes();
+
+    for (auto it = cpuTimings.constBegin(); it != cpuTimings.constEnd(); ++it)
+    {
+        if (auto node = nodes.find(it.key()); node != nodes.end())
+            node->second->setCpuTime(it.value());
+    }
+
+    for (auto it = gpuTimings.constBegin(); it != gpuTimings.constEnd(); ++it)
+    {
+        if (auto node = nodes.find(it.key()); node != nodes.end())
+            node->second->setGpuTime(it.value());
+    }
+
+    if (mIsCostHeatmapShown)
+        mModel->updateCostHeatmap();
+
+    if (gpuTimings.isEmpty())
+        return;
+
+    QVector<QPair<QString, double>> snapshot;
+
+    for (const auto& node : nodes)
+    {
+        if (node.second->getGpuTime() >= 0.0)
+            snapshot.push_back({ node.second->nodeDataModel()->caption(),
+                                 node.second->getGpuTime() });
+    }
+
+    emit gpuTimingsChanged(snapshot);
+}
+
+void RenderManager::shutdown()
+{
+    if (mTimingsTimer)
+        mTimingsTimer->stop();
+
+    if (mExecutor)
+        mExecutor->startGeneration();
+
+    mRenderThread = nullptr;
+    mExecutor = nullptr;
+    mCache = nullptr;
+}
 
 void RenderManager::updateViewerPushConstants(const QString &s)
 {
@@ -157,6 +382,268 @@ void RenderManager::handleClearScreenRequest()
     mRenderer->doClearScreen();
 }
 
+void RenderManager::handleNodeRenderRequest(NodeGraph::Node* node)
+{
+    if (!mExecutor)
+        return;
+
+    // Renders still running for an older request stop at the next node.
+    // Requests posted before the render thread gets to them replace each
+    // other, so a burst of slider events results in a single render.
+    RenderRequest request;
+    request.generation = mExecutor->startGeneration();
+    request.proxyScale = mIsInteracting ? mProxyScale : 1;
+    request.graph = mModel->createRenderGraph();
+    request.target = request.graph.indexOf(node->id());
+    request.viewMatrix = mRenderer->getViewMatrix();
+
+    if (request.target < 0)
+        return;
+
+    mRequestedProxyScale = request.proxyScale;
+
+    mRenderThread->post(std::move(request));
+}
+
+void RenderManager::handleNodeDeleted(NodeGraph::Node& node)
+{
+    if (!mExecutor)
+        return;
+
+    // Pending requests may point to the task of the node, make them
+    // stale. The running one stops at its next node, the task goes
+    // away on the render thread once it is done.
+    mExecutor->startGeneration();
+
+    std::shared_ptr<RenderTask> task = node.nodeDataModel()->takeRenderTask();
+    if (task)
+        mRenderThread->postJob([task = std::move(task)]() mutable { task = nullptr; });
+}
+
+void RenderManager::processRenderRequest(RenderRequest& request)
+{
+    // Also the case if one of its nodes was deleted in the meantime
+    if (mExecutor->isStale(request.generation))
+        return;
+
+    auto& graph = request.graph;
+    const int target = request.target;
+    auto task = graph.getNode(target).task;
+    const int proxyScale = request.proxyScale;
+
+    updateReadFiles(request);
+
+    // The full resolution size, asked from the tasks. Until they know it,
+    // the last result tells, roughly if it was a proxy.
+    QSize imageSize = graph.outputSizeOf(target);
+    if (imageSize.isEmpty() && task && task->getResult())
+        imageSize = QSize(task->getResult()->getWidth(), task->getResult()->getHeight()) * mRenderedProxyScale;
+
+    // The tasks hold results of the last resolution
+    if (proxyScale != 1 || mRenderedProxyScale != 1)
+        graph.setProxyScale(proxyScale);
+
+    // Set before rendering, a stopped render leaves results of this scale
+    mRenderedProxyScale = proxyScale;
+
+    // A newer request is posted already, which will display its result
+    if (!render(graph, target, imageSize, request))
+        return;
+
+    // The output size changed, so the visible region was wrong
+    const auto resultSize = [&task]()
+    {
+        return QSize(task->getResult()->getWidth(), task->getResult()->getHeight());
+    };
+
+    if (task && task->getResult() && !imageSize.isEmpty() &&
+        roiScaledDown(QRect(QPoint(0, 0), imageSize), proxyScale).size() != resultSize())
+    {
+        imageSize = resultSize() * proxyScale;
+
+        if (!render(graph, target, imageSize, request))
+            return;
+    }
+
+    // Everything the target depends on is up to date now,
+    // unless it was only previewed
+    std::vector<QUuid> cleanNodes;
+    if (proxyScale == 1)
+    {
+        for (const auto index : graph.upstreamOf(target))
+            cleanNodes.push_back(graph.getNode(index).id);
+    }
+
+    // The viewer and the nodes belong to the GUI thread
+    QMetaObject::invokeMethod(
+        this,
+        [this,
+         image = task ? task->getResult() : nullptr,
+         proxyScale,
+         generation = request.generation,
+         cleanNodes = std::move(cleanNodes)]()
+        {
+            if (!mExecutor)
+                return;
+
+            // Nodes changed since, so they are not clean after all
+            if (!mExecutor->isStale(generation))
+            {
+                const auto& nodes = mModel->getData()->getNodes();
+
+                for (const auto& id : cleanNodes)
+                {
+                    if (auto it = nodes.find(id); it != nodes.end())
+                        it->second->setIsDirty(false);
+                }
+            }
+
+            mRenderer->displayImage(image, proxyScale);
+        },
+        Qt::QueuedConnection);
+}
+
+void RenderManager::renderToFile(
+    NodeGraph::Node* node,
+    const QString& path,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace,
+    std::function<void(const bool success)> onFinished)
+{
+    auto graph = mModel->createRenderGraph();
+
+    const int target = graph.indexOf(node->id());
+    if (!mExecutor || target < 0)
+    {
+        if (onFinished)
+            onFinished(false);
+        return;
+    }
+
+    // The viewer render would only delay the file
+    mExecutor->startGeneration();
+
+    mRenderThread->postJob(
+        [this,
+         graph = std::move(graph),
+         target,
+         path,
+         attributes,
+         colorSpace,
+         onFinished = std::move(onFinished)]() mutable
+        {
+            const bool success = Renderer::renderToFile(
+                *mExecutor, *mRenderer, graph, target, path, attributes, colorSpace);
+
+            if (!onFinished)
+                return;
+
+            QMetaObject::invokeMethod(
+                this,
+                [onFinished = std::move(onFinished), success]() { onFinished(success); },
+                Qt::QueuedConnection);
+        });
+}
+
+bool RenderManager::render(
+    RenderGraph& graph,
+    const int target,
+    const QSize& imageSize,
+    const RenderRequest& request)
+{
+    // Only what is on screen gets computed, previews at their scale
+    const QRect roi = imageSize.isEmpty() ?
+        QRect() :
+        VulkanRenderer::getVisibleRegion(imageSize, request.viewMatrix);
+
+    graph.setRegionOfInterest(target, roiScaledDown(roi, request.proxyScale));
+
+    if (mIsCostHeatmapShown)
+    {
+        mExecutor->setNodeTimer(
+            [this, &graph](const int index, const double milliseconds)
+            {
+                std::lock_guard<std::mutex> lock(mCpuTimingsMutex);
+                mCpuTimings[graph.getNode(index).id] += milliseconds;
+            });
+    }
+
+    const bool isFinished = mExecutor->render(graph, target, request.generation);
+
+    // The graph is gone once the request is processed
+    mExecutor->setNodeTimer(nullptr);
+
+    return isFinished;
+}
+
+void RenderManager::handleViewChanged()
+{
+    if (!mExecutor)
+        return;
+
+    for (const auto& node : mModel->getData()->getNodes())
+    {
+        if (node.second->getIsViewed())
+        {
+            // Nodes whose result already covers the new region are skipped
+            handleNodeRenderRequest(node.second.get());
+            return;
+        }
+    }
+}
+
+void RenderManager::setProxyScale(const int scale)
+{
+    mProxyScale = std::max(scale, 1);
+}
+
+void RenderManager::handleInteractionStarted()
+{
+    mIsInteracting = true;
+}
+
+void RenderManager::handleInteractionFinished()
+{
+    mIsInteracting = false;
+
+    // Replaces a preview that is still pending, or stops
+    // the one that is running at its next node
+    if (mRequestedProxyScale != 1)
+        handleViewChanged();
+}
+
+void RenderManager::updateReadFiles(const RenderRequest& request)
+{
+    for (const auto& node : request.graph.getNodes())
+    {
+        auto readTask = dynamic_cast<RenderTaskRead*>(node.task);
+        if (!readTask || node.settings.size() < 2)
+            continue;
+
+        // The viewer shows the first file of a sequence
+        const QStringList files = node.settings[1].toStringList();
+        const QString file = files.isEmpty() ? QString() : files.front();
+
+        if (auto loaded = mReadFiles.find(node.id); loaded != mReadFiles.end() && *loaded == file)
+            continue;
+
+        mReadFiles.insert(node.id, file);
+
+        // Regions are decoded when the node executes, at the
+        // resolution of the render, proxies included
+        QSize size;
+        auto loader = file.isEmpty() ?
+            nullptr :
+            createRegionLoader(*mRenderer, file, size);
+
+        if (!file.isEmpty() && !loader)
+            CS_LOG_WARNING("Failed to read " + file);
+
+        readTask->setImage(nullptr);
+        readTask->setRegionLoader(size, std::move(loader));
+    }
+}
+
 //void RenderManager::displayNode(NodeBase* node)
 //{
 //    if (node && node->canBeRendered())
@@ -20,16 +20,34 @@
 #ifndef RENDERMANAGER_H
 #define RENDERMANAGER_H
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <QHash>
 #include <QObject>
+#include <QPair>
+#include <QTimer>
+#include <QVector>
 
 //#include "nodegraph/nodebase.h"
 //#include "nodegraph/nodedefinitions.h"
+#include "renderer/graphexecutor.h"
+#include "renderer/rendercache.h"
+#include "renderer/renderthread.h"
 
 namespace Cascade::Renderer
 {
     class VulkanRenderer;
 }
 
+namespace Cascade::NodeGraph
+{
+    class Node;
+    class NodeGraphDataModel;
+}
+
 namespace Cascade {
 
 using namespace Renderer;
@@ -45,23 +63,97 @@ public:
     RenderManager(RenderManager const&) = delete;
     void operator=(RenderManager const&) = delete;
 
-    //void setUp(VulkanRenderer* r, NodeGraph* ng);
+    void setUp(VulkanRenderer* r, NodeGraph::NodeGraphDataModel* model);
 
     void updateViewerPushConstants(const QString& s);
 
+    // Renders the node at full resolution and writes it to disk on the
+    // render thread. Images too large for the GPU are rendered in tiles
+    // and streamed out. onFinished is called on the GUI thread.
+    void renderToFile(
+        NodeGraph::Node* node,
+        const QString& path,
+        const QMap<std::string, std::string>& attributes,
+        const int colorSpace,
+        std::function<void(const bool success)> onFinished = nullptr);
+
+    // Drops all results and renders the viewed node again with
+    // images and shaders of the given precision. Switches once
+    // the render thread is done with the running render.
+    void setImagePrecision(const ImagePrecision precision);
+
+    // Releases the GPU resources held by the executor,
+    // has to happen before the renderer shuts down
+    void shutdown();
+
 private:
     RenderManager() {}
+
+    // Hands the content hasher and kernel fuser of the renderer to the
+    // executor, they are recreated when the precision changes
+    void connectDeviceFeatures();
+
+    // Called on the render thread, hands the result to the GUI thread
+    void processRenderRequest(RenderRequest& request);
+
+    // Called on the render thread, lets the Read nodes of the request
+    // read the files in their settings
+    void updateReadFiles(const RenderRequest& request);
+
+    // Starts polling the timings while the profiler panel
+    // or the heatmap is shown, and clears them otherwise
+    void updateProfiling();
+
+    // Hands the CPU and GPU times measured since the last call to the nodes
+    void updateTimings();
+
+    // Returns false if a newer request stopped the render
+    bool render(
+        RenderGraph& graph,
+        const int target,
+        const QSize& imageSize,
+        const RenderRequest& request);
 //    void displayNode(NodeBase* node);
 //    bool renderNodes(NodeBase* node);
 //    void renderNode(NodeBase* node);
 
     VulkanRenderer* mRenderer;
-    //NodeGraph* mNodeGraph;
+    NodeGraph::NodeGraphDataModel* mModel;
+
+    std::unique_ptr<GraphExecutor> mExecutor;
+    std::unique_ptr<RenderCache> mCache;
+
+    // Graph evaluation happens here, never on the GUI thread. So does
+    // everything that changes what a running render could be using.
+    std::unique_ptr<RenderThread> mRenderThread;
+
+    // Previews are rendered at 1/mProxyScale while a property is dragged
+    int mProxyScale = 4;
+    bool mIsInteracting = false;
+    int mRequestedProxyScale = 1;
+
+    // Only touched by the render thread
+    int mRenderedProxyScale = 1;
+    QHash<QUuid, QString> mReadFiles;
+
+    // Polls the GPU profiler while profiling is enabled
+    QTimer* mTimingsTimer = nullptr;
+
+    bool mIsGpuProfilerShown = false;
+
+    // Read by the render thread to decide if nodes are timed
+    std::atomic<bool> mIsCostHeatmapShown{false};
+
+    // Filled on the render thread, taken by updateTimings()
+    QHash<QUuid, double> mCpuTimings;
+    std::mutex mCpuTimingsMutex;
 
     //WindowManager* mWindowManager;
 
 signals:
     //void nodeHasBeenRendered(Cascade::NodeBase* node);
+    // Caption and milliseconds of every node with a measured GPU time
+    void gpuTimingsChanged(const QVector<QPair<QString, double>>& timings);
 
 public slots:
 //    void handleNodeDisplayRequest(Cascade::NodeBase* node);
@@ -72,6 +164,23 @@ public slots:
 //            const bool isBatch,
 //            const bool isLast);
     void handleClearScreenRequest();
+    void handleNodeRenderRequest(Cascade::NodeGraph::Node* node);
+    void handleNodeDeleted(Cascade::NodeGraph::Node& node);
+    // Renders what became visible after panning or zooming
+    void handleViewChanged();
+
+    // Applies to the next drag, 4 or 8 are sensible
+    void setProxyScale(const int scale);
+    void handleInteractionStarted();
+    // Replaces the last preview with a full resolution render
+    void handleInteractionFinished();
+
+    // Times the commands of every node on the GPU, costs a few
+    // timestamp queries per submission so it is off by default
+    void setGpuProfiling(const bool enabled);
+
+    // Times the nodes on the CPU and GPU and rates them by their cost
+    void setCostHeatmap(const bool shown);
 };
 
 } // namespace Cascade
@@ -0,0 +1,48 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "resourcefiles.h"
+
+#include <QDir>
+#include <QFile>
+
+namespace Cascade {
+
+void copyOcioConfigToDisk()
+{
+    if (!QDir("ocio").exists())
+    {
+        QDir().mkdir("ocio");
+        QDir().mkdir("ocio/luts");
+
+        QFile::copy(":/ocio/config.ocio", "ocio/config.ocio");
+        QFile::copy(":/ocio/luts/alexalogc.spi1d", "ocio/luts/alexalogc.spi1d");
+        QFile::copy(":/ocio/luts/cineon.spi1d", "ocio/luts/cineon.spi1d");
+        QFile::copy(":/ocio/luts/panalog.spi1d", "ocio/luts/panalog.spi1d");
+        QFile::copy(":/ocio/luts/ploglin.spi1d", "ocio/luts/ploglin.spi1d");
+        QFile::copy(":/ocio/luts/rec709.spi1d", "ocio/luts/rec709.spi1d");
+        QFile::copy(":/ocio/luts/redlog.spi1d", "ocio/luts/redlog.spi1d");
+        QFile::copy(":/ocio/luts/slog.spi1d", "ocio/luts/slog.spi1d");
+        QFile::copy(":/ocio/luts/srgb.spi1d", "ocio/luts/srgb.spi1d");
+        QFile::copy(":/ocio/luts/srgbf.spi1d", "ocio/luts/srgbf.spi1d");
+        QFile::copy(":/ocio/luts/viperlog.spi1d", "ocio/luts/viperlog.spi1d");
+    }
+}
+
+} // namespace Cascade
@@ -0,0 +1,32 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RESOURCEFILES_H
+#define RESOURCEFILES_H
+
+namespace Cascade {
+
+// Copies the OCIO config from the resources to disk.
+// We do this so that they end up in the right place when
+// running from an AppImage.
+void copyOcioConfigToDisk();
+
+} // namespace Cascade
+
+#endif // RESOURCEFILES_H
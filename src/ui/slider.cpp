@@ -132,6 +132,7 @@ bool Slider::eventFilter(QObject *watched, QEvent *event)
         if(mouseEvent->button() == Qt::LeftButton)
         {
             mIsDragging = true;
+            emit dragStarted();
             // factor for scaling pixels into value of slider
             double factorPixelsToValue = mSlider->maximum() / static_cast<double>(this->size().width());
             mSlider->setValue( static_cast<int>(mouseEvent->x() *factorPixelsToValue));
@@ -146,9 +147,10 @@ bool Slider::eventFilter(QObject *watched, QEvent *event)
     {
         QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
 
-        if(mouseEvent->button() == Qt::LeftButton)
+        if(mouseEvent->button() == Qt::LeftButton && mIsDragging)
         {
             mIsDragging = false;
+            emit dragFinished();
         }
     }
 
@@ -65,6 +65,10 @@ private:
 signals:
     void valueChanged();
 
+    // The value is being dragged with the mouse
+    void dragStarted();
+    void dragFinished();
+
 private slots:
     void handleSliderValueChanged();
     void handleSpinBoxValueChanged();
@@ -63,6 +63,16 @@ ViewerStatusBar::ViewerStatusBar(QWidget *parent) :
     mGainSlider->setMinMaxStepValue(0.0, 5.0, 0.01, 1.0);
     ui->horizontalLayout->insertWidget(16, mGainSlider);
 
+    // Right after the view mode
+    auto proxyLabel = new QLabel(" Proxy:", this);
+    ui->horizontalLayout->insertWidget(9, proxyLabel);
+
+    mProxyBox = new QComboBox(this);
+    mProxyBox->addItem("1/4", 4);
+    mProxyBox->addItem("1/8", 8);
+    mProxyBox->setToolTip("Resolution while dragging a property");
+    ui->horizontalLayout->insertWidget(10, mProxyBox);
+
     connect(ui->zoomResetButton, &QPushButton::clicked,
             this, &ViewerStatusBar::requestZoomReset);
     connect(ui->splitCheckBox, &QCheckBox::toggled,
@@ -77,6 +87,12 @@ ViewerStatusBar::ViewerStatusBar(QWidget *parent) :
             this, &ViewerStatusBar::handleSplitSliderChanged);
     connect(ui->viewerModeBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &ViewerStatusBar::handleViewerModeCheckBoxChanged);
+    connect(mProxyBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, [this]()
+            {
+                mProxyBox->clearFocus();
+                emit proxyScaleChanged(getProxyScale());
+            });
 }
 
 void ViewerStatusBar::setZoomText(const QString &s)
@@ -165,6 +181,11 @@ QString ViewerStatusBar::getViewerSettings()
     return s;
 }
 
+int ViewerStatusBar::getProxyScale() const
+{
+    return mProxyBox->currentData().toInt();
+}
+
 ViewerStatusBar::~ViewerStatusBar()
 {
     delete ui;
@@ -20,6 +20,7 @@
 #ifndef VIEWERSTATUSBAR_H
 #define VIEWERSTATUSBAR_H
 
+#include <QComboBox>
 #include <QWidget>
 
 #include "ui/slider.h"
@@ -47,6 +48,9 @@ public:
 
     QString getViewerSettings();
 
+    // Resolution divisor for previews while a property is dragged
+    int getProxyScale() const;
+
     ~ViewerStatusBar();
 
 private:
@@ -60,10 +64,13 @@ private:
     Slider* mGammaSlider;
     Slider* mGainSlider;
 
+    QComboBox* mProxyBox;
+
 signals:
     void requestZoomReset();
     void valueChanged();
     void viewerModeChanged(const Cascade::ViewerMode mode);
+    void proxyScaleChanged(const int scale);
 
 public slots:
     void handleSplitToggled();
@@ -22,6 +22,7 @@
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QLoggingCategory>
+#include <QVersionNumber>
 
 #include "viewerstatusbar.h"
 #include "renderer/vulkanrenderer.h"
@@ -41,6 +42,8 @@ VulkanView::VulkanView(ViewerStatusBar* statusBar, QWidget *parent)
     // Set up validation layers
     mInstance.setLayers(Renderer::instanceLayers);
     mInstance.setExtensions(Renderer::instanceExtensions);
+    // Vulkan 1.1 for vkCmdDispatchBase
+    mInstance.setApiVersion(QVersionNumber(1, 1));
 
     // Set up Dynamic Dispatch Loader to use with vulkan.hpp
     vk::DynamicLoader dl;
@@ -67,6 +67,8 @@ signals:
     void deviceLost();
     void rendererHasBeenCreated();
     void requestZoomTextUpdate(float f);
+    // Pan or zoom of the viewer changed
+    void viewChanged();
     void renderTargetHasBeenCreated(int w, int h);
 
 public slots:
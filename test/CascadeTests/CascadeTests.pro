@@ -28,27 +28,62 @@ VERSION = $${VERSION_MAJOR}.$${VERSION_MINOR}.$${VERSION_BUILD}
 HEADERS += \
         testheader.h \
     tst_filespropertymodel.h \
+        tst_barrierplanner.h \
+        tst_graphexecutor.h \
+        tst_imagealiasing.h \
+        tst_imageprecision.h \
+        tst_kernelfusion.h \
+        tst_latestvaluemailbox.h \
         tst_node.h \
         tst_nodegraphdatamodel.h \
         tst_nodegraphview.h \
+        tst_pipelinecacheheader.h \
+        tst_projectgraph.h \
+        tst_rangeallocator.h \
+        tst_rendercache.h \
+        tst_rendergraph.h \
         tst_slider.h \
-        ../../src/log.h \
+        tst_tiling.h \
         ../../src/ui/slider.h \
-        ../../src/renderer/rendertask.h \
-        ../../src/renderer/rendertaskread.h \
         $$files(../../src/nodegraph/*.h,          true) \
         $$files(../../src/nodegraph/nodes/*.h,    true) \
         $$files(../../src/properties/*.h,         true) \
 
 SOURCES += \
         main.cpp \
-        ../../src/log.cpp \
         ../../src/ui/slider.cpp \
-        ../../src/renderer/rendertask.cpp \
-        ../../src/renderer/rendertaskread.cpp \
         $$files(../../src/nodegraph/*.cpp,        true) \
         $$files(../../src/properties/*.cpp,       true) \
 
+# The renderer, the project graph and the property models are in
+# libcascade-core, only the GUI classes under test are compiled here
+SOURCES -= ../../src/nodegraph/projectgraph.cpp
+HEADERS -= \
+        ../../src/properties/filespropertymodel.h \
+        ../../src/properties/intpropertymodel.h \
+        ../../src/properties/propertymodel.h \
+        ../../src/properties/textpropertymodel.h \
+        ../../src/properties/titlepropertymodel.h
+
+include(../../cascade-core-link.pri)
+
+# The graph executor and the GPU classes it records into
+linux-g++ {
+
+    OS = $$system(uname -a)
+    isArch = $$find(OS,arch)
+    isUbuntu1804LTS = $$find(OS, 18.04.1-Ubuntu)
+
+    !isEmpty( isUbuntu1804LTS ){
+        INCLUDEPATH += $$(VULKAN_SDK)/include
+    }
+    isEmpty(isArch){
+        INCLUDEPATH += $$PWD/../../external/OpenColorIO/install/include
+    }
+
+    LIBS += -L/usr/lib/x86_64-linux-gnu -ldl -ltbb
+}
+
 RESOURCES += \
     resources.qrc
 
@@ -1,13 +1,29 @@
 #include "tst_filespropertymodel.h".h "
+#include "tst_barrierplanner.h"
+#include "tst_graphexecutor.h"
+#include "tst_imagealiasing.h"
+#include "tst_imageprecision.h"
+#include "tst_kernelfusion.h"
+#include "tst_latestvaluemailbox.h"
 #include "tst_node.h"
 #include "tst_nodegraphdatamodel.h"
 #include "tst_nodegraphview.h"
+#include "tst_pipelinecacheheader.h"
+#include "tst_projectgraph.h"
+#include "tst_rangeallocator.h"
+#include "tst_rendercache.h"
+#include "tst_rendergraph.h"
 #include "tst_slider.h"
+#include "tst_tiling.h"
 
 #include <QApplication>
 
 #include <gtest/gtest.h>
 
+#include "../../src/renderer/vulkanhppinclude.h"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
 int main(int argc, char* argv[])
 {
     QApplication a(argc, argv);
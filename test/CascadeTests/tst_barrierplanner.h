@@ -0,0 +1,130 @@
+#ifndef TST_BARRIERPLANNER_H
+#define TST_BARRIERPLANNER_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/barrierplanner.h"
+
+using namespace Cascade::Renderer;
+
+// Stand-ins for VkImageLayout values
+static constexpr uint32_t generalLayout = 1;
+static constexpr uint32_t readOnlyLayout = 5;
+
+TEST(BarrierPlannerTest, transitionsBeforeCommandAreBatched)
+{
+    BarrierPlanner planner;
+    planner.addImage(0, readOnlyLayout);
+    planner.addImage(1, 0, false);
+
+    auto batch = planner.planCommand({
+        { 0, computeStage, generalLayout, true, false },
+        { 1, computeStage, generalLayout, false, true } });
+
+    ASSERT_EQ(batch.imageBarriers.size(), 2);
+    ASSERT_EQ(batch.srcStages, allStages);
+    ASSERT_EQ(batch.dstStages, computeStage);
+
+    // The discarded output doesn't wait for anything
+    ASSERT_EQ(batch.imageBarriers[1].srcStages, 0);
+}
+
+TEST(BarrierPlannerTest, readAfterWriteMakesWriteAvailable)
+{
+    BarrierPlanner planner;
+    planner.addImage(0, generalLayout, false);
+
+    ASSERT_TRUE(planner.planCommand({ { 0, computeStage, generalLayout, false, true } }).isEmpty());
+
+    auto batch = planner.planCommand({ { 0, computeStage, generalLayout, true, false } });
+
+    ASSERT_EQ(batch.imageBarriers.size(), 1);
+    ASSERT_EQ(batch.imageBarriers[0].srcWrites, computeStage);
+    ASSERT_TRUE(batch.imageBarriers[0].dstReads);
+
+    // The write is visible to the compute stage now
+    ASSERT_TRUE(planner.planCommand({ { 0, computeStage, generalLayout, true, false } }).isEmpty());
+    ASSERT_FALSE(planner.planCommand({ { 0, transferStage, generalLayout, true, false } }).isEmpty());
+}
+
+TEST(BarrierPlannerTest, writeAfterReadOnlyWaitsForReaders)
+{
+    BarrierPlanner planner;
+    planner.addImage(0, generalLayout, false);
+
+    ASSERT_TRUE(planner.planCommand({ { 0, transferStage, generalLayout, true, false } }).isEmpty());
+
+    auto batch = planner.planCommand({ { 0, computeStage, generalLayout, false, true } });
+
+    ASSERT_EQ(batch.imageBarriers.size(), 1);
+    ASSERT_EQ(batch.srcStages, transferStage);
+    ASSERT_EQ(batch.imageBarriers[0].srcWrites, 0);
+}
+
+TEST(BarrierPlannerTest, independentImagesDontWaitForEachOther)
+{
+    BarrierPlanner planner;
+    planner.addImage(0, generalLayout, false);
+    planner.addImage(1, generalLayout, false);
+    planner.addImage(2, generalLayout, false);
+
+    ASSERT_TRUE(planner.planCommand({ { 0, computeStage, generalLayout, false, true } }).isEmpty());
+    ASSERT_TRUE(planner.planCommand({
+        { 1, computeStage, generalLayout, true, false },
+        { 2, computeStage, generalLayout, false, true } }).isEmpty());
+}
+
+TEST(BarrierPlannerTest, releaseOnlyTransitionsChangedLayouts)
+{
+    BarrierPlanner planner;
+    planner.addImage(0, readOnlyLayout);
+    planner.addImage(1, generalLayout);
+
+    auto batch = planner.planRelease({ { 0, readOnlyLayout }, { 1, readOnlyLayout } });
+
+    ASSERT_EQ(batch.imageBarriers.size(), 1);
+    ASSERT_EQ(batch.imageBarriers[0].image, 1);
+    ASSERT_EQ(batch.dstStages, allStages);
+}
+
+TEST(BarrierPlannerTest, releaseMakesWritesVisibleWithoutTransition)
+{
+    BarrierPlanner planner;
+    planner.addImage(0, generalLayout);
+
+    planner.planCommand({ { 0, computeStage, generalLayout, false, true } });
+
+    auto batch = planner.planRelease({ { 0, generalLayout } });
+
+    ASSERT_EQ(batch.imageBarriers.size(), 1);
+    ASSERT_EQ(batch.imageBarriers[0].oldLayout, generalLayout);
+    ASSERT_EQ(batch.imageBarriers[0].newLayout, generalLayout);
+    ASSERT_EQ(batch.imageBarriers[0].srcWrites, computeStage);
+}
+
+TEST(BarrierPlannerTest, readersOfFinishedImageDontWaitForEachOther)
+{
+    // Two branches reading the output of the same node,
+    // each in a command buffer of its own
+    for (int branch = 0; branch < 2; ++branch)
+    {
+        BarrierPlanner planner;
+        planner.addImage(0, generalLayout, false);
+        planner.addImage(1, 0, false);
+
+        auto batch = planner.planCommand({
+            { 0, computeStage, generalLayout, true, false },
+            { 1, computeStage, generalLayout, false, true } });
+
+        ASSERT_EQ(batch.imageBarriers.size(), 1);
+        ASSERT_EQ(batch.imageBarriers[0].image, 1);
+
+        batch = planner.planRelease({ { 0, generalLayout }, { 1, generalLayout } });
+
+        ASSERT_EQ(batch.imageBarriers.size(), 1);
+        ASSERT_EQ(batch.imageBarriers[0].image, 1);
+        ASSERT_EQ(planner.getLayout(0), generalLayout);
+    }
+}
+
+#endif // TST_BARRIERPLANNER_H
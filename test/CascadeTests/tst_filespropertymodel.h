@@ -57,4 +57,24 @@ TEST_F(FilesPropertyModelTest, removeEntryAndCheckCount)
     EXPECT_EQ(5, mModel->numEntries());
 }
 
+TEST_F(FilesPropertyModelTest, hashFollowsListChanges)
+{
+    QStringList entries =
+    {
+        "/this/is/path/1",
+        "/this/is/path/2"
+    };
+
+    mModel->addEntries(entries);
+
+    const uint64_t hash = mModel->getData()->hash(0);
+
+    // The cached modification times don't hide a changed list
+    EXPECT_EQ(hash, mModel->getData()->hash(0));
+
+    mModel->removeEntry(1);
+
+    EXPECT_NE(hash, mModel->getData()->hash(0));
+}
+
 #endif // TST_FILESPROPERTYMODEL_H
@@ -0,0 +1,151 @@
+#ifndef TST_GRAPHEXECUTOR_H
+#define TST_GRAPHEXECUTOR_H
+
+#include <atomic>
+#include <functional>
+
+#include "testheader.h"
+
+#include "../../src/renderer/graphexecutor.h"
+#include "../../src/renderer/rendergraph.h"
+
+#include "tst_rendergraph.h"
+
+using namespace Cascade::Renderer;
+
+// Counts its executions and can change things halfway through a render
+class CountingTestTask : public KernelTestTask
+{
+public:
+    CountingTestTask() : KernelTestTask(0) {}
+
+    void execute(RenderContext& context) override
+    {
+        mSettings = context.settings;
+        ++mExecutions;
+
+        if (mOnExecute)
+            mOnExecute();
+    }
+
+    int getExecutions() const
+    {
+        return mExecutions;
+    }
+
+    // What the last execution got to see
+    const std::vector<QVariant>& getSettings() const
+    {
+        return mSettings;
+    }
+
+    void setOnExecute(std::function<void()> onExecute)
+    {
+        mOnExecute = std::move(onExecute);
+    }
+
+private:
+    std::function<void()> mOnExecute;
+    std::atomic<int> mExecutions{0};
+    std::vector<QVariant> mSettings;
+};
+
+class GraphExecutorTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // read --> grade --> write
+        //
+        // Without a command buffer factory the tasks run on the CPU only.
+        // Nothing produces a result, so every node is executed.
+
+        mRead  = mGraph.addNode(QUuid::createUuid(), &mReadTask, 0);
+        mGrade = mGraph.addNode(QUuid::createUuid(), &mGradeTask, 1);
+        mWrite = mGraph.addNode(QUuid::createUuid(), &mWriteTask, 1);
+
+        mGraph.connect(mRead, mGrade, 0);
+        mGraph.connect(mGrade, mWrite, 0);
+        mGraph.computeHashes();
+    }
+
+    GraphExecutor mExecutor;
+
+    CountingTestTask mReadTask;
+    CountingTestTask mGradeTask;
+    CountingTestTask mWriteTask;
+
+    RenderGraph mGraph;
+
+    int mRead;
+    int mGrade;
+    int mWrite;
+};
+
+TEST_F(GraphExecutorTest, unstampedRenderIsNeverStopped)
+{
+    mGradeTask.setOnExecute([this]() { mExecutor.startGeneration(); });
+
+    ASSERT_TRUE(mExecutor.render(mGraph, mWrite));
+
+    ASSERT_EQ(mReadTask.getExecutions(), 1);
+    ASSERT_EQ(mGradeTask.getExecutions(), 1);
+    ASSERT_EQ(mWriteTask.getExecutions(), 1);
+}
+
+TEST_F(GraphExecutorTest, staleRenderStopsAtNextNode)
+{
+    // Like a new render request while the grade runs
+    mGradeTask.setOnExecute([this]() { mExecutor.startGeneration(); });
+
+    const uint64_t generation = mExecutor.startGeneration();
+
+    ASSERT_FALSE(mExecutor.render(mGraph, mWrite, generation));
+
+    ASSERT_TRUE(mExecutor.isStale(generation));
+    ASSERT_EQ(mReadTask.getExecutions(), 1);
+    ASSERT_EQ(mGradeTask.getExecutions(), 1);
+    ASSERT_EQ(mWriteTask.getExecutions(), 0);
+}
+
+TEST_F(GraphExecutorTest, renderOfOldGenerationExecutesNothing)
+{
+    const uint64_t generation = mExecutor.startGeneration();
+    mExecutor.startGeneration();
+
+    ASSERT_FALSE(mExecutor.render(mGraph, mWrite, generation));
+
+    ASSERT_EQ(mReadTask.getExecutions(), 0);
+    ASSERT_EQ(mGradeTask.getExecutions(), 0);
+    ASSERT_EQ(mWriteTask.getExecutions(), 0);
+}
+
+TEST_F(GraphExecutorTest, currentGenerationRendersEverything)
+{
+    // Only a newer generation stops a render
+    const uint64_t generation = mExecutor.startGeneration();
+
+    ASSERT_TRUE(mExecutor.render(mGraph, mWrite, generation));
+
+    ASSERT_FALSE(mExecutor.isStale(generation));
+    ASSERT_EQ(mWriteTask.getExecutions(), 1);
+}
+
+TEST(GraphExecutorSettingsTest, tasksGetTheSettingsOfTheSnapshot)
+{
+    const std::vector<QVariant> settings = { QVariant(), QVariant(40), QVariant("gain") };
+
+    CountingTestTask task;
+
+    RenderGraph graph;
+    const int grade = graph.addNode(QUuid::createUuid(), &task, 0, 1, true, settings);
+    graph.computeHashes();
+
+    GraphExecutor executor;
+
+    ASSERT_TRUE(executor.render(graph, grade));
+
+    ASSERT_EQ(task.getSettings(), settings);
+}
+
+#endif // TST_GRAPHEXECUTOR_H
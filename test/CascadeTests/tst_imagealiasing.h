@@ -0,0 +1,99 @@
+#ifndef TST_IMAGEALIASING_H
+#define TST_IMAGEALIASING_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/imagealiasing.h"
+#include "../../src/renderer/rendergraph.h"
+
+using namespace Cascade::Renderer;
+
+TEST(ImageAliasingTest, linearChainNeedsTwoBlocks)
+{
+    // read --> grade --> grade --> ... --> write
+
+    RenderGraph graph;
+
+    std::vector<int> nodes = { graph.addNode(QUuid::createUuid(), nullptr, 0) };
+
+    for (int i = 1; i < 30; ++i)
+    {
+        nodes.push_back(graph.addNode(QUuid::createUuid(), nullptr, 1));
+        graph.connect(nodes[i - 1], nodes[i], 0);
+    }
+
+    const std::vector<uint64_t> bytes(graph.size(), 1000);
+
+    auto plan = planImageAliasing(graph, nodes, bytes, { nodes.back() });
+
+    ASSERT_EQ(plan.blockSizes.size(), 2);
+    ASSERT_EQ(plan.getTotalBytes(), 2000);
+    ASSERT_EQ(plan.blockOf[nodes.back()], -1);
+
+    // A node never writes into the block it reads from
+    for (size_t i = 1; i + 1 < nodes.size(); ++i)
+        ASSERT_NE(plan.blockOf[nodes[i]], plan.blockOf[nodes[i - 1]]);
+}
+
+TEST(ImageAliasingTest, independentBranchesDontShare)
+{
+    // read1 --> grade1 --\
+    //                     --> merge --> grade3
+    // read2 --> grade2 --/
+
+    RenderGraph graph;
+    const int read1  = graph.addNode(QUuid::createUuid(), nullptr, 0);
+    const int read2  = graph.addNode(QUuid::createUuid(), nullptr, 0);
+    const int grade1 = graph.addNode(QUuid::createUuid(), nullptr, 1);
+    const int grade2 = graph.addNode(QUuid::createUuid(), nullptr, 1);
+    const int merge  = graph.addNode(QUuid::createUuid(), nullptr, 2);
+    const int grade3 = graph.addNode(QUuid::createUuid(), nullptr, 1);
+
+    graph.connect(read1, grade1, 0);
+    graph.connect(read2, grade2, 0);
+    graph.connect(grade1, merge, 0);
+    graph.connect(grade2, merge, 1);
+    graph.connect(merge, grade3, 0);
+
+    const std::vector<uint64_t> bytes(graph.size(), 100);
+
+    auto plan = planImageAliasing(graph, graph.upstreamOf(grade3), bytes, { grade3 });
+
+    // Either branch can run at any time relative to the other one
+    const std::vector<int> branch1 = { read1, grade1 };
+    const std::vector<int> branch2 = { read2, grade2 };
+
+    for (const auto a : branch1)
+    {
+        for (const auto b : branch2)
+            ASSERT_NE(plan.blockOf[a], plan.blockOf[b]);
+    }
+
+    // Once both branches are merged their blocks are free again
+    ASSERT_EQ(plan.blockSizes.size(), 4);
+    ASSERT_NE(plan.blockOf[merge], plan.blockOf[grade1]);
+    ASSERT_NE(plan.blockOf[merge], plan.blockOf[grade2]);
+}
+
+TEST(ImageAliasingTest, sharedBlockGrowsToLargestOutput)
+{
+    // small --> large --> small --> target
+
+    RenderGraph graph;
+    std::vector<int> nodes = { graph.addNode(QUuid::createUuid(), nullptr, 0) };
+
+    for (int i = 1; i < 4; ++i)
+    {
+        nodes.push_back(graph.addNode(QUuid::createUuid(), nullptr, 1));
+        graph.connect(nodes[i - 1], nodes[i], 0);
+    }
+
+    std::vector<uint64_t> bytes = { 10, 500, 40, 10 };
+
+    auto plan = planImageAliasing(graph, nodes, bytes, { nodes.back() });
+
+    ASSERT_EQ(plan.blockOf[nodes[0]], plan.blockOf[nodes[2]]);
+    ASSERT_EQ(plan.getTotalBytes(), 540);
+}
+
+#endif // TST_IMAGEALIASING_H
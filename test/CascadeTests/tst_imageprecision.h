@@ -0,0 +1,62 @@
+#ifndef TST_IMAGEPRECISION_H
+#define TST_IMAGEPRECISION_H
+
+#include <cmath>
+#include <limits>
+
+#include "testheader.h"
+
+#include "../../src/renderer/imageprecision.h"
+
+using namespace Cascade::Renderer;
+
+TEST(ImagePrecisionTest, halfRoundTripsRepresentableValues)
+{
+    for (const float value : { 0.0f, -0.0f, 1.0f, -2.5f, 0.5f, 65504.0f, 1.0f / 1024.0f })
+        ASSERT_EQ(halfToFloat(floatToHalf(value)), value);
+
+    // Smallest denormal
+    ASSERT_EQ(halfToFloat(0x0001), std::ldexp(1.0f, -24));
+    ASSERT_EQ(floatToHalf(std::ldexp(1.0f, -24)), 0x0001);
+}
+
+TEST(ImagePrecisionTest, halfRoundsAndSaturates)
+{
+    // Halfway between 1 and the next half, rounds to even
+    ASSERT_EQ(floatToHalf(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+    ASSERT_EQ(floatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)), 0x3c02);
+
+    ASSERT_EQ(floatToHalf(1.0e6f), 0x7c00);
+    ASSERT_EQ(floatToHalf(-1.0e6f), 0xfc00);
+    ASSERT_EQ(floatToHalf(1.0e-9f), 0x0000);
+    ASSERT_TRUE(std::isnan(halfToFloat(floatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(ImagePrecisionTest, storageImageFormatIsPatched)
+{
+    // Header, an rgba32f storage image and an r32ui one
+    std::vector<uint32_t> spirV = {
+        0x07230203, 0x00010000, 0, 10, 0,
+        (9u << 16) | 25, 1, 2, 1, 0, 0, 0, 2, 1,
+        (9u << 16) | 25, 3, 2, 1, 0, 0, 0, 2, 33 };
+
+    ASSERT_TRUE(patchStorageImageFormat(spirV, ImagePrecision::Float16));
+    ASSERT_EQ(spirV[13], 2);
+    ASSERT_EQ(spirV[22], 33);
+
+    ASSERT_TRUE(patchStorageImageFormat(spirV, ImagePrecision::Float32));
+    ASSERT_EQ(spirV[13], 1);
+
+    spirV.pop_back();
+    ASSERT_FALSE(patchStorageImageFormat(spirV, ImagePrecision::Float16));
+}
+
+TEST(ImagePrecisionTest, namesMatchGlslFormats)
+{
+    ASSERT_EQ(getImageFormatName(ImagePrecision::Float16), "rgba16f");
+    ASSERT_EQ(imagePrecisionFromName("rgba32f"), ImagePrecision::Float32);
+    ASSERT_FALSE(imagePrecisionFromName("rgba8").has_value());
+    ASSERT_EQ(getBytesPerPixel(ImagePrecision::Float16), 8);
+}
+
+#endif // TST_IMAGEPRECISION_H
@@ -0,0 +1,220 @@
+#ifndef TST_KERNELFUSION_H
+#define TST_KERNELFUSION_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/kernelfusion.h"
+#include "../../src/renderer/rendergraph.h"
+#include "../../src/renderer/rendertaskexposure.h"
+#include "tst_rendergraph.h"
+
+using namespace Cascade::Renderer;
+
+// Multiplies the pixel, like an exposure
+class PointwiseTestTask : public RenderTask
+{
+public:
+    explicit PointwiseTestTask(const float factor) : mFactor(factor) {}
+
+    void execute(RenderContext&) override {}
+
+    std::optional<PointwiseKernel> getPointwiseKernel(const std::vector<QVariant>&) const override
+    {
+        return PointwiseKernel{ "multiply", "    pixel.rgb *= parameter(0);", { mFactor } };
+    }
+
+private:
+    const float mFactor;
+};
+
+class KernelFusionTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // read --> grade1 --> grade2 --> grade3 --> blur
+
+        mRead   = mGraph.addNode(QUuid::createUuid(), nullptr, 0);
+        mGrade1 = mGraph.addNode(QUuid::createUuid(), &mGradeTask1, 1);
+        mGrade2 = mGraph.addNode(QUuid::createUuid(), &mGradeTask2, 2);
+        mGrade3 = mGraph.addNode(QUuid::createUuid(), &mGradeTask3, 1);
+        mBlur   = mGraph.addNode(QUuid::createUuid(), &mBlurTask, 1);
+
+        mGraph.connect(mRead, mGrade1, 0);
+        mGraph.connect(mGrade1, mGrade2, 0);
+        mGraph.connect(mGrade2, mGrade3, 0);
+        mGraph.connect(mGrade3, mBlur, 0);
+    }
+
+    PointwiseTestTask mGradeTask1 = PointwiseTestTask(1.0f);
+    PointwiseTestTask mGradeTask2 = PointwiseTestTask(2.0f);
+    PointwiseTestTask mGradeTask3 = PointwiseTestTask(3.0f);
+    KernelTestTask mBlurTask = KernelTestTask(2);
+
+    RenderGraph mGraph;
+    int mRead;
+    int mGrade1;
+    int mGrade2;
+    int mGrade3;
+    int mBlur;
+};
+
+TEST_F(KernelFusionTest, chainOfPointwiseNodesIsFused)
+{
+    const auto chains = findFusableChains(mGraph, mGraph.topologicalOrder());
+
+    ASSERT_EQ(chains.size(), 1);
+    ASSERT_EQ(chains.front(), std::vector<int>({ mGrade1, mGrade2, mGrade3 }));
+}
+
+TEST_F(KernelFusionTest, nodeWithSeveralConsumersEndsChain)
+{
+    // grade1 is also needed by the merge
+    const int merge = mGraph.addNode(QUuid::createUuid(), nullptr, 2);
+    mGraph.connect(mGrade1, merge, 0);
+    mGraph.connect(mBlur, merge, 1);
+
+    const auto chains = findFusableChains(mGraph, mGraph.topologicalOrder());
+
+    ASSERT_EQ(chains.size(), 1);
+    ASSERT_EQ(chains.front(), std::vector<int>({ mGrade2, mGrade3 }));
+}
+
+TEST_F(KernelFusionTest, connectedMaskEndsChain)
+{
+    mGraph.connect(mRead, mGrade2, 1);
+
+    const auto chains = findFusableChains(mGraph, mGraph.topologicalOrder());
+
+    ASSERT_EQ(chains.size(), 1);
+    ASSERT_EQ(chains.front(), std::vector<int>({ mGrade2, mGrade3 }));
+}
+
+TEST_F(KernelFusionTest, onlyScheduledNodesAreFused)
+{
+    // grade1 and grade2 are up to date
+    const auto chains = findFusableChains(mGraph, { mGrade3, mBlur });
+
+    ASSERT_TRUE(chains.empty());
+}
+
+TEST_F(KernelFusionTest, singleNodesCanBeChainsOfTheirOwn)
+{
+    mGraph.connect(mRead, mGrade2, 1);
+
+    const auto chains = findFusableChains(mGraph, mGraph.topologicalOrder(), true);
+
+    ASSERT_EQ(chains.size(), 2);
+    ASSERT_EQ(chains[0], std::vector<int>({ mGrade1 }));
+    ASSERT_EQ(chains[1], std::vector<int>({ mGrade2, mGrade3 }));
+}
+
+TEST(KernelFusionExposureTest, exposureIsPointwiseInStops)
+{
+    RenderTaskExposure exposure;
+
+    // Title, then the exposure in hundredths of a stop
+    const auto kernel = exposure.getPointwiseKernel({ QVariant(), QVariant(150) });
+
+    ASSERT_TRUE(kernel.has_value());
+    ASSERT_EQ(kernel->parameters, std::vector<float>({ 1.5f }));
+}
+
+TEST(KernelFusionExposureTest, exposureRunsItsKernelOnItsOwn)
+{
+    KernelTestTask source(0);
+    source.setResult(placeholderResult());
+
+    RenderTaskExposure exposure;
+
+    RenderContext context;
+    context.inputs = { &source };
+    context.settings = { QVariant(), QVariant(-200) };
+
+    std::vector<float> parameters;
+    context.runKernel = [&](const PointwiseKernel& kernel, const std::shared_ptr<CsImage>& input)
+    {
+        parameters = kernel.parameters;
+        return input;
+    };
+
+    exposure.execute(context);
+
+    ASSERT_EQ(parameters, std::vector<float>({ -2.0f }));
+    ASSERT_EQ(exposure.getResult(), source.getResult());
+}
+
+TEST_F(KernelFusionTest, signatureIgnoresParameterValues)
+{
+    const std::vector<PointwiseKernel> first = {
+        *mGradeTask1.getPointwiseKernel({}), *mGradeTask2.getPointwiseKernel({}) };
+    const std::vector<PointwiseKernel> second = {
+        *mGradeTask3.getPointwiseKernel({}), *mGradeTask1.getPointwiseKernel({}) };
+
+    ASSERT_EQ(fusedKernelSignature(first), fusedKernelSignature(second));
+    ASSERT_NE(fusedKernelSignature(first), fusedKernelSignature({ first.front() }));
+}
+
+TEST_F(KernelFusionTest, parametersArePackedInOrder)
+{
+    const auto parameters = packFusedParameters({
+        *mGradeTask1.getPointwiseKernel({}),
+        *mGradeTask2.getPointwiseKernel({}),
+        *mGradeTask3.getPointwiseKernel({}) });
+
+    // Padded to whole vec4s
+    ASSERT_EQ(parameters, std::vector<float>({ 1.0f, 2.0f, 3.0f, 0.0f }));
+}
+
+TEST_F(KernelFusionTest, shaderAppliesEveryKernelOnce)
+{
+    const auto code = generateFusedShader({
+        *mGradeTask1.getPointwiseKernel({}),
+        *mGradeTask2.getPointwiseKernel({}) });
+
+    ASSERT_NE(code.find("pixel = stage0(pixel);"), std::string::npos);
+    ASSERT_NE(code.find("pixel = stage1(pixel);"), std::string::npos);
+    ASSERT_EQ(code.find("stage2"), std::string::npos);
+    ASSERT_EQ(code.find("imageLoad"), code.rfind("imageLoad"));
+}
+
+TEST_F(KernelFusionTest, shaderTakesImagesFromSetsOfTheirOwn)
+{
+    const auto code = generateFusedShader({ *mGradeTask1.getPointwiseKernel({}) });
+
+    // Bound with the set every image gets from the descriptor allocator
+    ASSERT_NE(code.find("set = 0, binding = 0"), std::string::npos);
+    ASSERT_NE(code.find("set = 1, binding = 0"), std::string::npos);
+    ASSERT_NE(code.find("set = 2, binding = 0"), std::string::npos);
+}
+
+TEST(KernelFusionRegionTest, tileIsAddressedFromItsOrigin)
+{
+    // The input has a halo of four pixels for another consumer
+    const auto region = getFusedRegion(
+        QRect(512, 1024, 256, 256), QRect(508, 1020, 264, 264), true);
+
+    ASSERT_EQ(region.roi, QRect(0, 0, 256, 256));
+    ASSERT_EQ(region.inputOffset, QPoint(4, 4));
+    ASSERT_EQ(region.outputSize, QSize(256, 256));
+}
+
+TEST(KernelFusionRegionTest, viewerKeepsCanvasCoordinates)
+{
+    const auto region = getFusedRegion(
+        QRect(512, 1024, 256, 256), QRect(508, 1020, 264, 264), false);
+
+    ASSERT_EQ(region.roi, QRect(512, 1024, 256, 256));
+    ASSERT_EQ(region.inputOffset, QPoint(0, 0));
+    ASSERT_TRUE(region.outputSize.isEmpty());
+}
+
+TEST_F(KernelFusionTest, shaderReadsInputAtOffset)
+{
+    const auto code = generateFusedShader({ *mGradeTask1.getPointwiseKernel({}) });
+
+    ASSERT_NE(code.find("layout (push_constant)"), std::string::npos);
+    ASSERT_NE(code.find("imageLoad(inputImage, pixelCoords + region.inputOffset)"), std::string::npos);
+}
+
+#endif // TST_KERNELFUSION_H
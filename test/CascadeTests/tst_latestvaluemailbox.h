@@ -0,0 +1,64 @@
+#ifndef TST_LATESTVALUEMAILBOX_H
+#define TST_LATESTVALUEMAILBOX_H
+
+#include <thread>
+
+#include "testheader.h"
+
+#include "../../src/renderer/latestvaluemailbox.h"
+
+using namespace Cascade::Renderer;
+
+TEST(LatestValueMailboxTest, emptyMailboxHasNothingToTake)
+{
+    LatestValueMailbox<int> mailbox;
+
+    ASSERT_FALSE(mailbox.take().has_value());
+}
+
+TEST(LatestValueMailboxTest, onlyLatestValueIsKept)
+{
+    LatestValueMailbox<int> mailbox;
+
+    mailbox.post(1);
+    mailbox.post(2);
+    mailbox.post(3);
+
+    ASSERT_EQ(mailbox.take(), 3);
+    ASSERT_FALSE(mailbox.take().has_value());
+
+    mailbox.post(4);
+
+    ASSERT_EQ(mailbox.take(), 4);
+}
+
+TEST(LatestValueMailboxTest, consumerSeesIncreasingValuesEndingWithLast)
+{
+    LatestValueMailbox<int> mailbox;
+
+    const int count = 100000;
+
+    std::thread producer(
+        [&mailbox]()
+        {
+            for (int i = 1; i <= count; ++i)
+                mailbox.post(i);
+        });
+
+    int last = 0;
+
+    while (last < count)
+    {
+        if (auto value = mailbox.take())
+        {
+            ASSERT_GT(*value, last);
+            last = *value;
+        }
+    }
+
+    producer.join();
+
+    ASSERT_EQ(last, count);
+}
+
+#endif // TST_LATESTVALUEMAILBOX_H
@@ -109,4 +109,22 @@ TEST_F(NodeTest, getNodesBelowReturnsCorrectNumber)
     ASSERT_EQ(nodesBelowNode1.size(), 2);
 }
 
+TEST_F(NodeTest, invalidateOnlyMarksNodesBelow)
+{
+    // node1 --> node2 --> node3
+
+    mModel->createConnection(*mNode2, 0, *mNode1, 0);
+    mModel->createConnection(*mNode3, 0, *mNode2, 0);
+
+    mNode1->setIsDirty(false);
+    mNode2->setIsDirty(false);
+    mNode3->setIsDirty(false);
+
+    mNode2->invalidate();
+
+    ASSERT_EQ(mNode1->getIsDirty(), false);
+    ASSERT_EQ(mNode2->getIsDirty(), true);
+    ASSERT_EQ(mNode3->getIsDirty(), true);
+}
+
 #endif // TST_NODE_H
@@ -31,4 +31,28 @@ TEST_F(NodeGraphDataModelTest, checkThatDataWasCreated)
     ASSERT_NE(mModel->getData(), nullptr);
 }
 
+TEST_F(NodeGraphDataModelTest, loadRestoresSavedGraph)
+{
+    Node& read = mModel->createNode(mModel->registry().create("Read"));
+    Node& write = mModel->createNode(mModel->registry().create("Write"));
+    mModel->createConnection(write, 0, read, 0);
+
+    auto writeModel = static_cast<WriteNodeDataModel*>(write.nodeDataModel());
+    static_cast<TextPropertyData*>(writeModel->getPropertyData()[1])->setValue("out.exr");
+
+    const QUuid writeId = write.id();
+    const QJsonObject json = mModel->save();
+
+    NodeGraphDataModel restored(mScene, &mParent);
+    restored.load(json);
+
+    ASSERT_EQ(restored.getData()->getNodes().size(), 2);
+    ASSERT_EQ(restored.getData()->getConnections().size(), 1);
+
+    auto restoredWrite = static_cast<WriteNodeDataModel*>(
+        restored.getData()->getNode(writeId)->nodeDataModel());
+
+    ASSERT_EQ(restoredWrite->getPath(), "out.exr");
+}
+
 #endif // TST_NODEGRAPHDATAMODEL_H
@@ -0,0 +1,90 @@
+#ifndef TST_PIPELINECACHEHEADER_H
+#define TST_PIPELINECACHEHEADER_H
+
+#include <cstring>
+#include <vector>
+
+#include "testheader.h"
+
+#include "../../src/renderer/pipelinecacheheader.h"
+
+using namespace Cascade::Renderer;
+
+class PipelineCacheHeaderTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mDevice.vendorId = 0x10de;
+        mDevice.deviceId = 0x2684;
+        for (size_t i = 0; i < pipelineCacheUuidSize; ++i)
+            mDevice.uuid[i] = static_cast<uint8_t>(i + 1);
+
+        // Header followed by some driver data
+        mData.resize(16 + pipelineCacheUuidSize + 8, 0);
+        writeUint32(0, 16 + pipelineCacheUuidSize);
+        writeUint32(4, pipelineCacheHeaderVersionOne);
+        writeUint32(8, mDevice.vendorId);
+        writeUint32(12, mDevice.deviceId);
+        std::memcpy(mData.data() + 16, mDevice.uuid.data(), pipelineCacheUuidSize);
+    }
+
+    void writeUint32(const size_t offset, const uint32_t value)
+    {
+        std::memcpy(mData.data() + offset, &value, sizeof(value));
+    }
+
+    bool isCompatible() const
+    {
+        return isPipelineCacheCompatible(mData.data(), mData.size(), mDevice);
+    }
+
+    PipelineCacheDevice mDevice;
+    std::vector<char> mData;
+};
+
+TEST_F(PipelineCacheHeaderTest, matchingHeaderIsCompatible)
+{
+    ASSERT_TRUE(isCompatible());
+}
+
+TEST_F(PipelineCacheHeaderTest, wrongSizeIsRejected)
+{
+    // Shorter than the header
+    ASSERT_FALSE(isPipelineCacheCompatible(mData.data(), 16, mDevice));
+    ASSERT_FALSE(isPipelineCacheCompatible(nullptr, 0, mDevice));
+
+    // Header size smaller than the header or larger than the data
+    writeUint32(0, 16);
+    ASSERT_FALSE(isCompatible());
+
+    writeUint32(0, static_cast<uint32_t>(mData.size() + 1));
+    ASSERT_FALSE(isCompatible());
+}
+
+TEST_F(PipelineCacheHeaderTest, wrongVersionIsRejected)
+{
+    writeUint32(4, pipelineCacheHeaderVersionOne + 1);
+
+    ASSERT_FALSE(isCompatible());
+}
+
+TEST_F(PipelineCacheHeaderTest, wrongVendorOrDeviceIsRejected)
+{
+    writeUint32(8, 0x1002);
+    ASSERT_FALSE(isCompatible());
+
+    writeUint32(8, mDevice.vendorId);
+    writeUint32(12, mDevice.deviceId + 1);
+    ASSERT_FALSE(isCompatible());
+}
+
+TEST_F(PipelineCacheHeaderTest, wrongUuidIsRejected)
+{
+    // Same GPU after a driver update
+    mData[16 + pipelineCacheUuidSize - 1] ^= 0x01;
+
+    ASSERT_FALSE(isCompatible());
+}
+
+#endif // TST_PIPELINECACHEHEADER_H
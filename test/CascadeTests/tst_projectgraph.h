@@ -0,0 +1,90 @@
+#ifndef TST_PROJECTGRAPH_H
+#define TST_PROJECTGRAPH_H
+
+#include <QJsonArray>
+
+#include "testheader.h"
+
+#include "../../src/nodegraph/nodegraphdatamodel.h"
+#include "../../src/nodegraph/nodegraphscene.h"
+#include "../../src/nodegraph/projectgraph.h"
+
+using namespace Cascade::NodeGraph;
+
+class ProjectGraphTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // read --> write
+
+        mScene = new NodeGraphScene(&mParent);
+        mModel = new NodeGraphDataModel(mScene, &mParent);
+
+        Node& read = mModel->createNode(mModel->registry().create("Read"));
+        Node& write = mModel->createNode(mModel->registry().create("Write"));
+        mModel->createConnection(write, 0, read, 0);
+
+        auto writeModel = static_cast<WriteNodeDataModel*>(write.nodeDataModel());
+        static_cast<TextPropertyData*>(writeModel->getPropertyData()[1])->setValue("out.exr");
+
+        mWriteId = write.id();
+    }
+
+    QWidget mParent;
+    NodeGraphScene* mScene;
+    NodeGraphDataModel* mModel;
+    QUuid mWriteId;
+};
+
+TEST_F(ProjectGraphTest, loadsGraphSavedByTheEditor)
+{
+    ProjectGraph project;
+    project.load(mModel->save());
+
+    const auto writeNodes = project.getNodesOfType("Write");
+
+    ASSERT_EQ(writeNodes.size(), 1);
+    ASSERT_EQ(writeNodes.front(), mWriteId);
+    ASSERT_EQ(WriteNodeData::getPath(project.getNodeData(mWriteId)), "out.exr");
+
+    auto graph = project.createRenderGraph();
+
+    ASSERT_EQ(graph.upstreamOf(graph.indexOf(mWriteId)).size(), 2);
+}
+
+TEST_F(ProjectGraphTest, renderGraphMatchesTheEditor)
+{
+    ProjectGraph project;
+    project.load(mModel->save());
+
+    // Results cached by the editor stay valid for the same graph
+    auto editorGraph = mModel->createRenderGraph();
+    auto projectGraph = project.createRenderGraph();
+
+    const auto& editorNode = editorGraph.getNode(editorGraph.indexOf(mWriteId));
+    const auto& projectNode = projectGraph.getNode(projectGraph.indexOf(mWriteId));
+
+    ASSERT_EQ(editorNode.settingsHash, projectNode.settingsHash);
+    ASSERT_EQ(editorNode.hash, projectNode.hash);
+}
+
+TEST_F(ProjectGraphTest, unknownNodesAreSkipped)
+{
+    QJsonObject json = mModel->save();
+
+    QJsonObject unknown;
+    unknown["id"] = QUuid::createUuid().toString();
+    unknown["model"] = QJsonObject{ { "name", "DoesNotExist" } };
+
+    QJsonArray nodes = json["nodes"].toArray();
+    nodes.append(unknown);
+    json["nodes"] = nodes;
+
+    ProjectGraph project;
+    project.load(json);
+
+    ASSERT_EQ(project.createRenderGraph().size(), 2);
+}
+
+#endif // TST_PROJECTGRAPH_H
@@ -0,0 +1,64 @@
+#ifndef TST_RANGEALLOCATOR_H
+#define TST_RANGEALLOCATOR_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/rangeallocator.h"
+
+using namespace Cascade::Renderer;
+
+TEST(RangeAllocatorTest, allocationsAreAlignedAndDisjoint)
+{
+    RangeAllocator allocator(1024);
+
+    auto a = allocator.allocate(100);
+    auto b = allocator.allocate(100, 256);
+
+    ASSERT_TRUE(a.has_value());
+    ASSERT_TRUE(b.has_value());
+    ASSERT_EQ(*a, 0);
+    ASSERT_EQ(*b % 256, 0);
+    ASSERT_GE(*b, *a + 100);
+    ASSERT_EQ(allocator.getUsedBytes(), 200);
+
+    ASSERT_FALSE(allocator.allocate(1024).has_value());
+}
+
+TEST(RangeAllocatorTest, freedRangesAreMerged)
+{
+    RangeAllocator allocator(300);
+
+    auto a = allocator.allocate(100);
+    auto b = allocator.allocate(100);
+    auto c = allocator.allocate(100);
+
+    ASSERT_FALSE(allocator.allocate(1).has_value());
+
+    allocator.free(*a);
+    allocator.free(*c);
+    allocator.free(*b);
+
+    ASSERT_TRUE(allocator.isEmpty());
+    ASSERT_EQ(allocator.allocate(300), 0);
+}
+
+TEST(RangeAllocatorTest, smallestFittingRangeIsUsed)
+{
+    RangeAllocator allocator(1000);
+
+    auto a = allocator.allocate(400);
+    auto b = allocator.allocate(100);
+    auto c = allocator.allocate(50);
+    allocator.allocate(100);
+
+    // Free ranges of 400, 50 and 350
+    allocator.free(*a);
+    allocator.free(*c);
+
+    ASSERT_EQ(allocator.allocate(50), *c);
+    ASSERT_EQ(allocator.allocate(300), 650);
+    ASSERT_EQ(allocator.allocate(400), 0);
+    ASSERT_NE(*b, 0);
+}
+
+#endif // TST_RANGEALLOCATOR_H
@@ -0,0 +1,83 @@
+#ifndef TST_RENDERCACHE_H
+#define TST_RENDERCACHE_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/rendercache.h"
+
+using namespace Cascade::Renderer;
+
+class RenderCacheTest : public ::testing::Test
+{
+protected:
+    RenderCache mCache = RenderCache(300);
+};
+
+TEST_F(RenderCacheTest, insertedEntryIsFound)
+{
+    mCache.insert(1, nullptr, 100);
+
+    ASSERT_TRUE(mCache.contains(1));
+    ASSERT_FALSE(mCache.contains(2));
+    ASSERT_EQ(mCache.getUsedBytes(), 100);
+}
+
+TEST_F(RenderCacheTest, leastRecentlyUsedEntryIsEvicted)
+{
+    mCache.insert(1, nullptr, 100);
+    mCache.insert(2, nullptr, 100);
+    mCache.insert(3, nullptr, 100);
+
+    // Touch the oldest entry so that 2 becomes the least recently used one
+    mCache.find(1);
+
+    mCache.insert(4, nullptr, 100);
+
+    ASSERT_TRUE(mCache.contains(1));
+    ASSERT_FALSE(mCache.contains(2));
+    ASSERT_TRUE(mCache.contains(3));
+    ASSERT_TRUE(mCache.contains(4));
+    ASSERT_EQ(mCache.getUsedBytes(), 300);
+}
+
+TEST_F(RenderCacheTest, reinsertingReplacesEntry)
+{
+    mCache.insert(1, nullptr, 100);
+    mCache.insert(1, nullptr, 200);
+
+    ASSERT_EQ(mCache.size(), 1);
+    ASSERT_EQ(mCache.getUsedBytes(), 200);
+}
+
+TEST_F(RenderCacheTest, loweringBudgetEvicts)
+{
+    mCache.insert(1, nullptr, 100);
+    mCache.insert(2, nullptr, 100);
+
+    mCache.setBudget(100);
+
+    ASSERT_FALSE(mCache.contains(1));
+    ASSERT_TRUE(mCache.contains(2));
+}
+
+TEST_F(RenderCacheTest, imageUnderSeveralKeysCountsOnce)
+{
+    // Never dereferenced, only the address is compared
+    static int placeholder;
+    const auto image = std::shared_ptr<CsImage>(
+        std::shared_ptr<CsImage>(), reinterpret_cast<CsImage*>(&placeholder));
+
+    // Like a Write node that passes its input through
+    mCache.insert(1, image, 200);
+    mCache.insert(2, image, 200);
+
+    ASSERT_EQ(mCache.size(), 2);
+    ASSERT_EQ(mCache.getUsedBytes(), 200);
+
+    // Still held by the second key
+    mCache.insert(1, nullptr, 50);
+
+    ASSERT_EQ(mCache.getUsedBytes(), 250);
+}
+
+#endif // TST_RENDERCACHE_H
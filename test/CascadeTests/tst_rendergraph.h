@@ -0,0 +1,364 @@
+#ifndef TST_RENDERGRAPH_H
+#define TST_RENDERGRAPH_H
+
+#include <algorithm>
+
+#include "testheader.h"
+
+#include "../../src/renderer/rendergraph.h"
+#include "../../src/renderer/rendertask.h"
+
+using namespace Cascade::Renderer;
+
+// Needs its input grown by a fixed radius, like a blur
+class KernelTestTask : public RenderTask
+{
+public:
+    explicit KernelTestTask(const int radius) : mRadius(radius) {}
+
+    void execute(RenderContext&) override {}
+
+    QRect getInputRoi(const QRect& outputRoi, const int) const override
+    {
+        return outputRoi.adjusted(-mRadius, -mRadius, mRadius, mRadius);
+    }
+
+private:
+    const int mRadius;
+};
+
+class RenderGraphTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // read1 --> grade1 --\
+        //                     --> merge
+        // read2 --> grade2 --/
+        //
+        // read3
+
+        mRead1  = mGraph.addNode(QUuid::createUuid(), nullptr, 0);
+        mRead2  = mGraph.addNode(QUuid::createUuid(), nullptr, 0);
+        mRead3  = mGraph.addNode(QUuid::createUuid(), nullptr, 0);
+        mMerge  = mGraph.addNode(QUuid::createUuid(), nullptr, 2);
+        mGrade1 = mGraph.addNode(QUuid::createUuid(), nullptr, 1);
+        mGrade2 = mGraph.addNode(QUuid::createUuid(), nullptr, 1);
+
+        mGraph.connect(mRead1, mGrade1, 0);
+        mGraph.connect(mRead2, mGrade2, 0);
+        mGraph.connect(mGrade1, mMerge, 0);
+        mGraph.connect(mGrade2, mMerge, 1);
+    }
+
+    int positionOf(const std::vector<int>& order, const int index)
+    {
+        return std::find(order.begin(), order.end(), index) - order.begin();
+    }
+
+    RenderGraph mGraph;
+    int mRead1;
+    int mRead2;
+    int mRead3;
+    int mGrade1;
+    int mGrade2;
+    int mMerge;
+};
+
+TEST_F(RenderGraphTest, topologicalOrderContainsAllNodes)
+{
+    auto order = mGraph.topologicalOrder();
+
+    ASSERT_EQ(order.size(), 6);
+}
+
+TEST_F(RenderGraphTest, topologicalOrderPutsInputsFirst)
+{
+    auto order = mGraph.topologicalOrder();
+
+    ASSERT_LT(positionOf(order, mRead1), positionOf(order, mGrade1));
+    ASSERT_LT(positionOf(order, mRead2), positionOf(order, mGrade2));
+    ASSERT_LT(positionOf(order, mGrade1), positionOf(order, mMerge));
+    ASSERT_LT(positionOf(order, mGrade2), positionOf(order, mMerge));
+}
+
+TEST_F(RenderGraphTest, upstreamOfOnlyContainsDependencies)
+{
+    auto nodes = mGraph.upstreamOf(mGrade1);
+
+    ASSERT_EQ(nodes.size(), 2);
+    ASSERT_EQ(nodes.front(), mRead1);
+    ASSERT_EQ(nodes.back(), mGrade1);
+
+    nodes = mGraph.upstreamOf(mMerge);
+
+    ASSERT_EQ(nodes.size(), 5);
+    ASSERT_EQ(nodes.back(), mMerge);
+}
+
+TEST_F(RenderGraphTest, cycleResultsInEmptyOrder)
+{
+    // read1 --> grade1 --> merge --> read1
+    mGraph.connect(mMerge, mRead1, 0);
+
+    ASSERT_TRUE(mGraph.topologicalOrder().empty());
+}
+
+TEST_F(RenderGraphTest, reconnectingPortRemovesOldEdge)
+{
+    mGraph.connect(mRead3, mGrade1, 0);
+
+    const auto& read1Outputs = mGraph.getNode(mRead1).outputs;
+    ASSERT_EQ(std::find(read1Outputs.begin(), read1Outputs.end(), mGrade1), read1Outputs.end());
+    ASSERT_EQ(mGraph.getNode(mRead3).outputs, std::vector<int>{ mGrade1 });
+    ASSERT_EQ(mGraph.getNode(mGrade1).inputs, std::vector<int>{ mRead3 });
+
+    // read1 has no consumers left, so it comes out of the order unconstrained
+    auto order = mGraph.topologicalOrder();
+    ASSERT_EQ(order.size(), 6);
+    ASSERT_LT(positionOf(order, mRead3), positionOf(order, mGrade1));
+    ASSERT_EQ(mGraph.upstreamOf(mGrade1), (std::vector<int>{ mRead3, mGrade1 }));
+}
+
+TEST_F(RenderGraphTest, reconnectingPortKeepsEdgesOfOtherPorts)
+{
+    // read1 takes over port 1 of the merge, then grade2 gets it back
+    mGraph.connect(mRead1, mMerge, 1);
+    mGraph.connect(mGrade2, mMerge, 1);
+
+    ASSERT_EQ(mGraph.getNode(mRead1).outputs, std::vector<int>{ mGrade1 });
+    ASSERT_EQ(mGraph.getNode(mGrade2).outputs, std::vector<int>{ mMerge });
+    ASSERT_EQ(mGraph.getNode(mGrade1).outputs, std::vector<int>{ mMerge });
+}
+
+TEST_F(RenderGraphTest, criticalPathFollowsCostliestBranch)
+{
+    std::vector<double> costs(mGraph.size(), 1.0);
+    costs[mGrade2] = 5.0;
+
+    const std::vector<int> expected = { mRead2, mGrade2, mMerge };
+
+    ASSERT_EQ(mGraph.criticalPath(costs), expected);
+
+    costs[mRead3] = 10.0;
+
+    ASSERT_EQ(mGraph.criticalPath(costs), std::vector<int>{ mRead3 });
+}
+
+TEST_F(RenderGraphTest, criticalPathEndsAtNodeWithoutConsumers)
+{
+    const std::vector<double> costs(mGraph.size(), 0.0);
+
+    const auto path = mGraph.criticalPath(costs);
+
+    ASSERT_FALSE(path.empty());
+    ASSERT_TRUE(mGraph.getNode(path.back()).outputs.empty());
+    ASSERT_TRUE(mGraph.getNode(path.front()).inputs.empty());
+}
+
+TEST_F(RenderGraphTest, regionOfInterestIsPassedUpstream)
+{
+    const QRect roi(10, 10, 20, 20);
+
+    mGraph.setRegionOfInterest(mMerge, roi);
+
+    ASSERT_EQ(mGraph.getNode(mGrade1).roi, roi);
+    ASSERT_EQ(mGraph.getNode(mRead2).roi, roi);
+    ASSERT_TRUE(mGraph.getNode(mRead3).roi.isNull());
+}
+
+TEST_F(RenderGraphTest, regionOfInterestGrowsByKernelFootprint)
+{
+    // read --> blur --> merge
+    //     \-----------/
+
+    KernelTestTask blurTask(2);
+
+    RenderGraph graph;
+    const int read = graph.addNode(QUuid::createUuid(), nullptr, 0);
+    const int blur = graph.addNode(QUuid::createUuid(), &blurTask, 1);
+    const int merge = graph.addNode(QUuid::createUuid(), nullptr, 2);
+
+    graph.connect(read, blur, 0);
+    graph.connect(blur, merge, 0);
+    graph.connect(read, merge, 1);
+
+    graph.setRegionOfInterest(merge, QRect(10, 10, 10, 10));
+
+    ASSERT_EQ(graph.getNode(blur).roi, QRect(10, 10, 10, 10));
+    ASSERT_EQ(graph.getNode(read).roi, QRect(8, 8, 14, 14));
+}
+
+TEST_F(RenderGraphTest, wholeImageStaysWholeThroughKernelFootprint)
+{
+    KernelTestTask blurTask(2);
+
+    RenderGraph graph;
+    const int read = graph.addNode(QUuid::createUuid(), nullptr, 0);
+    const int blur = graph.addNode(QUuid::createUuid(), &blurTask, 1);
+
+    graph.connect(read, blur, 0);
+
+    graph.setRegionOfInterest(blur, QRect());
+
+    ASSERT_TRUE(graph.getNode(read).roi.isNull());
+}
+
+TEST_F(RenderGraphTest, settingsHashChangeDirtiesDownstream)
+{
+    mGraph.computeHashes();
+
+    const uint64_t mergeHash = mGraph.getNode(mMerge).hash;
+    const uint64_t grade2Hash = mGraph.getNode(mGrade2).hash;
+
+    RenderGraph clean;
+    for (const auto& node : mGraph.getNodes())
+        clean.addNode(node.id, nullptr, node.inputs.size(), node.settingsHash, false);
+    clean.connect(mRead1, mGrade1, 0);
+    clean.connect(mRead2, mGrade2, 0);
+    clean.connect(mGrade1, mMerge, 0);
+    clean.connect(mGrade2, mMerge, 1);
+    clean.computeHashes();
+
+    clean.setSettingsHash(mRead1, 42);
+
+    ASSERT_TRUE(clean.getNode(mRead1).dirty);
+    ASSERT_TRUE(clean.getNode(mGrade1).dirty);
+    ASSERT_TRUE(clean.getNode(mMerge).dirty);
+    ASSERT_FALSE(clean.getNode(mRead2).dirty);
+    ASSERT_FALSE(clean.getNode(mGrade2).dirty);
+
+    ASSERT_NE(clean.getNode(mMerge).hash, mergeHash);
+    ASSERT_EQ(clean.getNode(mGrade2).hash, grade2Hash);
+}
+
+// The task only checks that it has a result, it is never dereferenced
+static std::shared_ptr<CsImage> placeholderResult()
+{
+    static int placeholder;
+    return std::shared_ptr<CsImage>(std::shared_ptr<CsImage>(), reinterpret_cast<CsImage*>(&placeholder));
+}
+
+TEST(RenderTaskCutoffTest, neverExecutedTaskIsNotUpToDate)
+{
+    KernelTestTask task(0);
+    task.setResult(placeholderResult());
+
+    ASSERT_FALSE(task.isUpToDate(5, { 7, 8 }));
+    ASSERT_FALSE(task.hasSameInputs({ 7, 8 }));
+}
+
+TEST(RenderTaskCutoffTest, sameSettingsAndInputsAreUpToDate)
+{
+    KernelTestTask task(0);
+    task.setResult(placeholderResult());
+    task.setExecutedWith(5, { 7, 8 });
+
+    ASSERT_TRUE(task.isUpToDate(5, { 7, 8 }));
+    ASSERT_TRUE(task.hasSameInputs({ 7, 8 }));
+}
+
+TEST(RenderTaskCutoffTest, changedSettingsKeepSameInputs)
+{
+    KernelTestTask task(0);
+    task.setResult(placeholderResult());
+    task.setExecutedWith(5, { 7, 8 });
+
+    ASSERT_FALSE(task.isUpToDate(6, { 7, 8 }));
+    ASSERT_TRUE(task.hasSameInputs({ 7, 8 }));
+}
+
+TEST(RenderTaskCutoffTest, changedInputIsNotUpToDate)
+{
+    KernelTestTask task(0);
+    task.setResult(placeholderResult());
+    task.setExecutedWith(5, { 7, 8 });
+
+    ASSERT_FALSE(task.isUpToDate(5, { 7, 9 }));
+    ASSERT_FALSE(task.hasSameInputs({ 7, 9 }));
+    ASSERT_FALSE(task.isUpToDate(5, { 7 }));
+}
+
+TEST(RenderTaskCutoffTest, unknownInputHashNeverMatches)
+{
+    KernelTestTask task(0);
+    task.setResult(placeholderResult());
+    task.setExecutedWith(5, { 0, 8 });
+
+    ASSERT_FALSE(task.isUpToDate(5, { 0, 8 }));
+    ASSERT_FALSE(task.hasSameInputs({ 0, 8 }));
+}
+
+TEST(RenderTaskCutoffTest, replacedResultIsNotUpToDate)
+{
+    KernelTestTask task(0);
+    task.setResult(placeholderResult());
+    task.setExecutedWith(5, { 7, 8 });
+
+    task.setResult(placeholderResult());
+    ASSERT_FALSE(task.isUpToDate(5, { 7, 8 }));
+
+    task.setExecutedWith(5, { 7, 8 });
+    task.setResult(nullptr);
+    ASSERT_FALSE(task.isUpToDate(5, { 7, 8 }));
+}
+
+TEST(RenderGraphProxyTest, proxyNodesAreDirtyAndHashedApart)
+{
+    const QUuid id = QUuid::createUuid();
+
+    RenderGraph full;
+    full.addNode(id, nullptr, 0, 7, false);
+    full.computeHashes();
+
+    RenderGraph proxy;
+    proxy.addNode(id, nullptr, 0, 7, false);
+    proxy.computeHashes();
+    proxy.setProxyScale(4);
+
+    ASSERT_FALSE(full.getNode(0).dirty);
+    ASSERT_TRUE(proxy.getNode(0).dirty);
+    ASSERT_NE(full.getNode(0).settingsHash, proxy.getNode(0).settingsHash);
+    ASSERT_NE(full.getNode(0).hash, proxy.getNode(0).hash);
+}
+
+TEST(RenderGraphProxyTest, fullResolutionAfterProxyIsDirty)
+{
+    RenderGraph graph;
+    graph.addNode(QUuid::createUuid(), nullptr, 0, 7, false);
+    graph.computeHashes();
+
+    const uint64_t hash = graph.getNode(0).hash;
+
+    graph.setProxyScale(1);
+
+    ASSERT_TRUE(graph.getNode(0).dirty);
+    ASSERT_EQ(graph.getNode(0).hash, hash);
+}
+
+TEST(RenderGraphProxyTest, footprintShrinksWithProxyScale)
+{
+    KernelTestTask blurTask(8);
+
+    RenderGraph graph;
+    const int read = graph.addNode(QUuid::createUuid(), nullptr, 0);
+    const int blur = graph.addNode(QUuid::createUuid(), &blurTask, 1);
+
+    graph.connect(read, blur, 0);
+    graph.computeHashes();
+    graph.setProxyScale(4);
+
+    graph.setRegionOfInterest(blur, QRect(10, 10, 10, 10));
+
+    ASSERT_EQ(graph.getNode(read).roi, QRect(8, 8, 14, 14));
+}
+
+TEST(RenderGraphProxyTest, scaledRegionCoversPartialPixels)
+{
+    ASSERT_EQ(roiScaledDown(QRect(3, 4, 10, 1), 4), QRect(0, 1, 4, 1));
+    ASSERT_EQ(roiScaledDown(QRect(-1, 0, 2, 2), 4), QRect(-1, 0, 2, 1));
+    ASSERT_EQ(roiScaledUp(QRect(1, 2, 3, 4), 4), QRect(4, 8, 12, 16));
+    ASSERT_TRUE(roiScaledDown(QRect(), 4).isNull());
+}
+
+#endif // TST_RENDERGRAPH_H
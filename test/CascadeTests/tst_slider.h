@@ -1,6 +1,9 @@
 #ifndef TST_SLIDER_H
 #define TST_SLIDER_H
 
+#include <QApplication>
+#include <QMouseEvent>
+
 #include "testheader.h"
 
 #include "../../src/ui/slider.h"
@@ -36,4 +39,30 @@ TEST_F(SliderTest, createSliderAndCheckReturnValue)
     EXPECT_EQ(resultInt, 5);
 }
 
+TEST_F(SliderTest, dragIsBracketedBySignals)
+{
+    int started  = 0;
+    int finished = 0;
+
+    QObject::connect(mSliderInt, &Slider::dragStarted, [&started]() { ++started; });
+    QObject::connect(mSliderInt, &Slider::dragFinished, [&finished]() { ++finished; });
+
+    auto slider = mSliderInt->findChild<QSlider*>();
+
+    QMouseEvent press(
+        QEvent::MouseButtonPress, QPointF(5, 5), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent release(
+        QEvent::MouseButtonRelease, QPointF(5, 5), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+
+    QApplication::sendEvent(slider, &press);
+
+    EXPECT_EQ(started, 1);
+    EXPECT_EQ(finished, 0);
+
+    QApplication::sendEvent(slider, &release);
+
+    EXPECT_EQ(started, 1);
+    EXPECT_EQ(finished, 1);
+}
+
 #endif // TST_SLIDER_H
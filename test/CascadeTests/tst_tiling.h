@@ -0,0 +1,164 @@
+#ifndef TST_TILING_H
+#define TST_TILING_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/imageprecision.h"
+#include "../../src/renderer/rendergraph.h"
+#include "../../src/renderer/rendertaskread.h"
+#include "../../src/renderer/tiling.h"
+#include "tst_rendergraph.h"
+
+using namespace Cascade::Renderer;
+
+class TilingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // read --> blur --> blur
+
+        mRead  = mGraph.addNode(QUuid::createUuid(), nullptr, 0);
+        mBlur1 = mGraph.addNode(QUuid::createUuid(), &mBlurTask1, 1);
+        mBlur2 = mGraph.addNode(QUuid::createUuid(), &mBlurTask2, 1);
+
+        mGraph.connect(mRead, mBlur1, 0);
+        mGraph.connect(mBlur1, mBlur2, 0);
+    }
+
+    KernelTestTask mBlurTask1 = KernelTestTask(4);
+    KernelTestTask mBlurTask2 = KernelTestTask(8);
+
+    RenderGraph mGraph;
+    int mRead;
+    int mBlur1;
+    int mBlur2;
+};
+
+TEST_F(TilingTest, haloAddsUpFootprints)
+{
+    ASSERT_EQ(measureHalo(mGraph, mBlur2), 12);
+    ASSERT_EQ(measureHalo(mGraph, mBlur1), 4);
+}
+
+TEST_F(TilingTest, tilesCoverCanvasWithoutOverlap)
+{
+    const QSize canvas(1000, 700);
+
+    auto plan = planTiles(mGraph, mBlur2, canvas, 256 + 2 * 12, UINT64_MAX);
+
+    ASSERT_EQ(plan.tileSize, 256);
+    ASSERT_EQ(plan.tiles.size(), 4 * 3);
+
+    int pixels = 0;
+    for (const auto& tile : plan.tiles)
+    {
+        ASSERT_TRUE(QRect(QPoint(0, 0), canvas).contains(tile));
+        pixels += tile.width() * tile.height();
+    }
+    ASSERT_EQ(pixels, canvas.width() * canvas.height());
+}
+
+TEST_F(TilingTest, tilesFitMemoryBudget)
+{
+    const QSize canvas(4096, 4096);
+
+    // Three nodes, 16 bytes per pixel
+    const uint64_t budget = 3 * 16 * 600 * 600;
+
+    ASSERT_TRUE(needsTiling(mGraph, mBlur2, canvas, 16384, budget));
+
+    auto plan = planTiles(mGraph, mBlur2, canvas, 16384, budget);
+
+    ASSERT_EQ(plan.tileSize, 512);
+}
+
+TEST_F(TilingTest, halfPrecisionFitsLargerTiles)
+{
+    const QSize canvas(4096, 4096);
+
+    const uint64_t budget = 3 * 16 * 800 * 800;
+
+    ASSERT_EQ(planTiles(mGraph, mBlur2, canvas, 16384, budget).tileSize, 512);
+
+    setImagePrecision(ImagePrecision::Float16);
+    auto plan = planTiles(mGraph, mBlur2, canvas, 16384, budget);
+    setImagePrecision(ImagePrecision::Float32);
+
+    ASSERT_EQ(plan.tileSize, 1024);
+}
+
+TEST(TilingAliasingTest, longChainFitsWithAliasedIntermediates)
+{
+    // read --> grade --> ... --> grade
+
+    RenderGraph graph;
+    int last = graph.addNode(QUuid::createUuid(), nullptr, 0);
+
+    for (int i = 0; i < 9; ++i)
+    {
+        const int next = graph.addNode(QUuid::createUuid(), nullptr, 1);
+        graph.connect(last, next, 0);
+        last = next;
+    }
+
+    const QSize canvas(1024, 1024);
+
+    // Two blocks shared by the intermediates plus the target
+    const uint64_t budget = 3 * 16 * 1024 * 1024;
+
+    // Counted like the tiles, so the canvas fits in one piece
+    ASSERT_FALSE(needsTiling(graph, last, canvas, 16384, budget));
+    ASSERT_TRUE(needsTiling(graph, last, canvas, 16384, budget - 1));
+
+    auto plan = planTiles(graph, last, canvas, 16384, budget);
+
+    ASSERT_EQ(plan.tileSize, 1024);
+    ASSERT_EQ(plan.tiles.size(), 1);
+}
+
+TEST(TilingReadTest, tilesOnlyLoadTheirRegion)
+{
+    RenderTaskRead read;
+    std::vector<QRect> regions;
+
+    read.setRegionLoader(
+        QSize(16384, 16384),
+        [&regions](const QRect& region, const RenderContext&)
+        {
+            regions.push_back(region);
+            return std::shared_ptr<CsImage>();
+        });
+
+    ASSERT_EQ(read.getOutputSize({}), QSize(16384, 16384));
+
+    // The tile with the halo of the nodes downstream
+    RenderContext tile;
+    tile.isTile = true;
+    tile.roi = QRect(-8, 1016, 1040, 1040);
+    read.execute(tile);
+
+    RenderContext whole;
+    read.execute(whole);
+
+    ASSERT_EQ(regions.size(), 2);
+    ASSERT_EQ(regions[0], tile.roi);
+    ASSERT_EQ(regions[1], QRect(0, 0, 16384, 16384));
+}
+
+TEST(TilingReadTest, wholeFileIsValidBeyondTheViewport)
+{
+    RenderTaskRead read;
+
+    // The viewer decodes the whole file, panning must not decode it again
+    RenderContext viewer;
+    viewer.roi = QRect(100, 100, 640, 480);
+    ASSERT_TRUE(read.getComputedRegion(viewer).isNull());
+
+    RenderContext tile;
+    tile.isTile = true;
+    tile.roi = QRect(-8, 1016, 1040, 1040);
+    ASSERT_EQ(read.getComputedRegion(tile), tile.roi);
+}
+
+#endif // TST_TILING_H